@@ -53,6 +53,16 @@ public:
   ///
   virtual Eigen::MatrixXi Predict(const Eigen::MatrixXd &X) = 0;
 
+  ///
+  /// @brief Predict classes and class probabilities for a block of samples in float precision.
+  /// The results are not stored in the classifier, so that several blocks can be predicted concurrently.
+  /// The default implementation converts the block and calls Predict(), calls are serialized.
+  /// @param X, The input samples. Matrix of shape = [n_samples, n_features]
+  /// @param Y, The predicted classes. Resized to shape = [n_samples, 1]
+  /// @param P, The class probabilities. Resized to shape = [n_samples, n_classes]
+  ///
+  virtual void PredictBlock(const Eigen::MatrixXf &X, Eigen::MatrixXi &Y, Eigen::MatrixXf &P);
+
   ///
   /// @brief GetPointWiseWeightCopy
   /// @return return label matrix of shape = [n_samples , 1]
@@ -16,6 +16,21 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkAbstractClassifier.h>
 
+#include <mutex>
+
+namespace
+{
+  // Predict() stores its results in the classifier, so block predictions
+  // based on it must not run concurrently
+  std::mutex predictBlockMutex;
+}
+
+void mitk::AbstractClassifier::PredictBlock(const Eigen::MatrixXf &X, Eigen::MatrixXi &Y, Eigen::MatrixXf &P)
+{
+  std::lock_guard<std::mutex> lock(predictBlockMutex);
+  Y = this->Predict(X.cast<double>());
+  P = m_OutProbability.cast<float>();
+}
 
 void mitk::AbstractClassifier::SetNthItems(const char * val, unsigned int idx)
 {
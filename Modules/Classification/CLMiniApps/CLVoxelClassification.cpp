@@ -337,11 +337,9 @@ int main(int argc, char* argv[])
     //////////////////////////////////////////////////////////////////////////////
     // If required do test
     //////////////////////////////////////////////////////////////////////////////
-    auto testDataX = mitk::DCUtilities::DC3dDToMatrixXd(testCollection,modalities, testMask);
-    auto testDataNewY = forest->Predict(testDataX);
-    //MITK_INFO << testDataNewY;
-
-    mitk::DCUtilities::MatrixToDC3d(testDataNewY, testCollection, resultMask, testMask);
+    mitk::DCUtilities::PredictBlockwise(testCollection, modalities, testMask,
+      [&forest](const Eigen::MatrixXf &X, Eigen::MatrixXi &Y, Eigen::MatrixXf &P) { forest->PredictBlock(X, Y, P); },
+      resultMask, std::vector<std::string>());
     //forest.SetMaskName(testMask);
     //forest.SetCollection(testCollection);
     //forest.Test();
@@ -44,6 +44,10 @@ namespace mitk
     Eigen::MatrixXi Predict(const Eigen::MatrixXd &X) override;
     Eigen::MatrixXi PredictWeighted(const Eigen::MatrixXd &X);
 
+    /// Thread-safe: the block is predicted in the calling thread and the
+    /// forest is not modified.
+    void PredictBlock(const Eigen::MatrixXf &X, Eigen::MatrixXi &Y, Eigen::MatrixXf &P) override;
+
 
     bool SupportsPointWiseWeight() override;
     bool SupportsPointWiseProbability() override;
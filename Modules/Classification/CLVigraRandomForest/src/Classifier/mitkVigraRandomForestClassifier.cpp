@@ -238,6 +238,29 @@ Eigen::MatrixXi mitk::VigraRandomForestClassifier::PredictWeighted(const Eigen::
 
 
 
+void mitk::VigraRandomForestClassifier::PredictBlock(const Eigen::MatrixXf &X_in, Eigen::MatrixXi &Y_out, Eigen::MatrixXf &P_out)
+{
+  P_out.resize(X_in.rows(), m_RandomForest.class_count());
+  P_out.fill(0);
+  Y_out.resize(X_in.rows(), 1);
+
+  vigra::MultiArrayView<2, float> X(vigra::Shape2(X_in.rows(),X_in.cols()),X_in.data());
+  vigra::MultiArrayView<2, float> P(vigra::Shape2(P_out.rows(),P_out.cols()),P_out.data());
+
+  m_RandomForest.predictProbabilities(X, P);
+
+  // the label is the class of maximum probability, which avoids a second
+  // traversal of the trees by predictLabels()
+  for (int row = 0; row < P_out.rows(); ++row)
+  {
+    int maxCol;
+    P_out.row(row).maxCoeff(&maxCol);
+    int label;
+    m_RandomForest.ext_param_.to_classlabel(maxCol, label);
+    Y_out(row,0) = label;
+  }
+}
+
 void mitk::VigraRandomForestClassifier::SetTreeWeights(Eigen::MatrixXd weights)
 {
   m_TreeWeights = weights;
@@ -39,6 +39,7 @@ class mitkVigraRandomForestTestSuite : public mitk::TestFixture
   MITK_TEST(TrainThreadedDecisionForest_MatlabDataSet_shouldReturnTrue);
   MITK_TEST(PredictWeightedDecisionForest_SetWeightsToZero_shouldReturnTrue);
   MITK_TEST(TrainThreadedDecisionForest_BreastCancerDataSet_shouldReturnTrue);
+  MITK_TEST(PredictBlock_FloatFeatures_EqualsPredict);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -176,6 +177,38 @@ public:
   }
 
 
+  // ------------------------------------------------------------------------------------------------------
+  // ------------------------------------------------------------------------------------------------------
+  /*
+  Blockwise prediction in float precision must match the prediction of the whole matrix, apart from
+  samples whose features are rounded across a split threshold.
+  */
+  void PredictBlock_FloatFeatures_EqualsPredict()
+  {
+    auto & Features_Training = FeatureData_Cancer.first;
+    auto & Features_Testing = FeatureData_Cancer.second;
+    auto & Labels_Training = LabelData_Cancer.first;
+
+    classifier->Train(Features_Training,Labels_Training);
+    Eigen::MatrixXi classes = classifier->Predict(Features_Testing);
+    Eigen::MatrixXd probabilities = classifier->GetPointWiseProbabilities();
+
+    Eigen::MatrixXf features = Features_Testing.cast<float>();
+    Eigen::MatrixXi blockClasses;
+    Eigen::MatrixXf blockProbabilities;
+    classifier->PredictBlock(features, blockClasses, blockProbabilities);
+
+    CPPUNIT_ASSERT_EQUAL(classes.rows(), blockClasses.rows());
+    CPPUNIT_ASSERT_EQUAL(probabilities.cols(), blockProbabilities.cols());
+
+    unsigned int differences = 0;
+    for (int i = 0; i < classes.rows(); ++i)
+      if (classes(i,0) != blockClasses(i,0))
+        ++differences;
+
+    MITK_TEST_CONDITION(differences <= static_cast<unsigned int>(classes.rows()) / 100, "Blockwise prediction equals prediction of the whole matrix.");
+  }
+
   // ------------------------------------------------------------------------------------------------------
   // ------------------------------------------------------------------------------------------------------
   /*Reading an file, which includes the trainingdataset and the testdataset, and convert the
@@ -0,0 +1,138 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkDataCollection.h>
+#include <mitkDataCollectionUtilities.h>
+
+#include <mitkImage.h>
+#include <mitkImageWriteAccessor.h>
+
+#include <itkImage.h>
+
+#include <cmath>
+
+class mitkDataCollectionUtilitiesTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkDataCollectionUtilitiesTestSuite);
+  MITK_TEST(PredictBlockwise_MaskAndUnevenBlocks_EqualsMatrixPrediction);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::DataCollection::Pointer m_Collection;
+  std::vector<std::string> m_Features;
+  std::vector<std::string> m_Probabilities;
+
+  template <typename TPixel>
+  mitk::Image::Pointer CreateImage(unsigned int *dimensions, TPixel (*value)(unsigned int))
+  {
+    mitk::Image::Pointer image = mitk::Image::New();
+    image->Initialize(mitk::MakeScalarPixelType<TPixel>(), 3, dimensions);
+
+    mitk::ImageWriteAccessor accessor(image);
+    TPixel *data = static_cast<TPixel *>(accessor.GetData());
+    const unsigned int numberOfVoxels = dimensions[0] * dimensions[1] * dimensions[2];
+    for (unsigned int i = 0; i < numberOfVoxels; ++i)
+      data[i] = value(i);
+    return image;
+  }
+
+  static unsigned char MaskValue(unsigned int i) { return i % 3 == 0 ? 0 : 1; }
+  static short ShortFeatureValue(unsigned int i) { return static_cast<short>((i * 37) % 101) - 50; }
+  static double DoubleFeatureValue(unsigned int i) { return 40.0 * std::sin(0.7 * i); }
+
+  // One patient of the collection: a mask, a short feature as mitk image and a double feature as itk image
+  mitk::DataCollection::Pointer CreatePatient(unsigned int x, unsigned int y, unsigned int z)
+  {
+    unsigned int dimensions[3] = {x, y, z};
+
+    itk::Image<double, 3>::Pointer doubleFeature = itk::Image<double, 3>::New();
+    itk::Image<double, 3>::SizeType size = {{x, y, z}};
+    doubleFeature->SetRegions(size);
+    doubleFeature->Allocate();
+    const unsigned int numberOfVoxels = x * y * z;
+    for (unsigned int i = 0; i < numberOfVoxels; ++i)
+      doubleFeature->GetBufferPointer()[i] = DoubleFeatureValue(i);
+
+    mitk::DataCollection::Pointer patient = mitk::DataCollection::New();
+    patient->AddData(CreateImage<unsigned char>(dimensions, &MaskValue).GetPointer(), "Mask");
+    patient->AddData(CreateImage<short>(dimensions, &ShortFeatureValue).GetPointer(), "ShortFeature");
+    patient->AddData(doubleFeature.GetPointer(), "DoubleFeature");
+    return patient;
+  }
+
+  // A simple deterministic classifier of two features
+  static void Predict(const Eigen::MatrixXf &X, Eigen::MatrixXi &Y, Eigen::MatrixXf &P)
+  {
+    Y.resize(X.rows(), 1);
+    P.resize(X.rows(), 2);
+    for (int row = 0; row < X.rows(); ++row)
+    {
+      P(row, 0) = 1.0f / (1.0f + std::exp((X(row, 1) - X(row, 0)) / 20.0f));
+      P(row, 1) = 1.0f - P(row, 0);
+      Y(row, 0) = P(row, 0) > 0.5f ? 1 : 2;
+    }
+  }
+
+public:
+  void setUp() override
+  {
+    m_Collection = mitk::DataCollection::New();
+    m_Collection->AddData(CreatePatient(7, 5, 3).GetPointer(), "Patient1");
+    m_Collection->AddData(CreatePatient(4, 6, 5).GetPointer(), "Patient2");
+
+    m_Features = {"ShortFeature", "DoubleFeature"};
+    m_Probabilities = {"Probability1", "Probability2"};
+  }
+
+  void tearDown() override { m_Collection = nullptr; }
+
+  void PredictBlockwise_MaskAndUnevenBlocks_EqualsMatrixPrediction()
+  {
+    // 16 divides neither 105 nor 120 voxels
+    mitk::DCUtilities::PredictBlockwise(m_Collection, m_Features, "Mask", &Predict, "Labels", m_Probabilities, 16);
+
+    mitk::DataCollection *patient = dynamic_cast<mitk::DataCollection *>(m_Collection->GetData("Patient1").GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Feature images are not converted to double images",
+                           dynamic_cast<mitk::Image *>(patient->GetData("ShortFeature").GetPointer()) != nullptr);
+
+    // prediction of the feature matrix of all voxels
+    Eigen::MatrixXf X = mitk::DCUtilities::DC3dDToMatrixXd(m_Collection, m_Features, "Mask").cast<float>();
+    Eigen::MatrixXi Y;
+    Eigen::MatrixXf P;
+    Predict(X, Y, P);
+
+    Eigen::MatrixXi labels = mitk::DCUtilities::DC3dDToMatrixXi(m_Collection, "Labels", "Mask");
+    Eigen::MatrixXd probabilities = mitk::DCUtilities::DC3dDToMatrixXd(m_Collection, m_Probabilities, "Mask");
+
+    CPPUNIT_ASSERT_EQUAL(70 + 80, static_cast<int>(labels.rows()));
+    CPPUNIT_ASSERT_MESSAGE("Both classes are predicted", (Y.array() == 1).any() && (Y.array() == 2).any());
+    CPPUNIT_ASSERT_MESSAGE("Blockwise labels equal the labels of the whole matrix", labels == Y);
+    CPPUNIT_ASSERT_MESSAGE("Blockwise probabilities equal the probabilities of the whole matrix",
+                           probabilities.isApprox(P.cast<double>(), 1e-6));
+
+    // voxels outside of the mask are not predicted
+    itk::Image<unsigned char, 3> *labelImage =
+      dynamic_cast<itk::Image<unsigned char, 3> *>(patient->GetData("Labels").GetPointer());
+    CPPUNIT_ASSERT(labelImage != nullptr);
+    for (unsigned int i = 0; i < 105; i += 3)
+      CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(labelImage->GetBufferPointer()[i]));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkDataCollectionUtilities)
@@ -19,6 +19,259 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkDataCollectionImageIterator.h>
 
 #include <mitkImageCast.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkExceptionMacro.h>
+
+#include <itkImageIOBase.h>
+#include <itkMultiThreader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+  typedef itk::Image<double, 3> FeatureImageType;
+  typedef itk::Image<unsigned char, 3> LabelImageType;
+
+  typedef void (*ConvertFeatureFunction)(const char *voxels, const unsigned char *mask, std::size_t numberOfVoxels, float *out);
+
+  // Copies the voxels within the mask of a range of a feature image to a column of the feature matrix
+  template <typename TPixel>
+  void ConvertMaskedFeature(const char *voxels, const unsigned char *mask, std::size_t numberOfVoxels, float *out)
+  {
+    const TPixel *feature = reinterpret_cast<const TPixel *>(voxels);
+    for (std::size_t i = 0; i < numberOfVoxels; ++i)
+    {
+      if (mask[i] > 0)
+        *out++ = static_cast<float>(feature[i]);
+    }
+  }
+
+  // The voxels of a feature image in its own pixel type, they are converted to float block by block
+  struct FeatureVoxels
+  {
+    const char *voxels;
+    std::size_t pixelSize;
+    ConvertFeatureFunction convert;
+  };
+
+  // A range of voxels of one image of the collection, given by pointers to its first voxel
+  struct PredictionBlock
+  {
+    const unsigned char *mask;
+    std::vector<FeatureVoxels> features;
+    unsigned char *labels;
+    std::vector<double *> probabilities;
+    std::size_t numberOfVoxels;
+  };
+
+  struct BlockPredictionData
+  {
+    std::vector<PredictionBlock> blocks;
+    // keep the buffers of the mitk feature images accessible during the prediction
+    std::vector<std::unique_ptr<mitk::ImageReadAccessor>> featureAccessors;
+    std::atomic<std::size_t> nextBlock;
+    const mitk::DCUtilities::BlockPredictionFunction *predict;
+    std::mutex errorMutex;
+    std::string error;
+  };
+
+  // Same conversion as in DataCollectionImageIterator: mitk images are replaced by itk images
+  template <typename TImageType>
+  TImageType *GetItkImageFromDC(mitk::DataCollection *dc, const std::string &name)
+  {
+    mitk::Image *image = dynamic_cast<mitk::Image *>(dc->GetData(name).GetPointer());
+    if (image != nullptr)
+    {
+      typename TImageType::Pointer itkImage = TImageType::New();
+      mitk::CastToItkImage(image, itkImage);
+      dc->SetData(itkImage.GetPointer(), name);
+    }
+    return dynamic_cast<TImageType *>(dc->GetData(name).GetPointer());
+  }
+
+  ConvertFeatureFunction GetConvertFeatureFunction(int componentType)
+  {
+    switch (componentType)
+    {
+      case itk::ImageIOBase::UCHAR:
+        return &ConvertMaskedFeature<unsigned char>;
+      case itk::ImageIOBase::CHAR:
+        return &ConvertMaskedFeature<char>;
+      case itk::ImageIOBase::USHORT:
+        return &ConvertMaskedFeature<unsigned short>;
+      case itk::ImageIOBase::SHORT:
+        return &ConvertMaskedFeature<short>;
+      case itk::ImageIOBase::UINT:
+        return &ConvertMaskedFeature<unsigned int>;
+      case itk::ImageIOBase::INT:
+        return &ConvertMaskedFeature<int>;
+      case itk::ImageIOBase::ULONG:
+        return &ConvertMaskedFeature<unsigned long>;
+      case itk::ImageIOBase::LONG:
+        return &ConvertMaskedFeature<long>;
+      case itk::ImageIOBase::FLOAT:
+        return &ConvertMaskedFeature<float>;
+      case itk::ImageIOBase::DOUBLE:
+        return &ConvertMaskedFeature<double>;
+      default:
+        return nullptr;
+    }
+  }
+
+  // Unlike the iterators of the collection, mitk feature images are not replaced by double itk images,
+  // their voxels are read in their own pixel type.
+  FeatureVoxels GetFeatureVoxels(mitk::DataCollection *dc, const std::string &name, std::size_t numberOfVoxels,
+                                 BlockPredictionData &data)
+  {
+    itk::DataObject *object = dc->HasElement(name) ? dc->GetData(name).GetPointer() : nullptr;
+
+    FeatureImageType *itkImage = dynamic_cast<FeatureImageType *>(object);
+    if (itkImage != nullptr && itkImage->GetLargestPossibleRegion().GetNumberOfPixels() == numberOfVoxels)
+    {
+      FeatureVoxels feature;
+      feature.voxels = reinterpret_cast<const char *>(itkImage->GetBufferPointer());
+      feature.pixelSize = sizeof(double);
+      feature.convert = &ConvertMaskedFeature<double>;
+      return feature;
+    }
+
+    mitk::Image *image = dynamic_cast<mitk::Image *>(object);
+    if (image != nullptr && image->GetPixelType().GetNumberOfComponents() == 1 && image->GetTimeSteps() == 1 &&
+        std::size_t(image->GetDimension(0)) * image->GetDimension(1) * image->GetDimension(2) == numberOfVoxels)
+    {
+      FeatureVoxels feature;
+      feature.convert = GetConvertFeatureFunction(image->GetPixelType().GetComponentType());
+      if (feature.convert != nullptr)
+      {
+        data.featureAccessors.emplace_back(new mitk::ImageReadAccessor(image));
+        feature.voxels = static_cast<const char *>(data.featureAccessors.back()->GetData());
+        feature.pixelSize = image->GetPixelType().GetSize();
+        return feature;
+      }
+    }
+
+    mitkThrow() << "Feature image " << name << " is missing, not a scalar image or does not match the size of the mask";
+  }
+
+  void CollectPredictionBlocks(mitk::DataCollection *dc, const std::vector<std::string> &features, const std::string &mask,
+                               const std::string &labelName, const std::vector<std::string> &probabilityNames,
+                               unsigned int blockSize, BlockPredictionData &data)
+  {
+    LabelImageType *maskImage = dc->HasElement(mask) ? GetItkImageFromDC<LabelImageType>(dc, mask) : nullptr;
+    if (maskImage == nullptr)
+    {
+      for (std::size_t i = 0; i < dc->Size(); ++i)
+      {
+        mitk::DataCollection *collection = dynamic_cast<mitk::DataCollection *>(dc->GetData(i).GetPointer());
+        if (collection != nullptr)
+          CollectPredictionBlocks(collection, features, mask, labelName, probabilityNames, blockSize, data);
+      }
+      return;
+    }
+
+    const std::size_t numberOfVoxels = maskImage->GetLargestPossibleRegion().GetNumberOfPixels();
+
+    PredictionBlock block;
+    block.mask = maskImage->GetBufferPointer();
+
+    LabelImageType *labelImage = GetItkImageFromDC<LabelImageType>(dc, labelName);
+    if (labelImage == nullptr || labelImage->GetLargestPossibleRegion().GetNumberOfPixels() != numberOfVoxels)
+      mitkThrow() << "Label image " << labelName << " is not an unsigned char image of the size of the mask " << mask;
+    block.labels = labelImage->GetBufferPointer();
+
+    for (const auto &name : features)
+      block.features.push_back(GetFeatureVoxels(dc, name, numberOfVoxels, data));
+
+    for (const auto &name : probabilityNames)
+    {
+      FeatureImageType *image = GetItkImageFromDC<FeatureImageType>(dc, name);
+      if (image == nullptr || image->GetLargestPossibleRegion().GetNumberOfPixels() != numberOfVoxels)
+        mitkThrow() << "Probability image " << name << " is not a double image of the size of the mask " << mask;
+      block.probabilities.push_back(image->GetBufferPointer());
+    }
+
+    for (std::size_t offset = 0; offset < numberOfVoxels; offset += blockSize)
+    {
+      PredictionBlock current = block;
+      current.mask += offset;
+      current.labels += offset;
+      for (auto &feature : current.features)
+        feature.voxels += offset * feature.pixelSize;
+      for (auto &probability : current.probabilities)
+        probability += offset;
+      current.numberOfVoxels = std::min<std::size_t>(blockSize, numberOfVoxels - offset);
+      data.blocks.push_back(current);
+    }
+  }
+
+  void PredictBlock(const PredictionBlock &block, const mitk::DCUtilities::BlockPredictionFunction &predict,
+                    Eigen::MatrixXf &X, Eigen::MatrixXi &Y, Eigen::MatrixXf &P)
+  {
+    std::size_t numberOfRows = 0;
+    for (std::size_t i = 0; i < block.numberOfVoxels; ++i)
+    {
+      if (block.mask[i] > 0)
+        ++numberOfRows;
+    }
+    if (numberOfRows == 0)
+      return;
+
+    // the columns of the column-major matrix are filled one feature after another
+    X.resize(numberOfRows, block.features.size());
+    for (std::size_t col = 0; col < block.features.size(); ++col)
+    {
+      const FeatureVoxels &feature = block.features[col];
+      feature.convert(feature.voxels, block.mask, block.numberOfVoxels, X.col(col).data());
+    }
+
+    predict(X, Y, P);
+
+    if (static_cast<std::size_t>(P.cols()) < block.probabilities.size())
+      mitkThrow() << "Classifier predicted " << P.cols() << " class probabilities, " << block.probabilities.size() << " requested";
+
+    std::size_t row = 0;
+    for (std::size_t i = 0; i < block.numberOfVoxels; ++i)
+    {
+      if (block.mask[i] > 0)
+      {
+        block.labels[i] = Y(row, 0);
+        for (std::size_t col = 0; col < block.probabilities.size(); ++col)
+          block.probabilities[col][i] = P(row, col);
+        ++row;
+      }
+    }
+  }
+
+  ITK_THREAD_RETURN_TYPE PredictBlocksCallback(void *arg)
+  {
+    typedef itk::MultiThreader::ThreadInfoStruct ThreadInfoType;
+    ThreadInfoType *infoStruct = static_cast<ThreadInfoType *>(arg);
+    BlockPredictionData *data = static_cast<BlockPredictionData *>(infoStruct->UserData);
+
+    // the matrices are reused for all blocks of this thread
+    Eigen::MatrixXf X;
+    Eigen::MatrixXi Y;
+    Eigen::MatrixXf P;
+
+    try
+    {
+      // blocks are distributed dynamically, as their costs depend on the number of voxels in the mask
+      for (std::size_t index = data->nextBlock++; index < data->blocks.size(); index = data->nextBlock++)
+        PredictBlock(data->blocks[index], *data->predict, X, Y, P);
+    }
+    catch (const std::exception &e)
+    {
+      std::lock_guard<std::mutex> lock(data->errorMutex);
+      data->error = e.what();
+      data->nextBlock = data->blocks.size();
+    }
+
+    return 0;
+  }
+}
 
 int mitk::DCUtilities::VoxelInMask(mitk::DataCollection::Pointer dc, std::string mask)
 {
@@ -206,6 +459,30 @@ void mitk::DCUtilities::MatrixToDC3d(const Eigen::MatrixXi &matrix, mitk::DataCo
   return MatrixToDC3d(matrix, dc, names, mask);
 }
 
+void mitk::DCUtilities::PredictBlockwise(mitk::DataCollection::Pointer dc, const std::vector<std::string> &features, std::string mask,
+                                          const BlockPredictionFunction &predict, const std::string &labelName,
+                                          const std::vector<std::string> &probabilityNames, unsigned int blockSize)
+{
+  if (blockSize == 0)
+    mitkThrow() << "Block size must be greater than 0";
+
+  EnsureUCharImageInDC(dc, labelName, mask);
+  for (const auto &name : probabilityNames)
+    EnsureDoubleImageInDC(dc, name, mask);
+
+  BlockPredictionData data;
+  data.nextBlock = 0;
+  data.predict = &predict;
+  CollectPredictionBlocks(dc, features, mask, labelName, probabilityNames, blockSize, data);
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetSingleMethod(PredictBlocksCallback, &data);
+  threader->SingleMethodExecute();
+
+  if (!data.error.empty())
+    mitkThrow() << "Blockwise prediction failed: " << data.error;
+}
+
 void mitk::DCUtilities::EnsureUCharImageInDC(mitk::DataCollection::Pointer dc, std::string name, std::string origin)
 {
   typedef itk::Image<unsigned char, 3> FeatureImage;
@@ -22,6 +22,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkDataCollection.h>
 #include <Eigen/Dense>
 
+#include <functional>
+
 namespace mitk
 {
   class MITKDATACOLLECTION_EXPORT DCUtilities
@@ -39,6 +41,30 @@ namespace mitk
     static void MatrixToDC3d(const Eigen::MatrixXd &matrix, mitk::DataCollection::Pointer dc, const std::string &names, std::string mask);
     static void MatrixToDC3d(const Eigen::MatrixXi &matrix, mitk::DataCollection::Pointer dc, const std::string &names, std::string mask);
 
+    /**
+    * \brief Predicts a block of samples, see mitk::AbstractClassifier::PredictBlock().
+    * Must be safe to be called concurrently.
+    */
+    typedef std::function<void(const Eigen::MatrixXf &X, Eigen::MatrixXi &Y, Eigen::MatrixXf &P)> BlockPredictionFunction;
+
+    /**
+    * \brief Predicts all voxels within the mask block by block and writes the labels and class
+    * probabilities directly into images of the collection.
+    *
+    * In contrast to DC3dDToMatrixXd() and MatrixToDC3d() no feature matrix of all voxels is created.
+    * The feature images are read in their own pixel type, mitk images are not replaced by double
+    * images as by the iterators of the collection. Only the voxels of a block are converted to float
+    * and predicted, by several threads, which needs about (number of threads x blockSize x number of
+    * features) floats in addition to the images of the collection and the label and probability images.
+    *
+    * \param labelName unsigned char image for the predicted labels, created if necessary
+    * \param probabilityNames double images for the first class probabilities, created if necessary
+    * \param blockSize number of voxels of a block
+    */
+    static void PredictBlockwise(mitk::DataCollection::Pointer dc, const std::vector<std::string> &features, std::string mask,
+                                 const BlockPredictionFunction &predict, const std::string &labelName,
+                                 const std::vector<std::string> &probabilityNames, unsigned int blockSize = 65536);
+
     static void EnsureUCharImageInDC(mitk::DataCollection::Pointer dc, std::string name, std::string origin);
     static void EnsureDoubleImageInDC(mitk::DataCollection::Pointer dc, std::string name, std::string origin);
   };
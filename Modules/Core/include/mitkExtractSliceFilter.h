@@ -162,6 +162,8 @@ namespace mitk
       this->m_InterpolationMode = interpolation;
     }
 
+    ExtractSliceFilter::ResliceInterpolation GetInterpolationMode() const { return this->m_InterpolationMode; }
+
   protected:
     ExtractSliceFilter(vtkImageReslice *reslicer = nullptr);
     ~ExtractSliceFilter() override;
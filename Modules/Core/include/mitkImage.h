@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageAccessorBase.h"
 #include "mitkImageDataItem.h"
 #include "mitkImageDescriptor.h"
+#include "mitkImageVolumeLoader.h"
 #include "mitkImageVtkAccessor.h"
 #include "mitkLevelWindow.h"
 #include "mitkPlaneGeometry.h"
@@ -35,6 +36,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkHistogram.h>
 #endif
 
+#include <list>
+
 class vtkImageData;
 
 namespace itk
@@ -261,6 +264,28 @@ namespace mitk
                                   int n = 0,
                                   ImportMemoryManagementType importMemoryManagement = CopyMemory);
 
+    //##Documentation
+    //## @brief Set a @a loader that provides volumes which are not set when they are accessed
+    //## for the first time, e.g. by reading single time steps of a large file.
+    //##
+    //## If @a maximumNumberOfResidentVolumes is greater than 0, the least recently used loaded
+    //## volumes are released when further volumes are loaded and loaded again on the next access.
+    //## A loaded volume is kept as long as it is referenced (ImageDataItem pointers, vtkImageData
+    //## in use) or accessed by an ImageReadAccessor or ImageWriteAccessor. Once its data was changed
+    //## (ImageWriteAccessor, SetSlice(), SetVolume() etc.), it is kept for good, so that the changes
+    //## are not lost. Raw pointers to volume data are only valid as long as one of these conditions
+    //## holds, changes through raw pointers are lost when the volume is released.
+    //##
+    //## Accessing a complete channel loads all volumes and removes the loader.
+    //## The loader is also removed by (re-)initializing the image.
+    void SetVolumeLoader(ImageVolumeLoader *loader, unsigned int maximumNumberOfResidentVolumes = 0);
+    ImageVolumeLoader *GetVolumeLoader() const;
+    unsigned int GetMaximumNumberOfResidentVolumes() const;
+
+    //##Documentation
+    //## @brief Get the number of volumes that were provided by the volume loader and are currently loaded.
+    unsigned int GetNumberOfLoadedVolumes() const;
+
     //##Documentation
     //## initialize new (or re-initialize) image information
     //## @warning Initialize() by pic assumes a plane, evenly spaced geometry starting at (0,0,0).
@@ -730,6 +755,26 @@ namespace mitk
     bool IsVolumeSet_unlocked(int t, int n) const;
     bool IsChannelSet_unlocked(int n) const;
 
+    ImageDataItemPointer LoadVolumeData_unlocked(int t, int n) const;
+    bool IsLoadedVolumeReleasable_unlocked(int t, int n) const;
+    /** Releases least recently used loaded volumes until at most the maximum number of volumes is resident */
+    void ReleaseLoadedVolumes() const;
+    /** Marks the loaded volumes in the address range as changed, called when write access is granted */
+    void MarkLoadedVolumesModified(const void *begin, const void *end) const;
+
+    struct LoadedVolume
+    {
+      int t;
+      int n;
+      /** data modification time of the volume when it was loaded */
+      unsigned long dataMTime;
+    };
+
+    mutable ImageVolumeLoader::Pointer m_VolumeLoader;
+    unsigned int m_MaximumNumberOfResidentVolumes;
+    /** most recently used first */
+    mutable std::list<LoadedVolume> m_LoadedVolumes;
+
     /** Stores all existing ImageReadAccessors */
     mutable std::vector<ImageAccessorBase *> m_Readers;
     /** Stores all existing ImageWriteAccessors */
@@ -22,6 +22,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include <mitkIpPic.h>
 //#include "mitkPixelType.h"
 #include "mitkImageDescriptor.h"
+
+#include <itkTimeStamp.h>
 //#include "mitkImageVtkAccessor.h"
 
 class vtkImageData;
@@ -132,8 +134,13 @@ namespace mitk
     virtual void ConstructVtkImageData(ImageConstPointer) const;
 
     unsigned long GetSize() const { return m_Size; }
+
+    /** Marks the data as changed, this includes the data of the parent item */
     virtual void Modified() const;
 
+    /** Time of the last call of Modified() for this item or one of its children */
+    unsigned long GetDataMTime() const { return m_DataMTime.GetMTime(); }
+
   protected:
     unsigned char *m_Data;
 
@@ -150,6 +157,8 @@ namespace mitk
 
     unsigned long m_Size;
 
+    mutable itk::TimeStamp m_DataMTime;
+
   private:
     void ComputeItemSize(const unsigned int *dimensions, unsigned int dimension);
 
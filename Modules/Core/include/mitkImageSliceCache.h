@@ -0,0 +1,161 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkImageSliceCache_h
+#define mitkImageSliceCache_h
+
+#include <MitkCoreExports.h>
+#include <mitkExtractSliceFilter.h>
+#include <mitkImage.h>
+#include <mitkPlaneGeometry.h>
+
+#include <vtkSmartPointer.h>
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+
+class vtkImageData;
+class vtkMatrix4x4;
+
+namespace mitk
+{
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif
+
+  /**
+   * \brief LRU cache of resliced 2D image slices, shared by all renderers.
+   *
+   * Slices are identified by the image (and its modification time), the time step, the plane geometry and
+   * the reslice parameters. The ImageVtkMapper2D looks up its slice before reslicing and adds every newly
+   * resliced slice. While scrolling, the slices following the current one in scroll direction can be
+   * prefetched on a background thread, so that they are already available when they are shown.
+   *
+   * The cache is limited by the memory of the stored slices; the least recently used slices are removed first.
+   */
+  class MITKCORE_EXPORT ImageSliceCache
+  {
+  public:
+    /** \brief Everything the resliced image depends on. */
+    struct SliceKey
+    {
+      const Image *image;
+      unsigned long imageMTime;
+      int timeStep;
+      const BaseGeometry *referenceGeometry;
+      Point3D origin;
+      Vector3D axis0;
+      Vector3D axis1;
+      ScalarType extent[2];
+      int interpolationMode;
+      bool inPlaneResampleExtentByGeometry;
+
+      SliceKey();
+      SliceKey(const Image *image,
+               int timeStep,
+               const PlaneGeometry *planeGeometry,
+               ExtractSliceFilter::ResliceInterpolation interpolationMode,
+               bool inPlaneResampleExtentByGeometry);
+
+      bool Matches(const SliceKey &other) const;
+    };
+
+    /** \brief A resliced image and the reslice information needed to display it. */
+    struct Slice
+    {
+      vtkSmartPointer<vtkImageData> image;
+      vtkSmartPointer<vtkMatrix4x4> resliceAxes;
+      ScalarType spacing[2];
+    };
+
+    static ImageSliceCache *GetInstance();
+
+    /** \brief Returns true and copies the slice if it is cached; marks it as most recently used. */
+    bool Get(const SliceKey &key, Slice &slice);
+
+    /** \brief Stores a copy of the output of the given (updated) reslicer. */
+    void Add(const SliceKey &key, ExtractSliceFilter *reslicer);
+
+    /**
+     * \brief Prefetches the slices following the given plane in direction of the given offset.
+     *
+     * Pending prefetches of earlier requests are dropped, only the latest scroll position is relevant.
+     */
+    void Prefetch(const SliceKey &key, Image *image, const PlaneGeometry *planeGeometry, const Vector3D &offset);
+
+    /** \brief Removes all slices and pending prefetches. */
+    void Clear();
+
+    void SetEnabled(bool enabled);
+    bool GetEnabled() const;
+
+    /** \brief Maximum memory of all cached slices in bytes (default 256 MB). */
+    void SetMaximumSize(unsigned long long size);
+    unsigned long long GetMaximumSize() const;
+
+    /** \brief Number of slices that are prefetched in scroll direction (default 4, 0 disables prefetching). */
+    void SetNumberOfPrefetchedSlices(unsigned int number);
+    unsigned int GetNumberOfPrefetchedSlices() const;
+
+    unsigned int GetNumberOfSlices() const;
+
+  protected:
+    ImageSliceCache();
+    ~ImageSliceCache();
+
+    struct Entry
+    {
+      SliceKey key;
+      Slice slice;
+      unsigned long long size;
+    };
+
+    struct PrefetchJob
+    {
+      SliceKey key;
+      Image::Pointer image;
+      PlaneGeometry::Pointer planeGeometry;
+    };
+
+    void Insert(const SliceKey &key, const Slice &slice);
+    bool Contains(const SliceKey &key) const;
+    void Shrink();
+    void PrefetchLoop();
+    void ComputeSlice(const PrefetchJob &job);
+
+    std::list<Entry> m_Entries; ///< most recently used first
+    unsigned long long m_Size;
+    unsigned long long m_MaximumSize;
+    unsigned int m_NumberOfPrefetchedSlices;
+    bool m_Enabled;
+    mutable std::mutex m_Mutex;
+
+    std::deque<PrefetchJob> m_PrefetchJobs;
+    std::condition_variable m_PrefetchCondition;
+    std::thread m_PrefetchThread;
+    bool m_StopPrefetching;
+  };
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+} // namespace mitk
+
+#endif
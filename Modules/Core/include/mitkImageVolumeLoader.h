@@ -0,0 +1,54 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkImageVolumeLoader_h
+#define mitkImageVolumeLoader_h
+
+#include <MitkCoreExports.h>
+#include <mitkCommon.h>
+
+#include <itkObject.h>
+
+namespace mitk
+{
+  /**
+   * \brief Provides the data of image volumes on demand.
+   *
+   * A loader is set on an mitk::Image by Image::SetVolumeLoader(). The image then calls LoadVolume() when a
+   * volume (time step) is accessed for the first time or after it was released to limit the memory usage,
+   * e.g. to read single time steps of a large 4D image from its file.
+   *
+   * LoadVolume() is called while the data arrays of the image are locked, it must not access the image.
+   */
+  class MITKCORE_EXPORT ImageVolumeLoader : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(ImageVolumeLoader, itk::Object);
+
+    /**
+     * \brief Writes the complete volume of time step t and channel n to the buffer.
+     *
+     * The buffer has the size of one volume of the image. Errors are reported by exceptions.
+     */
+    virtual void LoadVolume(unsigned int t, unsigned int n, void *buffer) = 0;
+
+  protected:
+    ImageVolumeLoader() {}
+    ~ImageVolumeLoader() override {}
+  };
+}
+
+#endif
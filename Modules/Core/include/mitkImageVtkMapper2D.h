@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 // MITK Rendering
 #include "mitkBaseRenderer.h"
 #include "mitkExtractSliceFilter.h"
+#include "mitkImageSliceCache.h"
 #include "mitkVtkMapper.h"
 
 // VTK
@@ -34,6 +35,7 @@ class vtkPolyDataMapper;
 class vtkPlaneSource;
 class vtkImageData;
 class vtkLookupTable;
+class vtkMatrix4x4;
 class vtkImageExtractComponents;
 class vtkImageReslice;
 class vtkImageChangeInformation;
@@ -176,6 +178,25 @@ namespace mitk
       mitk::ExtractSliceFilter::Pointer m_Reslicer;
       /** \brief Filter for thick slices */
       vtkSmartPointer<vtkMitkThickSlicesFilter> m_TSFilter;
+      /** \brief Slab of the last thick slice rendering. If the next slab is only moved by
+            one slice along the plane normal, the thick slices filter can update its result
+            incrementally (see vtkMitkThickSlicesFilter::SetSlidingWindowShift). */
+      bool m_LastSlabValid;
+      mitk::Point3D m_LastSlabOrigin;
+      mitk::Vector3D m_LastSlabAxis0;
+      mitk::Vector3D m_LastSlabAxis1;
+      double m_LastSlabZSpacing;
+      int m_LastSlabMode;
+      int m_LastSlabNum;
+      int m_LastSlabInterpolation;
+      int m_LastSlabTimeStep;
+      unsigned long m_LastSlabImageMTime;
+      /** \brief Key of the last slice taken from or added to the slice cache, used to detect the scroll direction. */
+      mitk::ImageSliceCache::SliceKey m_LastSliceKey;
+      bool m_LastSliceKeyValid;
+      /** \brief Reslice axes and spacing of the current slice; set from the reslicer or the slice cache. */
+      vtkSmartPointer<vtkMatrix4x4> m_ResliceAxes;
+      mitk::ScalarType m_CachedSliceSpacing[2];
       /** \brief PolyData object containg all lines/points needed for outlining the contour.
             This container is used to save a computed contour for the next rendering execution.
             For instance, if you zoom or pann, there is no need to recompute the contour. */
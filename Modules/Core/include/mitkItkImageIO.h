@@ -55,6 +55,14 @@ namespace mitk
     // Fills the m_DefaultMetaDataKeys vector with default values
     virtual void InitializeDefaultMetaDataKeys();
 
+    // Sets the default reader options: time steps of 4D images can be loaded on demand from
+    // formats that support streamed reading, only the given number of time steps is kept in memory
+    void InitializeDefaultReaderOptions();
+
+    // Sets the default writer options: NRRD files are compressed in parallel by default, other formats
+    // use the compression of their ITK ImageIO, compression can be switched off for all formats
+    void InitializeDefaultWriterOptions();
+
   private:
     ItkImageIO(const ItkImageIO &other);
 
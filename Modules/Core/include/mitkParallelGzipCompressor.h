@@ -0,0 +1,61 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkParallelGzipCompressor_h
+#define mitkParallelGzipCompressor_h
+
+#include <MitkCoreExports.h>
+
+#include <cstddef>
+#include <ostream>
+
+namespace mitk
+{
+  /**
+   * @internal
+   *
+   * @brief Writes data as gzip stream that is compressed on several threads.
+   *
+   * Like pigz, the data is split into blocks which are deflated independently. Each block but the last
+   * ends with a sync flush, so that the concatenated blocks form a single regular gzip member that any
+   * gzip decoder reads. Since the blocks do not share their history, the ratio is slightly worse than
+   * sequential compression with the same level.
+   *
+   * @sa ItkImageIO
+   *
+   * @ingroup IO
+   */
+  class MITKCORE_EXPORT ParallelGzipCompressor
+  {
+  public:
+    /**
+     * @brief Compresses size bytes of data and writes the gzip stream.
+     *
+     * @param level zlib compression level (1: fastest, 9: best compression)
+     * @param numberOfThreads 0 uses one thread per core
+     *
+     * @throw mitk::Exception if the compression or writing fails.
+     */
+    static void Compress(const void *data,
+                         std::size_t size,
+                         std::ostream &stream,
+                         int level = 6,
+                         unsigned int numberOfThreads = 0,
+                         std::size_t blockSize = 1024 * 1024);
+  };
+}
+
+#endif
@@ -22,6 +22,8 @@ class vtkPiecewiseFunction;
 #include <vtkImageData.h>
 #include <vtkThreadedImageAlgorithm.h>
 
+#include <vector>
+
 #include <MitkCoreExports.h>
 /** Documentation
 * \brief Applies the grayvalue or color/opacity level window to scalar or RGB(A) images.
@@ -33,6 +35,9 @@ class vtkPiecewiseFunction;
 *
 * The filter is also able to apply an opacity level window to RGBA images.
 *
+* For 8 and 16 bit scalar images the RGBA value of every possible input value is
+* computed once and the pixels are mapped by a table lookup.
+*
 * \ingroup Renderer
 */
 class MITKCORE_EXPORT vtkMitkLevelWindowFilter : public vtkThreadedImageAlgorithm
@@ -84,6 +89,10 @@ protected:
   int RequestInformation(vtkInformation *request,
                          vtkInformationVector **inputVector,
                          vtkInformationVector *outputVector) override;
+  /** \brief Prepares the lookup table (and the value table for 8 and 16 bit images) before the threaded execution. */
+  int RequestData(vtkInformation *request,
+                  vtkInformationVector **inputVector,
+                  vtkInformationVector *outputVector) override;
   //  /** Standard VTK filter method to apply the filter. See VTK documentation. Not used at the moment.*/
   //  void ExecuteInformation(vtkImageData *vtkNotUsed(inData), vtkImageData *vtkNotUsed(outData));
 
@@ -98,5 +107,11 @@ private:
   double m_MaxOpacity;
 
   double m_ClippingBounds[4];
+
+  /** RGBA values (stored as int) of all possible values of the 8 or 16 bit input type. */
+  std::vector<int> m_ValueTable;
+  bool m_UseValueTable;
+  int m_ValueTableScalarType;
+  vtkMTimeType m_ValueTableTime;
 };
 #endif
@@ -27,8 +27,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <MitkCoreExports.h>
 
+#include "vtkSmartPointer.h"
 #include "vtkThreadedImageAlgorithm.h"
 
+class vtkDataArray;
+
 class MITKCORE_EXPORT vtkMitkThickSlicesFilter : public vtkThreadedImageAlgorithm
 {
 public:
@@ -80,6 +83,18 @@ protected:
 
   int m_CurrentMode;
 
+  // Sliding window state of the SUM and MEAN modes: the per pixel sum of the
+  // last slab and its first and last slice
+  int SlidingWindowShift;
+  bool UseSlidingWindow;
+  bool SlabStateValid;
+  int SlabStateMode;
+  int SlabStateScalarType;
+  int SlabStateExtent[6];
+  vtkSmartPointer<vtkDataArray> SlabSum;
+  vtkSmartPointer<vtkDataArray> SlabFirstSlice;
+  vtkSmartPointer<vtkDataArray> SlabLastSlice;
+
 private:
   vtkMitkThickSlicesFilter(const vtkMitkThickSlicesFilter &); // Not implemented.
   void operator=(const vtkMitkThickSlicesFilter &);           // Not implemented.
@@ -87,6 +102,16 @@ private:
 public:
   void SetThickSliceMode(int mode) { m_CurrentMode = mode; }
   int GetThickSliceMode() { return m_CurrentMode; }
+
+  // Description:
+  // Tells the filter that the next input is the previous slab moved by the
+  // given number of slices along z (slice z of the new input equals slice
+  // z + shift of the previous one). For a shift of +1 or -1 the SUM and MEAN
+  // modes update the previous result by adding the entering and subtracting
+  // the leaving slice instead of summing up the whole slab. The hint is
+  // reset after each execution.
+  void SetSlidingWindowShift(int shift) { SlidingWindowShift = shift; }
+  int GetSlidingWindowShift() { return SlidingWindowShift; }
 };
 
 #endif
@@ -45,7 +45,8 @@ mitk::Image::Image()
     m_ImageDescriptor(nullptr),
     m_OffsetTable(nullptr),
     m_CompleteData(nullptr),
-    m_ImageStatistics(nullptr)
+    m_ImageStatistics(nullptr),
+    m_MaximumNumberOfResidentVolumes(0)
 {
   m_Dimensions = new unsigned int[MAX_IMAGE_DIMENSIONS];
   FILL_C_ARRAY(m_Dimensions, MAX_IMAGE_DIMENSIONS, 0u);
@@ -60,7 +61,8 @@ mitk::Image::Image(const Image &other)
     m_ImageDescriptor(nullptr),
     m_OffsetTable(nullptr),
     m_CompleteData(nullptr),
-    m_ImageStatistics(nullptr)
+    m_ImageStatistics(nullptr),
+    m_MaximumNumberOfResidentVolumes(0)
 {
   m_Dimensions = new unsigned int[MAX_IMAGE_DIMENSIONS];
   FILL_C_ARRAY(m_Dimensions, MAX_IMAGE_DIMENSIONS, 0u);
@@ -247,8 +249,16 @@ const vtkImageData *mitk::Image::GetVtkImageData(int t, int n) const
 mitk::Image::ImageDataItemPointer mitk::Image::GetSliceData(
   int s, int t, int n, void *data, ImportMemoryManagementType importMemoryManagement) const
 {
-  MutexHolder lock(m_ImageDataArraysLock);
-  return GetSliceData_unlocked(s, t, n, data, importMemoryManagement);
+  ImageDataItemPointer slice;
+  bool release;
+  {
+    MutexHolder lock(m_ImageDataArraysLock);
+    slice = GetSliceData_unlocked(s, t, n, data, importMemoryManagement);
+    release = m_MaximumNumberOfResidentVolumes > 0 && m_LoadedVolumes.size() > m_MaximumNumberOfResidentVolumes;
+  }
+  if (release)
+    this->ReleaseLoadedVolumes();
+  return slice;
 }
 
 mitk::Image::ImageDataItemPointer mitk::Image::GetSliceData_unlocked(
@@ -297,6 +307,13 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetSliceData_unlocked(
     return m_Slices[pos] = sl;
   }
 
+  // is slice available as part of a volume that can be loaded?
+  if (m_VolumeLoader.IsNotNull() && LoadVolumeData_unlocked(t, n).IsNotNull())
+  {
+    // now the volume is available (see "if" above)
+    return GetSliceData_unlocked(s, t, n, data, importMemoryManagement);
+  }
+
   // slice is unavailable. Can we calculate it?
   if ((GetSource().IsNotNull()) && (GetSource()->Updating() == false))
   {
@@ -332,8 +349,16 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetVolumeData(int t,
                                                              void *data,
                                                              ImportMemoryManagementType importMemoryManagement) const
 {
-  MutexHolder lock(m_ImageDataArraysLock);
-  return GetVolumeData_unlocked(t, n, data, importMemoryManagement);
+  ImageDataItemPointer volume;
+  bool release;
+  {
+    MutexHolder lock(m_ImageDataArraysLock);
+    volume = GetVolumeData_unlocked(t, n, data, importMemoryManagement);
+    release = m_MaximumNumberOfResidentVolumes > 0 && m_LoadedVolumes.size() > m_MaximumNumberOfResidentVolumes;
+  }
+  if (release)
+    this->ReleaseLoadedVolumes();
+  return volume;
 }
 mitk::Image::ImageDataItemPointer mitk::Image::GetVolumeData_unlocked(
   int t, int n, void *data, ImportMemoryManagementType importMemoryManagement) const
@@ -347,7 +372,21 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetVolumeData_unlocked(
   int pos = GetVolumeIndex(t, n);
   vol = m_Volumes[pos];
   if ((vol.GetPointer() != nullptr) && (vol->IsComplete()))
+  {
+    if (m_VolumeLoader.IsNotNull())
+    {
+      // mark as most recently used
+      for (auto it = m_LoadedVolumes.begin(); it != m_LoadedVolumes.end(); ++it)
+      {
+        if (it->t == t && it->n == n)
+        {
+          m_LoadedVolumes.splice(m_LoadedVolumes.begin(), m_LoadedVolumes, it);
+          break;
+        }
+      }
+    }
     return vol;
+  }
 
   const size_t ptypeSize = this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
 
@@ -428,6 +467,12 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetVolumeData_unlocked(
     return m_Volumes[pos] = vol;
   }
 
+  // volume can be loaded?
+  if (m_VolumeLoader.IsNotNull())
+  {
+    return LoadVolumeData_unlocked(t, n);
+  }
+
   // volume is unavailable. Can we calculate it?
   if ((GetSource().IsNotNull()) && (GetSource()->Updating() == false))
   {
@@ -539,6 +584,11 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetChannelData_unlocked(
       //   if(ch->GetPicDescriptor()->info->tags_head==nullptr)
       //     mitkIpFuncCopyTags(ch->GetPicDescriptor(), m_Volumes[GetVolumeIndex(0,n)]->GetPicDescriptor());
     }
+
+    // all volumes are part of the channel now, nothing is loaded or released anymore
+    m_VolumeLoader = nullptr;
+    m_LoadedVolumes.clear();
+
     return m_Channels[n] = ch;
   }
 
@@ -600,6 +650,11 @@ bool mitk::Image::IsSliceSet_unlocked(int s, int t, int n) const
   {
     return true;
   }
+  // volume can be loaded?
+  if (m_VolumeLoader.IsNotNull())
+  {
+    return true;
+  }
   return false;
 }
 
@@ -625,6 +680,10 @@ bool mitk::Image::IsVolumeSet_unlocked(int t, int n) const
   if ((ch.GetPointer() != nullptr) && (ch->IsComplete()))
     return true;
 
+  // volume can be loaded?
+  if (m_VolumeLoader.IsNotNull())
+    return true;
+
   // let's see if all slices of the volume are set, so that we can (could) combine them to a volume
   unsigned int s;
   for (s = 0; s < m_Dimensions[2]; ++s)
@@ -821,6 +880,9 @@ void mitk::Image::Initialize()
   }
   m_CompleteData = nullptr;
 
+  m_VolumeLoader = nullptr;
+  m_LoadedVolumes.clear();
+
   if (m_ImageStatistics == nullptr)
   {
     m_ImageStatistics = new mitk::ImageStatisticsHolder(this);
@@ -1310,6 +1372,149 @@ mitk::Image::ImageDataItemPointer mitk::Image::AllocateChannelData_unlocked(
   return ch;
 }
 
+void mitk::Image::SetVolumeLoader(ImageVolumeLoader *loader, unsigned int maximumNumberOfResidentVolumes)
+{
+  {
+    MutexHolder lock(m_ImageDataArraysLock);
+    m_VolumeLoader = loader;
+    m_MaximumNumberOfResidentVolumes = maximumNumberOfResidentVolumes;
+    if (loader == nullptr)
+    {
+      // loaded volumes stay resident
+      m_LoadedVolumes.clear();
+    }
+  }
+  this->ReleaseLoadedVolumes();
+}
+
+mitk::ImageVolumeLoader *mitk::Image::GetVolumeLoader() const
+{
+  MutexHolder lock(m_ImageDataArraysLock);
+  return m_VolumeLoader;
+}
+
+unsigned int mitk::Image::GetMaximumNumberOfResidentVolumes() const
+{
+  MutexHolder lock(m_ImageDataArraysLock);
+  return m_MaximumNumberOfResidentVolumes;
+}
+
+unsigned int mitk::Image::GetNumberOfLoadedVolumes() const
+{
+  MutexHolder lock(m_ImageDataArraysLock);
+  return static_cast<unsigned int>(m_LoadedVolumes.size());
+}
+
+mitk::Image::ImageDataItemPointer mitk::Image::LoadVolumeData_unlocked(int t, int n) const
+{
+  ImageDataItemPointer vol = AllocateVolumeData_unlocked(t, n, nullptr, CopyMemory);
+  try
+  {
+    m_VolumeLoader->LoadVolume(t, n, vol->m_Data);
+  }
+  catch (...)
+  {
+    m_Volumes[GetVolumeIndex(t, n)] = nullptr;
+    throw;
+  }
+  vol->SetComplete(true);
+
+  LoadedVolume loadedVolume;
+  loadedVolume.t = t;
+  loadedVolume.n = n;
+  loadedVolume.dataMTime = vol->GetDataMTime();
+  m_LoadedVolumes.push_front(loadedVolume);
+
+  return vol;
+}
+
+bool mitk::Image::IsLoadedVolumeReleasable_unlocked(int t, int n) const
+{
+  ImageDataItem *vol = m_Volumes[GetVolumeIndex(t, n)].GetPointer();
+  if (vol == nullptr)
+    return true;
+
+  // part of a channel
+  if (vol->GetParent().IsNotNull())
+    return false;
+
+  if (vol->m_VtkImageData != nullptr && vol->m_VtkImageData->GetReferenceCount() > 1)
+    return false;
+
+  // the volume is referenced by the image and by its slices, anything else uses it
+  int numberOfReferences = 1;
+  for (unsigned int s = 0; s < m_Dimensions[2]; ++s)
+  {
+    ImageDataItem *sl = m_Slices[GetSliceIndex(s, t, n)].GetPointer();
+    if (sl != nullptr && sl->GetParent().GetPointer() == vol)
+    {
+      if (sl->GetReferenceCount() > 1 ||
+          (sl->m_VtkImageData != nullptr && sl->m_VtkImageData->GetReferenceCount() > 1))
+        return false;
+      ++numberOfReferences;
+    }
+  }
+  if (vol->GetReferenceCount() > numberOfReferences)
+    return false;
+
+  const unsigned char *begin = vol->m_Data;
+  const unsigned char *end = begin + vol->m_Size;
+  for (const auto &accessors : {&m_Readers, &m_Writers})
+  {
+    for (ImageAccessorBase *accessor : *accessors)
+    {
+      if (static_cast<const unsigned char *>(accessor->m_AddressBegin) < end &&
+          begin < static_cast<const unsigned char *>(accessor->m_AddressEnd))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+void mitk::Image::ReleaseLoadedVolumes() const
+{
+  // lock like the ImageAccessors, so that no accessor is created while volumes are released
+  m_ReadWriteLock.Lock();
+  {
+    MutexHolder lock(m_ImageDataArraysLock);
+    if (m_VolumeLoader.IsNotNull() && m_MaximumNumberOfResidentVolumes > 0)
+    {
+      auto it = m_LoadedVolumes.end();
+      while (m_LoadedVolumes.size() > m_MaximumNumberOfResidentVolumes && it != m_LoadedVolumes.begin())
+      {
+        --it;
+
+        // changed volumes are kept, the changes would be lost otherwise
+        const ImageDataItem *vol = m_Volumes[GetVolumeIndex(it->t, it->n)].GetPointer();
+        if ((vol != nullptr && vol->GetDataMTime() != it->dataMTime) ||
+            !IsLoadedVolumeReleasable_unlocked(it->t, it->n))
+          continue;
+
+        for (unsigned int s = 0; s < m_Dimensions[2]; ++s)
+        {
+          m_Slices[GetSliceIndex(s, it->t, it->n)] = nullptr;
+        }
+        m_Volumes[GetVolumeIndex(it->t, it->n)] = nullptr;
+        it = m_LoadedVolumes.erase(it);
+      }
+    }
+  }
+  m_ReadWriteLock.Unlock();
+}
+
+void mitk::Image::MarkLoadedVolumesModified(const void *begin, const void *end) const
+{
+  MutexHolder lock(m_ImageDataArraysLock);
+  for (const LoadedVolume &loadedVolume : m_LoadedVolumes)
+  {
+    const ImageDataItem *vol = m_Volumes[GetVolumeIndex(loadedVolume.t, loadedVolume.n)].GetPointer();
+    if (vol != nullptr && static_cast<const unsigned char *>(begin) < vol->m_Data + vol->m_Size &&
+        vol->m_Data < static_cast<const unsigned char *>(end))
+      vol->Modified();
+  }
+}
+
 unsigned int *mitk::Image::GetDimensions() const
 {
   return m_Dimensions;
@@ -307,8 +307,11 @@ void mitk::ImageDataItem::ConstructVtkImageData(ImageConstPointer iP) const
 
 void mitk::ImageDataItem::Modified() const
 {
+  m_DataMTime.Modified();
   if (m_VtkImageData)
     m_VtkImageData->Modified();
+  if (m_Parent.IsNotNull())
+    m_Parent->Modified();
 }
 
 mitk::ImageVtkReadAccessor *mitk::ImageDataItem::GetVtkImageAccessor(mitk::ImageDataItem::ImageConstPointer iP) const
@@ -145,6 +145,9 @@ void mitk::ImageWriteAccessor::OrganizeWriteAccess()
   // insert self into Writers list in Image
   m_Image->m_Writers.push_back(this);
 
+  // volumes provided by a volume loader must not be released after they were written
+  m_Image->MarkLoadedVolumesModified(m_AddressBegin, m_AddressEnd);
+
   // printf("WriteAccess %d %d\n",(int) m_Image->m_Readers.size(),(int) m_Image->m_Writers.size());
   // fflush(0);
   m_Image->m_ReadWriteLock.Unlock();
@@ -23,15 +23,23 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkIPropertyPersistence.h>
 #include <mitkImage.h>
 #include <mitkImageReadAccessor.h>
+#include <mitkImageVolumeLoader.h>
 #include <mitkLocaleSwitch.h>
 
+#include "mitkParallelGzipCompressor.h"
+
 #include <itkImage.h>
 #include <itkImageFileReader.h>
 #include <itkImageIOFactory.h>
 #include <itkImageIORegion.h>
 #include <itkMetaDataObject.h>
 
+#include <itksys/SystemTools.hxx>
+
 #include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
 
 namespace mitk
 {
@@ -40,6 +48,150 @@ namespace mitk
   const char *const PROPERTY_KEY_TIMEGEOMETRY_TYPE = "org_mitk_timegeometry_type";
   const char *const PROPERTY_KEY_TIMEGEOMETRY_TIMEPOINTS = "org_mitk_timegeometry_timepoints";
 
+  const char *const OPTION_LOAD_TIME_STEPS_ON_DEMAND = "Load time steps on demand";
+  const char *const OPTION_MAXIMUM_NUMBER_OF_LOADED_TIME_STEPS = "Maximum number of loaded time steps";
+
+  const char *const OPTION_COMPRESSION = "Compression";
+  const char *const OPTION_COMPRESSION_LEVEL = "Compression level (1-9, parallel gzip)";
+  const char *const COMPRESSION_PARALLEL_GZIP = "Parallel gzip";
+  const char *const COMPRESSION_DEFAULT = "Default";
+  const char *const COMPRESSION_NONE = "None";
+
+  /** Returns the selected value of an option, lists of values are offered with the default value first. */
+  std::string GetSelectedOptionValue(const us::Any &option)
+  {
+    if (option.Type() == typeid(std::vector<std::string>))
+    {
+      const auto values = us::any_cast<std::vector<std::string>>(option);
+      return values.empty() ? std::string() : values.front();
+    }
+    return option.ToString();
+  }
+
+  /**
+   * Writes an NRRD file with attached data whose data is compressed in parallel. The header is written by the
+   * image IO for a single voxel image and the sizes are corrected afterwards, so the data is written only once.
+   * Returns false if the header does not have the expected layout, the image IO is restored in this case.
+   */
+  bool WriteNrrdWithParallelGzip(itk::ImageIOBase *imageIO, const std::string &path, const void *data, int level)
+  {
+    const unsigned int dimension = imageIO->GetNumberOfDimensions();
+    const std::size_t size = imageIO->GetImageSizeInBytes();
+    const itk::ImageIORegion ioRegion = imageIO->GetIORegion();
+    std::vector<itk::SizeValueType> dimensions(dimension);
+
+    itk::ImageIORegion voxelRegion(dimension);
+    for (unsigned int i = 0; i < dimension; ++i)
+    {
+      dimensions[i] = imageIO->GetDimensions(i);
+      imageIO->SetDimensions(i, 1);
+      voxelRegion.SetSize(i, 1);
+    }
+    imageIO->SetIORegion(voxelRegion);
+    imageIO->UseCompressionOff();
+    imageIO->Write(data);
+
+    for (unsigned int i = 0; i < dimension; ++i)
+      imageIO->SetDimensions(i, dimensions[i]);
+    imageIO->SetIORegion(ioRegion);
+
+    std::string header;
+    {
+      std::ifstream file(path.c_str(), std::ios::binary);
+
+      // the header ends with an empty line
+      bool rawEncoding = false;
+      bool sizesReplaced = false;
+      std::string line;
+      while (std::getline(file, line))
+      {
+        if (line == "encoding: raw")
+        {
+          rawEncoding = true;
+          line = "encoding: gzip";
+        }
+        else if (line.compare(0, 7, "sizes: ") == 0)
+        {
+          // the last sizes are the image dimensions, a leading size is the number of components
+          std::istringstream stream(line.substr(7));
+          std::vector<std::string> sizes((std::istream_iterator<std::string>(stream)), std::istream_iterator<std::string>());
+          if (sizes.size() < dimension)
+            return false;
+
+          const std::size_t firstDimension = sizes.size() - dimension;
+          std::ostringstream newLine;
+          newLine << "sizes:";
+          for (std::size_t i = 0; i < sizes.size(); ++i)
+          {
+            if (i < firstDimension)
+            {
+              newLine << ' ' << sizes[i];
+              continue;
+            }
+            if (sizes[i] != "1")
+              return false;
+            newLine << ' ' << dimensions[i - firstDimension];
+          }
+          line = newLine.str();
+          sizesReplaced = true;
+        }
+        header += line + '\n';
+        if (line.empty())
+          break;
+      }
+
+      if (!file || !rawEncoding || !sizesReplaced)
+        return false;
+
+      // nothing but the voxel may follow the header
+      const std::streamoff dataOffset = file.tellg();
+      file.seekg(0, std::ios::end);
+      if (file.tellg() - dataOffset != static_cast<std::streamoff>(imageIO->GetPixelSize()))
+        return false;
+    }
+
+    std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+    file.write(header.data(), header.size());
+    ParallelGzipCompressor::Compress(data, size, file, level);
+    return static_cast<bool>(file);
+  }
+
+  /** Reads single time steps of a 4D image file by streaming the region of the time step. */
+  class ItkImageIOVolumeLoader : public ImageVolumeLoader
+  {
+  public:
+    mitkClassMacro(ItkImageIOVolumeLoader, ImageVolumeLoader);
+    mitkNewMacro1Param(Self, itk::ImageIOBase *);
+
+    void LoadVolume(unsigned int t, unsigned int n, void *buffer) override
+    {
+      if (n != 0)
+      {
+        mitkThrow() << "Image files provide only one channel";
+      }
+
+      mitk::LocaleSwitch localeSwitch("C");
+
+      itk::ImageIORegion ioRegion(m_ImageIO->GetNumberOfDimensions());
+      for (unsigned int i = 0; i < ioRegion.GetImageDimension(); ++i)
+      {
+        ioRegion.SetIndex(i, 0);
+        ioRegion.SetSize(i, m_ImageIO->GetDimensions(i));
+      }
+      ioRegion.SetIndex(3, t);
+      ioRegion.SetSize(3, 1);
+
+      // the image locks its data arrays while loading, so the ImageIO is never used concurrently
+      m_ImageIO->SetIORegion(ioRegion);
+      m_ImageIO->Read(buffer);
+    }
+
+  protected:
+    ItkImageIOVolumeLoader(itk::ImageIOBase *imageIO) : m_ImageIO(imageIO) {}
+
+    itk::ImageIOBase::Pointer m_ImageIO;
+  };
+
   ItkImageIO::ItkImageIO(const ItkImageIO &other)
     : AbstractFileIO(other), m_ImageIO(dynamic_cast<itk::ImageIOBase *>(other.m_ImageIO->Clone().GetPointer()))
   {
@@ -108,6 +260,8 @@ namespace mitk
 
     this->AbstractFileReader::SetMimeTypePrefix(IOMimeTypes::DEFAULT_BASE_NAME() + ".image.");
     this->InitializeDefaultMetaDataKeys();
+    this->InitializeDefaultReaderOptions();
+    this->InitializeDefaultWriterOptions();
 
     std::vector<std::string> readExtensions = m_ImageIO->GetSupportedReadExtensions();
 
@@ -177,6 +331,8 @@ namespace mitk
 
     this->AbstractFileReader::SetMimeTypePrefix(IOMimeTypes::DEFAULT_BASE_NAME() + ".image.");
     this->InitializeDefaultMetaDataKeys();
+    this->InitializeDefaultReaderOptions();
+    this->InitializeDefaultWriterOptions();
 
     if (rank)
     {
@@ -283,12 +439,51 @@ namespace mitk
     ioRegion.SetIndex(ioStart);
 
     MITK_INFO << "ioRegion: " << ioRegion << std::endl;
-    m_ImageIO->SetIORegion(ioRegion);
-    void *buffer = new unsigned char[m_ImageIO->GetImageSizeInBytes()];
-    m_ImageIO->Read(buffer);
+
+    const Options options = this->GetReaderOptions();
+    bool loadTimeStepsOnDemand = us::any_cast<bool>(options.find(OPTION_LOAD_TIME_STEPS_ON_DEMAND)->second);
+    if (loadTimeStepsOnDemand)
+    {
+      if (m_ImageIO->GetNumberOfDimensions() != MAXDIM || dimensions[3] < 2)
+      {
+        loadTimeStepsOnDemand = false;
+      }
+      else if (this->GetInputStream() != nullptr)
+      {
+        MITK_WARN << "Time steps cannot be loaded on demand from a stream, loading all time steps";
+        loadTimeStepsOnDemand = false;
+      }
+      else if (!m_ImageIO->CanStreamRead())
+      {
+        MITK_WARN << m_ImageIO->GetNameOfClass() << " cannot read single time steps, loading all time steps";
+        loadTimeStepsOnDemand = false;
+      }
+    }
 
     image->Initialize(MakePixelType(m_ImageIO), ndim, dimensions);
-    image->SetImportChannel(buffer, 0, Image::ManageMemory);
+
+    if (loadTimeStepsOnDemand)
+    {
+      // the loader reads the file with its own ImageIO, since this one is shared by all reads
+      itk::ImageIOBase::Pointer imageIO = dynamic_cast<itk::ImageIOBase *>(m_ImageIO->Clone().GetPointer());
+      imageIO->SetFileName(path);
+      imageIO->ReadImageInformation();
+
+      const int maximumNumberOfLoadedTimeSteps =
+        us::any_cast<int>(options.find(OPTION_MAXIMUM_NUMBER_OF_LOADED_TIME_STEPS)->second);
+      image->SetVolumeLoader(ItkImageIOVolumeLoader::New(imageIO).GetPointer(),
+                             static_cast<unsigned int>(std::max(maximumNumberOfLoadedTimeSteps, 0)));
+
+      MITK_INFO << "loading the " << dimensions[3] << " time steps on demand";
+    }
+    else
+    {
+      m_ImageIO->SetIORegion(ioRegion);
+      void *buffer = new unsigned char[m_ImageIO->GetImageSizeInBytes()];
+      m_ImageIO->Read(buffer);
+
+      image->SetImportChannel(buffer, 0, Image::ManageMemory);
+    }
 
     const itk::MetaDataDictionary &dictionary = m_ImageIO->GetMetaDataDictionary();
 
@@ -378,7 +573,6 @@ namespace mitk
 
     image->SetTimeGeometry(timeGeometry);
 
-    buffer = nullptr;
     MITK_INFO << "number of image components: " << image->GetPixelType().GetNumberOfComponents() << std::endl;
 
     for (auto iter = dictionary.Begin(), iterEnd = dictionary.End(); iter != iterEnd;
@@ -571,8 +765,15 @@ namespace mitk
         ioRegion.SetIndex(i, image->GetLargestPossibleRegion().GetIndex(i));
       }
 
+      // NRRD data is compressed in parallel after ITK has written the header
+      const Options options = this->GetWriterOptions();
+      const std::string compression = GetSelectedOptionValue(options.find(OPTION_COMPRESSION)->second);
+      const bool parallelGzip = compression == COMPRESSION_PARALLEL_GZIP &&
+                                std::string(m_ImageIO->GetNameOfClass()) == "NrrdImageIO" &&
+                                itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(path)) == ".nrrd";
+
       // use compression if available
-      m_ImageIO->UseCompressionOn();
+      m_ImageIO->SetUseCompression(compression != COMPRESSION_NONE && !parallelGzip);
 
       m_ImageIO->SetIORegion(ioRegion);
       m_ImageIO->SetFileName(path);
@@ -623,6 +824,17 @@ namespace mitk
       }
 
       ImageReadAccessor imageAccess(image);
+
+      if (parallelGzip)
+      {
+        const int level = std::min(std::max(us::any_cast<int>(options.find(OPTION_COMPRESSION_LEVEL)->second), 1), 9);
+        if (WriteNrrdWithParallelGzip(m_ImageIO, path, imageAccess.GetData(), level))
+          return;
+
+        MITK_WARN << "Unexpected NRRD header, using the sequential compression of " << m_ImageIO->GetNameOfClass();
+        m_ImageIO->UseCompressionOn();
+      }
+
       m_ImageIO->Write(imageAccess.GetData());
     }
     catch (const std::exception &e)
@@ -668,4 +880,26 @@ namespace mitk
     this->m_DefaultMetaDataKeys.push_back(PROPERTY_NAME_TIMEGEOMETRY_TIMEPOINTS);
     this->m_DefaultMetaDataKeys.push_back("ITK.InputFilterName");
   }
+
+  void ItkImageIO::InitializeDefaultReaderOptions()
+  {
+    Options defaultOptions;
+    defaultOptions[OPTION_LOAD_TIME_STEPS_ON_DEMAND] = false;
+    defaultOptions[OPTION_MAXIMUM_NUMBER_OF_LOADED_TIME_STEPS] = 8;
+    this->SetDefaultReaderOptions(defaultOptions);
+  }
+
+  void ItkImageIO::InitializeDefaultWriterOptions()
+  {
+    Options defaultOptions;
+
+    std::vector<std::string> compression;
+    compression.push_back(COMPRESSION_PARALLEL_GZIP);
+    compression.push_back(COMPRESSION_DEFAULT);
+    compression.push_back(COMPRESSION_NONE);
+    defaultOptions[OPTION_COMPRESSION] = compression;
+    defaultOptions[OPTION_COMPRESSION_LEVEL] = 6;
+
+    this->SetDefaultWriterOptions(defaultOptions);
+  }
 }
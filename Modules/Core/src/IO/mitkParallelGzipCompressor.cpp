@@ -0,0 +1,157 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkParallelGzipCompressor.h"
+
+#include <mitkExceptionMacro.h>
+
+#include <itk_zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  struct Block
+  {
+    const unsigned char *data;
+    std::size_t size;
+    bool last;
+    uLong crc;
+    std::vector<unsigned char> compressed;
+  };
+
+  // deflates the block without zlib or gzip wrapper, returns an error message on failure
+  std::string DeflateBlock(Block &block, int level)
+  {
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+      return "Could not initialize zlib";
+
+    // the bound does not include the empty block of the sync flush
+    block.compressed.resize(deflateBound(&stream, static_cast<uLong>(block.size)) + 16);
+
+    stream.next_in = const_cast<Bytef *>(block.data);
+    stream.avail_in = static_cast<uInt>(block.size);
+    stream.next_out = block.compressed.data();
+    stream.avail_out = static_cast<uInt>(block.compressed.size());
+
+    const int flush = block.last ? Z_FINISH : Z_SYNC_FLUSH;
+    while (true)
+    {
+      const int result = deflate(&stream, flush);
+      if (result == Z_STREAM_ERROR)
+      {
+        deflateEnd(&stream);
+        return "zlib stream error";
+      }
+
+      const bool done = block.last ? result == Z_STREAM_END : stream.avail_out != 0;
+      if (done)
+        break;
+
+      // not expected, but output space is simply extended
+      const std::size_t used = block.compressed.size() - stream.avail_out;
+      block.compressed.resize(block.compressed.size() * 2);
+      stream.next_out = block.compressed.data() + used;
+      stream.avail_out = static_cast<uInt>(block.compressed.size() - used);
+    }
+
+    block.compressed.resize(block.compressed.size() - stream.avail_out);
+    deflateEnd(&stream);
+
+    block.crc = crc32(crc32(0L, Z_NULL, 0), block.data, static_cast<uInt>(block.size));
+    return std::string();
+  }
+
+  void WriteLittleEndian32(std::ostream &stream, uLong value)
+  {
+    char bytes[4];
+    for (int i = 0; i < 4; ++i)
+      bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    stream.write(bytes, 4);
+  }
+}
+
+void mitk::ParallelGzipCompressor::Compress(
+  const void *data, std::size_t size, std::ostream &stream, int level, unsigned int numberOfThreads, std::size_t blockSize)
+{
+  if (numberOfThreads == 0)
+    numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  blockSize = std::max<std::size_t>(blockSize, 64 * 1024);
+  const std::size_t numberOfBlocks = std::max<std::size_t>(1, (size + blockSize - 1) / blockSize);
+
+  // gzip header: deflate, no flags, no modification time, unknown OS
+  const char header[10] = {'\x1f', '\x8b', '\x08', 0, 0, 0, 0, 0, 0, '\xff'};
+  stream.write(header, sizeof(header));
+
+  // blocks are compressed in groups, so that the compressed data of only a few blocks per thread is held in memory
+  const std::size_t blocksPerGroup = 4 * numberOfThreads;
+  const auto *bytes = static_cast<const unsigned char *>(data);
+  uLong crc = crc32(0L, Z_NULL, 0);
+
+  std::vector<Block> blocks;
+  for (std::size_t firstBlock = 0; firstBlock < numberOfBlocks; firstBlock += blocksPerGroup)
+  {
+    const std::size_t groupSize = std::min(blocksPerGroup, numberOfBlocks - firstBlock);
+    blocks.resize(groupSize);
+    for (std::size_t i = 0; i < groupSize; ++i)
+    {
+      const std::size_t offset = (firstBlock + i) * blockSize;
+      blocks[i].data = bytes + offset;
+      blocks[i].size = std::min(blockSize, size - std::min(size, offset));
+      blocks[i].last = firstBlock + i == numberOfBlocks - 1;
+    }
+
+    std::atomic<std::size_t> nextBlock(0);
+    std::vector<std::string> errors(groupSize);
+    auto deflateBlocks = [&]() {
+      for (std::size_t i = nextBlock++; i < groupSize; i = nextBlock++)
+        errors[i] = DeflateBlock(blocks[i], level);
+    };
+
+    std::vector<std::thread> threads;
+    const auto numberOfGroupThreads = static_cast<unsigned int>(std::min<std::size_t>(numberOfThreads, groupSize));
+    for (unsigned int i = 1; i < numberOfGroupThreads; ++i)
+      threads.emplace_back(deflateBlocks);
+    deflateBlocks();
+    for (auto &thread : threads)
+      thread.join();
+
+    for (std::size_t i = 0; i < groupSize; ++i)
+    {
+      if (!errors[i].empty())
+        mitkThrow() << "Compression failed: " << errors[i];
+
+      stream.write(reinterpret_cast<const char *>(blocks[i].compressed.data()), blocks[i].compressed.size());
+      crc = crc32_combine(crc, blocks[i].crc, static_cast<z_off_t>(blocks[i].size));
+    }
+  }
+
+  // gzip trailer: CRC-32 and size modulo 2^32
+  WriteLittleEndian32(stream, crc);
+  WriteLittleEndian32(stream, static_cast<uLong>(size & 0xffffffffu));
+
+  if (!stream)
+    mitkThrow() << "Writing the compressed data failed";
+}
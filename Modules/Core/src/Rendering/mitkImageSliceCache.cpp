@@ -0,0 +1,321 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkImageSliceCache.h"
+
+#include <mitkImageReadAccessor.h>
+#include <mitkLogMacros.h>
+
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+
+namespace
+{
+  // tolerance for comparing plane geometries in mm; predicted prefetch planes differ
+  // from the planes of the slice navigation only by rounding errors
+  const mitk::ScalarType planeTolerance = 1e-6;
+}
+
+mitk::ImageSliceCache::SliceKey::SliceKey()
+  : image(nullptr),
+    imageMTime(0),
+    timeStep(0),
+    referenceGeometry(nullptr),
+    interpolationMode(ExtractSliceFilter::RESLICE_NEAREST),
+    inPlaneResampleExtentByGeometry(false)
+{
+  extent[0] = extent[1] = 0;
+}
+
+mitk::ImageSliceCache::SliceKey::SliceKey(const Image *image,
+                                          int timeStep,
+                                          const PlaneGeometry *planeGeometry,
+                                          ExtractSliceFilter::ResliceInterpolation interpolationMode,
+                                          bool inPlaneResampleExtentByGeometry)
+  : image(image),
+    imageMTime(image->GetMTime()),
+    timeStep(timeStep),
+    referenceGeometry(planeGeometry->GetReferenceGeometry()),
+    origin(planeGeometry->GetOrigin()),
+    axis0(planeGeometry->GetAxisVector(0)),
+    axis1(planeGeometry->GetAxisVector(1)),
+    interpolationMode(interpolationMode),
+    inPlaneResampleExtentByGeometry(inPlaneResampleExtentByGeometry)
+{
+  extent[0] = planeGeometry->GetExtent(0);
+  extent[1] = planeGeometry->GetExtent(1);
+}
+
+bool mitk::ImageSliceCache::SliceKey::Matches(const SliceKey &other) const
+{
+  return image == other.image && imageMTime == other.imageMTime && timeStep == other.timeStep &&
+         referenceGeometry == other.referenceGeometry && interpolationMode == other.interpolationMode &&
+         inPlaneResampleExtentByGeometry == other.inPlaneResampleExtentByGeometry &&
+         Equal(extent[0], other.extent[0], planeTolerance) && Equal(extent[1], other.extent[1], planeTolerance) &&
+         Equal(origin, other.origin, planeTolerance) && Equal(axis0, other.axis0, planeTolerance) &&
+         Equal(axis1, other.axis1, planeTolerance);
+}
+
+mitk::ImageSliceCache *mitk::ImageSliceCache::GetInstance()
+{
+  static ImageSliceCache instance;
+  return &instance;
+}
+
+mitk::ImageSliceCache::ImageSliceCache()
+  : m_Size(0),
+    m_MaximumSize(256ULL * 1024 * 1024),
+    m_NumberOfPrefetchedSlices(4),
+    m_Enabled(true),
+    m_StopPrefetching(false)
+{
+}
+
+mitk::ImageSliceCache::~ImageSliceCache()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_StopPrefetching = true;
+    m_PrefetchJobs.clear();
+  }
+  m_PrefetchCondition.notify_all();
+
+  if (m_PrefetchThread.joinable())
+    m_PrefetchThread.join();
+}
+
+bool mitk::ImageSliceCache::Get(const SliceKey &key, Slice &slice)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  if (!m_Enabled)
+    return false;
+
+  for (auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+  {
+    if (it->key.Matches(key))
+    {
+      // move to the front of the LRU list
+      m_Entries.splice(m_Entries.begin(), m_Entries, it);
+      slice = m_Entries.front().slice;
+      return true;
+    }
+  }
+  return false;
+}
+
+void mitk::ImageSliceCache::Add(const SliceKey &key, ExtractSliceFilter *reslicer)
+{
+  vtkImageData *output = reslicer->GetVtkOutput();
+  if (!this->GetEnabled() || output == nullptr)
+    return;
+
+  // the output of the reslicer is reused for the next slice, so it is copied
+  Slice slice;
+  slice.image = vtkSmartPointer<vtkImageData>::New();
+  slice.image->DeepCopy(output);
+  slice.resliceAxes = vtkSmartPointer<vtkMatrix4x4>::New();
+  slice.resliceAxes->DeepCopy(reslicer->GetResliceAxes());
+  slice.spacing[0] = reslicer->GetOutputSpacing()[0];
+  slice.spacing[1] = reslicer->GetOutputSpacing()[1];
+
+  this->Insert(key, slice);
+}
+
+void mitk::ImageSliceCache::Insert(const SliceKey &key, const Slice &slice)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  if (!m_Enabled || this->Contains(key))
+    return;
+
+  Entry entry;
+  entry.key = key;
+  entry.slice = slice;
+  entry.size = static_cast<unsigned long long>(slice.image->GetActualMemorySize()) * 1024;
+
+  m_Entries.push_front(entry);
+  m_Size += entry.size;
+  this->Shrink();
+}
+
+bool mitk::ImageSliceCache::Contains(const SliceKey &key) const
+{
+  for (const auto &entry : m_Entries)
+  {
+    if (entry.key.Matches(key))
+      return true;
+  }
+  return false;
+}
+
+void mitk::ImageSliceCache::Shrink()
+{
+  while (m_Size > m_MaximumSize && !m_Entries.empty())
+  {
+    m_Size -= m_Entries.back().size;
+    m_Entries.pop_back();
+  }
+}
+
+void mitk::ImageSliceCache::Prefetch(const SliceKey &key,
+                                     Image *image,
+                                     const PlaneGeometry *planeGeometry,
+                                     const Vector3D &offset)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  // only the slices ahead of the latest scroll position are of interest
+  m_PrefetchJobs.clear();
+
+  if (!m_Enabled || m_NumberOfPrefetchedSlices == 0 || image == nullptr || planeGeometry == nullptr)
+    return;
+
+  for (unsigned int i = 1; i <= m_NumberOfPrefetchedSlices; ++i)
+  {
+    PrefetchJob job;
+    job.key = key;
+    job.key.origin = key.origin + offset * static_cast<ScalarType>(i);
+
+    if (this->Contains(job.key))
+      continue;
+
+    job.image = image;
+    job.planeGeometry = planeGeometry->Clone();
+    job.planeGeometry->SetOrigin(job.key.origin);
+    m_PrefetchJobs.push_back(job);
+  }
+
+  if (m_PrefetchJobs.empty())
+    return;
+
+  if (!m_PrefetchThread.joinable())
+    m_PrefetchThread = std::thread(&ImageSliceCache::PrefetchLoop, this);
+
+  m_PrefetchCondition.notify_one();
+}
+
+void mitk::ImageSliceCache::PrefetchLoop()
+{
+  while (true)
+  {
+    PrefetchJob job;
+    {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      m_PrefetchCondition.wait(lock, [this] { return m_StopPrefetching || !m_PrefetchJobs.empty(); });
+
+      if (m_StopPrefetching)
+        return;
+
+      job = m_PrefetchJobs.front();
+      m_PrefetchJobs.pop_front();
+
+      if (this->Contains(job.key))
+        continue;
+    }
+
+    this->ComputeSlice(job);
+  }
+}
+
+void mitk::ImageSliceCache::ComputeSlice(const PrefetchJob &job)
+{
+  try
+  {
+    if (!job.image->IsVolumeSet(job.key.timeStep))
+      return;
+
+    // The slice is extracted from a separate image that references the pixel data of the
+    // time step, so that the pipeline of the rendered image is not touched by this thread.
+    // The read accessor prevents concurrent writes to the data.
+    ImageReadAccessor accessor(job.image, job.image->GetVolumeData(job.key.timeStep));
+
+    auto volume = Image::New();
+    volume->Initialize(job.image->GetPixelType(), *job.image->GetTimeGeometry()->GetGeometryForTimeStep(job.key.timeStep));
+    volume->SetImportVolume(const_cast<void *>(accessor.GetData()), 0, 0, Image::ReferenceMemory);
+
+    auto reslicer = ExtractSliceFilter::New();
+    reslicer->SetInput(volume);
+    reslicer->SetWorldGeometry(job.planeGeometry);
+    reslicer->SetTimeStep(0);
+    reslicer->SetResliceTransformByGeometry(volume->GetGeometry());
+    reslicer->SetInPlaneResampleExtentByGeometry(job.key.inPlaneResampleExtentByGeometry);
+    reslicer->SetInterpolationMode(static_cast<ExtractSliceFilter::ResliceInterpolation>(job.key.interpolationMode));
+    reslicer->SetVtkOutputRequest(true);
+    reslicer->Update();
+
+    this->Add(job.key, reslicer);
+  }
+  catch (const std::exception &e)
+  {
+    MITK_WARN << "Prefetching of image slice failed: " << e.what();
+  }
+}
+
+void mitk::ImageSliceCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Entries.clear();
+  m_PrefetchJobs.clear();
+  m_Size = 0;
+}
+
+void mitk::ImageSliceCache::SetEnabled(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Enabled = enabled;
+  if (!m_Enabled)
+  {
+    m_Entries.clear();
+    m_PrefetchJobs.clear();
+    m_Size = 0;
+  }
+}
+
+bool mitk::ImageSliceCache::GetEnabled() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Enabled;
+}
+
+void mitk::ImageSliceCache::SetMaximumSize(unsigned long long size)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_MaximumSize = size;
+  this->Shrink();
+}
+
+unsigned long long mitk::ImageSliceCache::GetMaximumSize() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_MaximumSize;
+}
+
+void mitk::ImageSliceCache::SetNumberOfPrefetchedSlices(unsigned int number)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_NumberOfPrefetchedSlices = number;
+}
+
+unsigned int mitk::ImageSliceCache::GetNumberOfPrefetchedSlices() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_NumberOfPrefetchedSlices;
+}
+
+unsigned int mitk::ImageSliceCache::GetNumberOfSlices() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return static_cast<unsigned int>(m_Entries.size());
+}
@@ -28,6 +28,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkVtkResliceInterpolationProperty.h>
 
 //#include <mitkTransferFunction.h>
+#include "mitkImageSliceCache.h"
 #include "mitkImageStatisticsHolder.h"
 #include "mitkPlaneClipping.h"
 #include <mitkTransferFunctionProperty.h>
@@ -56,6 +57,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkTransform.h>
 
 // ITK
+#include <itkMath.h>
 #include <itkRGBAPixel.h>
 #include <mitkRenderingModeProperty.h>
 
@@ -228,9 +230,12 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer(mitk::BaseRenderer *rendere
   }
 
   const auto *planeGeometry = dynamic_cast<const PlaneGeometry *>(worldGeometry);
+  bool sliceFromCache = false;
 
   if (thickSlicesMode > 0)
   {
+    localStorage->m_LastSliceKeyValid = false;
+
     double dataZSpacing = 1.0;
 
     Vector3D normInIndex, normal;
@@ -264,6 +269,52 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer(mitk::BaseRenderer *rendere
     localStorage->m_TSFilter->SetThickSliceMode(thickSlicesMode - 1);
     localStorage->m_TSFilter->SetInputData(localStorage->m_Reslicer->GetVtkOutput());
 
+    // If only the plane was moved along its normal by exactly one slice of the slab
+    // (e.g. when scrolling), the filter can reuse the previous slab.
+    int slabShift = 0;
+    if (abstractGeometry == nullptr && planeGeometry != nullptr)
+    {
+      const Point3D origin = planeGeometry->GetOrigin();
+      const Vector3D axis0 = planeGeometry->GetAxisVector(0);
+      const Vector3D axis1 = planeGeometry->GetAxisVector(1);
+      const int interpolation = localStorage->m_Reslicer->GetInterpolationMode();
+
+      if (localStorage->m_LastSlabValid && localStorage->m_LastSlabMode == thickSlicesMode &&
+          localStorage->m_LastSlabNum == thickSlicesNum && localStorage->m_LastSlabInterpolation == interpolation &&
+          localStorage->m_LastSlabTimeStep == this->GetTimestep() &&
+          localStorage->m_LastSlabImageMTime == image->GetMTime() &&
+          Equal(localStorage->m_LastSlabZSpacing, dataZSpacing, sqrteps) &&
+          Equal(localStorage->m_LastSlabAxis0, axis0, sqrteps) && Equal(localStorage->m_LastSlabAxis1, axis1, sqrteps))
+      {
+        const Vector3D offset = origin - localStorage->m_LastSlabOrigin;
+        const double offsetAlongNormal = offset * normal;
+        const double slices = offsetAlongNormal / dataZSpacing;
+        const int roundedSlices = itk::Math::Round<int>(slices);
+
+        // the plane must not have moved within the plane and must match the slice grid
+        const double tolerance = 1e-3;
+        if ((offset - normal * offsetAlongNormal).GetNorm() < tolerance * dataZSpacing &&
+            std::abs(slices - roundedSlices) < tolerance)
+          slabShift = roundedSlices;
+      }
+
+      localStorage->m_LastSlabValid = true;
+      localStorage->m_LastSlabOrigin = origin;
+      localStorage->m_LastSlabAxis0 = axis0;
+      localStorage->m_LastSlabAxis1 = axis1;
+      localStorage->m_LastSlabZSpacing = dataZSpacing;
+      localStorage->m_LastSlabMode = thickSlicesMode;
+      localStorage->m_LastSlabNum = thickSlicesNum;
+      localStorage->m_LastSlabInterpolation = interpolation;
+      localStorage->m_LastSlabTimeStep = this->GetTimestep();
+      localStorage->m_LastSlabImageMTime = image->GetMTime();
+    }
+    else
+    {
+      localStorage->m_LastSlabValid = false;
+    }
+    localStorage->m_TSFilter->SetSlidingWindowShift(slabShift);
+
     // vtkFilter=>mitkFilter=>vtkFilter update mechanism will fail without calling manually
     localStorage->m_Reslicer->Modified();
     localStorage->m_Reslicer->Update();
@@ -274,17 +325,73 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer(mitk::BaseRenderer *rendere
   }
   else
   {
+    localStorage->m_LastSlabValid = false;
+
     // this is needed when thick mode was enable bevore. These variable have to be reset to default values
     localStorage->m_Reslicer->SetOutputDimensionality(2);
     localStorage->m_Reslicer->SetOutputSpacingZDirection(1.0);
     localStorage->m_Reslicer->SetOutputExtentZDirection(0, 0);
 
-    localStorage->m_Reslicer->Modified();
-    // start the pipeline with updating the largest possible, needed if the geometry of the input has changed
-    localStorage->m_Reslicer->UpdateLargestPossibleRegion();
-    localStorage->m_ReslicedImage = localStorage->m_Reslicer->GetVtkOutput();
+    // Slices of plane geometries are shared by all renderers via the slice cache
+    ImageSliceCache *sliceCache = ImageSliceCache::GetInstance();
+    const bool useSliceCache = sliceCache->GetEnabled() && planeGeometry != nullptr &&
+                               dynamic_cast<const AbstractTransformGeometry *>(worldGeometry) == nullptr;
+
+    ImageSliceCache::SliceKey sliceKey;
+    ImageSliceCache::Slice cachedSlice;
+    if (useSliceCache)
+    {
+      sliceKey = ImageSliceCache::SliceKey(image,
+                                           this->GetTimestep(),
+                                           planeGeometry,
+                                           localStorage->m_Reslicer->GetInterpolationMode(),
+                                           inPlaneResampleExtentByGeometry);
+      sliceFromCache = sliceCache->Get(sliceKey, cachedSlice);
+    }
+
+    if (sliceFromCache)
+    {
+      localStorage->m_ReslicedImage = cachedSlice.image;
+      localStorage->m_ResliceAxes = cachedSlice.resliceAxes;
+      localStorage->m_CachedSliceSpacing[0] = cachedSlice.spacing[0];
+      localStorage->m_CachedSliceSpacing[1] = cachedSlice.spacing[1];
+    }
+    else
+    {
+      localStorage->m_Reslicer->Modified();
+      // start the pipeline with updating the largest possible, needed if the geometry of the input has changed
+      localStorage->m_Reslicer->UpdateLargestPossibleRegion();
+      localStorage->m_ReslicedImage = localStorage->m_Reslicer->GetVtkOutput();
+
+      if (useSliceCache)
+        sliceCache->Add(sliceKey, localStorage->m_Reslicer);
+    }
+
+    if (useSliceCache)
+    {
+      // when scrolling, prefetch the next slices in scroll direction
+      const ImageSliceCache::SliceKey &lastKey = localStorage->m_LastSliceKey;
+      if (localStorage->m_LastSliceKeyValid && lastKey.image == sliceKey.image &&
+          lastKey.imageMTime == sliceKey.imageMTime && lastKey.timeStep == sliceKey.timeStep &&
+          lastKey.referenceGeometry == sliceKey.referenceGeometry && Equal(lastKey.axis0, sliceKey.axis0) &&
+          Equal(lastKey.axis1, sliceKey.axis1))
+      {
+        Vector3D normal = planeGeometry->GetNormal();
+        normal.Normalize();
+        const Vector3D offset = sliceKey.origin - lastKey.origin;
+        const ScalarType offsetAlongNormal = offset * normal;
+
+        if (std::abs(offsetAlongNormal) > sqrteps && (offset - normal * offsetAlongNormal).GetNorm() < sqrteps)
+          sliceCache->Prefetch(sliceKey, image, planeGeometry, offset);
+      }
+      localStorage->m_LastSliceKey = sliceKey;
+    }
+    localStorage->m_LastSliceKeyValid = useSliceCache;
   }
 
+  if (!sliceFromCache)
+    localStorage->m_ResliceAxes = localStorage->m_Reslicer->GetResliceAxes();
+
   // Bounds information for reslicing (only reuqired if reference geometry
   // is present)
   // this used for generating a vtkPLaneSource with the right size
@@ -296,7 +403,8 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer(mitk::BaseRenderer *rendere
   localStorage->m_Reslicer->GetClippedPlaneBounds(sliceBounds);
 
   // get the spacing of the slice
-  localStorage->m_mmPerPixel = localStorage->m_Reslicer->GetOutputSpacing();
+  localStorage->m_mmPerPixel =
+    sliceFromCache ? localStorage->m_CachedSliceSpacing : localStorage->m_Reslicer->GetOutputSpacing();
 
   // calculate minimum bounding rect of IMAGE in texture
   {
@@ -1033,7 +1141,7 @@ void mitk::ImageVtkMapper2D::TransformActor(mitk::BaseRenderer *renderer)
   LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
   // get the transformation matrix of the reslicer in order to render the slice as axial, coronal or saggital
   vtkSmartPointer<vtkTransform> trans = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkMatrix4x4> matrix = localStorage->m_Reslicer->GetResliceAxes();
+  vtkSmartPointer<vtkMatrix4x4> matrix = localStorage->m_ResliceAxes;
   trans->SetMatrix(matrix);
   // transform the plane/contour (the actual actor) to the corresponding view (axial, coronal or saggital)
   localStorage->m_Actor->SetUserTransform(trans);
@@ -1097,6 +1205,15 @@ mitk::ImageVtkMapper2D::LocalStorage::LocalStorage()
   m_Actors = vtkSmartPointer<vtkPropAssembly>::New();
   m_Reslicer = mitk::ExtractSliceFilter::New();
   m_TSFilter = vtkSmartPointer<vtkMitkThickSlicesFilter>::New();
+  m_LastSlabValid = false;
+  m_LastSlabZSpacing = 1.0;
+  m_LastSlabMode = 0;
+  m_LastSlabNum = 0;
+  m_LastSlabInterpolation = 0;
+  m_LastSlabTimeStep = 0;
+  m_LastSlabImageMTime = 0;
+  m_LastSliceKeyValid = false;
+  m_CachedSliceSpacing[0] = m_CachedSliceSpacing[1] = 1.0;
   m_OutlinePolyData = vtkSmartPointer<vtkPolyData>::New();
   m_ReslicedImage = vtkSmartPointer<vtkImageData>::New();
   m_EmptyPolyData = vtkSmartPointer<vtkPolyData>::New();
@@ -29,6 +29,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 // used for acos etc.
 #include <cmath>
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 // used for PI
 #include <itkMath.h>
 
@@ -39,7 +43,13 @@ static const double PI = itk::Math::pi;
 vtkStandardNewMacro(vtkMitkLevelWindowFilter);
 
 vtkMitkLevelWindowFilter::vtkMitkLevelWindowFilter()
-  : m_LookupTable(nullptr), m_OpacityFunction(nullptr), m_MinOpacity(0.0), m_MaxOpacity(255.0)
+  : m_LookupTable(nullptr),
+    m_OpacityFunction(nullptr),
+    m_MinOpacity(0.0),
+    m_MaxOpacity(255.0),
+    m_UseValueTable(false),
+    m_ValueTableScalarType(-1),
+    m_ValueTableTime(0)
 {
   // MITK_INFO << "mitk level/window filter uses " << GetNumberOfThreads() << " thread(s)";
 }
@@ -144,6 +154,21 @@ void HSItoRGB(T *HSI, T *RGB)
   RGB[2] = (T)(B < 0 ? 0 : (B > 255 ? 255 : B));
 }
 
+// Internal method which should never be used anywhere else and should not be in th header.
+//----------------------------------------------------------------------------
+// Computes the part [begin, end) of an output row (relative to outExt[0]) that lies within
+// the horizontal clipping bounds, so that the inner loops need no bounds checks.
+static void vtkGetClippedRowRange(const int outExt[6], const double *clippingBounds, int &begin, int &end)
+{
+  const int rowLength = outExt[1] - outExt[0] + 1;
+
+  begin = static_cast<int>(std::ceil(clippingBounds[0])) - outExt[0];
+  end = static_cast<int>(std::ceil(clippingBounds[1])) - outExt[0];
+
+  begin = std::max(0, std::min(begin, rowLength));
+  end = std::max(begin, std::min(end, rowLength));
+}
+
 // Internal method which should never be used anywhere else and should not be in th header.
 //----------------------------------------------------------------------------
 // This templated function executes the filter for any type of data.
@@ -184,93 +209,112 @@ void vtkApplyLookupTableOnRGBA(vtkMitkLevelWindowFilter *self,
     T *outputSI = outputIt.BeginSpan();
     T *outputSIEnd = outputIt.EndSpan();
 
+    // pixels outside of the clipping bounds are transparent
+    int begin = 0;
+    int end = 0;
     if (y >= clippingBounds[2] && y < clippingBounds[3])
+      vtkGetClippedRowRange(outExt, clippingBounds, begin, end);
+
+    std::fill(outputSI, outputSI + 4 * begin, T(0));
+    inputSI += maxC * begin;
+    outputSI += 4 * begin;
+
+    for (int x = begin; x < end; x++)
     {
-      int x = outExt[0];
+      double rgb[3], alpha, hsi[3];
 
-      while (outputSI != outputSIEnd)
-      {
-        if (x >= clippingBounds[0] && x < clippingBounds[1])
-        {
-          double rgb[3], alpha, hsi[3];
+      // level/window mechanism for intensity in HSI space
+      rgb[0] = static_cast<double>(*inputSI);
+      inputSI++;
+      rgb[1] = static_cast<double>(*inputSI);
+      inputSI++;
+      rgb[2] = static_cast<double>(*inputSI);
+      inputSI++;
 
-          // level/window mechanism for intensity in HSI space
-          rgb[0] = static_cast<double>(*inputSI);
-          inputSI++;
-          rgb[1] = static_cast<double>(*inputSI);
-          inputSI++;
-          rgb[2] = static_cast<double>(*inputSI);
-          inputSI++;
+      RGBtoHSI<double>(rgb, hsi);
+      hsi[2] = hsi[2] * 255.0 * scale - bias;
+      hsi[2] = (hsi[2] > 255.0 ? 255 : (hsi[2] < 0.0 ? 0 : hsi[2]));
+      hsi[2] /= 255.0;
+      HSItoRGB<double>(hsi, rgb);
+
+      *outputSI = static_cast<T>(rgb[0]);
+      outputSI++;
+      *outputSI = static_cast<T>(rgb[1]);
+      outputSI++;
+      *outputSI = static_cast<T>(rgb[2]);
+      outputSI++;
+
+      unsigned char finalAlpha = 255;
 
-          RGBtoHSI<double>(rgb, hsi);
-          hsi[2] = hsi[2] * 255.0 * scale - bias;
-          hsi[2] = (hsi[2] > 255.0 ? 255 : (hsi[2] < 0.0 ? 0 : hsi[2]));
-          hsi[2] /= 255.0;
-          HSItoRGB<double>(hsi, rgb);
-
-          *outputSI = static_cast<T>(rgb[0]);
-          outputSI++;
-          *outputSI = static_cast<T>(rgb[1]);
-          outputSI++;
-          *outputSI = static_cast<T>(rgb[2]);
-          outputSI++;
-
-          unsigned char finalAlpha = 255;
-
-          // RGBA case
-          if (maxC >= 4)
-          {
-            // level/window mechanism for opacity
-            alpha = static_cast<double>(*inputSI);
-            inputSI++;
-            alpha = alpha * scaleOpac - biasOpac;
-            if (alpha > 255.0)
-            {
-              alpha = 255.0;
-            }
-            else if (alpha < 0.0)
-            {
-              alpha = 0.0;
-            }
-            finalAlpha = static_cast<unsigned char>(alpha);
-
-            for (int c = 4; c < maxC; c++)
-              inputSI++;
-          }
-
-          *outputSI = static_cast<T>(finalAlpha);
-          outputSI++;
+      // RGBA case
+      if (maxC >= 4)
+      {
+        // level/window mechanism for opacity
+        alpha = static_cast<double>(*inputSI);
+        inputSI++;
+        alpha = alpha * scaleOpac - biasOpac;
+        if (alpha > 255.0)
+        {
+          alpha = 255.0;
         }
-        else
+        else if (alpha < 0.0)
         {
-          inputSI += maxC;
-          *outputSI = 0;
-          outputSI++;
-          *outputSI = 0;
-          outputSI++;
-          *outputSI = 0;
-          outputSI++;
-          *outputSI = 0;
-          outputSI++;
+          alpha = 0.0;
         }
+        finalAlpha = static_cast<unsigned char>(alpha);
 
-        x++;
+        for (int c = 4; c < maxC; c++)
+          inputSI++;
       }
+
+      *outputSI = static_cast<T>(finalAlpha);
+      outputSI++;
     }
-    else
+
+    std::fill(outputSI, outputSIEnd, T(0));
+
+    inputIt.NextSpan();
+    outputIt.NextSpan();
+    y++;
+  }
+}
+
+// Internal method which should never be used anywhere else and should not be in th header.
+//----------------------------------------------------------------------------
+// Maps scalars of 8 and 16 bit types with a precomputed RGBA value for every possible
+// input value (see vtkBuildValueTable). One table lookup per pixel, no branches.
+template <class T>
+void vtkApplyValueTableOnScalars(
+  vtkImageData *inData, vtkImageData *outData, int outExt[6], double *clippingBounds, const int *valueTable, T *)
+{
+  vtkImageIterator<T> inputIt(inData, outExt);
+  vtkImageIterator<unsigned char> outputIt(outData, outExt);
+
+  // the table starts at the smallest value of T
+  const int offset = -static_cast<int>(std::numeric_limits<T>::min());
+
+  int y = outExt[2];
+
+  // Loop through ouput pixels
+  while (!outputIt.IsAtEnd())
+  {
+    const T *inputSI = inputIt.BeginSpan();
+    int *outputSI = reinterpret_cast<int *>(outputIt.BeginSpan());
+    int *outputSIEnd = reinterpret_cast<int *>(outputIt.EndSpan());
+
+    // pixels outside of the clipping bounds are transparent
+    int begin = 0;
+    int end = 0;
+    if (y >= clippingBounds[2] && y < clippingBounds[3])
+      vtkGetClippedRowRange(outExt, clippingBounds, begin, end);
+
+    std::fill(outputSI, outputSI + begin, 0);
+    for (int x = begin; x < end; x++)
     {
-      while (outputSI != outputSIEnd)
-      {
-        *outputSI = 0;
-        outputSI++;
-        *outputSI = 0;
-        outputSI++;
-        *outputSI = 0;
-        outputSI++;
-        *outputSI = 0;
-        outputSI++;
-      }
+      outputSI[x] = valueTable[static_cast<int>(inputSI[x]) + offset];
     }
+    std::fill(outputSI + end, outputSIEnd, 0);
+
     inputIt.NextSpan();
     outputIt.NextSpan();
     y++;
@@ -281,8 +325,12 @@ void vtkApplyLookupTableOnRGBA(vtkMitkLevelWindowFilter *self,
 //----------------------------------------------------------------------------
 // This templated function executes the filter for any type of data.
 template <class T>
-void vtkApplyLookupTableOnScalarsFast(
-  vtkMitkLevelWindowFilter *self, vtkImageData *inData, vtkImageData *outData, int outExt[6], T *)
+void vtkApplyLookupTableOnScalarsFast(vtkMitkLevelWindowFilter *self,
+                                      vtkImageData *inData,
+                                      vtkImageData *outData,
+                                      int outExt[6],
+                                      double *clippingBounds,
+                                      T *)
 {
   vtkImageIterator<T> inputIt(inData, outExt);
   vtkImageIterator<unsigned char> outputIt(outData, outExt);
@@ -303,32 +351,40 @@ void vtkApplyLookupTableOnScalarsFast(
   // due to later conversion to int for rounding
   bias += 0.5f;
 
+  std::vector<int> indices(outExt[1] - outExt[0] + 1);
+
+  int y = outExt[2];
+
   // Loop through ouput pixels
   while (!outputIt.IsAtEnd())
   {
-    unsigned char *outputSI = outputIt.BeginSpan();
-    unsigned char *outputSIEnd = outputIt.EndSpan();
+    const T *inputSI = inputIt.BeginSpan();
+    int *outputSI = reinterpret_cast<int *>(outputIt.BeginSpan());
+    int *outputSIEnd = reinterpret_cast<int *>(outputIt.EndSpan());
 
-    T *inputSI = inputIt.BeginSpan();
+    // pixels outside of the clipping bounds are transparent
+    int begin = 0;
+    int end = 0;
+    if (y >= clippingBounds[2] && y < clippingBounds[3])
+      vtkGetClippedRowRange(outExt, clippingBounds, begin, end);
 
-    while (outputSI != outputSIEnd)
+    // map to indices first; this loop has no dependencies and can be vectorized
+    for (int x = begin; x < end; x++)
     {
-      // map to an index
-      auto idx = static_cast<int>(*inputSI * scale + bias);
-
-      if (idx < 0)
-        idx = 0;
-      else if (idx > maxIndex)
-        idx = maxIndex;
-
-      *reinterpret_cast<int *>(outputSI) = realLookupTable[idx];
+      auto idx = static_cast<int>(inputSI[x] * scale + bias);
+      indices[x] = idx < 0 ? 0 : (idx > maxIndex ? maxIndex : idx);
+    }
 
-      inputSI++;
-      outputSI += 4;
+    std::fill(outputSI, outputSI + begin, 0);
+    for (int x = begin; x < end; x++)
+    {
+      outputSI[x] = realLookupTable[indices[x]];
     }
+    std::fill(outputSI + end, outputSIEnd, 0);
 
     inputIt.NextSpan();
     outputIt.NextSpan();
+    y++;
   }
 }
 
@@ -352,46 +408,23 @@ void vtkApplyLookupTableOnScalars(vtkMitkLevelWindowFilter *self,
   // Loop through ouput pixels
   while (!outputIt.IsAtEnd())
   {
-    unsigned char *outputSI = outputIt.BeginSpan();
-    unsigned char *outputSIEnd = outputIt.EndSpan();
+    const T *inputSI = inputIt.BeginSpan();
+    int *outputSI = reinterpret_cast<int *>(outputIt.BeginSpan());
+    int *outputSIEnd = reinterpret_cast<int *>(outputIt.EndSpan());
 
-    // do we iterate over the inner vertical clipping bounds
+    // pixels outside of the clipping bounds are transparent
+    int begin = 0;
+    int end = 0;
     if (y >= clippingBounds[2] && y < clippingBounds[3])
-    {
-      T *inputSI = inputIt.BeginSpan();
+      vtkGetClippedRowRange(outExt, clippingBounds, begin, end);
 
-      int x = outExt[0];
-
-      while (outputSI != outputSIEnd)
-      {
-        // is this pixel within horizontal clipping bounds
-        if (x >= clippingBounds[0] && x < clippingBounds[1])
-        {
-          // fetching original value
-          auto grayValue = static_cast<double>(*inputSI);
-          // applying lookuptable - copy the 4 (RGBA) chars as a single int
-          *reinterpret_cast<int *>(outputSI) = *reinterpret_cast<int *>(lookupTable->MapValue(grayValue));
-        }
-        else
-        {
-          // outer horizontal clipping bounds - write a transparent RGBA pixel as a single int
-          *reinterpret_cast<int *>(outputSI) = 0;
-        }
-
-        inputSI++;
-        outputSI += 4;
-        x++;
-      }
-    }
-    else
+    std::fill(outputSI, outputSI + begin, 0);
+    for (int x = begin; x < end; x++)
     {
-      // outer vertical clipping bounds - write a transparent RGBA line as ints
-      while (outputSI != outputSIEnd)
-      {
-        *reinterpret_cast<int *>(outputSI) = 0;
-        outputSI += 4;
-      }
+      // applying lookuptable - copy the 4 (RGBA) chars as a single int
+      outputSI[x] = *reinterpret_cast<int *>(lookupTable->MapValue(static_cast<double>(inputSI[x])));
     }
+    std::fill(outputSI + end, outputSIEnd, 0);
 
     inputIt.NextSpan();
     outputIt.NextSpan();
@@ -399,6 +432,27 @@ void vtkApplyLookupTableOnScalars(vtkMitkLevelWindowFilter *self,
   }
 }
 
+// Internal method which should never be used anywhere else and should not be in th header.
+//----------------------------------------------------------------------------
+// Maps a gray value with a vtkColorTransferFunction and an optional opacity function to RGBA.
+// vtkColorTransferFunction::MapValue is not threadsafe, so the color is computed directly.
+static inline void vtkMapValueCTF(vtkColorTransferFunction *lookupTable,
+                                  vtkPiecewiseFunction *opacityFunction,
+                                  double grayValue,
+                                  unsigned char *rgbaOut)
+{
+  double rgba[4];
+  lookupTable->GetColor(grayValue, rgba); // RGB mapping
+  rgba[3] = 1.0;
+  if (opacityFunction)
+    rgba[3] = opacityFunction->GetValue(grayValue); // Alpha mapping
+
+  for (int i = 0; i < 4; ++i)
+  {
+    rgbaOut[i] = static_cast<unsigned char>(255.0 * rgba[i] + 0.5);
+  }
+}
+
 // Internal method which should never be used anywhere else and should not be in th header.
 //----------------------------------------------------------------------------
 // This templated function executes the filter for any type of data.
@@ -420,57 +474,22 @@ void vtkApplyLookupTableOnScalarsCTF(vtkMitkLevelWindowFilter *self,
   // Loop through ouput pixels
   while (!outputIt.IsAtEnd())
   {
+    const T *inputSI = inputIt.BeginSpan();
     unsigned char *outputSI = outputIt.BeginSpan();
     unsigned char *outputSIEnd = outputIt.EndSpan();
 
-    // do we iterate over the inner vertical clipping bounds
+    // pixels outside of the clipping bounds are transparent
+    int begin = 0;
+    int end = 0;
     if (y >= clippingBounds[2] && y < clippingBounds[3])
-    {
-      T *inputSI = inputIt.BeginSpan();
-
-      int x = outExt[0];
-
-      while (outputSI != outputSIEnd)
-      {
-        // is this pixel within horizontal clipping bounds
-        if (x >= clippingBounds[0] && x < clippingBounds[1])
-        {
-          // fetching original value
-          auto grayValue = static_cast<double>(*inputSI);
-
-          // applying directly colortransferfunction
-          // because vtkColorTransferFunction::MapValue is not threadsafe
-          double rgba[4];
-          lookupTable->GetColor(grayValue, rgba); // RGB mapping
-          rgba[3] = 1.0;
-          if (opacityFunction)
-            rgba[3] = opacityFunction->GetValue(grayValue); // Alpha mapping
-
-          for (int i = 0; i < 4; ++i)
-          {
-            outputSI[i] = static_cast<unsigned char>(255.0 * rgba[i] + 0.5);
-          }
-        }
-        else
-        {
-          // outer horizontal clipping bounds - write a transparent RGBA pixel as a single int
-          *reinterpret_cast<int *>(outputSI) = 0;
-        }
+      vtkGetClippedRowRange(outExt, clippingBounds, begin, end);
 
-        inputSI++;
-        outputSI += 4;
-        x++;
-      }
-    }
-    else
+    std::fill(outputSI, outputSI + 4 * begin, 0);
+    for (int x = begin; x < end; x++)
     {
-      // outer vertical clipping bounds - write a transparent RGBA line as ints
-      while (outputSI != outputSIEnd)
-      {
-        *reinterpret_cast<int *>(outputSI) = 0;
-        outputSI += 4;
-      }
+      vtkMapValueCTF(lookupTable, opacityFunction, static_cast<double>(inputSI[x]), outputSI + 4 * x);
     }
+    std::fill(outputSI + 4 * end, outputSIEnd, 0);
 
     inputIt.NextSpan();
     outputIt.NextSpan();
@@ -478,6 +497,60 @@ void vtkApplyLookupTableOnScalarsCTF(vtkMitkLevelWindowFilter *self,
   }
 }
 
+// Internal method which should never be used anywhere else and should not be in th header.
+//----------------------------------------------------------------------------
+// Computes the RGBA value (as int) of every value of an 8 or 16 bit type in the same way
+// as the per pixel functions above.
+template <class T>
+void vtkBuildValueTable(vtkMitkLevelWindowFilter *self, std::vector<int> &valueTable, T *)
+{
+  const int minValue = std::numeric_limits<T>::min();
+  const int maxValue = std::numeric_limits<T>::max();
+  valueTable.resize(maxValue - minValue + 1);
+
+  auto *vlt = dynamic_cast<vtkLookupTable *>(self->GetLookupTable());
+  auto *ctf = dynamic_cast<vtkColorTransferFunction *>(self->GetLookupTable());
+
+  if (ctf)
+  {
+    vtkPiecewiseFunction *opacityFunction = self->GetOpacityPiecewiseFunction();
+    for (int value = minValue; value <= maxValue; ++value)
+    {
+      vtkMapValueCTF(ctf,
+                     opacityFunction,
+                     static_cast<double>(value),
+                     reinterpret_cast<unsigned char *>(&valueTable[value - minValue]));
+    }
+  }
+  else if (vlt && vlt->GetScale() == VTK_SCALE_LINEAR)
+  {
+    // same mapping as vtkApplyLookupTableOnScalarsFast
+    double tableRange[2];
+    vlt->GetTableRange(tableRange);
+    const int *realLookupTable = reinterpret_cast<int *>(vlt->GetTable()->GetPointer(0));
+    int maxIndex = vlt->GetNumberOfColors() - 1;
+
+    const float scale = (tableRange[1] - tableRange[0] > 0 ? (maxIndex + 1) / (tableRange[1] - tableRange[0]) : 0.0);
+    float bias = -tableRange[0] * scale;
+    bias += 0.5f;
+
+    for (int value = minValue; value <= maxValue; ++value)
+    {
+      auto idx = static_cast<int>(static_cast<T>(value) * scale + bias);
+      idx = idx < 0 ? 0 : (idx > maxIndex ? maxIndex : idx);
+      valueTable[value - minValue] = realLookupTable[idx];
+    }
+  }
+  else
+  {
+    vtkScalarsToColors *lookupTable = self->GetLookupTable();
+    for (int value = minValue; value <= maxValue; ++value)
+    {
+      valueTable[value - minValue] = *reinterpret_cast<int *>(lookupTable->MapValue(static_cast<double>(value)));
+    }
+  }
+}
+
 int vtkMitkLevelWindowFilter::RequestInformation(vtkInformation *request,
                                                  vtkInformationVector **inputVector,
                                                  vtkInformationVector *outputVector)
@@ -492,6 +565,69 @@ int vtkMitkLevelWindowFilter::RequestInformation(vtkInformation *request,
   return 1;
 }
 
+int vtkMitkLevelWindowFilter::RequestData(vtkInformation *request,
+                                          vtkInformationVector **inputVector,
+                                          vtkInformationVector *outputVector)
+{
+  // The lookup table is prepared once here instead of in every thread
+  if (this->GetLookupTable())
+    this->GetLookupTable()->Build();
+
+  m_UseValueTable = false;
+
+  vtkImageData *input = vtkImageData::GetData(inputVector[0]);
+  if (input && this->GetLookupTable() && input->GetNumberOfScalarComponents() <= 2)
+  {
+    const int scalarType = input->GetScalarType();
+    const bool smallType = scalarType == VTK_CHAR || scalarType == VTK_SIGNED_CHAR ||
+                           scalarType == VTK_UNSIGNED_CHAR || scalarType == VTK_SHORT ||
+                           scalarType == VTK_UNSIGNED_SHORT;
+
+    if (smallType)
+    {
+      // the table only depends on the lookup table and the opacity function
+      vtkMTimeType tableTime = m_LookupTable->GetMTime();
+      if (m_OpacityFunction)
+        tableTime = std::max(tableTime, m_OpacityFunction->GetMTime());
+
+      bool tableValid =
+        !m_ValueTable.empty() && m_ValueTableScalarType == scalarType && m_ValueTableTime == tableTime;
+
+      // Building the table costs one mapping per possible value. For 16 bit values this only
+      // pays off if the table is reused or the slice has at least as many pixels.
+      vtkIdType tableSize = (scalarType == VTK_SHORT || scalarType == VTK_UNSIGNED_SHORT) ? 65536 : 256;
+      if (!tableValid && input->GetNumberOfPoints() >= tableSize)
+      {
+        switch (scalarType)
+        {
+          case VTK_CHAR:
+            vtkBuildValueTable(this, m_ValueTable, static_cast<char *>(nullptr));
+            break;
+          case VTK_SIGNED_CHAR:
+            vtkBuildValueTable(this, m_ValueTable, static_cast<signed char *>(nullptr));
+            break;
+          case VTK_UNSIGNED_CHAR:
+            vtkBuildValueTable(this, m_ValueTable, static_cast<unsigned char *>(nullptr));
+            break;
+          case VTK_SHORT:
+            vtkBuildValueTable(this, m_ValueTable, static_cast<short *>(nullptr));
+            break;
+          case VTK_UNSIGNED_SHORT:
+            vtkBuildValueTable(this, m_ValueTable, static_cast<unsigned short *>(nullptr));
+            break;
+        }
+        m_ValueTableScalarType = scalarType;
+        m_ValueTableTime = tableTime;
+        tableValid = true;
+      }
+
+      m_UseValueTable = tableValid;
+    }
+  }
+
+  return this->Superclass::RequestData(request, inputVector, outputVector);
+}
+
 // Method to run the filter in different threads.
 void vtkMitkLevelWindowFilter::ThreadedExecute(vtkImageData *inData, vtkImageData *outData, int extent[6], int /*id*/)
 {
@@ -506,21 +642,43 @@ void vtkMitkLevelWindowFilter::ThreadedExecute(vtkImageData *inData, vtkImageDat
         return;
     }
   }
+  else if (m_UseValueTable)
+  {
+    const int *valueTable = m_ValueTable.data();
+    switch (inData->GetScalarType())
+    {
+      case VTK_CHAR:
+        vtkApplyValueTableOnScalars(
+          inData, outData, extent, m_ClippingBounds, valueTable, static_cast<char *>(nullptr));
+        break;
+      case VTK_SIGNED_CHAR:
+        vtkApplyValueTableOnScalars(
+          inData, outData, extent, m_ClippingBounds, valueTable, static_cast<signed char *>(nullptr));
+        break;
+      case VTK_UNSIGNED_CHAR:
+        vtkApplyValueTableOnScalars(
+          inData, outData, extent, m_ClippingBounds, valueTable, static_cast<unsigned char *>(nullptr));
+        break;
+      case VTK_SHORT:
+        vtkApplyValueTableOnScalars(
+          inData, outData, extent, m_ClippingBounds, valueTable, static_cast<short *>(nullptr));
+        break;
+      case VTK_UNSIGNED_SHORT:
+        vtkApplyValueTableOnScalars(
+          inData, outData, extent, m_ClippingBounds, valueTable, static_cast<unsigned short *>(nullptr));
+        break;
+      default:
+        vtkErrorMacro(<< "Execute: Unknown ScalarType");
+        return;
+    }
+  }
   else
   {
-    bool dontClip = extent[2] >= m_ClippingBounds[2] && extent[3] <= m_ClippingBounds[3] &&
-                    extent[0] >= m_ClippingBounds[0] && extent[1] <= m_ClippingBounds[1];
-
-    if (this->GetLookupTable())
-      this->GetLookupTable()->Build();
-
     auto *vlt = dynamic_cast<vtkLookupTable *>(this->GetLookupTable());
     auto *ctf = dynamic_cast<vtkColorTransferFunction *>(this->GetLookupTable());
 
     bool linearLookupTable = vlt && vlt->GetScale() == VTK_SCALE_LINEAR;
 
-    bool useFast = dontClip && linearLookupTable;
-
     if (ctf)
     {
       switch (inData->GetScalarType())
@@ -532,12 +690,12 @@ void vtkMitkLevelWindowFilter::ThreadedExecute(vtkImageData *inData, vtkImageDat
           return;
       }
     }
-    else if (useFast)
+    else if (linearLookupTable)
     {
       switch (inData->GetScalarType())
       {
-        vtkTemplateMacro(
-          vtkApplyLookupTableOnScalarsFast(this, inData, outData, extent, static_cast<VTK_TT *>(nullptr)));
+        vtkTemplateMacro(vtkApplyLookupTableOnScalarsFast(
+          this, inData, outData, extent, m_ClippingBounds, static_cast<VTK_TT *>(nullptr)));
         default:
           vtkErrorMacro(<< "Execute: Unknown ScalarType");
           return;
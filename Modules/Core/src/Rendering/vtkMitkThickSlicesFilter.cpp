@@ -24,8 +24,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vtkPointData.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 
+#include <algorithm>
 #include <math.h>
 #include <sstream>
+#include <vector>
 
 vtkStandardNewMacro(vtkMitkThickSlicesFilter);
 
@@ -38,6 +40,14 @@ vtkMitkThickSlicesFilter::vtkMitkThickSlicesFilter()
 
   this->m_CurrentMode = MIP;
 
+  this->SlidingWindowShift = 0;
+  this->UseSlidingWindow = false;
+  this->SlabStateValid = false;
+  this->SlabStateMode = -1;
+  this->SlabStateScalarType = -1;
+  for (int i = 0; i < 6; i++)
+    this->SlabStateExtent[i] = 0;
+
   // by default process active point scalars
   this->SetInputArrayToProcess(0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, vtkDataSetAttributes::SCALARS);
 }
@@ -108,10 +118,96 @@ int vtkMitkThickSlicesFilter::RequestUpdateExtent(vtkInformation *,
   return 1;
 }
 
+//----------------------------------------------------------------------------
+// Row kernels of the thick slice modes. They are plain loops over contiguous
+// rows, so the compiler can vectorize them.
+template <class T>
+static inline void vtkMitkThickSlicesMaxRow(T *acc, const T *row, int length)
+{
+  for (int x = 0; x < length; x++)
+    acc[x] = row[x] > acc[x] ? row[x] : acc[x];
+}
+
+template <class T>
+static inline void vtkMitkThickSlicesMinRow(T *acc, const T *row, int length)
+{
+  for (int x = 0; x < length; x++)
+    acc[x] = row[x] < acc[x] ? row[x] : acc[x];
+}
+
+template <class T, class TAcc>
+static inline void vtkMitkThickSlicesAddRow(TAcc *acc, const T *row, int length)
+{
+  for (int x = 0; x < length; x++)
+    acc[x] += row[x];
+}
+
+template <class T>
+static inline void vtkMitkThickSlicesAddWeightedRow(double *acc, const T *row, double weight, int length)
+{
+  for (int x = 0; x < length; x++)
+    acc[x] += static_cast<double>(row[x]) * weight;
+}
+
+// Replaces the leaving by the entering slice in the sum of a sliding slab
+template <class T, class TAcc>
+static inline void vtkMitkThickSlicesSlideRow(TAcc *acc, const T *leaving, const T *entering, int length)
+{
+  for (int x = 0; x < length; x++)
+    acc[x] = static_cast<TAcc>(acc[x] - leaving[x] + entering[x]);
+}
+
+//----------------------------------------------------------------------------
+// Sums up the rows of the slab for the SUM and MEAN modes. If a sliding window
+// shift is given, only the entering and leaving slices are applied to the sum
+// of the previous slab.
+template <class T, class TAcc>
+static void vtkMitkThickSlicesFilterSlab(T *inPtr,
+                                         vtkIdType *inIncs,
+                                         int minZ,
+                                         int maxZ,
+                                         int rowLength,
+                                         int numberOfRows,
+                                         TAcc *sum,
+                                         T *firstSlice,
+                                         T *lastSlice,
+                                         vtkIdType stateRowLength,
+                                         int shift)
+{
+  for (int idxY = 0; idxY < numberOfRows; idxY++)
+  {
+    const T *slabRow = inPtr + idxY * inIncs[1];
+    TAcc *sumRow = sum + idxY * stateRowLength;
+    T *firstRow = firstSlice + idxY * stateRowLength;
+    T *lastRow = lastSlice + idxY * stateRowLength;
+
+    if (shift == 1)
+    {
+      vtkMitkThickSlicesSlideRow(sumRow, firstRow, slabRow + maxZ * inIncs[2], rowLength);
+    }
+    else if (shift == -1)
+    {
+      vtkMitkThickSlicesSlideRow(sumRow, lastRow, slabRow + minZ * inIncs[2], rowLength);
+    }
+    else
+    {
+      std::fill(sumRow, sumRow + rowLength, TAcc(0));
+      for (int z = minZ; z <= maxZ; z++)
+        vtkMitkThickSlicesAddRow(sumRow, slabRow + z * inIncs[2], rowLength);
+    }
+
+    // remember the border slices for the next shift
+    std::copy(slabRow + minZ * inIncs[2], slabRow + minZ * inIncs[2] + rowLength, firstRow);
+    std::copy(slabRow + maxZ * inIncs[2], slabRow + maxZ * inIncs[2] + rowLength, lastRow);
+  }
+}
+
 //----------------------------------------------------------------------------
 // This execute method handles boundaries.
 // it handles boundaries. Pixels are just replicated to get values
 // out of extent.
+// The slab is traversed slice by slice for each row (z-outer), so that the
+// input is read contiguously.
 template <class T>
 void vtkMitkThickSlicesFilterExecute(vtkMitkThickSlicesFilter *self,
                                      vtkImageData *inData,
@@ -119,39 +215,29 @@ void vtkMitkThickSlicesFilterExecute(vtkMitkThickSlicesFilter *self,
                                      vtkImageData *outData,
                                      T *outPtr,
                                      int outExt[6],
+                                     void *slabSum,
+                                     void *slabFirstSlice,
+                                     void *slabLastSlice,
+                                     int slabStateExtent[6],
+                                     int slidingWindowShift,
                                      int /*id*/)
 {
-  int idxX, idxY;
+  int idxY;
   int maxX, maxY;
   vtkIdType inIncX, inIncY, inIncZ;
   vtkIdType outIncX, outIncY, outIncZ;
-  // int axesNum;
   int *inExt = inData->GetExtent();
   int *wholeExtent;
   vtkIdType *inIncs;
-  // int useYMin, useYMax, useXMin, useXMax;
 
   // find the region to loop over
   maxX = outExt[1] - outExt[0];
   maxY = outExt[3] - outExt[2];
 
-  //  maxZ = outExt[5] - outExt[4];
-
-  // Get the dimensionality of the gradient.
-  // axesNum = self->GetDimensionality();
-
   // Get increments to march through data
   inData->GetContinuousIncrements(outExt, inIncX, inIncY, inIncZ);
   outData->GetContinuousIncrements(outExt, outIncX, outIncY, outIncZ);
-  /*
-// The data spacing is important for computing the gradient.
-// central differences (2 * ratio).
-// Negative because below we have (min - max) for dx ...
-inData->GetSpacing(r);
-r[0] = -0.5 / r[0];
-r[1] = -0.5 / r[1];
-r[2] = -0.5 / r[2];
-    */
+
   // get some other info we need
   inIncs = inData->GetIncrements();
   wholeExtent = inData->GetExtent();
@@ -169,6 +255,13 @@ r[2] = -0.5 / r[2];
 
   double invNum = 1.0 / (_maxZ - _minZ + 1);
 
+  const int rowLength = maxX + 1;
+  const vtkIdType outRowInc = rowLength + outIncY;
+
+  // position of the output region within the sliding window state
+  const vtkIdType stateRowLength = slabStateExtent[1] - slabStateExtent[0] + 1;
+  const vtkIdType stateOffset = (outExt[0] - slabStateExtent[0]) + (outExt[2] - slabStateExtent[2]) * stateRowLength;
+
   switch (self->GetThickSliceMode())
   {
     default:
@@ -177,60 +270,37 @@ r[2] = -0.5 / r[2];
       // MIP
       for (idxY = 0; idxY <= maxY; idxY++)
       {
-        // useYMin = ((idxY + outExt[2]) <= wholeExtent[2]) ? 0 : -inIncs[1];
-        // useYMax = ((idxY + outExt[2]) >= wholeExtent[3]) ? 0 : inIncs[1];
-        for (idxX = 0; idxX <= maxX; idxX++)
-        {
-          // useXMin = ((idxX + outExt[0]) <= wholeExtent[0]) ? 0 : -inIncs[0];
-          // useXMax = ((idxX + outExt[0]) >= wholeExtent[1]) ? 0 : inIncs[0];
-
-          T mip = inPtr[_minZ * inIncs[2]];
-
-          for (int z = _minZ + 1; z <= _maxZ; z++)
-          {
-            T value = inPtr[z * inIncs[2]];
-            if (value > mip)
-              mip = value;
-          }
-
-          // do X axis
-          *outPtr = mip;
-          outPtr++;
-          inPtr++;
-        }
-        outPtr += outIncY;
-        inPtr += inIncY;
+        const T *slabRow = inPtr + idxY * inIncs[1];
+        T *outRow = outPtr + idxY * outRowInc;
+
+        std::copy(slabRow + _minZ * inIncs[2], slabRow + _minZ * inIncs[2] + rowLength, outRow);
+        for (int z = _minZ + 1; z <= _maxZ; z++)
+          vtkMitkThickSlicesMaxRow(outRow, slabRow + z * inIncs[2], rowLength);
       }
     }
     break;
 
     case vtkMitkThickSlicesFilter::SUM:
     {
-      // MIP
+      double *sum = static_cast<double *>(slabSum) + stateOffset;
+      vtkMitkThickSlicesFilterSlab(inPtr,
+                                   inIncs,
+                                   _minZ,
+                                   _maxZ,
+                                   rowLength,
+                                   maxY + 1,
+                                   sum,
+                                   static_cast<T *>(slabFirstSlice) + stateOffset,
+                                   static_cast<T *>(slabLastSlice) + stateOffset,
+                                   stateRowLength,
+                                   slidingWindowShift);
+
       for (idxY = 0; idxY <= maxY; idxY++)
       {
-        // useYMin = ((idxY + outExt[2]) <= wholeExtent[2]) ? 0 : -inIncs[1];
-        // useYMax = ((idxY + outExt[2]) >= wholeExtent[3]) ? 0 : inIncs[1];
-        for (idxX = 0; idxX <= maxX; idxX++)
-        {
-          // useXMin = ((idxX + outExt[0]) <= wholeExtent[0]) ? 0 : -inIncs[0];
-          // useXMax = ((idxX + outExt[0]) >= wholeExtent[1]) ? 0 : inIncs[0];
-
-          double sum = 0;
-
-          for (int z = _minZ; z <= _maxZ; z++)
-          {
-            T value = inPtr[z * inIncs[2]];
-            sum += value;
-          }
-
-          // do X axis
-          *outPtr = static_cast<T>(invNum * sum);
-          outPtr++;
-          inPtr++;
-        }
-        outPtr += outIncY;
-        inPtr += inIncY;
+        const double *sumRow = sum + idxY * stateRowLength;
+        T *outRow = outPtr + idxY * outRowInc;
+        for (int x = 0; x < rowLength; x++)
+          outRow[x] = static_cast<T>(invNum * sumRow[x]);
       }
     }
     break;
@@ -255,31 +325,19 @@ r[2] = -0.5 / r[2];
         weights[i] /= sum;
       }
 
+      std::vector<double> weightedRow(rowLength);
       for (idxY = 0; idxY <= maxY; idxY++)
       {
-        // useYMin = ((idxY + outExt[2]) <= wholeExtent[2]) ? 0 : -inIncs[1];
-        // useYMax = ((idxY + outExt[2]) >= wholeExtent[3]) ? 0 : inIncs[1];
-        for (idxX = 0; idxX <= maxX; idxX++)
-        {
-          // useXMin = ((idxX + outExt[0]) <= wholeExtent[0]) ? 0 : -inIncs[0];
-          // useXMax = ((idxX + outExt[0]) >= wholeExtent[1]) ? 0 : inIncs[0];
-
-          T mip = inPtr[_minZ * inIncs[2]];
-          i = 0;
-          double mymip = 0;
-          for (int z = _minZ + 1; z <= _maxZ; z++)
-          {
-            double value = inPtr[z * inIncs[2]];
-            mymip += value * weights[i++];
-          }
-          mip = static_cast<T>(mymip);
-          // do X axis
-          *outPtr = mip;
-          outPtr++;
-          inPtr++;
-        }
-        outPtr += outIncY;
-        inPtr += inIncY;
+        const T *slabRow = inPtr + idxY * inIncs[1];
+        T *outRow = outPtr + idxY * outRowInc;
+
+        std::fill(weightedRow.begin(), weightedRow.end(), 0.0);
+        i = 0;
+        for (int z = _minZ + 1; z <= _maxZ; z++)
+          vtkMitkThickSlicesAddWeightedRow(weightedRow.data(), slabRow + z * inIncs[2], weights[i++], rowLength);
+
+        for (int x = 0; x < rowLength; x++)
+          outRow[x] = static_cast<T>(weightedRow[x]);
       }
     }
     break;
@@ -288,24 +346,12 @@ r[2] = -0.5 / r[2];
     {
       for (idxY = 0; idxY <= maxY; idxY++)
       {
-        for (idxX = 0; idxX <= maxX; idxX++)
-        {
-          T mip = inPtr[_minZ * inIncs[2]];
-
-          for (int z = _minZ + 1; z <= _maxZ; z++)
-          {
-            T value = inPtr[z * inIncs[2]];
-            if (value < mip)
-              mip = value;
-          }
-
-          // do X axis
-          *outPtr = mip;
-          outPtr++;
-          inPtr++;
-        }
-        outPtr += outIncY;
-        inPtr += inIncY;
+        const T *slabRow = inPtr + idxY * inIncs[1];
+        T *outRow = outPtr + idxY * outRowInc;
+
+        std::copy(slabRow + _minZ * inIncs[2], slabRow + _minZ * inIncs[2] + rowLength, outRow);
+        for (int z = _minZ + 1; z <= _maxZ; z++)
+          vtkMitkThickSlicesMinRow(outRow, slabRow + z * inIncs[2], rowLength);
       }
     }
     break;
@@ -314,27 +360,26 @@ r[2] = -0.5 / r[2];
     {
       const int size = _maxZ - _minZ;
 
-      // MEAN
+      // MEAN, summed up in the pixel type
+      T *sum = static_cast<T *>(slabSum) + stateOffset;
+      vtkMitkThickSlicesFilterSlab(inPtr,
+                                   inIncs,
+                                   _minZ,
+                                   _maxZ,
+                                   rowLength,
+                                   maxY + 1,
+                                   sum,
+                                   static_cast<T *>(slabFirstSlice) + stateOffset,
+                                   static_cast<T *>(slabLastSlice) + stateOffset,
+                                   stateRowLength,
+                                   slidingWindowShift);
+
       for (idxY = 0; idxY <= maxY; idxY++)
       {
-        for (idxX = 0; idxX <= maxX; idxX++)
-        {
-          T sum = 0;
-          for (int z = _minZ; z <= _maxZ; z++)
-          {
-            T value = inPtr[z * inIncs[2]];
-            sum += value;
-          }
-
-          T mip = sum / size;
-
-          // do X axis
-          *outPtr = mip;
-          outPtr++;
-          inPtr++;
-        }
-        outPtr += outIncY;
-        inPtr += inIncY;
+        const T *sumRow = sum + idxY * stateRowLength;
+        T *outRow = outPtr + idxY * outRowInc;
+        for (int x = 0; x < rowLength; x++)
+          outRow[x] = static_cast<T>(sumRow[x] / size);
       }
     }
     break;
@@ -345,7 +390,56 @@ int vtkMitkThickSlicesFilter::RequestData(vtkInformation *request,
                                           vtkInformationVector **inputVector,
                                           vtkInformationVector *outputVector)
 {
-  if (!this->Superclass::RequestData(request, inputVector, outputVector))
+  vtkImageData *input = vtkImageData::GetData(inputVector[0]);
+  vtkDataArray *inputArray = this->GetInputArrayToProcess(0, inputVector);
+  if (!input || !inputArray)
+  {
+    vtkErrorMacro("No input array was found. Cannot execute");
+    return 0;
+  }
+
+  this->UseSlidingWindow = false;
+  if (m_CurrentMode == SUM || m_CurrentMode == MEAN)
+  {
+    int inExt[6];
+    input->GetExtent(inExt);
+
+    // The sliding window can only be used if the previous slab was computed
+    // in the same way and on the same grid
+    bool sameSlab = this->SlabStateValid && this->SlabStateMode == m_CurrentMode &&
+                    this->SlabStateScalarType == inputArray->GetDataType();
+    for (int i = 0; i < 6; i++)
+      sameSlab = sameSlab && this->SlabStateExtent[i] == inExt[i];
+
+    this->UseSlidingWindow = sameSlab && (this->SlidingWindowShift == 1 || this->SlidingWindowShift == -1);
+
+    if (!this->UseSlidingWindow)
+    {
+      vtkIdType numberOfPixels =
+        static_cast<vtkIdType>(inExt[1] - inExt[0] + 1) * static_cast<vtkIdType>(inExt[3] - inExt[2] + 1);
+      int sumType = m_CurrentMode == SUM ? VTK_DOUBLE : inputArray->GetDataType();
+
+      this->SlabSum.TakeReference(vtkDataArray::CreateDataArray(sumType));
+      this->SlabSum->SetNumberOfTuples(numberOfPixels);
+      this->SlabFirstSlice.TakeReference(vtkDataArray::CreateDataArray(inputArray->GetDataType()));
+      this->SlabFirstSlice->SetNumberOfTuples(numberOfPixels);
+      this->SlabLastSlice.TakeReference(vtkDataArray::CreateDataArray(inputArray->GetDataType()));
+      this->SlabLastSlice->SetNumberOfTuples(numberOfPixels);
+
+      for (int i = 0; i < 6; i++)
+        this->SlabStateExtent[i] = inExt[i];
+    }
+  }
+
+  int result = this->Superclass::RequestData(request, inputVector, outputVector);
+
+  // the shift hint is only valid for a single execution
+  this->SlidingWindowShift = 0;
+  this->SlabStateValid = result && (m_CurrentMode == SUM || m_CurrentMode == MEAN);
+  this->SlabStateMode = m_CurrentMode;
+  this->SlabStateScalarType = inputArray->GetDataType();
+
+  if (!result)
   {
     return 0;
   }
@@ -409,10 +503,25 @@ void vtkMitkThickSlicesFilter::ThreadedRequestData(vtkInformation *,
   void *inPtr = inputArray->GetVoidPointer(0);
   void *outPtr = output->GetScalarPointerForExtent(outExt);
 
+  // sliding window state, only used by the SUM and MEAN modes
+  void *slabSum = this->SlabSum ? this->SlabSum->GetVoidPointer(0) : nullptr;
+  void *slabFirstSlice = this->SlabFirstSlice ? this->SlabFirstSlice->GetVoidPointer(0) : nullptr;
+  void *slabLastSlice = this->SlabLastSlice ? this->SlabLastSlice->GetVoidPointer(0) : nullptr;
+
   switch (inputArray->GetDataType())
   {
-    vtkTemplateMacro(vtkMitkThickSlicesFilterExecute(
-      this, input, static_cast<VTK_TT *>(inPtr), output, static_cast<VTK_TT *>(outPtr), outExt, threadId));
+    vtkTemplateMacro(vtkMitkThickSlicesFilterExecute(this,
+                                                     input,
+                                                     static_cast<VTK_TT *>(inPtr),
+                                                     output,
+                                                     static_cast<VTK_TT *>(outPtr),
+                                                     outExt,
+                                                     slabSum,
+                                                     slabFirstSlice,
+                                                     slabLastSlice,
+                                                     this->SlabStateExtent,
+                                                     this->UseSlidingWindow ? this->SlidingWindowShift : 0,
+                                                     threadId));
     default:
       vtkErrorMacro("Execute: Unknown ScalarType " << input->GetScalarType());
       return;
@@ -0,0 +1,152 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkExtractSliceFilter.h"
+#include "mitkImageGenerator.h"
+#include "mitkImageSliceCache.h"
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+
+#include <vtkImageData.h>
+
+#include <chrono>
+#include <thread>
+
+class mitkImageSliceCacheTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkImageSliceCacheTestSuite);
+  MITK_TEST(Get_AddedSlice_ReturnsSlice);
+  MITK_TEST(Get_OtherPlane_ReturnsFalse);
+  MITK_TEST(Get_ModifiedImage_ReturnsFalse);
+  MITK_TEST(SetMaximumSize_Zero_RemovesSlices);
+  MITK_TEST(Prefetch_ScrollDirection_AddsNextSlices);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::Image::Pointer m_Image;
+  mitk::PlaneGeometry::Pointer m_Plane;
+  mitk::ImageSliceCache *m_Cache;
+
+  mitk::ImageSliceCache::SliceKey CreateKey(const mitk::PlaneGeometry *plane)
+  {
+    return mitk::ImageSliceCache::SliceKey(m_Image, 0, plane, mitk::ExtractSliceFilter::RESLICE_NEAREST, false);
+  }
+
+  mitk::ExtractSliceFilter::Pointer Reslice(const mitk::PlaneGeometry *plane)
+  {
+    auto reslicer = mitk::ExtractSliceFilter::New();
+    reslicer->SetInput(m_Image);
+    reslicer->SetWorldGeometry(plane);
+    reslicer->SetResliceTransformByGeometry(m_Image->GetGeometry());
+    reslicer->SetVtkOutputRequest(true);
+    reslicer->Update();
+    return reslicer;
+  }
+
+public:
+  void setUp() override
+  {
+    m_Image = mitk::ImageGenerator::GenerateGradientImage<unsigned char>(10u, 10u, 10u);
+
+    m_Plane = mitk::PlaneGeometry::New();
+    m_Plane->InitializeStandardPlane(m_Image->GetGeometry(), mitk::PlaneGeometry::Axial, 4.5);
+    m_Plane->SetReferenceGeometry(m_Image->GetGeometry());
+
+    m_Cache = mitk::ImageSliceCache::GetInstance();
+    m_Cache->SetEnabled(true);
+    m_Cache->SetMaximumSize(256ULL * 1024 * 1024);
+    m_Cache->SetNumberOfPrefetchedSlices(0);
+    m_Cache->Clear();
+  }
+
+  void tearDown() override
+  {
+    m_Cache->Clear();
+    m_Image = nullptr;
+    m_Plane = nullptr;
+  }
+
+  void Get_AddedSlice_ReturnsSlice()
+  {
+    auto reslicer = this->Reslice(m_Plane);
+    m_Cache->Add(this->CreateKey(m_Plane), reslicer);
+
+    mitk::ImageSliceCache::Slice slice;
+    CPPUNIT_ASSERT_MESSAGE("Added slice is cached", m_Cache->Get(this->CreateKey(m_Plane), slice));
+
+    int *cachedDims = slice.image->GetDimensions();
+    int *dims = reslicer->GetVtkOutput()->GetDimensions();
+    CPPUNIT_ASSERT_MESSAGE("Cached slice has the size of the resliced image",
+                           cachedDims[0] == dims[0] && cachedDims[1] == dims[1]);
+    CPPUNIT_ASSERT_MESSAGE("Cached slice has the spacing of the reslicer",
+                           mitk::Equal(slice.spacing[0], reslicer->GetOutputSpacing()[0]) &&
+                             mitk::Equal(slice.spacing[1], reslicer->GetOutputSpacing()[1]));
+  }
+
+  void Get_OtherPlane_ReturnsFalse()
+  {
+    m_Cache->Add(this->CreateKey(m_Plane), this->Reslice(m_Plane));
+
+    mitk::PlaneGeometry::Pointer otherPlane = m_Plane->Clone();
+    mitk::Vector3D offset;
+    offset.Fill(0.0);
+    offset[2] = 1.0;
+    otherPlane->SetOrigin(m_Plane->GetOrigin() + offset);
+
+    mitk::ImageSliceCache::Slice slice;
+    CPPUNIT_ASSERT_MESSAGE("Slice of another plane is not cached", !m_Cache->Get(this->CreateKey(otherPlane), slice));
+  }
+
+  void Get_ModifiedImage_ReturnsFalse()
+  {
+    m_Cache->Add(this->CreateKey(m_Plane), this->Reslice(m_Plane));
+    m_Image->Modified();
+
+    mitk::ImageSliceCache::Slice slice;
+    CPPUNIT_ASSERT_MESSAGE("Slice of a modified image is not cached", !m_Cache->Get(this->CreateKey(m_Plane), slice));
+  }
+
+  void SetMaximumSize_Zero_RemovesSlices()
+  {
+    m_Cache->Add(this->CreateKey(m_Plane), this->Reslice(m_Plane));
+    CPPUNIT_ASSERT_EQUAL(1u, m_Cache->GetNumberOfSlices());
+
+    m_Cache->SetMaximumSize(0);
+    CPPUNIT_ASSERT_EQUAL(0u, m_Cache->GetNumberOfSlices());
+  }
+
+  void Prefetch_ScrollDirection_AddsNextSlices()
+  {
+    m_Cache->SetNumberOfPrefetchedSlices(2);
+
+    mitk::Vector3D offset;
+    offset.Fill(0.0);
+    offset[2] = 1.0;
+    m_Cache->Prefetch(this->CreateKey(m_Plane), m_Image, m_Plane, offset);
+
+    // wait for the background thread
+    for (int i = 0; i < 100 && m_Cache->GetNumberOfSlices() < 2; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    mitk::PlaneGeometry::Pointer nextPlane = m_Plane->Clone();
+    nextPlane->SetOrigin(m_Plane->GetOrigin() + offset);
+
+    mitk::ImageSliceCache::Slice slice;
+    CPPUNIT_ASSERT_MESSAGE("Next slice was prefetched", m_Cache->Get(this->CreateKey(nextPlane), slice));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkImageSliceCache)
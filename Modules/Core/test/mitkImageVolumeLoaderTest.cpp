@@ -0,0 +1,176 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkImage.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkImageVolumeLoader.h"
+#include "mitkImageWriteAccessor.h"
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+  /** Fills each volume with its time step and counts the loads */
+  class TestVolumeLoader : public mitk::ImageVolumeLoader
+  {
+  public:
+    mitkClassMacro(TestVolumeLoader, mitk::ImageVolumeLoader);
+    itkFactorylessNewMacro(Self);
+
+    void LoadVolume(unsigned int t, unsigned int, void *buffer) override
+    {
+      std::memset(buffer, static_cast<int>(t), volumeSize);
+      ++numberOfLoads;
+    }
+
+    unsigned int numberOfLoads = 0;
+    size_t volumeSize = 0;
+  };
+}
+
+class mitkImageVolumeLoaderTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkImageVolumeLoaderTestSuite);
+  MITK_TEST(GetVolumeData_NotSet_LoadsVolume);
+  MITK_TEST(GetVolumeData_MaximumReached_ReleasesLeastRecentlyUsed);
+  MITK_TEST(GetVolumeData_AccessedVolume_IsNotReleased);
+  MITK_TEST(GetVolumeData_ModifiedImage_ReleasesVolumes);
+  MITK_TEST(GetVolumeData_WrittenVolume_IsKept);
+  MITK_TEST(GetVolumeData_SetSlice_KeepsVolume);
+  MITK_TEST(ReadAccessor_WholeImage_LoadsAllAndRemovesLoader);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::Image::Pointer m_Image;
+  TestVolumeLoader::Pointer m_Loader;
+
+  unsigned char ReadFirstValue(unsigned int t)
+  {
+    mitk::ImageReadAccessor accessor(m_Image, m_Image->GetVolumeData(t));
+    return static_cast<const unsigned char *>(accessor.GetData())[0];
+  }
+
+public:
+  void setUp() override
+  {
+    unsigned int dimensions[4] = {8, 8, 4, 10};
+    m_Image = mitk::Image::New();
+    m_Image->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 4, dimensions);
+
+    m_Loader = TestVolumeLoader::New();
+    m_Loader->volumeSize = 8 * 8 * 4;
+    m_Image->SetVolumeLoader(m_Loader, 3);
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+    m_Loader = nullptr;
+  }
+
+  void GetVolumeData_NotSet_LoadsVolume()
+  {
+    CPPUNIT_ASSERT_MESSAGE("Volume is available", m_Image->IsVolumeSet(5));
+    CPPUNIT_ASSERT_EQUAL(0u, m_Loader->numberOfLoads);
+
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned char>(5), this->ReadFirstValue(5));
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned char>(5), this->ReadFirstValue(5));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Volume is loaded once", 1u, m_Loader->numberOfLoads);
+  }
+
+  void GetVolumeData_MaximumReached_ReleasesLeastRecentlyUsed()
+  {
+    for (unsigned int t = 0; t < 6; ++t)
+      this->ReadFirstValue(t);
+
+    CPPUNIT_ASSERT_EQUAL(3u, m_Image->GetNumberOfLoadedVolumes());
+
+    // time step 5 is still loaded, time step 0 was released
+    this->ReadFirstValue(5);
+    CPPUNIT_ASSERT_EQUAL(6u, m_Loader->numberOfLoads);
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned char>(0), this->ReadFirstValue(0));
+    CPPUNIT_ASSERT_EQUAL(7u, m_Loader->numberOfLoads);
+  }
+
+  void GetVolumeData_AccessedVolume_IsNotReleased()
+  {
+    mitk::ImageReadAccessor accessor(m_Image, m_Image->GetVolumeData(0));
+
+    for (unsigned int t = 1; t < 6; ++t)
+      this->ReadFirstValue(t);
+
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned char>(0), static_cast<const unsigned char *>(accessor.GetData())[0]);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Accessed volume is not loaded again", 6u, m_Loader->numberOfLoads);
+  }
+
+  void GetVolumeData_ModifiedImage_ReleasesVolumes()
+  {
+    this->ReadFirstValue(0);
+    m_Image->Modified();
+
+    for (unsigned int t = 1; t < 6; ++t)
+      this->ReadFirstValue(t);
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Modified() does not pin loaded volumes", 3u, m_Image->GetNumberOfLoadedVolumes());
+    this->ReadFirstValue(0);
+    CPPUNIT_ASSERT_EQUAL(7u, m_Loader->numberOfLoads);
+  }
+
+  void GetVolumeData_WrittenVolume_IsKept()
+  {
+    {
+      mitk::ImageWriteAccessor accessor(m_Image, m_Image->GetVolumeData(0));
+      static_cast<unsigned char *>(accessor.GetData())[0] = 42;
+    }
+
+    for (unsigned int t = 1; t < 6; ++t)
+      this->ReadFirstValue(t);
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Written value is kept", static_cast<unsigned char>(42), this->ReadFirstValue(0));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Written volume is not loaded again", 6u, m_Loader->numberOfLoads);
+  }
+
+  void GetVolumeData_SetSlice_KeepsVolume()
+  {
+    this->ReadFirstValue(0);
+    std::vector<unsigned char> slice(8 * 8, 42);
+    m_Image->SetSlice(slice.data(), 0, 0);
+
+    for (unsigned int t = 1; t < 6; ++t)
+      this->ReadFirstValue(t);
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Set slice is kept", static_cast<unsigned char>(42), this->ReadFirstValue(0));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Changed volume is not loaded again", 6u, m_Loader->numberOfLoads);
+  }
+
+  void ReadAccessor_WholeImage_LoadsAllAndRemovesLoader()
+  {
+    mitk::ImageReadAccessor accessor(m_Image);
+    auto data = static_cast<const unsigned char *>(accessor.GetData());
+
+    bool correct = true;
+    for (unsigned int t = 0; t < 10; ++t)
+      correct = correct && data[t * m_Loader->volumeSize] == t;
+
+    CPPUNIT_ASSERT_MESSAGE("All time steps are loaded", correct);
+    CPPUNIT_ASSERT_MESSAGE("Loader is removed", m_Image->GetVolumeLoader() == nullptr);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkImageVolumeLoader)
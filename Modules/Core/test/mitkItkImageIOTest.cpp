@@ -21,13 +21,16 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkIOUtil.h"
 #include "mitkITKImageImport.h"
+#include "mitkImageReadAccessor.h"
 #include <mitkExtractSliceFilter.h>
 
 #include "itksys/SystemTools.hxx"
 #include <itkImageRegionIterator.h>
 
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <map>
 
 #ifdef WIN32
 #include "process.h"
@@ -47,6 +50,7 @@ class mitkItkImageIOTestSuite : public mitk::TestFixture
   MITK_TEST(TestWrite3DImageWithTwoPlanes);
   MITK_TEST(TestWrite3DplusT_ArbitraryTG);
   MITK_TEST(TestWrite3DplusT_ProportionalTG);
+  MITK_TEST(TestNRRDCompressionOptions);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -422,6 +426,87 @@ public:
     CPPUNIT_ASSERT_THROW(mitk::IOUtil::Save(image, mitk::IOUtil::CreateTemporaryFile("3Dto2DTestImageXXXXXX.png")),
                          mitk::Exception);
   }
+
+  /**
+  * Write a segmentation-like NRRD with each compression option, check the encoding in the header
+  * and compare the data read back
+  */
+  void TestNRRDCompressionOptions()
+  {
+    typedef itk::Image<unsigned char, 3> ImageType;
+
+    ImageType::SizeType size;
+    size[0] = 256;
+    size[1] = 256;
+    size[2] = 128;
+
+    ImageType::RegionType region;
+    region.SetSize(size);
+    ImageType::Pointer itkImage = ImageType::New();
+    itkImage->SetRegions(region);
+    itkImage->Allocate();
+
+    // a few labeled boxes with noise at their borders
+    unsigned int seed = 1;
+    for (itk::ImageRegionIterator<ImageType> it(itkImage, region); !it.IsAtEnd(); ++it)
+    {
+      const ImageType::IndexType index = it.GetIndex();
+      unsigned char label = static_cast<unsigned char>((index[0] / 64 + index[1] / 64 + index[2] / 32) % 4);
+      seed = seed * 1103515245 + 12345;
+      if (index[0] % 64 == 0 && (seed >> 16) % 2 == 0)
+        label = 0;
+      it.Set(label);
+    }
+    mitk::Image::Pointer image = mitk::ImportItkImage(itkImage);
+    const std::size_t dataSize = size[0] * size[1] * size[2];
+
+    const char *compressions[] = {"Parallel gzip", "Default", "None"};
+    std::map<std::string, std::streamoff> fileSizes;
+    for (const char *compression : compressions)
+    {
+      const std::string path = mitk::IOUtil::CreateTemporaryFile("CompressionTestImageXXXXXX.nrrd");
+
+      mitk::IFileWriter::Options options;
+      options["Compression"] = std::string(compression);
+      mitk::IOUtil::Save(image, path, options);
+
+      // the header ends with an empty line, the data follows
+      std::ifstream file(path.c_str(), std::ios::binary);
+      std::string encoding;
+      std::string line;
+      while (std::getline(file, line) && !line.empty())
+      {
+        if (line.compare(0, 10, "encoding: ") == 0)
+          encoding = line.substr(10);
+      }
+      unsigned char magic[2] = {0, 0};
+      file.read(reinterpret_cast<char *>(magic), 2);
+      file.seekg(0, std::ios::end);
+      fileSizes[compression] = file.tellg();
+      file.close();
+
+      if (std::string(compression) == "None")
+      {
+        CPPUNIT_ASSERT_EQUAL(std::string("raw"), encoding);
+      }
+      else
+      {
+        CPPUNIT_ASSERT_EQUAL_MESSAGE(std::string("Encoding with compression ") + compression, std::string("gzip"), encoding);
+        CPPUNIT_ASSERT_MESSAGE(std::string("Data starts with the gzip magic number with compression ") + compression,
+                               magic[0] == 0x1f && magic[1] == 0x8b);
+      }
+
+      mitk::Image::Pointer compareImage = mitk::IOUtil::LoadImage(path);
+      mitk::ImageReadAccessor expected(image);
+      mitk::ImageReadAccessor actual(compareImage);
+      CPPUNIT_ASSERT_MESSAGE(std::string("Data is equal after writing with compression ") + compression,
+                             std::memcmp(expected.GetData(), actual.GetData(), dataSize) == 0);
+
+      std::remove(path.c_str());
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("Parallel gzip compresses the data", fileSizes["Parallel gzip"] < fileSizes["None"]);
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkItkImageIO)
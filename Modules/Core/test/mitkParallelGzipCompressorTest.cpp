@@ -0,0 +1,110 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkParallelGzipCompressor.h>
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <itk_zlib.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+class mitkParallelGzipCompressorTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkParallelGzipCompressorTestSuite);
+  MITK_TEST(Compress_EmptyData_DecodesToEmptyData);
+  MITK_TEST(Compress_LessThanOneBlock_DecodesToData);
+  MITK_TEST(Compress_PartialLastBlock_DecodesToData);
+  MITK_TEST(Compress_SingleThread_DecodesToData);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  // the smallest block size the compressor uses
+  static const std::size_t BlockSize = 64 * 1024;
+
+  /** Compressible data: runs of values with some noise */
+  std::vector<unsigned char> CreateData(std::size_t size)
+  {
+    std::vector<unsigned char> data(size);
+    unsigned int seed = 1;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      data[i] = static_cast<unsigned char>((i / 97) % 5 + ((seed >> 16) % 8 == 0 ? 1 : 0));
+    }
+    return data;
+  }
+
+  /** Decodes a gzip stream with zlib, fails if it is not a single complete gzip member */
+  std::vector<unsigned char> Decode(const std::string &gzip)
+  {
+    CPPUNIT_ASSERT_MESSAGE("Stream starts with the gzip magic number",
+                           gzip.size() >= 2 && static_cast<unsigned char>(gzip[0]) == 0x1f &&
+                             static_cast<unsigned char>(gzip[1]) == 0x8b);
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(gzip.data()));
+    stream.avail_in = static_cast<uInt>(gzip.size());
+    CPPUNIT_ASSERT_EQUAL(Z_OK, inflateInit2(&stream, 16 + MAX_WBITS));
+
+    std::vector<unsigned char> decoded;
+    unsigned char buffer[4096];
+    int result = Z_OK;
+    while (result == Z_OK)
+    {
+      stream.next_out = buffer;
+      stream.avail_out = sizeof(buffer);
+      result = inflate(&stream, Z_NO_FLUSH);
+      decoded.insert(decoded.end(), buffer, buffer + sizeof(buffer) - stream.avail_out);
+    }
+    const uInt remainingInput = stream.avail_in;
+    inflateEnd(&stream);
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("The gzip stream is complete and its checksum is valid", Z_STREAM_END, result);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Nothing follows the gzip member", static_cast<uInt>(0), remainingInput);
+    return decoded;
+  }
+
+  void CheckRoundTrip(std::size_t size, unsigned int numberOfThreads)
+  {
+    const std::vector<unsigned char> data = CreateData(size);
+
+    std::ostringstream stream;
+    mitk::ParallelGzipCompressor::Compress(data.data(), data.size(), stream, 6, numberOfThreads, BlockSize);
+    CPPUNIT_ASSERT(stream.good());
+
+    const std::vector<unsigned char> decoded = Decode(stream.str());
+    CPPUNIT_ASSERT_EQUAL(data.size(), decoded.size());
+    CPPUNIT_ASSERT_MESSAGE("Decoded data equals the input", data == decoded);
+  }
+
+public:
+  void Compress_EmptyData_DecodesToEmptyData() { CheckRoundTrip(0, 4); }
+
+  void Compress_LessThanOneBlock_DecodesToData() { CheckRoundTrip(1000, 4); }
+
+  // two threads compress groups of eight blocks, so the ten blocks are written in two groups
+  void Compress_PartialLastBlock_DecodesToData() { CheckRoundTrip(9 * BlockSize + 123, 2); }
+
+  void Compress_SingleThread_DecodesToData() { CheckRoundTrip(3 * BlockSize + 1, 1); }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkParallelGzipCompressor)
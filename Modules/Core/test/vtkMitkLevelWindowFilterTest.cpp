@@ -0,0 +1,148 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+
+#include <vtkMitkLevelWindowFilter.h>
+
+#include <vtkColorTransferFunction.h>
+#include <vtkImageData.h>
+#include <vtkLookupTable.h>
+#include <vtkSmartPointer.h>
+
+#include <cstring>
+
+class vtkMitkLevelWindowFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(vtkMitkLevelWindowFilterTestSuite);
+  MITK_TEST(ValueTable_LogLookupTable_MatchesMapValue);
+  MITK_TEST(ValueTable_ColorTransferFunction_MatchesGetColor);
+  MITK_TEST(Execute_ClippingBounds_OutsideIsTransparent);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  template <class T>
+  vtkSmartPointer<vtkImageData> CreateImage(int size, int scalarType, int numberOfValues)
+  {
+    auto image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(size, size, 1);
+    image->AllocateScalars(scalarType, 1);
+
+    auto *data = static_cast<T *>(image->GetScalarPointer());
+    for (int i = 0; i < size * size; ++i)
+      data[i] = static_cast<T>((i * 7) % numberOfValues);
+
+    return image;
+  }
+
+  vtkSmartPointer<vtkImageData> Apply(vtkImageData *image, vtkScalarsToColors *lookupTable, double *clippingBounds)
+  {
+    auto filter = vtkSmartPointer<vtkMitkLevelWindowFilter>::New();
+    filter->SetLookupTable(lookupTable);
+    filter->SetClippingBounds(clippingBounds);
+    filter->SetInputData(image);
+    filter->Update();
+    return filter->GetOutput();
+  }
+
+  vtkSmartPointer<vtkLookupTable> CreateLinearLookupTable()
+  {
+    auto lookupTable = vtkSmartPointer<vtkLookupTable>::New();
+    lookupTable->SetTableRange(0, 1000);
+    lookupTable->SetNumberOfColors(256);
+    lookupTable->Build();
+    return lookupTable;
+  }
+
+public:
+  void ValueTable_LogLookupTable_MatchesMapValue()
+  {
+    const int size = 512;
+    vtkSmartPointer<vtkImageData> image = this->CreateImage<unsigned short>(size, VTK_UNSIGNED_SHORT, 4096);
+
+    auto lookupTable = vtkSmartPointer<vtkLookupTable>::New();
+    lookupTable->SetScaleToLog10();
+    lookupTable->SetTableRange(1, 4000);
+    lookupTable->Build();
+
+    double clippingBounds[4] = {0, size, 0, size};
+    vtkSmartPointer<vtkImageData> output = this->Apply(image, lookupTable, clippingBounds);
+
+    auto *input = static_cast<unsigned short *>(image->GetScalarPointer());
+    auto *rgba = static_cast<unsigned char *>(output->GetScalarPointer());
+    bool equal = true;
+    for (int i = 0; i < size * size && equal; ++i)
+      equal = std::memcmp(rgba + 4 * i, lookupTable->MapValue(input[i]), 4) == 0;
+
+    CPPUNIT_ASSERT_MESSAGE("Table mapping of 16 bit values equals MapValue", equal);
+  }
+
+  void ValueTable_ColorTransferFunction_MatchesGetColor()
+  {
+    const int size = 64;
+    vtkSmartPointer<vtkImageData> image = this->CreateImage<unsigned char>(size, VTK_UNSIGNED_CHAR, 256);
+
+    auto transferFunction = vtkSmartPointer<vtkColorTransferFunction>::New();
+    transferFunction->AddRGBPoint(0, 0, 0, 1);
+    transferFunction->AddRGBPoint(128, 0, 1, 0);
+    transferFunction->AddRGBPoint(255, 1, 0, 0);
+
+    double clippingBounds[4] = {0, size, 0, size};
+    vtkSmartPointer<vtkImageData> output = this->Apply(image, transferFunction, clippingBounds);
+
+    auto *input = static_cast<unsigned char *>(image->GetScalarPointer());
+    auto *rgba = static_cast<unsigned char *>(output->GetScalarPointer());
+    bool equal = true;
+    for (int i = 0; i < size * size && equal; ++i)
+    {
+      double color[3];
+      transferFunction->GetColor(input[i], color);
+      for (int c = 0; c < 3; ++c)
+        equal = equal && rgba[4 * i + c] == static_cast<unsigned char>(255.0 * color[c] + 0.5);
+      equal = equal && rgba[4 * i + 3] == 255;
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("Table mapping of 8 bit values equals the color transfer function", equal);
+  }
+
+  void Execute_ClippingBounds_OutsideIsTransparent()
+  {
+    const int size = 32;
+    vtkSmartPointer<vtkImageData> image = this->CreateImage<float>(size, VTK_FLOAT, 1000);
+    vtkSmartPointer<vtkLookupTable> lookupTable = this->CreateLinearLookupTable();
+    lookupTable->SetAlphaRange(1, 1);
+    lookupTable->ForceBuild();
+
+    double clippingBounds[4] = {8, 16, 4, 12};
+    vtkSmartPointer<vtkImageData> output = this->Apply(image, lookupTable, clippingBounds);
+
+    bool correct = true;
+    for (int y = 0; y < size; ++y)
+    {
+      for (int x = 0; x < size; ++x)
+      {
+        auto *rgba = static_cast<unsigned char *>(output->GetScalarPointer(x, y, 0));
+        bool inside = x >= 8 && x < 16 && y >= 4 && y < 12;
+        correct = correct && (inside ? rgba[3] == 255 : rgba[3] == 0);
+      }
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("Only pixels within the clipping bounds are opaque", correct);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(vtkMitkLevelWindowFilter)
@@ -153,6 +153,37 @@ int vtkMitkThickSlicesFilterTest(int, char *[])
   thickSliceFilter->Update();
   vtkMitkThickSlicesFilterTestHelper::EvaluateResult(6, thickSliceFilter->GetOutput(), "Mean");
 
+  //////////////////////////////////////////////////////////////////////////
+  // Slab moved by one slice:
+  // 444444444
+  // ...
+  // 999999999
+  // The mean and sum are updated from the previous slab.
+
+  mitk::Image::Pointer testImage3 = vtkMitkThickSlicesFilterTestHelper::CreateTestImage(4, 9);
+  thickSliceFilter->SetInputData(testImage3->GetVtkImageData());
+
+  // Mean, sliding from testImage2
+  thickSliceFilter->SetSlidingWindowShift(1);
+  thickSliceFilter->Modified();
+  thickSliceFilter->Update();
+  vtkMitkThickSlicesFilterTestHelper::EvaluateResult(7, thickSliceFilter->GetOutput(), "Mean (sliding)");
+  MITK_TEST_CONDITION(thickSliceFilter->GetSlidingWindowShift() == 0, "Sliding window shift is reset after execution");
+
+  // Sum, full computation because the mode changed
+  thickSliceFilter->SetThickSliceMode(1);
+  thickSliceFilter->SetSlidingWindowShift(1);
+  thickSliceFilter->Modified();
+  thickSliceFilter->Update();
+  vtkMitkThickSlicesFilterTestHelper::EvaluateResult(6, thickSliceFilter->GetOutput(), "Sum");
+
+  // Sum, sliding back to testImage2
+  thickSliceFilter->SetInputData(testImage2->GetVtkImageData());
+  thickSliceFilter->SetSlidingWindowShift(-1);
+  thickSliceFilter->Modified();
+  thickSliceFilter->Update();
+  vtkMitkThickSlicesFilterTestHelper::EvaluateResult(5, thickSliceFilter->GetOutput(), "Sum (sliding)");
+
   thickSliceFilter->Delete();
 
   MITK_TEST_END()
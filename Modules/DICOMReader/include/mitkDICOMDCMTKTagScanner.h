@@ -30,7 +30,13 @@ namespace mitk
     \ingroup DICOMReaderModule
     \brief Encapsulates the tag scanning process for a set of DICOM files.
 
-    For the scanning process it uses DCMTK functionality.
+    For the scanning process it uses DCMTK functionality. The files are
+    scanned by several threads, and each file is only parsed up to the
+    pixel data.
+
+    Optionally the scan results are kept in a persistent tag index (see
+    SetIndexFileName()), so that a repeated scan of the same files only
+    parses files that were changed in between.
   */
   class MITKDICOMREADER_EXPORT DICOMDCMTKTagScanner : public DICOMTagScanner
   {
@@ -82,6 +88,27 @@ namespace mitk
       */
       DICOMTagCache::Pointer GetScanCache() const override;
 
+      /**
+      \brief Number of threads used for scanning (default 0 = number of cores).
+      */
+      itkSetMacro(NumberOfThreads, unsigned int);
+      itkGetConstMacro(NumberOfThreads, unsigned int);
+
+      /**
+      \brief File name of the persistent tag index (default empty = no index).
+      Files are looked up by path, size and modification time. Their values are
+      taken from the index if it contains all scanned tags, the other files are
+      parsed. Scan() writes the updated index back to the file.
+      */
+      itkSetStringMacro(IndexFileName);
+      itkGetStringMacro(IndexFileName);
+
+      /**
+      \brief Number of files parsed by the last Scan().
+      Files whose values were taken from the tag index are not counted.
+      */
+      itkGetConstMacro(NumberOfParsedFiles, unsigned int);
+
     protected:
 
       DICOMDCMTKTagScanner();
@@ -90,6 +117,9 @@ namespace mitk
       std::set<DICOMTagPath> m_ScannedTags;
       StringList m_InputFilenames;
       DICOMGenericTagCache::Pointer m_Cache;
+      unsigned int m_NumberOfThreads;
+      std::string m_IndexFileName;
+      unsigned int m_NumberOfParsedFiles;
 
     private:
       DICOMDCMTKTagScanner(const DICOMDCMTKTagScanner&);
@@ -80,8 +80,13 @@ class MITKDICOMREADER_EXPORT DICOMFileReaderSelector : public itk::LightObject
     const StringList& GetInputFiles() const;
 
     /// Execute the analysis and selection process. The first reader with a minimal number of outputs will be returned.
+    /// The input files are scanned once for the tags of all readers, the readers then analyze the files in parallel.
     DICOMFileReader::Pointer GetFirstReaderWithMinimumNumberOfOutputImages();
 
+    /// \brief Time in seconds each reader of GetAllConfiguredReaders() needed to analyze the input files
+    /// during the last selection, -1 for readers that failed.
+    std::vector<double> GetReaderAnalysisTimes() const;
+
   protected:
 
     DICOMFileReaderSelector();
@@ -96,6 +101,7 @@ class MITKDICOMREADER_EXPORT DICOMFileReaderSelector : public itk::LightObject
     StringList m_PossibleConfigurations;
     StringList m_InputFilenames;
     ReaderList m_Readers;
+    std::vector<double> m_ReaderAnalysisTimes;
 
  };
 
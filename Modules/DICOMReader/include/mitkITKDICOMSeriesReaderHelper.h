@@ -87,6 +87,22 @@ class ITKDICOMSeriesReaderHelper
     typename ImageType::Pointer
     FixUpTiltedGeometry( ImageType* input, const GantryTiltInformation& tiltInfo );
 
+    /** Decodes the files concurrently, file i into the memory at destinations[i], which must
+     provide sliceSizeInBytes. Progress is reported per slice to the mitk::ProgressBar.
+     @return false if a file cannot be decoded directly into the memory, e.g. because its pixel
+     type differs from the first file. The content of the memory is undefined then.
+     */
+    static bool ReadSlicesConcurrently( const StringContainer& filenames,
+                                        const std::vector<void*>& destinations,
+                                        std::size_t sliceSizeInBytes );
+
+    /** Decodes all slices of all time steps concurrently into the volumes of the initialized image.
+     @return false if the slices do not fit into the image or cannot be decoded directly.
+     */
+    template <typename PixelType>
+    bool
+    ReadTimeStepsConcurrently( Image* image, const StringContainerList& filenamesOfTimeSteps );
+
     template <typename PixelType>
     Image::Pointer
     LoadDICOMByITK( const StringContainer& filenames,
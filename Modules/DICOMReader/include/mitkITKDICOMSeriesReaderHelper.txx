@@ -17,6 +17,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkImageSeriesReader.h>
 #include <itkResampleImageFilter.h>
+
+#include "mitkImageWriteAccessor.h"
+
+#include <memory>
 //#include <itkAffineTransform.h>
 //#include <itkLinearInterpolateImageFunction.h>
 //#include <itkTimeProbesCollectorBase.h>
@@ -49,17 +53,37 @@ mitk::ITKDICOMSeriesReaderHelper
                              // see NormalDirectionConsistencySorter.
 
   reader->SetFileNames(filenames);
-  reader->Update();
-  typename ImageType::Pointer readVolume = reader->GetOutput();
 
-  // if we detected that the images are from a tilted gantry acquisition, we need to push some pixels into the right position
-  if (correctTilt)
+  bool loaded = false;
+  if (!correctTilt)
   {
-    readVolume = FixUpTiltedGeometry( reader->GetOutput(), tiltInfo );
+    // only the headers are read by the series reader, the slices are decoded
+    // concurrently, directly into the volume of the mitk::Image
+    reader->UpdateOutputInformation();
+    image->InitializeByItk(reader->GetOutput());
+
+    StringContainerList filenamesOfTimeSteps(1, filenames);
+    loaded = ReadTimeStepsConcurrently<PixelType>(image, filenamesOfTimeSteps);
+    if (!loaded)
+    {
+      image = mitk::Image::New();
+    }
   }
 
-  image->InitializeByItk(readVolume.GetPointer());
-  image->SetImportVolume(readVolume->GetBufferPointer());
+  if (!loaded)
+  {
+    reader->Update();
+    typename ImageType::Pointer readVolume = reader->GetOutput();
+
+    // if we detected that the images are from a tilted gantry acquisition, we need to push some pixels into the right position
+    if (correctTilt)
+    {
+      readVolume = FixUpTiltedGeometry( reader->GetOutput(), tiltInfo );
+    }
+
+    image->InitializeByItk(readVolume.GetPointer());
+    image->SetImportVolume(readVolume->GetBufferPointer());
+  }
 
 #ifdef MBILOG_ENABLE_DEBUG
 
@@ -117,46 +141,65 @@ mitk::ITKDICOMSeriesReaderHelper
                              // see NormalDirectionConsistencySorter.
 
 
-  unsigned int currentTimeStep = 0;
-
-#ifdef MBILOG_ENABLE_DEBUG
-  MITK_DEBUG << "Start loading timestep " << currentTimeStep;
-  MITK_DEBUG_OUTPUT_FILELIST( filenamesForTimeSteps.front() )
-#endif // MBILOG_ENABLE_DEBUG
-
   reader->SetFileNames(filenamesForTimeSteps.front());
-  reader->Update();
-  typename ImageType::Pointer readVolume = reader->GetOutput();
 
-  // if we detected that the images are from a tilted gantry acquisition, we need to push some pixels into the right position
-  if (correctTilt)
+  bool loaded = false;
+  if (!correctTilt)
   {
-    readVolume = FixUpTiltedGeometry( reader->GetOutput(), tiltInfo );
-  }
+    // only the headers of the first time step are read by the series reader, the slices
+    // of all time steps are decoded concurrently, directly into the volumes of the mitk::Image
+    reader->UpdateOutputInformation();
+    image->InitializeByItk(reader->GetOutput(), 1, numberOfTimeSteps);
 
-  image->InitializeByItk(readVolume.GetPointer(), 1, numberOfTimeSteps);
-  image->SetImportVolume(readVolume->GetBufferPointer(), currentTimeStep++); // timestep 0
+    loaded = ReadTimeStepsConcurrently<PixelType>(image, filenamesForTimeSteps);
+    if (!loaded)
+    {
+      image = mitk::Image::New();
+    }
+  }
 
-  // for other time-steps
-  for (auto timestepsIter = ++(filenamesForTimeSteps.cbegin()); // start with SECOND entry
-      timestepsIter != filenamesForTimeSteps.cend();
-      ++currentTimeStep, ++timestepsIter)
+  if (!loaded)
   {
+    unsigned int currentTimeStep = 0;
+
 #ifdef MBILOG_ENABLE_DEBUG
     MITK_DEBUG << "Start loading timestep " << currentTimeStep;
-    MITK_DEBUG_OUTPUT_FILELIST( *timestepsIter )
+    MITK_DEBUG_OUTPUT_FILELIST( filenamesForTimeSteps.front() )
 #endif // MBILOG_ENABLE_DEBUG
 
-    reader->SetFileNames( *timestepsIter );
     reader->Update();
-    readVolume = reader->GetOutput();
+    typename ImageType::Pointer readVolume = reader->GetOutput();
 
+    // if we detected that the images are from a tilted gantry acquisition, we need to push some pixels into the right position
     if (correctTilt)
     {
       readVolume = FixUpTiltedGeometry( reader->GetOutput(), tiltInfo );
     }
 
-    image->SetImportVolume(readVolume->GetBufferPointer(), currentTimeStep);
+    image->InitializeByItk(readVolume.GetPointer(), 1, numberOfTimeSteps);
+    image->SetImportVolume(readVolume->GetBufferPointer(), currentTimeStep++); // timestep 0
+
+    // for other time-steps
+    for (auto timestepsIter = ++(filenamesForTimeSteps.cbegin()); // start with SECOND entry
+        timestepsIter != filenamesForTimeSteps.cend();
+        ++currentTimeStep, ++timestepsIter)
+    {
+#ifdef MBILOG_ENABLE_DEBUG
+      MITK_DEBUG << "Start loading timestep " << currentTimeStep;
+      MITK_DEBUG_OUTPUT_FILELIST( *timestepsIter )
+#endif // MBILOG_ENABLE_DEBUG
+
+      reader->SetFileNames( *timestepsIter );
+      reader->Update();
+      readVolume = reader->GetOutput();
+
+      if (correctTilt)
+      {
+        readVolume = FixUpTiltedGeometry( reader->GetOutput(), tiltInfo );
+      }
+
+      image->SetImportVolume(readVolume->GetBufferPointer(), currentTimeStep);
+    }
   }
 
 #ifdef MBILOG_ENABLE_DEBUG
@@ -176,6 +219,39 @@ mitk::ITKDICOMSeriesReaderHelper
 }
 
 
+template <typename PixelType>
+bool
+mitk::ITKDICOMSeriesReaderHelper
+::ReadTimeStepsConcurrently( Image* image, const StringContainerList& filenamesOfTimeSteps )
+{
+  const std::size_t sliceSizeInBytes = sizeof(PixelType) * image->GetDimension(0) * image->GetDimension(1);
+
+  StringContainer filenames;
+  std::vector<void*> destinations;
+  std::vector<std::unique_ptr<ImageWriteAccessor>> accessors;
+
+  unsigned int timeStep = 0;
+  for (auto timestepsIter = filenamesOfTimeSteps.cbegin(); timestepsIter != filenamesOfTimeSteps.cend(); ++timeStep, ++timestepsIter)
+  {
+    if ( timeStep >= image->GetDimension(3) || timestepsIter->size() != image->GetDimension(2) )
+    {
+      MITK_DEBUG << "Time step " << timeStep << " does not fit into the image, falling back to sequential loading";
+      return false;
+    }
+
+    accessors.emplace_back(new ImageWriteAccessor(image, image->GetVolumeData(timeStep)));
+    char* volume = static_cast<char*>(accessors.back()->GetData());
+
+    for (std::size_t slice = 0; slice < timestepsIter->size(); ++slice)
+    {
+      filenames.push_back((*timestepsIter)[slice]);
+      destinations.push_back(volume + slice * sliceSizeInBytes);
+    }
+  }
+
+  return ReadSlicesConcurrently(filenames, destinations, sliceSizeInBytes);
+}
+
 template <typename ImageType>
 typename ImageType::Pointer
 mitk::ITKDICOMSeriesReaderHelper
@@ -19,8 +19,189 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <dcmtk/dcmdata/dcfilefo.h>
 #include <dcmtk/dcmdata/dcpath.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <fstream>
+#include <locale>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+  /** Scan result of one file as stored in the tag index. */
+  struct IndexEntry
+  {
+    unsigned long long size = 0;
+    long long modificationTime = 0;
+    std::set<std::string> scannedTags; ///< property names of the scanned tag paths
+    std::vector<std::pair<mitk::DICOMTagPath, std::string>> values;
+  };
+
+  typedef std::map<std::string, IndexEntry> IndexType;
+
+  const char *const indexHeader = "MITK DICOM tag index 1";
+
+  std::string Escape(const std::string &str)
+  {
+    std::string result;
+    result.reserve(str.size());
+    for (char c : str)
+    {
+      switch (c)
+      {
+        case '\\': result += "\\\\"; break;
+        case '\t': result += "\\t"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        default: result += c;
+      }
+    }
+    return result;
+  }
+
+  std::string Unescape(const std::string &str)
+  {
+    std::string result;
+    result.reserve(str.size());
+    for (std::size_t i = 0; i < str.size(); ++i)
+    {
+      if (str[i] == '\\' && i + 1 < str.size())
+      {
+        ++i;
+        switch (str[i])
+        {
+          case 't': result += '\t'; break;
+          case 'n': result += '\n'; break;
+          case 'r': result += '\r'; break;
+          default: result += str[i];
+        }
+      }
+      else
+      {
+        result += str[i];
+      }
+    }
+    return result;
+  }
+
+  std::vector<std::string> SplitLine(const std::string &line)
+  {
+    std::vector<std::string> fields;
+    std::size_t start = 0;
+    std::size_t end;
+    while ((end = line.find('\t', start)) != std::string::npos)
+    {
+      fields.push_back(Unescape(line.substr(start, end - start)));
+      start = end + 1;
+    }
+    fields.push_back(Unescape(line.substr(start)));
+    return fields;
+  }
+
+  /*
+  Format (one record per line, fields separated by tabs):
+    F path size modificationTime   starts the entry of a file
+    S tagPath                      tag path that was scanned for the file
+    V tagPath value                tag path and value that were found
+  Tag paths are stored as property names (DICOMTagPathToPropertyName()).
+  */
+  IndexType ReadIndex(const std::string &fileName)
+  {
+    IndexType index;
+
+    std::ifstream stream(fileName.c_str());
+    if (!stream.is_open())
+      return index;
+    stream.imbue(std::locale::classic());
+
+    std::string line;
+    if (!std::getline(stream, line) || line != indexHeader)
+    {
+      MITK_WARN << "Ignoring DICOM tag index of unknown format: " << fileName;
+      return index;
+    }
+
+    try
+    {
+      IndexEntry *entry = nullptr;
+      while (std::getline(stream, line))
+      {
+        std::vector<std::string> fields = SplitLine(line);
+        if (fields[0] == "F" && fields.size() == 4)
+        {
+          entry = &index[fields[1]];
+          *entry = IndexEntry();
+          entry->size = std::stoull(fields[2]);
+          entry->modificationTime = std::stoll(fields[3]);
+        }
+        else if (fields[0] == "S" && fields.size() == 2 && entry != nullptr)
+        {
+          entry->scannedTags.insert(fields[1]);
+        }
+        else if (fields[0] == "V" && fields.size() == 3 && entry != nullptr)
+        {
+          entry->values.emplace_back(mitk::PropertyNameToDICOMTagPath(fields[1]), fields[2]);
+        }
+        else
+        {
+          throw std::invalid_argument(line);
+        }
+      }
+    }
+    catch (const std::exception &)
+    {
+      MITK_WARN << "Ignoring DICOM tag index with invalid content: " << fileName;
+      return IndexType();
+    }
+
+    return index;
+  }
+
+  void WriteIndex(const std::string &fileName, const IndexType &index)
+  {
+    // write to a temporary file first, so that an interrupted scan does not leave a broken index
+    std::string tempFileName = fileName + ".tmp";
+    {
+      std::ofstream stream(tempFileName.c_str(), std::ios::trunc);
+      if (!stream.is_open())
+      {
+        MITK_WARN << "Cannot write DICOM tag index: " << fileName;
+        return;
+      }
+      stream.imbue(std::locale::classic());
+
+      stream << indexHeader << '\n';
+      for (const auto &file : index)
+      {
+        stream << "F\t" << Escape(file.first) << '\t' << file.second.size << '\t' << file.second.modificationTime << '\n';
+        for (const auto &tag : file.second.scannedTags)
+          stream << "S\t" << Escape(tag) << '\n';
+        for (const auto &value : file.second.values)
+          stream << "V\t" << Escape(mitk::DICOMTagPathToPropertyName(value.first)) << '\t' << Escape(value.second) << '\n';
+      }
+    }
+
+    itksys::SystemTools::RemoveFile(fileName);
+    if (!itksys::SystemTools::RenameFile(tempFileName.c_str(), fileName.c_str()))
+      MITK_WARN << "Cannot write DICOM tag index: " << fileName;
+  }
+
+  void GetFileStatus(const std::string &fileName, IndexEntry &entry)
+  {
+    entry.size = itksys::SystemTools::FileLength(fileName);
+    entry.modificationTime = itksys::SystemTools::ModifiedTime(fileName);
+  }
+}
 
 mitk::DICOMDCMTKTagScanner::DICOMDCMTKTagScanner()
+  : m_NumberOfThreads(0), m_NumberOfParsedFiles(0)
 {
 }
 
@@ -102,66 +283,169 @@ mitk::DICOMTagPath DcmPathToTagPath(DcmPath * dcmpath)
   return result;
 }
 
+namespace
+{
+  /** Parses the file up to the pixel data and collects the values of the scanned tags. */
+  bool ScanFile(const std::string &fileName, const std::set<mitk::DICOMTagPath> &scannedTags, DcmPathProcessor &processor, IndexEntry &entry)
+  {
+    DcmFileFormat dfile;
+    OFCondition cond = dfile.loadFileUntilTag(fileName.c_str(), EXS_Unknown, EGL_noChange, DCM_MaxReadLength, ERM_autoDetect, DCM_PixelData);
+    if (cond.bad())
+    {
+      MITK_ERROR << "Error when scanning for tags. Cannot open given file. File: " << fileName;
+      return false;
+    }
+
+    for (const auto& path : scannedTags)
+    {
+      entry.scannedTags.insert(mitk::DICOMTagPathToPropertyName(path));
+
+      std::string tagPath = DICOMTagPathToDCMTKSearchPath(path);
+      cond = processor.findOrCreatePath(dfile.getDataset(), tagPath.c_str());
+      if (cond.good())
+      {
+        OFList< DcmPath * > findings;
+        processor.getResults(findings);
+        for (const auto& finding : findings)
+        {
+          auto element = dynamic_cast<DcmElement*>(finding->back()->m_obj);
+          if (!element)
+          {
+            auto item = dynamic_cast<DcmItem*>(finding->back()->m_obj);
+            if (item)
+            {
+              element = item->getElement(finding->back()->m_itemNo);
+            }
+          }
+
+          if (element)
+          {
+            OFString value;
+            cond = element->getOFStringArray(value);
+            if (cond.good())
+            {
+              entry.values.emplace_back(DcmPathToTagPath(finding), std::string(value.c_str()));
+            }
+          }
+        }
+      }
+    }
+
+    return true;
+  }
+
+  bool IsUpToDate(const IndexEntry &cached, const IndexEntry &status, const std::set<std::string> &scannedTags)
+  {
+    return cached.size == status.size && cached.modificationTime == status.modificationTime &&
+      std::includes(cached.scannedTags.cbegin(), cached.scannedTags.cend(), scannedTags.cbegin(), scannedTags.cend());
+  }
+}
+
 void mitk::DICOMDCMTKTagScanner::Scan()
 {
   this->PushLocale();
 
   try
   {
-    DcmPathProcessor processor;
-    processor.setItemWildcardSupport(true);
+    const std::size_t numberOfFiles = this->m_InputFilenames.size();
 
-    DICOMGenericTagCache::Pointer newCache = DICOMGenericTagCache::New();
+    IndexType index;
+    if (!m_IndexFileName.empty())
+      index = ReadIndex(m_IndexFileName);
 
-    for (const auto& fileName : this->m_InputFilenames)
+    std::set<std::string> scannedTagNames;
+    for (const auto& path : this->m_ScannedTags)
+      scannedTagNames.insert(DICOMTagPathToPropertyName(path));
+
+    // files that are known by the index do not need to be parsed again
+    std::vector<IndexEntry> entries(numberOfFiles);
+    std::vector<char> isValid(numberOfFiles, false); // not vector<bool>, elements are written concurrently
+    std::vector<std::size_t> filesToScan;
+
+    for (std::size_t i = 0; i < numberOfFiles; ++i)
     {
-      DcmFileFormat dfile;
-      OFCondition cond = dfile.loadFile(fileName.c_str());
-      if (cond.bad())
+      const std::string& fileName = this->m_InputFilenames[i];
+      if (!m_IndexFileName.empty())
       {
-        MITK_ERROR << "Error when scanning for tags. Cannot open given file. File: " << fileName;
+        GetFileStatus(fileName, entries[i]);
+        auto finding = index.find(fileName);
+        if (finding != index.end() && IsUpToDate(finding->second, entries[i], scannedTagNames))
+        {
+          entries[i] = finding->second;
+          isValid[i] = true;
+          continue;
+        }
       }
-      else
-      {
-        DICOMGenericImageFrameInfo::Pointer info = DICOMGenericImageFrameInfo::New(fileName);
+      filesToScan.push_back(i);
+    }
+
+    // the remaining files are distributed dynamically to the threads
+    std::atomic<std::size_t> nextFile(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
 
-        for (const auto& path : this->m_ScannedTags)
+    auto scanFiles = [&]()
+    {
+      DcmPathProcessor processor;
+      processor.setItemWildcardSupport(true);
+
+      try
+      {
+        for (std::size_t next = nextFile++; next < filesToScan.size(); next = nextFile++)
         {
-          std::string tagPath = DICOMTagPathToDCMTKSearchPath(path);
-          cond = processor.findOrCreatePath(dfile.getDataset(), tagPath.c_str());
-          if (cond.good())
-          {
-            OFList< DcmPath * > findings;
-            processor.getResults(findings);
-            for (const auto& finding : findings)
-            {
-              auto element = dynamic_cast<DcmElement*>(finding->back()->m_obj);
-              if (!element)
-              {
-                auto item = dynamic_cast<DcmItem*>(finding->back()->m_obj);
-                if (item)
-                {
-                  element = item->getElement(finding->back()->m_itemNo);
-                }
-              }
-
-              if (element)
-              {
-                OFString value;
-                cond = element->getOFStringArray(value);
-                if (cond.good())
-                {
-                  info->SetTagValue(DcmPathToTagPath(finding), std::string(value.c_str()));
-                }
-              }
-            }
-          }
+          const std::size_t i = filesToScan[next];
+          isValid[i] = ScanFile(this->m_InputFilenames[i], this->m_ScannedTags, processor, entries[i]);
         }
-        newCache->AddFrameInfo(info);
       }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+          error = std::current_exception();
+        nextFile = filesToScan.size();
+      }
+    };
+
+    unsigned int numberOfThreads = m_NumberOfThreads > 0 ? m_NumberOfThreads : std::thread::hardware_concurrency();
+    numberOfThreads = std::max(1u, std::min<unsigned int>(numberOfThreads, filesToScan.size()));
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < numberOfThreads; ++i)
+      threads.emplace_back(scanFiles);
+    scanFiles();
+    for (auto& thread : threads)
+      thread.join();
+
+    if (error)
+      std::rethrow_exception(error);
+
+    DICOMGenericTagCache::Pointer newCache = DICOMGenericTagCache::New();
+
+    for (std::size_t i = 0; i < numberOfFiles; ++i)
+    {
+      if (!isValid[i])
+        continue;
+
+      DICOMGenericImageFrameInfo::Pointer info = DICOMGenericImageFrameInfo::New(this->m_InputFilenames[i]);
+      for (const auto& value : entries[i].values)
+      {
+        info->SetTagValue(value.first, value.second);
+      }
+      newCache->AddFrameInfo(info);
+    }
+
+    if (!m_IndexFileName.empty() && !filesToScan.empty())
+    {
+      for (auto i : filesToScan)
+      {
+        if (isValid[i])
+          index[this->m_InputFilenames[i]] = entries[i];
+      }
+      WriteIndex(m_IndexFileName, index);
     }
 
     m_Cache = newCache;
+    m_NumberOfParsedFiles = static_cast<unsigned int>(filesToScan.size());
 
     this->PopLocale();
   }
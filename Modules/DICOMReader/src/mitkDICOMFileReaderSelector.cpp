@@ -24,6 +24,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <usModuleResourceStream.h>
 #include <usModule.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <thread>
+
 mitk::DICOMFileReaderSelector
 ::DICOMFileReaderSelector()
 {
@@ -182,71 +188,115 @@ mitk::DICOMFileReaderSelector
   return m_InputFilenames;
 }
 
+std::vector<double>
+mitk::DICOMFileReaderSelector
+::GetReaderAnalysisTimes() const
+{
+  return m_ReaderAnalysisTimes;
+}
+
 mitk::DICOMFileReader::Pointer
 mitk::DICOMFileReaderSelector
 ::GetFirstReaderWithMinimumNumberOfOutputImages()
 {
-  ReaderList workingCandidates;
+  typedef std::chrono::steady_clock Clock;
+
+  // do the tag scanning externally and just ONCE, for the tags of all readers
+  auto scanStart = Clock::now();
 
-  // do the tag scanning externally and just ONCE
   DICOMGDCMTagScanner::Pointer gdcmScanner = DICOMGDCMTagScanner::New();
   gdcmScanner->SetInputFiles( m_InputFilenames );
 
-  // let all readers analyze the file set
   for ( auto rIter = m_Readers.cbegin(); rIter != m_Readers.cend(); ++rIter )
   {
     gdcmScanner->AddTagPaths((*rIter)->GetTagsOfInterest());
   }
 
   gdcmScanner->Scan();
+  DICOMTagCache::Pointer tagCache = gdcmScanner->GetScanCache();
+
+  MITK_INFO << "Scanned tags of " << m_InputFilenames.size() << " files for " << m_Readers.size() << " readers in "
+            << std::chrono::duration<double>(Clock::now() - scanStart).count() << " s";
+
+  // let all readers analyze the file set, they only read from the shared tag cache,
+  // so they can be evaluated in parallel
+  const std::vector<DICOMFileReader::Pointer> readers(m_Readers.cbegin(), m_Readers.cend());
+  std::vector<char> succeeded(readers.size(), false); // not vector<bool>, elements are written concurrently
+  m_ReaderAnalysisTimes.assign(readers.size(), -1.0);
 
-  // let all readers analyze the file set
-  unsigned int readerIndex(0);
-  for ( auto rIter = m_Readers.cbegin(); rIter != m_Readers.cend(); ++readerIndex, ++rIter )
+  for (const auto& reader : readers)
   {
-    (*rIter)->SetInputFiles( m_InputFilenames );
-    (*rIter)->SetTagCache( gdcmScanner->GetScanCache() );
-    try
+    reader->SetInputFiles( m_InputFilenames );
+    reader->SetTagCache( tagCache );
+  }
+
+  std::atomic<std::size_t> nextReader(0);
+  auto analyzeReaders = [&]()
+  {
+    for (std::size_t readerIndex = nextReader++; readerIndex < readers.size(); readerIndex = nextReader++)
     {
-      (*rIter)->AnalyzeInputFiles();
-      workingCandidates.push_back( *rIter );
-      MITK_INFO << "Reader " << readerIndex << " (" << (*rIter)->GetConfigurationLabel() << ") suggests " << (*rIter)->GetNumberOfOutputs() << " 3D blocks";
-      if ((*rIter)->GetNumberOfOutputs() == 1)
+      const DICOMFileReader::Pointer& reader = readers[readerIndex];
+      auto start = Clock::now();
+      try
       {
-        MITK_DEBUG << "Early out with reader #" << readerIndex << " (" << (*rIter)->GetConfigurationLabel() << "), less than 1 block is not possible";
-        return *rIter;
+        reader->AnalyzeInputFiles();
+        succeeded[readerIndex] = true;
+        m_ReaderAnalysisTimes[readerIndex] = std::chrono::duration<double>(Clock::now() - start).count();
+      }
+      catch ( const std::exception& e )
+      {
+        MITK_ERROR << "Reader " << readerIndex << " (" << reader->GetConfigurationLabel() << ") threw exception during file analysis, ignoring this reader. Exception: " << e.what();
+      }
+      catch (...)
+      {
+        MITK_ERROR << "Reader " << readerIndex << " (" << reader->GetConfigurationLabel() << ") threw unknown exception during file analysis, ignoring this reader.";
       }
     }
-    catch ( const std::exception& e )
-    {
-      MITK_ERROR << "Reader " << readerIndex << " (" << (*rIter)->GetConfigurationLabel() << ") threw exception during file analysis, ignoring this reader. Exception: " << e.what();
-    }
-    catch (...)
-    {
-      MITK_ERROR << "Reader " << readerIndex << " (" << (*rIter)->GetConfigurationLabel() << ") threw unknown exception during file analysis, ignoring this reader.";
-    }
+  };
+
+  const unsigned int numberOfThreads = std::max(1u, std::min<unsigned int>(std::thread::hardware_concurrency(), readers.size()));
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < numberOfThreads; ++i)
+  {
+    threads.emplace_back(analyzeReaders);
+  }
+  analyzeReaders();
+  for (auto& thread : threads)
+  {
+    thread.join();
   }
 
   DICOMFileReader::Pointer bestReader;
 
   unsigned int minimumNumberOfOutputs = std::numeric_limits<unsigned int>::max();
-  readerIndex = 0;
-  unsigned int bestReaderIndex(0);
-  // select the reader with the minimum number of mitk::Images as output
-  for ( auto rIter = workingCandidates.cbegin(); rIter != workingCandidates.cend(); ++readerIndex, ++rIter )
+  std::size_t bestReaderIndex(0);
+  // select the first reader with the minimum number of mitk::Images as output
+  for ( std::size_t readerIndex = 0; readerIndex < readers.size(); ++readerIndex )
   {
-    const unsigned int thisReadersNumberOfOutputs = (*rIter)->GetNumberOfOutputs();
+    if (!succeeded[readerIndex])
+      continue;
+
+    const unsigned int thisReadersNumberOfOutputs = readers[readerIndex]->GetNumberOfOutputs();
+    MITK_INFO << "Reader " << readerIndex << " (" << readers[readerIndex]->GetConfigurationLabel() << ") suggests "
+              << thisReadersNumberOfOutputs << " 3D blocks, analysis took " << m_ReaderAnalysisTimes[readerIndex] << " s";
+
     if (   thisReadersNumberOfOutputs > 0  // we don't count readers that don't actually produce output
         && thisReadersNumberOfOutputs < minimumNumberOfOutputs )
     {
-      minimumNumberOfOutputs = (*rIter)->GetNumberOfOutputs();
-      bestReader = *rIter;
+      minimumNumberOfOutputs = thisReadersNumberOfOutputs;
+      bestReader = readers[readerIndex];
       bestReaderIndex = readerIndex;
     }
   }
 
-  MITK_DEBUG << "Decided for reader #" << bestReaderIndex << " (" << bestReader->GetConfigurationLabel() << ")";
-  MITK_DEBUG << m_PossibleConfigurations[bestReaderIndex];
+  if (bestReader.IsNotNull())
+  {
+    MITK_DEBUG << "Decided for reader #" << bestReaderIndex << " (" << bestReader->GetConfigurationLabel() << ")";
+    if (bestReaderIndex < m_PossibleConfigurations.size())
+    {
+      MITK_DEBUG << m_PossibleConfigurations[bestReaderIndex];
+    }
+  }
 
   return bestReader;
 }
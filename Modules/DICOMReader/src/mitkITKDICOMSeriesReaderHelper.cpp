@@ -32,9 +32,16 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkDICOMGDCMTagScanner.h"
 #include "mitkArbitraryTimeGeometry.h"
+#include "mitkProgressBar.h"
 
 #include "dcmtk/dcmdata/dcvrda.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 
 const mitk::DICOMTag mitk::ITKDICOMSeriesReaderHelper::AcquisitionDateTag = mitk::DICOMTag( 0x0008, 0x0022 );
 const mitk::DICOMTag mitk::ITKDICOMSeriesReaderHelper::AcquisitionTimeTag = mitk::DICOMTag( 0x0008, 0x0032 );
@@ -456,3 +463,125 @@ mitk::TimeGeometry::Pointer
 
   return timeGeometry;
 };
+
+bool mitk::ITKDICOMSeriesReaderHelper::ReadSlicesConcurrently( const StringContainer& filenames,
+                                                                const std::vector<void*>& destinations,
+                                                                std::size_t sliceSizeInBytes )
+{
+  const std::size_t numberOfSlices = filenames.size();
+  if ( numberOfSlices == 0 || destinations.size() != numberOfSlices )
+  {
+    return false;
+  }
+
+  // all slices must have the pixel type of the first one, which determined the pixel type of the image
+  itk::ImageIOBase::IOComponentType componentType;
+  unsigned int numberOfComponents;
+  try
+  {
+    itk::GDCMImageIO::Pointer io = itk::GDCMImageIO::New();
+    io->SetFileName( filenames.front() );
+    io->ReadImageInformation();
+    componentType = io->GetComponentType();
+    numberOfComponents = io->GetNumberOfComponents();
+  }
+  catch ( const std::exception& e )
+  {
+    MITK_DEBUG << "Could not read " << filenames.front() << ": " << e.what();
+    return false;
+  }
+
+  std::atomic<std::size_t> nextSlice( 0 );
+  std::atomic<bool> failed( false );
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::size_t numberOfReadSlices = 0;
+  unsigned int numberOfFinishedThreads = 0;
+
+  // each thread decodes whole slices with its own ImageIO, GDCM takes care of
+  // compressed transfer syntaxes (JPEG, JPEG 2000, RLE)
+  auto readSlices = [&]()
+  {
+    itk::GDCMImageIO::Pointer io = itk::GDCMImageIO::New();
+    for ( std::size_t slice = nextSlice++; slice < numberOfSlices && !failed; slice = nextSlice++ )
+    {
+      try
+      {
+        io->SetFileName( filenames[slice] );
+        io->ReadImageInformation();
+
+        if ( io->GetComponentType() != componentType
+          || io->GetNumberOfComponents() != numberOfComponents
+          || io->GetImageSizeInBytes() != sliceSizeInBytes )
+        {
+          MITK_DEBUG << "Pixel type or size of " << filenames[slice] << " differs from the first slice";
+          failed = true;
+          break;
+        }
+
+        io->Read( destinations[slice] );
+      }
+      catch ( const std::exception& e )
+      {
+        MITK_DEBUG << "Could not decode " << filenames[slice] << ": " << e.what();
+        failed = true;
+        break;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock( mutex );
+        ++numberOfReadSlices;
+      }
+      condition.notify_one();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock( mutex );
+      ++numberOfFinishedThreads;
+    }
+    condition.notify_one();
+  };
+
+  const unsigned int numberOfThreads = static_cast<unsigned int>(
+    std::max<std::size_t>( 1, std::min<std::size_t>( std::thread::hardware_concurrency(), numberOfSlices ) ) );
+
+  std::vector<std::thread> threads;
+  threads.reserve( numberOfThreads );
+  for ( unsigned int i = 0; i < numberOfThreads; ++i )
+  {
+    threads.emplace_back( readSlices );
+  }
+
+  // progress is reported from the calling thread, the progress bar is not thread-safe
+  ProgressBar::GetInstance()->AddStepsToDo( static_cast<unsigned int>( numberOfSlices ) );
+  std::size_t numberOfReportedSlices = 0;
+  {
+    std::unique_lock<std::mutex> lock( mutex );
+    while ( numberOfFinishedThreads < numberOfThreads )
+    {
+      condition.wait( lock );
+
+      const std::size_t steps = numberOfReadSlices - numberOfReportedSlices;
+      if ( steps > 0 )
+      {
+        numberOfReportedSlices = numberOfReadSlices;
+        lock.unlock();
+        ProgressBar::GetInstance()->Progress( static_cast<unsigned int>( steps ) );
+        lock.lock();
+      }
+    }
+  }
+
+  for ( auto& thread : threads )
+  {
+    thread.join();
+  }
+
+  if ( numberOfReportedSlices < numberOfSlices )
+  {
+    ProgressBar::GetInstance()->Progress( static_cast<unsigned int>( numberOfSlices - numberOfReportedSlices ) );
+  }
+
+  return !failed;
+}
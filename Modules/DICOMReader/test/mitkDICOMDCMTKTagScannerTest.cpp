@@ -21,6 +21,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkTestingMacros.h"
 
 #include "mitkStringProperty.h"
+#include "mitkIOUtil.h"
+
+#include <itksys/SystemTools.hxx>
 
 class mitkDICOMDCMTKTagScannerTestSuite : public mitk::TestFixture
 {
@@ -28,6 +31,8 @@ class mitkDICOMDCMTKTagScannerTestSuite : public mitk::TestFixture
 
   MITK_TEST(DeepScanning);
   MITK_TEST(MultiFileScanning);
+  MITK_TEST(IndexedScanning);
+  MITK_TEST(IndexedScanningOfModifiedFile);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -123,6 +128,103 @@ public:
     CPPUNIT_ASSERT_MESSAGE("Testing value of instance uid finding of frame 3", findings.front().value == "1.2.276.0.99.1.4.8323329.3795.1303917947.940055");
   }
 
+  void IndexedScanning()
+  {
+    std::string indexFileName = mitk::IOUtil::CreateTemporaryFile("mitkDICOMTagIndex_XXXXXX.txt");
+    itksys::SystemTools::RemoveFile(indexFileName);
+
+    mitk::DICOMTagPath instanceUID(0x0008, 0x0018);
+    mitk::DICOMTagPath patientName(0x0010, 0x0010);
+
+    scanner->SetIndexFileName(indexFileName);
+    scanner->SetInputFiles(ctFiles);
+    scanner->AddTagPath(instanceUID);
+    scanner->AddTagPath(patientName);
+    scanner->Scan();
+
+    CPPUNIT_ASSERT_MESSAGE("Testing that the tag index is written", itksys::SystemTools::FileExists(indexFileName));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Testing that all files are parsed without index", 4u, scanner->GetNumberOfParsedFiles());
+
+    // a subset of the indexed tags is taken from the index without parsing any file
+    mitk::DICOMDCMTKTagScanner::Pointer indexedScanner = mitk::DICOMDCMTKTagScanner::New();
+    indexedScanner->SetIndexFileName(indexFileName);
+    indexedScanner->SetInputFiles(ctFiles);
+    indexedScanner->AddTagPath(instanceUID);
+    indexedScanner->Scan();
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Testing that no file is parsed with index", 0u, indexedScanner->GetNumberOfParsedFiles());
+
+    mitk::DICOMDatasetAccessingImageFrameList frames = scanner->GetFrameInfoList();
+    mitk::DICOMDatasetAccessingImageFrameList indexedFrames = indexedScanner->GetFrameInfoList();
+    CPPUNIT_ASSERT_MESSAGE("Testing number of frames of the indexed scan", indexedFrames.size() == frames.size());
+
+    for (std::size_t i = 0; i < frames.size(); ++i)
+    {
+      mitk::DICOMDatasetAccess::FindingsListType findings = frames[i]->GetTagValueAsString(instanceUID);
+      mitk::DICOMDatasetAccess::FindingsListType indexedFindings = indexedFrames[i]->GetTagValueAsString(instanceUID);
+      CPPUNIT_ASSERT_MESSAGE("Testing instance uid finding of indexed scan", indexedFindings.size() == 1 && indexedFindings.front().isValid);
+      CPPUNIT_ASSERT_MESSAGE("Testing instance uid value of indexed scan", indexedFindings.front().value == findings.front().value);
+    }
+
+    itksys::SystemTools::RemoveFile(indexFileName);
+  }
+
+  void IndexedScanningOfModifiedFile()
+  {
+    std::string indexFileName = mitk::IOUtil::CreateTemporaryFile("mitkDICOMTagIndex_XXXXXX.txt");
+    itksys::SystemTools::RemoveFile(indexFileName);
+
+    // work on copies, the modification time of the test data must not be changed
+    std::string directory = mitk::IOUtil::CreateTemporaryDirectory("mitkDICOMTagIndex_XXXXXX");
+    mitk::StringList files;
+    for (const auto &file : ctFiles)
+    {
+      files.push_back(directory + "/" + itksys::SystemTools::GetFilenameName(file));
+      itksys::SystemTools::CopyFileAlways(file, files.back());
+    }
+
+    mitk::DICOMTagPath instanceUID(0x0008, 0x0018);
+
+    scanner->SetIndexFileName(indexFileName);
+    scanner->SetInputFiles(files);
+    scanner->AddTagPath(instanceUID);
+    scanner->Scan();
+
+    // the modification time has a resolution of seconds
+    const long modificationTime = itksys::SystemTools::ModifiedTime(files[1]);
+    while (itksys::SystemTools::ModifiedTime(files[1]) == modificationTime)
+    {
+      itksys::SystemTools::Delay(100);
+      itksys::SystemTools::Touch(files[1], false);
+    }
+
+    mitk::DICOMDCMTKTagScanner::Pointer indexedScanner = mitk::DICOMDCMTKTagScanner::New();
+    indexedScanner->SetIndexFileName(indexFileName);
+    indexedScanner->SetInputFiles(files);
+    indexedScanner->AddTagPath(instanceUID);
+    indexedScanner->Scan();
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Testing that only the modified file is parsed", 1u, indexedScanner->GetNumberOfParsedFiles());
+
+    mitk::DICOMDatasetAccessingImageFrameList frames = scanner->GetFrameInfoList();
+    mitk::DICOMDatasetAccessingImageFrameList indexedFrames = indexedScanner->GetFrameInfoList();
+    CPPUNIT_ASSERT_MESSAGE("Testing number of frames of the indexed scan", indexedFrames.size() == frames.size());
+    CPPUNIT_ASSERT_MESSAGE("Testing instance uid value of the modified file",
+                           indexedFrames[1]->GetTagValueAsString(instanceUID).front().value == frames[1]->GetTagValueAsString(instanceUID).front().value);
+
+    // the rescanned file is updated in the index
+    mitk::DICOMDCMTKTagScanner::Pointer updatedScanner = mitk::DICOMDCMTKTagScanner::New();
+    updatedScanner->SetIndexFileName(indexFileName);
+    updatedScanner->SetInputFiles(files);
+    updatedScanner->AddTagPath(instanceUID);
+    updatedScanner->Scan();
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Testing that the index is updated", 0u, updatedScanner->GetNumberOfParsedFiles());
+
+    itksys::SystemTools::RemoveADirectory(directory);
+    itksys::SystemTools::RemoveFile(indexFileName);
+  }
+
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkDICOMDCMTKTagScanner)
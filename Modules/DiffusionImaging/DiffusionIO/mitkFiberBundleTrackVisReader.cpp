@@ -30,6 +30,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <tinyxml.h>
 #include <vtkCleanPolyData.h>
 #include <mitkTrackvis.h>
+#include <mitkStreamlineFileReader.h>
 #include <mitkCustomMimeType.h>
 #include "mitkDiffusionIOMimeTypes.h"
 
@@ -37,6 +38,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 mitk::FiberBundleTrackVisReader::FiberBundleTrackVisReader()
   : mitk::AbstractFileReader( mitk::DiffusionIOMimeTypes::FIBERBUNDLE_TRK_MIMETYPE_NAME(), "TrackVis Fiber Bundle Reader" )
 {
+  Options defaultOptions;
+  defaultOptions["Subsampling step"] = 1;
+  defaultOptions["Minimum length (mm)"] = 0.0;
+  defaultOptions["Maximum length (mm, 0: no limit)"] = 0.0;
+  defaultOptions["Use compact fiber storage"] = false;
+  this->SetDefaultOptions(defaultOptions);
+
   m_ServiceReg = this->RegisterService();
 }
 
@@ -68,11 +76,18 @@ std::vector<itk::SmartPointer<mitk::BaseData> > mitk::FiberBundleTrackVisReader:
 
     if (ext==".trk")
     {
-      FiberBundle::Pointer mitk_fib = FiberBundle::New();
-      TrackVisFiberReader reader;
-      reader.open(this->GetInputLocation().c_str());
-      reader.read(mitk_fib.GetPointer());
-      result.push_back(mitk_fib.GetPointer());
+      Options options = this->GetOptions();
+      StreamlineFileReader reader;
+      reader.SetSubsamplingStep(us::any_cast<int>(options["Subsampling step"]));
+      reader.SetMinLength(us::any_cast<double>(options["Minimum length (mm)"]));
+      double maxLength = us::any_cast<double>(options["Maximum length (mm, 0: no limit)"]);
+      reader.SetMaxLength(maxLength>0 ? maxLength : -1);
+      reader.Open(filename);
+      FiberBundle::Pointer fib = reader.ReadFiberBundle(us::any_cast<bool>(options["Use compact fiber storage"]));
+      if (reader.GetNumberOfSkippedFibers()>0)
+        MITK_INFO << "Skipped " << reader.GetNumberOfSkippedFibers() << " streamlines";
+      result.push_back(fib.GetPointer());
+      setlocale(LC_ALL, currLocale.c_str());
       return result;
     }
 
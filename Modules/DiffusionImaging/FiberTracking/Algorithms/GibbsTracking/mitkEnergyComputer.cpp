@@ -17,11 +17,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkEnergyComputer.h"
 #include <vnl/vnl_copy.h>
 #include <itkNumericTraits.h>
+#include <algorithm>
 
 using namespace mitk;
 
 EnergyComputer::EnergyComputer(ItkFloatImageType* mask, ParticleGrid* particleGrid, SphereInterpolator* interpolator, ItkRandGenType* randGen)
     : m_UseTrilinearInterpolation(true)
+    , m_UseSamplingRegion(false)
 {
     m_ParticleGrid = particleGrid;
     m_RandGen = randGen;
@@ -81,6 +83,7 @@ EnergyComputer::EnergyComputer(ItkFloatImageType* mask, ParticleGrid* particleGr
                     m_NumActiveVoxels++;
                 }
             }
+    m_TotalSpatialProbability = m_CumulatedSpatialProbability[m_NumActiveVoxels];
     for (int k = 0; k < m_NumActiveVoxels; k++)
         m_CumulatedSpatialProbability[k] /= m_CumulatedSpatialProbability[m_NumActiveVoxels];
 
@@ -125,9 +128,68 @@ void EnergyComputer::DrawRandomPosition(vnl_vector_fixed<float, 3>& R)
         }
         break;
     }
-    R[0] = m_Spacing[0]*((float)(m_ActiveIndices[rh-1] % m_Size[0])  + m_RandGen->GetVariate());
-    R[1] = m_Spacing[1]*((float)((m_ActiveIndices[rh-1]/m_Size[0]) % m_Size[1])  + m_RandGen->GetVariate());
-    R[2] = m_Spacing[2]*((float)(m_ActiveIndices[rh-1]/(m_Size[0]*m_Size[1]))    + m_RandGen->GetVariate());
+    for (;;)
+    {
+        R[0] = m_Spacing[0]*((float)(m_ActiveIndices[rh-1] % m_Size[0])  + m_RandGen->GetVariate());
+        R[1] = m_Spacing[1]*((float)((m_ActiveIndices[rh-1]/m_Size[0]) % m_Size[1])  + m_RandGen->GetVariate());
+        R[2] = m_Spacing[2]*((float)(m_ActiveIndices[rh-1]/(m_Size[0]*m_Size[1]))    + m_RandGen->GetVariate());
+
+        // voxels at the border of the sampling region are only partially covered
+        if (!m_UseSamplingRegion)
+            break;
+        if (R[0]>=m_SamplingLower[0] && R[0]<m_SamplingUpper[0] && R[1]>=m_SamplingLower[1] && R[1]<m_SamplingUpper[1] && R[2]>=m_SamplingLower[2] && R[2]<m_SamplingUpper[2])
+            break;
+    }
+}
+
+// cumulate the spatial probability of all active voxels overlapping the sampling region, weighted by the covered fraction of the voxel
+float EnergyComputer::SetSamplingRegion(const vnl_vector_fixed<float, 3>& lower, const vnl_vector_fixed<float, 3>& upper)
+{
+    m_UseSamplingRegion = true;
+    m_SamplingLower = lower;
+    m_SamplingUpper = upper;
+
+    int start[3], end[3];
+    for (int i=0; i<3; i++)
+    {
+        start[i] = std::max(0, (int)floor(lower[i]/m_Spacing[i]));
+        end[i] = std::min(m_Size[i], (int)ceil(upper[i]/m_Spacing[i]));
+    }
+
+    m_NumActiveVoxels = 0;
+    m_CumulatedSpatialProbability[0] = 0;
+    for (int x = start[0]; x < end[0]; x++)
+        for (int y = start[1]; y < end[1]; y++)
+            for (int z = start[2]; z < end[2]; z++)
+            {
+                ItkFloatImageType::IndexType index;
+                index[0] = x; index[1] = y; index[2] = z;
+                float value = m_Mask->GetPixel(index);
+                if (value > 0.5)
+                {
+                    float overlap = 1;
+                    for (int i=0; i<3; i++)
+                    {
+                        float a = std::max(lower[i], index[i]*m_Spacing[i]);
+                        float b = std::min(upper[i], (index[i]+1)*m_Spacing[i]);
+                        overlap *= std::max(0.0f, b-a)/m_Spacing[i];
+                    }
+                    if (overlap <= 0)
+                        continue;
+
+                    m_CumulatedSpatialProbability[m_NumActiveVoxels+1] = m_CumulatedSpatialProbability[m_NumActiveVoxels] + value*overlap;
+                    m_ActiveIndices[m_NumActiveVoxels] = x+(y+z*m_Size[1])*m_Size[0];
+                    m_NumActiveVoxels++;
+                }
+            }
+
+    float regionProbability = m_CumulatedSpatialProbability[m_NumActiveVoxels];
+    for (int k = 0; k < m_NumActiveVoxels; k++)
+        m_CumulatedSpatialProbability[k] /= regionProbability;
+
+    if (m_TotalSpatialProbability <= 0)
+        return 0;
+    return regionProbability/m_TotalSpatialProbability;
 }
 
 // return spatial probability of position
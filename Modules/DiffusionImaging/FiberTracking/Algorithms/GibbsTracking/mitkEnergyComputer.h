@@ -42,6 +42,9 @@ public:
     // get random position inside mask
     void DrawRandomPosition(vnl_vector_fixed<float, 3>& R);
 
+    // restrict random positions to the box [lower, upper) (world coordinates), returns fraction of the total spatial probability inside the box
+    float SetSamplingRegion(const vnl_vector_fixed<float, 3>& lower, const vnl_vector_fixed<float, 3>& upper);
+
     // external energy calculation
     virtual float ComputeExternalEnergy(vnl_vector_fixed<float, 3>& R, vnl_vector_fixed<float, 3>& N, Particle* dp) =0;
 
@@ -63,8 +66,12 @@ protected:
     vnl_vector_fixed<float, 3>      m_Spacing;
     std::vector< float >            m_CumulatedSpatialProbability;
     std::vector< int >              m_ActiveIndices;    // indices inside mask
+    vnl_vector_fixed<float, 3>      m_SamplingLower;    // lower corner of sampling region
+    vnl_vector_fixed<float, 3>      m_SamplingUpper;    // upper corner of sampling region
 
     bool    m_UseTrilinearInterpolation;    // is deactivated if less than 3 image slices are available
+    bool    m_UseSamplingRegion;            // random positions are restricted to the sampling region
+    float   m_TotalSpatialProbability;      // sum of the mask values of all active voxels
     int     m_NumActiveVoxels;              // voxels inside mask
     float   m_ConnectionPotential;          // larger value results in larger energy value -> higher proposal acceptance probability
     float   m_ParticleChemicalPotential;    // larger value results in larger energy value -> higher proposal acceptance probability
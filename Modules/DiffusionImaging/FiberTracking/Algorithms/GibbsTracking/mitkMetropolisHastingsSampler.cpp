@@ -20,6 +20,7 @@ using namespace mitk;
 
 MetropolisHastingsSampler::MetropolisHastingsSampler(ParticleGrid* grid, EnergyComputer* enComp, ItkRandGenType* randGen, float curvThres)
     : m_ExTemp(0.01)
+    , m_DensityScale(1.0)
     , m_BirthProb(0.25)
     , m_DeathProb(0.05)
     , m_ShiftProb(0.15)
@@ -84,7 +85,18 @@ void MetropolisHastingsSampler::PrintProposalTimes()
 void MetropolisHastingsSampler::SetTemperature(float val)
 {
     m_InTemp = val;
-    m_Density = exp(-m_ChempotParticle/m_InTemp);
+    m_Density = m_DensityScale*exp(-m_ChempotParticle/m_InTemp);
+}
+
+// births are only proposed inside the sampled domain, which covers this fraction of the spatial probability mass (applied by the next SetTemperature)
+void MetropolisHastingsSampler::SetDensityScale(float val)
+{
+    m_DensityScale = val;
+}
+
+float MetropolisHastingsSampler::GetBirthProbability()
+{
+    return m_BirthProb;
 }
 
 // add small random number drawn from gaussian to each vector element
@@ -111,9 +123,16 @@ void MetropolisHastingsSampler::MakeProposal()
 {
     float randnum = m_RandGen->GetVariate();
 
+    // frozen particles (halo of a sampling domain) are visible to the energy computation but are never proposed for a change
+    int numFrozen = m_ParticleGrid->m_NumFrozenParticles;
+    int numFree = m_ParticleGrid->m_NumParticles - numFrozen;
+
     // Birth Proposal
     if (randnum < m_BirthProb)
     {
+        if (m_EnergyComputer->GetNumActiveVoxels() <= 0)
+            return;
+
         m_BirthTime.Start();
         vnl_vector_fixed<float, 3> R;
         m_EnergyComputer->DrawRandomPosition(R);
@@ -122,7 +141,7 @@ void MetropolisHastingsSampler::MakeProposal()
         prop.GetPos() = R;
         prop.GetDir() = N;
 
-        float prob =  m_Density * m_DeathProb /((m_BirthProb)*(m_ParticleGrid->m_NumParticles+1));
+        float prob =  m_Density * m_DeathProb /((m_BirthProb)*(numFree+1));
 
         float ex_energy = m_EnergyComputer->ComputeExternalEnergy(R,N,nullptr);
         float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop);
@@ -144,16 +163,16 @@ void MetropolisHastingsSampler::MakeProposal()
     else if (randnum < m_BirthProb+m_DeathProb)
     {
         m_DeathTime.Start();
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (numFree > 0)
         {
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = numFrozen + m_RandGen->GetIntegerVariate()%numFree;
             Particle *dp = m_ParticleGrid->GetParticle(pnum);
             if (dp->pID == -1 && dp->mID == -1)
             {
                 float ex_energy = m_EnergyComputer->ComputeExternalEnergy(dp->GetPos(),dp->GetDir(),dp);
                 float in_energy = m_EnergyComputer->ComputeInternalEnergy(dp);
 
-                float prob = m_ParticleGrid->m_NumParticles * (m_BirthProb) /(m_Density*m_DeathProb); //*SpatProb(dp->R);
+                float prob = numFree * (m_BirthProb) /(m_Density*m_DeathProb); //*SpatProb(dp->R);
                 prob *= exp(-(in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
                 if (prob > 1 || m_RandGen->GetVariate() < prob)
                 {
@@ -167,10 +186,10 @@ void MetropolisHastingsSampler::MakeProposal()
     // Shift Proposal
     else  if (randnum < m_BirthProb+m_DeathProb+m_ShiftProb)
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (numFree > 0)
         {
             m_ShiftTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = numFrozen + m_RandGen->GetIntegerVariate()%numFree;
             Particle *p =  m_ParticleGrid->GetParticle(pnum);
             Particle prop_p = *p;
 
@@ -203,10 +222,10 @@ void MetropolisHastingsSampler::MakeProposal()
     // Optimal Shift Proposal
     else  if (randnum < m_BirthProb+m_DeathProb+m_ShiftProb+m_OptShiftProb)
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (numFree > 0)
         {
             m_OptShiftTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = numFrozen + m_RandGen->GetIntegerVariate()%numFree;
             Particle *p =  m_ParticleGrid->GetParticle(pnum);
 
             bool no_proposal = false;
@@ -270,10 +289,10 @@ void MetropolisHastingsSampler::MakeProposal()
     // Connection Proposal
     else
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (numFree > 0)
         {
             m_ConnectionTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = numFrozen + m_RandGen->GetIntegerVariate()%numFree;
             Particle *p = m_ParticleGrid->GetParticle(pnum);
 
             EndPoint P;
@@ -458,7 +477,7 @@ void MetropolisHastingsSampler::ComputeEndPointProposalDistribution(EndPoint P)
     {
         Particle *p2 =  m_ParticleGrid->GetNextNeighbor();
         if (p2 == nullptr) break;
-        if (p!=p2 && p2->label == 0)
+        if (p!=p2 && p2->label == 0 && p2->ID >= m_ParticleGrid->m_NumFrozenParticles)
         {
             if (p2->mID == -1)
             {
@@ -46,10 +46,12 @@ public:
 
     MetropolisHastingsSampler(ParticleGrid* grid, EnergyComputer* enComp, ItkRandGenType* randGen, float curvThres);
     void SetTemperature(float val);
+    void SetDensityScale(float val);    ///< fraction of the spatial probability covered by the sampled domain (1 if the whole image is sampled). Call before SetTemperature.
 
     void MakeProposal();    ///< make proposal for birth/death/shift/connection of particles
     int GetNumAcceptedProposals();
     void SetProbabilities(float birth, float death, float shift, float optShift, float connect);    ///< update the probabilities of the single proposals
+    float GetBirthProbability();
     void PrintProposalTimes();  ///< print the state of the proposal time probes
 
 protected:
@@ -72,6 +74,7 @@ protected:
     float m_InTemp;     ///< simulated annealing temperature
     float m_ExTemp;     ///< simulated annealing temperature
     float m_Density;
+    float m_DensityScale;
 
     float m_BirthProb;          ///< probability for particle birth
     float m_DeathProb;          ///< probability for particle death
@@ -0,0 +1,372 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkParallelMetropolisHastingsSampler.h"
+#include <mitkLogMacros.h>
+#include <omp.h>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+using namespace mitk;
+
+ParallelMetropolisHastingsSampler::ParallelMetropolisHastingsSampler(ParticleGrid* grid, ItkOdfImgType* odfImage, ItkFloatImageType* mask, SphereInterpolator* interpolator, int cellCapacity, int seed, float curvThres, int domainSize)
+    : m_ParticleGrid(grid)
+    , m_HaloSize(2)
+    , m_Temperature(1)
+{
+    // the halo has to cover all cells that are searched for neighbours of the domain particles and their endpoints.
+    // domains of the same colour are one domain apart, so the halo must not be larger than a domain.
+    m_DomainSize = std::max(domainSize, m_HaloSize);
+    m_CellSize = 2*m_ParticleGrid->m_ParticleLength;
+
+    m_RandGen = ItkRandGenType::New();
+    m_RandGen->SetSeed(seed);
+
+    vnl_vector_fixed<int, 3> localSize;
+    localSize.fill(m_DomainSize + 2*m_HaloSize);
+
+    m_Workers.resize(omp_get_max_threads());
+    for (unsigned int i=0; i<m_Workers.size(); i++)
+    {
+        Worker& worker = m_Workers[i];
+        worker.randGen = ItkRandGenType::New();
+        worker.grid = new ParticleGrid(localSize, m_ParticleGrid->m_ParticleLength, cellCapacity);
+        worker.interpolator = new SphereInterpolator(*interpolator);    // the interpolator stores the result of the last lookup and can't be shared
+        worker.encomp = new GibbsEnergyComputer(odfImage, mask, worker.grid, worker.interpolator, worker.randGen);
+        worker.sampler = new MetropolisHastingsSampler(worker.grid, worker.encomp, worker.randGen, curvThres);
+    }
+    MITK_INFO << "ParallelMetropolisHastingsSampler: " << m_Workers.size() << " threads, domain size " << m_DomainSize << " cells";
+}
+
+ParallelMetropolisHastingsSampler::~ParallelMetropolisHastingsSampler()
+{
+    for (unsigned int i=0; i<m_Workers.size(); i++)
+    {
+        delete m_Workers[i].sampler;
+        delete m_Workers[i].encomp;
+        delete m_Workers[i].interpolator;
+        delete m_Workers[i].grid;
+    }
+}
+
+void ParallelMetropolisHastingsSampler::SetParameters(float particleWeight, float particleWidth, float connectionPotential, float curvThres, float inexBalance, float particlePotential)
+{
+    for (unsigned int i=0; i<m_Workers.size(); i++)
+        m_Workers[i].encomp->SetParameters(particleWeight, particleWidth, connectionPotential, curvThres, inexBalance, particlePotential);
+}
+
+void ParallelMetropolisHastingsSampler::SetTemperature(float val)
+{
+    m_Temperature = val;
+}
+
+unsigned long ParallelMetropolisHastingsSampler::GetNumAcceptedProposals()
+{
+    unsigned long accepted = 0;
+    for (unsigned int i=0; i<m_Workers.size(); i++)
+        accepted += m_Workers[i].sampler->GetNumAcceptedProposals();
+    return accepted;
+}
+
+int ParallelMetropolisHastingsSampler::GetNumThreads()
+{
+    return m_Workers.size();
+}
+
+// sample all domains, one colour after the other
+void ParallelMetropolisHastingsSampler::MakeProposals(unsigned long num)
+{
+    vnl_vector_fixed<int, 3> gridSize = m_ParticleGrid->GetGridSize();
+
+    // shift domain boundaries randomly, otherwise particles close to the boundaries would never be connected across them
+    vnl_vector_fixed<int, 3> offset, numDomains;
+    for (int i=0; i<3; i++)
+    {
+        offset[i] = m_RandGen->GetIntegerVariate(m_DomainSize-1);
+        numDomains[i] = (gridSize[i] + offset[i] + m_DomainSize - 1)/m_DomainSize;
+    }
+
+    int numParticles = m_ParticleGrid->m_NumParticles;
+    for (int color=0; color<8; color++)
+    {
+        std::vector< Domain > domains;
+        for (int z=(color>>2)&1; z<numDomains[2]; z+=2)
+            for (int y=(color>>1)&1; y<numDomains[1]; y+=2)
+                for (int x=color&1; x<numDomains[0]; x+=2)
+                {
+                    Domain domain;
+                    domain.lower[0] = std::max(x*m_DomainSize - offset[0], 0);
+                    domain.lower[1] = std::max(y*m_DomainSize - offset[1], 0);
+                    domain.lower[2] = std::max(z*m_DomainSize - offset[2], 0);
+                    domain.upper[0] = std::min((x+1)*m_DomainSize - offset[0], gridSize[0]);
+                    domain.upper[1] = std::min((y+1)*m_DomainSize - offset[1], gridSize[1]);
+                    domain.upper[2] = std::min((z+1)*m_DomainSize - offset[2], gridSize[2]);
+                    domain.seed = m_RandGen->GetIntegerVariate();   // seeding per domain keeps the result independent of the thread scheduling
+                    domains.push_back(domain);
+                }
+
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int i=0; i<(int)domains.size(); i++)
+            SampleDomain(m_Workers[omp_get_thread_num()], domains[i], num, numParticles);
+
+        std::vector< int > deadParticles;
+        for (unsigned int i=0; i<domains.size(); i++)
+            MergeDomain(domains[i], deadParticles);
+
+        // removing particles changes the IDs of other particles, so this is done after all domains of the colour are merged
+        std::sort(deadParticles.begin(), deadParticles.end(), std::greater<int>());
+        for (unsigned int i=0; i<deadParticles.size(); i++)
+            m_ParticleGrid->RemoveParticle(deadParticles[i]);
+    }
+}
+
+// copy domain and halo into the local grid of the worker, sample it and store the resulting particles in the domain
+void ParallelMetropolisHastingsSampler::SampleDomain(Worker& worker, Domain& domain, unsigned long num, int numParticles)
+{
+    vnl_vector_fixed<int, 3> gridSize = m_ParticleGrid->GetGridSize();
+
+    // births are restricted to the domain
+    vnl_vector_fixed<float, 3> lower, upper;
+    for (int i=0; i<3; i++)
+    {
+        lower[i] = domain.lower[i]*m_CellSize;
+        upper[i] = domain.upper[i]*m_CellSize;
+    }
+    float spatialFraction = worker.encomp->SetSamplingRegion(lower, upper);
+    if (spatialFraction <= 0)
+        return;
+
+    // collect particles of the domain and its halo
+    vnl_vector_fixed<int, 3> haloLower, haloUpper;
+    for (int i=0; i<3; i++)
+    {
+        haloLower[i] = std::max(domain.lower[i] - m_HaloSize, 0);
+        haloUpper[i] = std::min(domain.upper[i] + m_HaloSize, gridSize[i]);
+    }
+
+    std::vector< Particle* > frozenParticles;
+    std::vector< Particle* > freeParticles;
+    vnl_vector_fixed<int, 3> cell;
+    for (cell[2]=haloLower[2]; cell[2]<haloUpper[2]; cell[2]++)
+        for (cell[1]=haloLower[1]; cell[1]<haloUpper[1]; cell[1]++)
+            for (cell[0]=haloLower[0]; cell[0]<haloUpper[0]; cell[0]++)
+            {
+                bool inside = cell[0]>=domain.lower[0] && cell[0]<domain.upper[0] && cell[1]>=domain.lower[1] && cell[1]<domain.upper[1] && cell[2]>=domain.lower[2] && cell[2]<domain.upper[2];
+                int n = m_ParticleGrid->GetNumParticlesInCell(cell);
+                for (int j=0; j<n; j++)
+                {
+                    Particle* p = m_ParticleGrid->GetParticleInCell(cell, j);
+                    if (!inside)
+                    {
+                        frozenParticles.push_back(p);
+                        continue;
+                    }
+
+                    // particles connected to a particle outside of the halo can't be changed safely
+                    bool linkedOutside = false;
+                    int links[2] = {p->pID, p->mID};
+                    for (int e=0; e<2; e++)
+                    {
+                        if (links[e] == -1)
+                            continue;
+                        vnl_vector_fixed<int, 3> c = m_ParticleGrid->GetCell(m_ParticleGrid->GetParticle(links[e])->GetPos());
+                        if (c[0]<haloLower[0] || c[0]>=haloUpper[0] || c[1]<haloLower[1] || c[1]>=haloUpper[1] || c[2]<haloLower[2] || c[2]>=haloUpper[2])
+                            linkedOutside = true;
+                    }
+                    if (linkedOutside)
+                        frozenParticles.push_back(p);
+                    else
+                        freeParticles.push_back(p);
+                }
+            }
+
+    // number of proposals the serial sampler would spend in this domain
+    float birthProb = worker.sampler->GetBirthProbability();
+    float weight = spatialFraction;
+    if (numParticles > 0)
+        weight = birthProb*spatialFraction + (1-birthProb)*(float)freeParticles.size()/numParticles;
+    unsigned long numProposals = (unsigned long)(num*weight + 0.5);
+    if (numProposals == 0)
+        return;
+
+    // fill local grid, frozen particles first so that they occupy the lowest IDs
+    ParticleGrid* grid = worker.grid;
+    vnl_vector_fixed<int, 3> gridOffset;
+    for (int i=0; i<3; i++)
+        gridOffset[i] = domain.lower[i] - m_HaloSize;
+    grid->SetGridOffset(gridOffset);
+    worker.localIDs.clear();
+
+    for (unsigned int i=0; i<frozenParticles.size()+freeParticles.size(); i++)
+    {
+        if (i == frozenParticles.size())
+            grid->FreezeParticles();
+        Particle* p = i<frozenParticles.size() ? frozenParticles[i] : freeParticles[i-frozenParticles.size()];
+        Particle* lp = grid->NewParticle(p->GetPos());
+        if (lp == nullptr)
+        {
+            MITK_WARN << "ParallelMetropolisHastingsSampler: could not copy particle into domain grid. Skipping domain.";
+            return;
+        }
+        lp->GetDir() = p->GetDir();
+        lp->sourceID = p->ID;
+        worker.localIDs[p->ID] = lp->ID;
+    }
+    if (freeParticles.empty())
+        grid->FreezeParticles();
+
+    // copy connections between the collected particles
+    std::unordered_map< int, int >::iterator it;
+    for (int l=0; l<grid->m_NumParticles; l++)
+    {
+        Particle* lp = grid->GetParticle(l);
+        Particle* p = m_ParticleGrid->GetParticle(lp->sourceID);
+        if (p->pID != -1 && (it = worker.localIDs.find(p->pID)) != worker.localIDs.end())
+            lp->pID = it->second;
+        if (p->mID != -1 && (it = worker.localIDs.find(p->mID)) != worker.localIDs.end())
+            lp->mID = it->second;
+    }
+    grid->SetWritableRegion(domain.lower, domain.upper);
+
+    domain.sourceFree.resize(freeParticles.size());
+    for (unsigned int i=0; i<freeParticles.size(); i++)
+        domain.sourceFree[i] = freeParticles[i]->ID;
+
+    // sample domain
+    worker.randGen->SetSeed(domain.seed);
+    worker.sampler->SetDensityScale(spatialFraction);
+    worker.sampler->SetTemperature(m_Temperature);
+    for (unsigned long i=0; i<numProposals; i++)
+        worker.sampler->MakeProposal();
+
+    // store result
+    int numFrozen = grid->m_NumFrozenParticles;
+    domain.particles.resize(grid->m_NumParticles-numFrozen);
+    for (int l=numFrozen; l<grid->m_NumParticles; l++)
+    {
+        Particle* lp = grid->GetParticle(l);
+        DomainParticle& dp = domain.particles[l-numFrozen];
+        dp.pos = lp->GetPos();
+        dp.dir = lp->GetDir();
+        dp.sourceID = lp->sourceID;
+
+        int links[2] = {lp->pID, lp->mID};
+        for (int e=0; e<2; e++)
+        {
+            dp.link[e] = -1;
+            dp.linkEp[e] = 0;
+            dp.linkFrozen[e] = false;
+            if (links[e] == -1)
+                continue;
+
+            Particle* lp2 = grid->GetParticle(links[e]);
+            dp.linkEp[e] = (lp2->pID == l) ? 1 : -1;
+            if (links[e] < numFrozen)
+            {
+                dp.link[e] = lp2->sourceID;
+                dp.linkFrozen[e] = true;
+            }
+            else
+                dp.link[e] = links[e]-numFrozen;
+        }
+    }
+}
+
+// write particles and connections of a sampled domain back into the global grid
+void ParallelMetropolisHastingsSampler::MergeDomain(Domain& domain, std::vector< int >& deadParticles)
+{
+    if (domain.sourceFree.empty() && domain.particles.empty())
+        return;
+
+    // connections of all particles the domain sampler could change are rebuilt from the result
+    for (unsigned int i=0; i<domain.sourceFree.size(); i++)
+    {
+        Particle* p = m_ParticleGrid->GetParticle(domain.sourceFree[i]);
+        if (p->pID != -1)
+            m_ParticleGrid->DestroyConnection(p, +1);
+        if (p->mID != -1)
+            m_ParticleGrid->DestroyConnection(p, -1);
+    }
+
+    // update positions and insert new particles
+    std::vector< int > globalIDs(domain.particles.size(), -1);
+    std::vector< int > survivors;
+    for (unsigned int i=0; i<domain.particles.size(); i++)
+    {
+        DomainParticle& dp = domain.particles[i];
+        if (dp.sourceID >= 0)
+        {
+            Particle* p = m_ParticleGrid->GetParticle(dp.sourceID);
+            vnl_vector_fixed<float, 3> Rtmp = p->GetPos();
+            vnl_vector_fixed<float, 3> Ntmp = p->GetDir();
+            p->GetPos() = dp.pos;
+            p->GetDir() = dp.dir;
+            if (!m_ParticleGrid->TryUpdateGrid(dp.sourceID))
+            {
+                p->GetPos() = Rtmp;
+                p->GetDir() = Ntmp;
+            }
+            globalIDs[i] = dp.sourceID;
+            survivors.push_back(dp.sourceID);
+        }
+        else
+        {
+            Particle* p = m_ParticleGrid->NewParticle(dp.pos);
+            if (p != nullptr)
+            {
+                p->GetDir() = dp.dir;
+                globalIDs[i] = p->ID;
+            }
+        }
+    }
+
+    // restore connections
+    for (unsigned int i=0; i<domain.particles.size(); i++)
+    {
+        if (globalIDs[i] < 0)
+            continue;
+        DomainParticle& dp = domain.particles[i];
+        for (int e=0; e<2; e++)
+        {
+            if (dp.link[e] < 0)
+                continue;
+
+            int partner;
+            if (dp.linkFrozen[e])
+                partner = dp.link[e];
+            else if (dp.link[e] > (int)i)   // connections between two domain particles are created only once
+                partner = globalIDs[dp.link[e]];
+            else
+                continue;
+            if (partner < 0)
+                continue;
+
+            Particle* p = m_ParticleGrid->GetParticle(globalIDs[i]);
+            Particle* p2 = m_ParticleGrid->GetParticle(partner);
+            int ep = (e==0) ? 1 : -1;
+            if ((ep==1 ? p->pID : p->mID) != -1 || (dp.linkEp[e]==1 ? p2->pID : p2->mID) != -1)
+                continue;
+            m_ParticleGrid->CreateConnection(p, ep, p2, dp.linkEp[e]);
+        }
+    }
+
+    // particles that died in the domain
+    std::vector< int > sourceFree = domain.sourceFree;
+    std::sort(sourceFree.begin(), sourceFree.end());
+    std::sort(survivors.begin(), survivors.end());
+    std::set_difference(sourceFree.begin(), sourceFree.end(), survivors.begin(), survivors.end(), std::back_inserter(deadParticles));
+}
@@ -0,0 +1,113 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _PARALLELSAMPLER
+#define _PARALLELSAMPLER
+
+// MITK
+#include <MitkFiberTrackingExports.h>
+#include <mitkParticleGrid.h>
+#include <mitkGibbsEnergyComputer.h>
+#include <mitkMetropolisHastingsSampler.h>
+#include <mitkSphereInterpolator.h>
+
+// ITK
+#include <itkImage.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+// MISC
+#include <vector>
+#include <unordered_map>
+
+namespace mitk
+{
+
+/**
+* \brief Samples the particle grid in parallel by splitting it into spatial domains.
+*
+* The grid cells are grouped into cubic domains that are coloured like a 3D checkerboard (8 colours).
+* Domains of the same colour are at least one domain apart, so they are sampled concurrently by independent
+* MetropolisHastingsSamplers working on local copies of the domain. Particles in a halo around each domain are
+* copied as frozen particles: they contribute to the energies but are never changed. After all domains of one
+* colour are sampled, their particles and connections are written back into the global grid before the next
+* colour is processed. The domain boundaries are shifted randomly after each sweep over all colours. */
+
+class MITKFIBERTRACKING_EXPORT ParallelMetropolisHastingsSampler
+{
+public:
+
+    typedef itk::Image< float, 3 >  ItkFloatImageType;
+    typedef GibbsEnergyComputer::ItkOdfImgType ItkOdfImgType;
+    typedef itk::Statistics::MersenneTwisterRandomVariateGenerator ItkRandGenType;
+
+    ParallelMetropolisHastingsSampler(ParticleGrid* grid, ItkOdfImgType* odfImage, ItkFloatImageType* mask, SphereInterpolator* interpolator, int cellCapacity, int seed, float curvThres, int domainSize=6);
+    ~ParallelMetropolisHastingsSampler();
+
+    void SetParameters(float particleWeight, float particleWidth, float connectionPotential, float curvThres, float inexBalance, float particlePotential);   ///< energy parameters, see EnergyComputer::SetParameters
+    void SetTemperature(float val);
+
+    void MakeProposals(unsigned long num);  ///< distribute num proposals over all domains (one sweep over all colours)
+    unsigned long GetNumAcceptedProposals();
+    int GetNumThreads();
+
+protected:
+
+    /** particle of a sampling domain as it is written back into the global grid */
+    struct DomainParticle
+    {
+        vnl_vector_fixed<float, 3> pos;
+        vnl_vector_fixed<float, 3> dir;
+        int sourceID;       ///< global ID or -1 if the particle was born in the domain
+        int link[2];        ///< connected particle at the + and - endpoint (index in the domain or global ID of a frozen particle, -1 if unconnected)
+        int linkEp[2];      ///< endpoint of the connected particle
+        bool linkFrozen[2]; ///< connected particle is frozen
+    };
+
+    struct Domain
+    {
+        vnl_vector_fixed<int, 3> lower;     ///< first global grid cell of the domain
+        vnl_vector_fixed<int, 3> upper;     ///< global grid cell behind the domain
+        unsigned int seed;
+        std::vector< int > sourceFree;      ///< global IDs of the particles that could be changed by the domain sampler
+        std::vector< DomainParticle > particles;
+    };
+
+    /** sampler and local particle grid used by a single thread */
+    struct Worker
+    {
+        ParticleGrid*               grid;
+        SphereInterpolator*         interpolator;
+        GibbsEnergyComputer*        encomp;
+        MetropolisHastingsSampler*  sampler;
+        ItkRandGenType::Pointer     randGen;
+        std::unordered_map< int, int > localIDs;    ///< global -> local particle IDs
+    };
+
+    void SampleDomain(Worker& worker, Domain& domain, unsigned long num, int numParticles);
+    void MergeDomain(Domain& domain, std::vector< int >& deadParticles);
+
+    ParticleGrid*               m_ParticleGrid;     ///< global particle grid
+    std::vector< Worker >       m_Workers;
+    ItkRandGenType::Pointer     m_RandGen;          ///< draws domain offsets and seeds
+    int                         m_DomainSize;       ///< edge length of a domain in grid cells
+    int                         m_HaloSize;         ///< width of the frozen halo in grid cells
+    float                       m_CellSize;
+    float                       m_Temperature;
+};
+
+}
+
+#endif
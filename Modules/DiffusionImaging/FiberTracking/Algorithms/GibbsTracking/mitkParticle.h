@@ -36,6 +36,7 @@ public:
         label = 0;
         pID = -1;
         mID = -1;
+        sourceID = -1;
     }
 
     ~Particle()
@@ -47,6 +48,7 @@ public:
     int pID;                // successor ID
     int mID;                // predecessor ID
     unsigned char label;    // label used in the fiber building process
+    int sourceID;           // ID of the original particle if this particle is a copy living in a sampling domain (-1 otherwise)
 
     vnl_vector_fixed<float, 3>& GetPos()
     {
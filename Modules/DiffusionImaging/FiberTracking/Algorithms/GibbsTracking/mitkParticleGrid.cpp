@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkParticleGrid.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <algorithm>
 
 using namespace mitk;
 
@@ -25,6 +26,7 @@ ParticleGrid::ParticleGrid(ItkFloatImageType* image, float particleLength, int c
 {
     // initialize counters
     m_NumParticles = 0;
+    m_NumFrozenParticles = 0;
     m_NumConnections = 0;
     m_NumCellOverflows = 0;
     m_ParticleLength = particleLength;
@@ -37,6 +39,9 @@ ParticleGrid::ParticleGrid(ItkFloatImageType* image, float particleLength, int c
     m_GridScale[0] = 1/cellSize;
     m_GridScale[1] = 1/cellSize;
     m_GridScale[2] = 1/cellSize;
+    m_GridOffset.fill(0);
+    m_WritableLower.fill(0);
+    m_WritableUpper = m_GridSize;
 
     m_CellCapacity = cellCapacity;          // maximum number of particles per grid cell
     m_ContainerCapacity = 100000;           // initial particle container capacity
@@ -57,6 +62,40 @@ ParticleGrid::ParticleGrid(ItkFloatImageType* image, float particleLength, int c
     std::cout << "ParticleGrid: allocated " << (sizeof(Particle)*m_ContainerCapacity + sizeof(Particle*)*m_GridSize[0]*m_GridSize[1]*m_GridSize[2])/1048576 << "mb for " << m_ContainerCapacity/1000 << "k particles." << std::endl;
 }
 
+ParticleGrid::ParticleGrid(const vnl_vector_fixed<int, 3>& gridSize, float particleLength, int cellCapacity)
+{
+    // initialize counters
+    m_NumParticles = 0;
+    m_NumFrozenParticles = 0;
+    m_NumConnections = 0;
+    m_NumCellOverflows = 0;
+    m_ParticleLength = particleLength;
+
+    // same cell size as the grid covering the complete image
+    float cellSize = 2*m_ParticleLength;
+    m_GridSize = gridSize;
+    m_GridScale.fill(1/cellSize);
+    m_GridOffset.fill(0);
+    m_WritableLower.fill(0);
+    m_WritableUpper = m_GridSize;
+
+    m_CellCapacity = cellCapacity;
+    m_ContainerCapacity = 100000;
+    unsigned long  numCells = m_GridSize[0]*m_GridSize[1]*m_GridSize[2];
+    unsigned long  size = numCells*m_CellCapacity;
+    if ( (unsigned long)itk::NumericTraits<int>::max()<size )
+        throw std::bad_alloc();
+
+    m_Particles.resize(m_ContainerCapacity);
+    m_Grid.resize(size, nullptr);
+    m_OccupationCount.resize(numCells, 0);
+    m_NeighbourTracker.cellidx.resize(8, 0);
+    m_NeighbourTracker.cellidx_c.resize(8, 0);
+
+    for (int i = 0;i < m_ContainerCapacity;i++)
+        m_Particles[i].ID = i;
+}
+
 ParticleGrid::~ParticleGrid()
 {
 
@@ -67,6 +106,7 @@ void ParticleGrid::ResetGrid()
 {
     // initialize counters
     m_NumParticles = 0;
+    m_NumFrozenParticles = 0;
     m_NumConnections = 0;
     m_NumCellOverflows = 0;
     m_Particles.clear();
@@ -82,11 +122,80 @@ void ParticleGrid::ResetGrid()
     m_OccupationCount.resize(numCells, 0);          // allocate and initialize occupation counter array
     m_NeighbourTracker.cellidx.resize(8, 0);        // allocate and initialize neighbour tracker
     m_NeighbourTracker.cellidx_c.resize(8, 0);
+    m_WritableLower.fill(0);
+    m_WritableUpper = m_GridSize;
 
     for (int i = 0;i < m_ContainerCapacity;i++)     // initialize particle IDs
         m_Particles[i].ID = i;
 }
 
+void ParticleGrid::SetGridOffset(const vnl_vector_fixed<int, 3>& offset)
+{
+    m_GridOffset = offset;
+    ResetGrid();
+}
+
+void ParticleGrid::SetWritableRegion(const vnl_vector_fixed<int, 3>& lower, const vnl_vector_fixed<int, 3>& upper)
+{
+    for (int i=0; i<3; i++)
+    {
+        m_WritableLower[i] = std::max(lower[i]-m_GridOffset[i], 0);
+        m_WritableUpper[i] = std::min(upper[i]-m_GridOffset[i], m_GridSize[i]);
+    }
+}
+
+void ParticleGrid::FreezeParticles()
+{
+    m_NumFrozenParticles = m_NumParticles;
+}
+
+vnl_vector_fixed<int, 3> ParticleGrid::GetGridSize()
+{
+    return m_GridSize;
+}
+
+vnl_vector_fixed<int, 3> ParticleGrid::GetCell(vnl_vector_fixed<float, 3>& R)
+{
+    vnl_vector_fixed<int, 3> cell;
+    cell[0] = int(R[0]*m_GridScale[0]);
+    cell[1] = int(R[1]*m_GridScale[1]);
+    cell[2] = int(R[2]*m_GridScale[2]);
+    return cell;
+}
+
+int ParticleGrid::GetNumParticlesInCell(const vnl_vector_fixed<int, 3>& cell)
+{
+    vnl_vector_fixed<int, 3> c = cell - m_GridOffset;
+    return m_OccupationCount[c[0] + m_GridSize[0]*(c[1] + m_GridSize[1]*c[2])];
+}
+
+Particle* ParticleGrid::GetParticleInCell(const vnl_vector_fixed<int, 3>& cell, int i)
+{
+    vnl_vector_fixed<int, 3> c = cell - m_GridOffset;
+    return m_Grid[m_CellCapacity*(c[0] + m_GridSize[0]*(c[1] + m_GridSize[1]*c[2])) + i];
+}
+
+int ParticleGrid::GetWritableCellIndex(vnl_vector_fixed<float, 3>& R)
+{
+    int xint = int(R[0]*m_GridScale[0]) - m_GridOffset[0];
+    if (xint < m_WritableLower[0])
+        return -1;
+    if (xint >= m_WritableUpper[0])
+        return -1;
+    int yint = int(R[1]*m_GridScale[1]) - m_GridOffset[1];
+    if (yint < m_WritableLower[1])
+        return -1;
+    if (yint >= m_WritableUpper[1])
+        return -1;
+    int zint = int(R[2]*m_GridScale[2]) - m_GridOffset[2];
+    if (zint < m_WritableLower[2])
+        return -1;
+    if (zint >= m_WritableUpper[2])
+        return -1;
+
+    return xint + m_GridSize[0]*(yint + m_GridSize[1]*zint);
+}
+
 bool ParticleGrid::ReallocateGrid()
 {
     int new_capacity = m_ContainerCapacity + 100000;    // increase container capacity by 100k particles
@@ -127,29 +236,17 @@ Particle* ParticleGrid::NewParticle(vnl_vector_fixed<float, 3> R)
             return nullptr;
     }
 
-    int xint = int(R[0]*m_GridScale[0]);
-    if (xint < 0)
-        return nullptr;
-    if (xint >= m_GridSize[0])
-        return nullptr;
-    int yint = int(R[1]*m_GridScale[1]);
-    if (yint < 0)
-        return nullptr;
-    if (yint >= m_GridSize[1])
-        return nullptr;
-    int zint = int(R[2]*m_GridScale[2]);
-    if (zint < 0)
-        return nullptr;
-    if (zint >= m_GridSize[2])
+    int idx = GetWritableCellIndex(R);
+    if (idx < 0)
         return nullptr;
 
-    int idx = xint + m_GridSize[0]*(yint + m_GridSize[1]*zint);
     if (m_OccupationCount[idx] < m_CellCapacity)
     {
         Particle *p = &(m_Particles[m_NumParticles]);
         p->GetPos() = R;
         p->mID = -1;
         p->pID = -1;
+        p->sourceID = -1;
         m_NumParticles++;
         p->gridindex = m_CellCapacity*idx + m_OccupationCount[idx];
         m_Grid[p->gridindex] = p;
@@ -167,23 +264,10 @@ bool ParticleGrid::TryUpdateGrid(int k)
 {
     Particle* p = &(m_Particles[k]);
 
-    int xint = int(p->GetPos()[0]*m_GridScale[0]);
-    if (xint < 0)
-        return false;
-    if (xint >= m_GridSize[0])
-        return false;
-    int yint = int(p->GetPos()[1]*m_GridScale[1]);
-    if (yint < 0)
-        return false;
-    if (yint >= m_GridSize[1])
-        return false;
-    int zint = int(p->GetPos()[2]*m_GridScale[2]);
-    if (zint < 0)
-        return false;
-    if (zint >= m_GridSize[2])
+    int idx = GetWritableCellIndex(p->GetPos());
+    if (idx < 0)
         return false;
 
-    int idx = xint + m_GridSize[0]*(yint+ zint*m_GridSize[1]);
     int cellidx = p->gridindex/m_CellCapacity;
     if (idx != cellidx) // cell has changed
     {
@@ -273,18 +357,21 @@ void ParticleGrid::ComputeNeighbors(vnl_vector_fixed<float, 3> &R)
 
     int dx = -1;
     if (xfrac-xint > 0.5) dx = 1;
+    xint -= m_GridOffset[0];
     if (xint <= 0) { xint = 0; dx = 1; }
     if (xint >= m_GridSize[0]-1) { xint = m_GridSize[0]-1; dx = -1; }
     if (m_GridSize[0] <= 1) { dx = 0; } // Necessary with 2d images (bug 15416)
 
     int dy = -1;
     if (yfrac-yint > 0.5) dy = 1;
+    yint -= m_GridOffset[1];
     if (yint <= 0) {yint = 0; dy = 1; }
     if (yint >= m_GridSize[1]-1) {yint = m_GridSize[1]-1; dy = -1;}
     if (m_GridSize[1] <= 1) { dy = 0; } // Necessary with 2d images (bug 15416)
 
     int dz = -1;
     if (zfrac-zint > 0.5) dz = 1;
+    zint -= m_GridOffset[2];
     if (zint <= 0) {zint = 0; dz = 1; }
     if (zint >= m_GridSize[2]-1) {zint = m_GridSize[2]-1; dz = -1;}
     if (m_GridSize[2] <= 1) { dz = 0; } // Necessary with 2d images (bug 15416)
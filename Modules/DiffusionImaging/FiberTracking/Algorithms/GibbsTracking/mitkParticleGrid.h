@@ -38,11 +38,13 @@ public:
     typedef itk::Image< float, 3 >  ItkFloatImageType;
 
     int m_NumParticles;         // number of particles
+    int m_NumFrozenParticles;   // particles with ID < m_NumFrozenParticles must not be changed by the sampler
     int m_NumConnections;       // number of connections
     int m_NumCellOverflows;     // number of cell overflows
     float m_ParticleLength;
 
     ParticleGrid(ItkFloatImageType* image, float particleLength, int cellCapacity);
+    ParticleGrid(const vnl_vector_fixed<int, 3>& gridSize, float particleLength, int cellCapacity);   ///< grid covering only a part of the image (see SetGridOffset)
     ~ParticleGrid();
 
     Particle* GetParticle(int ID);
@@ -61,9 +63,19 @@ public:
     bool CheckConsistency();
     void ResetGrid();
 
+    /** sub-grids used to sample single spatial domains in parallel. all cell indices are global, i.e. refer to the grid covering the complete image. */
+    void SetGridOffset(const vnl_vector_fixed<int, 3>& offset);   ///< global index of the first cell of this grid. removes all particles.
+    void SetWritableRegion(const vnl_vector_fixed<int, 3>& lower, const vnl_vector_fixed<int, 3>& upper);  ///< particles can only be created in or moved to cells in [lower, upper)
+    void FreezeParticles();     ///< mark all particles currently contained in the grid as frozen
+    vnl_vector_fixed<int, 3> GetGridSize();
+    vnl_vector_fixed<int, 3> GetCell(vnl_vector_fixed<float, 3>& R);  ///< global index of the cell containing R
+    int GetNumParticlesInCell(const vnl_vector_fixed<int, 3>& cell);
+    Particle* GetParticleInCell(const vnl_vector_fixed<int, 3>& cell, int i);
+
 protected:
 
     bool ReallocateGrid();
+    int GetWritableCellIndex(vnl_vector_fixed<float, 3>& R);   ///< index of the cell containing R or -1 if R lies outside of the writable region
 
     std::vector< Particle* >    m_Grid;             // the grid
     std::vector< Particle >     m_Particles;        // particle container
@@ -73,6 +85,9 @@ protected:
 
     vnl_vector_fixed< int, 3 >      m_GridSize;     // grid dimensions
     vnl_vector_fixed< float, 3 >    m_GridScale;    // scaling factor for grid
+    vnl_vector_fixed< int, 3 >      m_GridOffset;   // global index of first grid cell
+    vnl_vector_fixed< int, 3 >      m_WritableLower;    // local index of first cell that can receive particles
+    vnl_vector_fixed< int, 3 >      m_WritableUpper;    // local index behind last cell that can receive particles
 
     int m_CellCapacity;      // particle capacity of single cell in grid
 
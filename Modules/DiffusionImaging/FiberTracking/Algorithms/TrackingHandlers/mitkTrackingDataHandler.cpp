@@ -26,6 +26,7 @@ namespace mitk
         , m_FlipZ(false)
         , m_Mode(MODE::DETERMINISTIC)
         , m_RngItk(ItkRngType::New())
+        , m_StreamlineRngSeed(0)
         , m_NeedsDataInit(true)
         , m_Random(true)
     {
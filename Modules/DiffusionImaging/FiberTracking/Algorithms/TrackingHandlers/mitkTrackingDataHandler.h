@@ -25,6 +25,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <boost/random/discrete_distribution.hpp>
 #include <boost/random/variate_generator.hpp>
 #include <boost/random/mersenne_twister.hpp>
+#include <boost/random/seed_seq.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
 #include <mitkDiffusionFunctionCollection.h>
 #include <itkLinearInterpolateImageFunction.h>
 
@@ -55,7 +57,7 @@ public:
     typedef itk::Image<double, 3>         ItkDoubleImgType;
     typedef vnl_vector_fixed< float, 3 >  TrackingDirectionType;
 
-    virtual TrackingDirectionType ProposeDirection(const itk::Point<float, 3>& pos, std::deque< TrackingDirectionType >& olddirs, itk::Index<3>& oldIndex) = 0;  ///< predicts next progression direction at the given position
+    virtual TrackingDirectionType ProposeDirection(const itk::Point<float, 3>& pos, std::deque< TrackingDirectionType >& olddirs, itk::Index<3>& oldIndex, BoostRngType& rng) = 0;  ///< predicts next progression direction at the given position, rng is used for the probabilistic sampling
 
     virtual void InitForTracking() = 0;
     virtual itk::Vector<double, 3> GetSpacing() = 0;
@@ -81,12 +83,14 @@ public:
         m_Rng.seed(0);
         std::srand(0);
         m_RngItk->SetSeed(0);
+        m_StreamlineRngSeed = 0;
       }
       else
       {
         m_Rng.seed();
         m_RngItk->SetSeed();
         std::srand(std::time(0));
+        m_StreamlineRngSeed = m_RngItk->GetIntegerVariate();
       }
     }
 
@@ -95,6 +99,24 @@ public:
       return m_RngItk->GetUniformVariate(a, b);
     }
 
+    /**
+    * \brief Seeds the generator used for the streamline started at the given seed point.
+    *
+    * The random numbers of a streamline only depend on its seed index and on SetRandom(), not on the tracking thread.
+    * Probabilistic tracking is therefore reproducible after SetRandom(false) with any number of threads.
+    */
+    void InitStreamlineRng(BoostRngType& rng, unsigned int seed_index) const
+    {
+      const boost::uint32_t seeds[2] = {m_StreamlineRngSeed, seed_index};
+      boost::random::seed_seq seq(seeds, seeds+2);
+      rng.seed(seq);
+    }
+
+    static double GetRandDouble(BoostRngType& rng, const double & a, const double & b)
+    {
+      return boost::random::uniform_real_distribution<double>(a, b)(rng);
+    }
+
 protected:
 
     float               m_AngularThreshold;
@@ -105,6 +127,7 @@ protected:
     MODE                m_Mode;
     BoostRngType        m_Rng;
     ItkRngType::Pointer m_RngItk;
+    boost::uint32_t     m_StreamlineRngSeed;
     bool                m_NeedsDataInit;
     bool                m_Random;
 
@@ -90,7 +90,7 @@ void TrackingHandlerOdf::InitForTracking()
     std::cout << "TrackingHandlerOdf - Sharpening ODfs" << std::endl;
 }
 
-int TrackingHandlerOdf::SampleOdf(vnl_vector< float >& probs, vnl_vector< float >& angles)
+int TrackingHandlerOdf::SampleOdf(vnl_vector< float >& probs, vnl_vector< float >& angles, BoostRngType& rng)
 {
   boost::random::discrete_distribution<int, float> dist(probs.begin(), probs.end());
   int sampled_idx = 0;
@@ -101,11 +101,7 @@ int TrackingHandlerOdf::SampleOdf(vnl_vector< float >& probs, vnl_vector< float
   for (int i=0; i<m_NumProbSamples; i++)  // we sample m_NumProbSamples times and retain the sample with maximum probabilty
   {
     trials++;
-#pragma omp critical
-    {
-      boost::random::variate_generator<boost::random::mt19937&, boost::random::discrete_distribution<int,float>> sampler(m_Rng, dist);
-      sampled_idx = sampler();
-    }
+    sampled_idx = dist(rng);
     if (probs[sampled_idx]>max_prob && probs[sampled_idx]>m_OdfThreshold && fabs(angles[sampled_idx])>=m_AngularThreshold)
     {
       max_prob = probs[sampled_idx];
@@ -128,7 +124,7 @@ bool TrackingHandlerOdf::GetIsOdfFromTensor() const
   return m_OdfFromTensor;
 }
 
-vnl_vector_fixed<float,3> TrackingHandlerOdf::ProposeDirection(const itk::Point<float, 3>& pos, std::deque<vnl_vector_fixed<float, 3> >& olddirs, itk::Index<3>& oldIndex)
+vnl_vector_fixed<float,3> TrackingHandlerOdf::ProposeDirection(const itk::Point<float, 3>& pos, std::deque<vnl_vector_fixed<float, 3> >& olddirs, itk::Index<3>& oldIndex, BoostRngType& rng)
 {
 
   vnl_vector_fixed<float,3> output_direction; output_direction.fill(0);
@@ -202,7 +198,7 @@ vnl_vector_fixed<float,3> TrackingHandlerOdf::ProposeDirection(const itk::Point<
     }
     else if (m_Mode==MODE::PROBABILISTIC) // sample from complete ODF
     {
-      int max_sample_idx = SampleOdf(probs, angles);
+      int max_sample_idx = SampleOdf(probs, angles, rng);
       if (max_sample_idx>=0)
         output_direction = m_OdfFloatDirs.get_row(max_sample_idx) * probs[max_sample_idx];
       return output_direction;
@@ -253,7 +249,7 @@ vnl_vector_fixed<float,3> TrackingHandlerOdf::ProposeDirection(const itk::Point<
   // do probabilistic sampling
   if (m_Mode==MODE::PROBABILISTIC && probs_sum>0.0001)
   {
-    int max_sample_idx = SampleOdf(probs, angles);
+    int max_sample_idx = SampleOdf(probs, angles, rng);
     if (max_sample_idx>=0)
     {
       output_direction = m_OdfFloatDirs.get_row(max_sample_idx);
@@ -43,7 +43,7 @@ public:
 
 
   void InitForTracking();     ///< calls InputDataValidForTracking() and creates feature images
-  vnl_vector_fixed<float,3> ProposeDirection(const itk::Point<float, 3>& pos, std::deque< vnl_vector_fixed<float,3> >& olddirs, itk::Index<3>& oldIndex);  ///< predicts next progression direction at the given position
+  vnl_vector_fixed<float,3> ProposeDirection(const itk::Point<float, 3>& pos, std::deque< vnl_vector_fixed<float,3> >& olddirs, itk::Index<3>& oldIndex, BoostRngType& rng);  ///< predicts next progression direction at the given position
   bool WorldToIndex(itk::Point<float, 3>& pos, itk::Index<3>& index);
 
   void SetSharpenOdfs(bool doSharpen) { m_SharpenOdfs=doSharpen; }
@@ -66,7 +66,7 @@ public:
 
 protected:
 
-  int SampleOdf(vnl_vector< float >& probs, vnl_vector< float >& angles);
+  int SampleOdf(vnl_vector< float >& probs, vnl_vector< float >& angles, BoostRngType& rng);
 
   float                           m_GfaThreshold;
   float                           m_OdfThreshold;
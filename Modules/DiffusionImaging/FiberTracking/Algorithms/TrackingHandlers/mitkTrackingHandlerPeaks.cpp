@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkTrackingHandlerPeaks.h"
+#include <boost/random/uniform_int_distribution.hpp>
 
 namespace mitk
 {
@@ -74,7 +75,7 @@ void TrackingHandlerPeaks::InitForTracking()
   std::cout << "TrackingHandlerPeaks - Peak threshold: " << m_PeakThreshold << std::endl;
 }
 
-vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetMatchingDirection(itk::Index<3> idx3, vnl_vector_fixed<float,3>& oldDir)
+vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetMatchingDirection(itk::Index<3> idx3, vnl_vector_fixed<float,3>& oldDir, BoostRngType& rng)
 {
   vnl_vector_fixed<float,3> out_dir; out_dir.fill(0);
   float angle = 0;
@@ -88,9 +89,7 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetMatchingDirection(itk::Index<
       // try m_NumDirs times to get a non-zero random direction
       for (int j=0; j<m_NumDirs; j++)
       {
-        int i = 0;
-#pragma omp critical
-        i = m_RngItk->GetIntegerVariate(m_NumDirs-1);
+        int i = boost::random::uniform_int_distribution<int>(0, m_NumDirs-1)(rng);
         out_dir = GetDirection(idx3, i);
 
         if (out_dir.magnitude()>mitk::eps)
@@ -174,7 +173,7 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetDirection(itk::Index<3> idx3,
   return dir;
 }
 
-vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetDirection(itk::Point<float, 3> itkP, bool interpolate, vnl_vector_fixed<float,3> oldDir){
+vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetDirection(itk::Point<float, 3> itkP, bool interpolate, vnl_vector_fixed<float,3> oldDir, BoostRngType& rng){
   // transform physical point to index coordinates
   itk::Index<3> idx3;
   itk::ContinuousIndex< float, 3> cIdx;
@@ -225,37 +224,37 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetDirection(itk::Point<float, 3
       interpWeights[6] = (1-frac_x)*(  frac_y)*(1-frac_z);
       interpWeights[7] = (1-frac_x)*(1-frac_y)*(1-frac_z);
 
-      dir = GetMatchingDirection(idx3, oldDir) * interpWeights[0];
+      dir = GetMatchingDirection(idx3, oldDir, rng) * interpWeights[0];
 
       itk::Index<3> tmpIdx = idx3; tmpIdx[0]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[1];
+      dir +=  GetMatchingDirection(tmpIdx, oldDir, rng) * interpWeights[1];
 
       tmpIdx = idx3; tmpIdx[1]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[2];
+      dir +=  GetMatchingDirection(tmpIdx, oldDir, rng) * interpWeights[2];
 
       tmpIdx = idx3; tmpIdx[2]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[3];
+      dir +=  GetMatchingDirection(tmpIdx, oldDir, rng) * interpWeights[3];
 
       tmpIdx = idx3; tmpIdx[0]++; tmpIdx[1]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[4];
+      dir +=  GetMatchingDirection(tmpIdx, oldDir, rng) * interpWeights[4];
 
       tmpIdx = idx3; tmpIdx[1]++; tmpIdx[2]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[5];
+      dir +=  GetMatchingDirection(tmpIdx, oldDir, rng) * interpWeights[5];
 
       tmpIdx = idx3; tmpIdx[2]++; tmpIdx[0]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[6];
+      dir +=  GetMatchingDirection(tmpIdx, oldDir, rng) * interpWeights[6];
 
       tmpIdx = idx3; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[7];
+      dir +=  GetMatchingDirection(tmpIdx, oldDir, rng) * interpWeights[7];
     }
   }
   else
-    dir = GetMatchingDirection(idx3, oldDir);
+    dir = GetMatchingDirection(idx3, oldDir, rng);
 
   return dir;
 }
 
-vnl_vector_fixed<float,3> TrackingHandlerPeaks::ProposeDirection(const itk::Point<float, 3>& pos, std::deque<vnl_vector_fixed<float, 3> >& olddirs, itk::Index<3>& oldIndex)
+vnl_vector_fixed<float,3> TrackingHandlerPeaks::ProposeDirection(const itk::Point<float, 3>& pos, std::deque<vnl_vector_fixed<float, 3> >& olddirs, itk::Index<3>& oldIndex, BoostRngType& rng)
 {
   // CHECK: wann wird wo normalisiert
   vnl_vector_fixed<float,3> output_direction; output_direction.fill(0);
@@ -269,7 +268,7 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::ProposeDirection(const itk::Poin
   if (!m_Interpolate && oldIndex==index)
     return oldDir;
 
-  output_direction = GetDirection(pos, m_Interpolate, oldDir);
+  output_direction = GetDirection(pos, m_Interpolate, oldDir, rng);
   float mag = output_direction.magnitude();
 
   if (mag>=m_PeakThreshold)
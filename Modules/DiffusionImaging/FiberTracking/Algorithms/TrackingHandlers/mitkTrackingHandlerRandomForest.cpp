@@ -178,7 +178,7 @@ void TrackingHandlerRandomForest< ShOrder, NumberOfSignalFeatures >::InitForTrac
 }
 
 template< int ShOrder, int NumberOfSignalFeatures >
-vnl_vector_fixed<float,3> TrackingHandlerRandomForest< ShOrder, NumberOfSignalFeatures >::ProposeDirection(const itk::Point<float, 3>& pos, std::deque<vnl_vector_fixed<float, 3> >& olddirs, itk::Index<3>& oldIndex)
+vnl_vector_fixed<float,3> TrackingHandlerRandomForest< ShOrder, NumberOfSignalFeatures >::ProposeDirection(const itk::Point<float, 3>& pos, std::deque<vnl_vector_fixed<float, 3> >& olddirs, itk::Index<3>& oldIndex, BoostRngType& rng)
 {
 
   vnl_vector_fixed<float,3> output_direction; output_direction.fill(0);
@@ -316,11 +316,7 @@ vnl_vector_fixed<float,3> TrackingHandlerRandomForest< ShOrder, NumberOfSignalFe
 
     for (int i=0; i<50; i++)  // we allow 50 trials to exceed m_AngularThreshold
     {
-  #pragma omp critical
-      {
-        boost::random::variate_generator<boost::random::mt19937&, boost::random::discrete_distribution<int,float>> sampler(m_Rng, dist);
-        sampled_idx = sampler();
-      }
+      sampled_idx = dist(rng);
 
       if ( probs2[sampled_idx]>0.1 && (!check_last_dir || (check_last_dir && fabs(angles[sampled_idx])>=m_AngularThreshold)) )
         break;
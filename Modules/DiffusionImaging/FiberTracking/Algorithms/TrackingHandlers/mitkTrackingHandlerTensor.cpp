@@ -294,7 +294,7 @@ vnl_vector_fixed<float,3> TrackingHandlerTensor::GetLargestEigenvector(TensorTyp
   return dir;
 }
 
-vnl_vector_fixed<float,3> TrackingHandlerTensor::ProposeDirection(const itk::Point<float, 3>& pos, std::deque<vnl_vector_fixed<float, 3> >& olddirs, itk::Index<3>& oldIndex)
+vnl_vector_fixed<float,3> TrackingHandlerTensor::ProposeDirection(const itk::Point<float, 3>& pos, std::deque<vnl_vector_fixed<float, 3> >& olddirs, itk::Index<3>& oldIndex, BoostRngType& rng)
 {
   vnl_vector_fixed<float,3> output_direction; output_direction.fill(0);
   TensorType tensor; tensor.Fill(0);
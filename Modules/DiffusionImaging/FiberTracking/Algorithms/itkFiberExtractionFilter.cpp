@@ -23,6 +23,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <math.h>
 #include <boost/progress.hpp>
 #include <mitkDiffusionFunctionCollection.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <algorithm>
+#include <limits>
 
 namespace itk{
 
@@ -94,6 +97,115 @@ bool FiberExtractionFilter< PixelType >::IsPositive(const itk::Point<float, 3>&
   return false;
 }
 
+template< class PixelType >
+bool FiberExtractionFilter< PixelType >::GetPositiveBounds(ItkInputImgType* roi, double bounds[6])
+{
+  itk::Index<3> minIdx, maxIdx;
+  bool found = false;
+  itk::ImageRegionConstIteratorWithIndex< ItkInputImgType > it(roi, roi->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    bool positive = false;
+    if( m_InputType == INPUT::SCALAR_MAP )
+      positive = it.Get()>=m_Threshold;
+    else
+    {
+      // the label extraction compares the labels to the pixel values truncated to short
+      for (auto l : m_Labels)
+        if (l==it.Get() || l==(short)it.Get())
+          positive = true;
+    }
+    if (!positive)
+      continue;
+
+    itk::Index<3> idx = it.GetIndex();
+    for (int a=0; a<3; ++a)
+    {
+      if (!found || idx[a]<minIdx[a])
+        minIdx[a] = idx[a];
+      if (!found || idx[a]>maxIdx[a])
+        maxIdx[a] = idx[a];
+    }
+    found = true;
+  }
+  if (!found)
+    return false;
+
+  // a positive point is closer than one voxel to a positive voxel center, also with linear interpolation
+  for (int a=0; a<3; ++a)
+  {
+    bounds[2*a] = std::numeric_limits<double>::max();
+    bounds[2*a+1] = -std::numeric_limits<double>::max();
+  }
+  for (int c=0; c<8; ++c)
+  {
+    itk::ContinuousIndex< double, 3 > cIdx;
+    for (int a=0; a<3; ++a)
+      cIdx[a] = (c & (1<<a)) ? maxIdx[a]+1 : minIdx[a]-1;
+    itk::Point< double, 3 > p;
+    roi->TransformContinuousIndexToPhysicalPoint(cIdx, p);
+    for (int a=0; a<3; ++a)
+    {
+      bounds[2*a] = std::min(bounds[2*a], p[a]);
+      bounds[2*a+1] = std::max(bounds[2*a+1], p[a]);
+    }
+  }
+  return true;
+}
+
+template< class PixelType >
+void FiberExtractionFilter< PixelType >::FindCandidates()
+{
+  m_Candidates.clear();
+
+  // interpolated labels can match anywhere in the image and points outside of the image have label 0
+  bool allCandidates = m_InputType==INPUT::LABEL_MAP &&
+      (m_Interpolate || std::find(m_Labels.begin(), m_Labels.end(), 0)!=m_Labels.end());
+  if (allCandidates)
+  {
+    for (long i=0; i<m_InputFiberBundle->GetNumFibers(); ++i)
+      m_Candidates.push_back(i);
+    return;
+  }
+
+  const mitk::FiberSpatialIndex* index = m_InputFiberBundle->GetSpatialIndex();
+  for (auto roi : m_RoiImages)
+  {
+    double bounds[6];
+    if (!GetPositiveBounds(roi, bounds))
+      continue;
+    std::vector< long > ids = index->GetFibers(bounds);
+    std::vector< long > merged;
+    std::set_union(m_Candidates.begin(), m_Candidates.end(), ids.begin(), ids.end(), std::back_inserter(merged));
+    m_Candidates.swap(merged);
+  }
+  MITK_INFO << m_Candidates.size() << " of " << m_InputFiberBundle->GetNumFibers() << " fibers pass through the ROI bounding boxes";
+}
+
+template< class PixelType >
+void FiberExtractionFilter< PixelType >::AddNonCandidates(std::vector< long >& ids)
+{
+  std::vector< long > merged;
+  merged.reserve(ids.size() + m_InputFiberBundle->GetNumFibers() - m_Candidates.size());
+  auto id = ids.begin();
+  auto candidate = m_Candidates.begin();
+  for (long i=0; i<m_InputFiberBundle->GetNumFibers(); ++i)
+  {
+    if (candidate!=m_Candidates.end() && *candidate==i)
+    {
+      ++candidate;
+      if (id!=ids.end() && *id==i)
+      {
+        merged.push_back(i);
+        ++id;
+      }
+    }
+    else
+      merged.push_back(i);
+  }
+  ids.swap(merged);
+}
+
 template< class PixelType >
 std::vector< std::pair<unsigned int, unsigned int> > FiberExtractionFilter< PixelType >::GetPositiveLabels() const
 {
@@ -111,11 +223,12 @@ void FiberExtractionFilter< PixelType >::ExtractOverlap(mitk::FiberBundle::Point
 
   std::vector< long > negative_ids; // fibers not overlapping with ANY mask
 
-  boost::progress_display disp(m_InputFiberBundle->GetNumFibers());
-  for (int i=0; i<m_InputFiberBundle->GetNumFibers(); i++)
+  boost::progress_display disp(fib->GetNumFibers());
+  for (int k=0; k<fib->GetNumFibers(); k++)
   {
     ++disp;
-    vtkCell* cell = polydata->GetCell(i);
+    long i = m_Candidates.at(k);
+    vtkCell* cell = polydata->GetCell(k);
     int numPoints = cell->GetNumberOfPoints();
     vtkPoints* points = cell->GetPoints();
 
@@ -151,7 +264,10 @@ void FiberExtractionFilter< PixelType >::ExtractOverlap(mitk::FiberBundle::Point
   }
 
   if (!m_NoNegatives)
+  {
+    AddNonCandidates(negative_ids);
     m_Negatives.push_back(CreateFib(negative_ids));
+  }
   if (!m_NoPositives)
     for (auto ids : positive_ids)
       if (ids.size()>=m_MinFibersPerTract)
@@ -169,11 +285,12 @@ void FiberExtractionFilter< PixelType >::ExtractEndpoints(mitk::FiberBundle::Poi
 
   std::vector< long > negative_ids; // fibers not overlapping with ANY mask
 
-  boost::progress_display disp(m_InputFiberBundle->GetNumFibers());
-  for (int i=0; i<m_InputFiberBundle->GetNumFibers(); i++)
+  boost::progress_display disp(fib->GetNumFibers());
+  for (int k=0; k<fib->GetNumFibers(); k++)
   {
     ++disp;
-    vtkCell* cell = polydata->GetCell(i);
+    long i = m_Candidates.at(k);
+    vtkCell* cell = polydata->GetCell(k);
     int numPoints = cell->GetNumberOfPoints();
     vtkPoints* points = cell->GetPoints();
 
@@ -217,7 +334,10 @@ void FiberExtractionFilter< PixelType >::ExtractEndpoints(mitk::FiberBundle::Poi
   }
 
   if (!m_NoNegatives)
+  {
+    AddNonCandidates(negative_ids);
     m_Negatives.push_back(CreateFib(negative_ids));
+  }
   if (!m_NoPositives)
     for (auto ids : positive_ids)
       if (ids.size()>=m_MinFibersPerTract)
@@ -235,11 +355,12 @@ void FiberExtractionFilter< PixelType >::ExtractLabels(mitk::FiberBundle::Pointe
 
   std::vector< long > negative_ids; // fibers not overlapping with ANY label
 
-  boost::progress_display disp(m_InputFiberBundle->GetNumFibers());
-  for (int i=0; i<m_InputFiberBundle->GetNumFibers(); i++)
+  boost::progress_display disp(fib->GetNumFibers());
+  for (int k=0; k<fib->GetNumFibers(); k++)
   {
     ++disp;
-    vtkCell* cell = polydata->GetCell(i);
+    long i = m_Candidates.at(k);
+    vtkCell* cell = polydata->GetCell(k);
     int numPoints = cell->GetNumberOfPoints();
     vtkPoints* points = cell->GetPoints();
 
@@ -307,7 +428,10 @@ void FiberExtractionFilter< PixelType >::ExtractLabels(mitk::FiberBundle::Pointe
   }
 
   if (!m_NoNegatives)
+  {
+    AddNonCandidates(negative_ids);
     m_Negatives.push_back(CreateFib(negative_ids));
+  }
   if (!m_NoPositives)
   {
     for (auto labels : positive_ids)
@@ -358,7 +482,12 @@ void FiberExtractionFilter< PixelType >::GenerateData()
     return;
   }
 
-  if (m_Mode==MODE::OVERLAP && !m_DontResampleFibers)
+  // only the fibers passing through the ROIs are resampled and tested
+  FindCandidates();
+  if ((long)m_Candidates.size()<fib->GetNumFibers())
+    fib = CreateFib(m_Candidates);
+
+  if (m_Mode==MODE::OVERLAP && !m_DontResampleFibers && fib->GetNumFibers()>0)
   {
     float minSpacing = 1;
     for (auto mask : m_RoiImages)
@@ -368,7 +497,8 @@ void FiberExtractionFilter< PixelType >::GenerateData()
           minSpacing = mask->GetSpacing()[i];
     }
 
-    fib = m_InputFiberBundle->GetDeepCopy();
+    if (fib==m_InputFiberBundle)
+      fib = m_InputFiberBundle->GetDeepCopy();
     fib->ResampleLinear(minSpacing/5);
   }
 
@@ -92,6 +92,9 @@ protected:
   void ExtractEndpoints(mitk::FiberBundle::Pointer fib);
   void ExtractLabels(mitk::FiberBundle::Pointer fib);
   bool IsPositive(const itk::Point<float, 3>& itkP);
+  bool GetPositiveBounds(ItkInputImgType* roi, double bounds[6]);  ///< World space bounding box of all points that can be positive; false if the ROI contains no such points
+  void FindCandidates();                                           ///< Finds the fibers passing through the bounding boxes of the ROIs
+  void AddNonCandidates(std::vector< long >& ids);                 ///< Merges the fibers that are no candidates into the sorted ids
 
   mitk::FiberBundle::Pointer                  m_InputFiberBundle;
   std::vector< mitk::FiberBundle::Pointer >   m_Positives;
@@ -112,6 +115,7 @@ protected:
   bool                                        m_SplitLabels;
   unsigned int                                m_MinFibersPerTract;
   std::vector< std::pair< unsigned int, unsigned int > >  m_PositiveLabels;
+  std::vector< long >                         m_Candidates;   ///< Sorted ids of the input fibers that can be positive. Fiber i of the bundle passed to the Extract* methods is m_Candidates[i].
   typename itk::LinearInterpolateImageFunction< itk::Image< PixelType, 3 >, float >::Pointer   m_Interpolator;
 };
 }
@@ -77,7 +77,7 @@ void FitFibersToImageFilter::CreateDiffSystem()
   MITK_INFO << "Num. residuals: " << m_NumResiduals;
   MITK_INFO << "Creating system ...";
 
-  A.set_size(m_NumResiduals, m_NumUnknowns);
+  std::vector< CsrMatrix::ColumnType > columns(m_NumUnknowns);
   b.set_size(m_NumResiduals); b.fill(0.0);
 
   m_MeanTractDensity = 0;
@@ -152,16 +152,11 @@ void FitFibersToImageFilter::CreateDiffSystem()
         {
           unsigned int linear_index = x + sz_x*y + sz_x*sz_y*z + sz_x*sz_y*sz_z*g;
 
+          b[linear_index] = (double)measured_pixel[g] - measured_mean;
           if (m_FitIndividualFibers)
-          {
-            b[linear_index] = (double)measured_pixel[g] - measured_mean;
-            A.put(linear_index, fiber_count, A.get(linear_index, fiber_count) + simulated_pixel[g]);
-          }
+            columns[fiber_count].push_back(std::make_pair(linear_index, (double)simulated_pixel[g]));
           else
-          {
-            b[linear_index] = (double)measured_pixel[g] - measured_mean;
-            A.put(linear_index, bundle, A.get(linear_index, bundle) + simulated_pixel[g]);
-          }
+            columns[bundle].push_back(std::make_pair(linear_index, (double)simulated_pixel[g]));
         }
 
       }
@@ -171,10 +166,12 @@ void FitFibersToImageFilter::CreateDiffSystem()
   }
 
   m_NumCoveredDirections = voxel_indicator.sum();
+  A.SetColumns(m_NumResiduals, columns);
+  MITK_INFO << "System matrix: " << A.GetNumEntries() << " entries, " << A.GetMemorySize()/(1024*1024) << " MB";
 
   m_MeanTractDensity /= (m_NumCoveredDirections*fiber_count);
   m_MeanSignal /= m_NumCoveredDirections;
-  A /= m_MeanTractDensity;
+  A.Scale(1.0/m_MeanTractDensity);
   b *= 100.0/m_MeanSignal;  // times 100 because we want to avoid too small values for computational reasons
 
   // NEW FIT
@@ -218,7 +215,6 @@ void FitFibersToImageFilter::CreatePeakSystem()
   MITK_INFO << "Num. residuals: " << m_NumResiduals;
   MITK_INFO << "Creating system ...";
 
-  A.set_size(m_NumResiduals, m_NumUnknowns);
   b.set_size(m_NumResiduals); b.fill(0.0);
 
   m_MeanTractDensity = 0;
@@ -226,22 +222,35 @@ void FitFibersToImageFilter::CreatePeakSystem()
   m_NumCoveredDirections = 0;
   fiber_count = 0;
 
+  // the contributions of each fiber are collected in parallel, one column of the system matrix per fiber or bundle
+  std::vector< CsrMatrix::ColumnType > columns(m_NumUnknowns);
   for (unsigned int bundle=0; bundle<m_Tractograms.size(); bundle++)
   {
     vtkSmartPointer<vtkPolyData> polydata = m_Tractograms.at(bundle)->GetFiberPolyData();
+    polydata->BuildCells();
+    int num_fibers = m_Tractograms.at(bundle)->GetNumFibers();
 
-    for (int i=0; i<m_Tractograms.at(bundle)->GetNumFibers(); ++i)
+    std::vector< CsrMatrix::ColumnType > fiber_columns;
+    if (!m_FitIndividualFibers)
+      fiber_columns.resize(num_fibers);
+    std::vector< double > fiber_density(num_fibers, 0.0);
+
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int i=0; i<num_fibers; ++i)
     {
-      vtkCell* cell = polydata->GetCell(i);
-      int numPoints = cell->GetNumberOfPoints();
-      vtkPoints* points = cell->GetPoints();
+      CsrMatrix::ColumnType& column = m_FitIndividualFibers ? columns[fiber_count+i] : fiber_columns[i];
+
+      vtkIdType numPoints = 0;
+      vtkIdType* point_ids = nullptr;
+      polydata->GetCellPoints(i, numPoints, point_ids);
 
       if (numPoints<2)
         MITK_INFO << "FIBER WITH ONLY ONE POINT ENCOUNTERED!";
 
       for (int j=0; j<numPoints-1; ++j)
       {
-        double* p1 = points->GetPoint(j);
+        double p1[3];
+        polydata->GetPoint(point_ids[j], p1);
         PointType4 p;
         p[0]=p1[0];
         p[1]=p1[1];
@@ -254,7 +263,8 @@ void FitFibersToImageFilter::CreatePeakSystem()
         if (!m_PeakImage->GetLargestPossibleRegion().IsInside(idx4) || (m_MaskImage.IsNotNull() && m_MaskImage->GetPixel(idx3)==0))
           continue;
 
-        double* p2 = points->GetPoint(j+1);
+        double p2[3];
+        polydata->GetPoint(point_ids[j+1], p2);
         vnl_vector_fixed<float,3> fiber_dir;
         fiber_dir[0] = p[0]-p2[0];
         fiber_dir[1] = p[1]-p2[1];
@@ -263,40 +273,62 @@ void FitFibersToImageFilter::CreatePeakSystem()
 
         double w = 1;
         int peak_id = dim_four_size-1;
-        vnl_vector_fixed<float,3> odf_peak = GetClosestPeak(idx4, m_PeakImage, fiber_dir, peak_id, w);
-        float peak_mag = odf_peak.magnitude();
+        GetClosestPeak(idx4, m_PeakImage, fiber_dir, peak_id, w);
 
         int x = idx4[0];
         int y = idx4[1];
         int z = idx4[2];
 
         unsigned int linear_index = x + sz_x*y + sz_x*sz_y*z + sz_x*sz_y*sz_z*peak_id;
+        fiber_density[i] += w;
+        column.push_back(std::make_pair(linear_index, w));
+      }
+    }
 
-        if (b[linear_index] == 0 && peak_id<dim_four_size-1)
-        {
-          m_NumCoveredDirections++;
-          m_MeanSignal += peak_mag;
-        }
-        m_MeanTractDensity += w;
-
-        if (m_FitIndividualFibers)
-        {
-          b[linear_index] = peak_mag;
-          A.put(linear_index, fiber_count, A.get(linear_index, fiber_count) + w);
-        }
-        else
-        {
-          b[linear_index] = peak_mag;
-          A.put(linear_index, bundle, A.get(linear_index, bundle) + w);
-        }
+    for (int i=0; i<num_fibers; ++i)
+      m_MeanTractDensity += fiber_density[i];
+    if (!m_FitIndividualFibers)
+    {
+      for (auto& c : fiber_columns)
+      {
+        columns[bundle].insert(columns[bundle].end(), c.begin(), c.end());
+        CsrMatrix::ColumnType().swap(c);
       }
+    }
+    fiber_count += num_fibers;
+  }
 
-      ++fiber_count;
+  A.SetColumns(m_NumResiduals, columns);
+  MITK_INFO << "System matrix: " << A.GetNumEntries() << " entries, " << A.GetMemorySize()/(1024*1024) << " MB";
+
+  // every covered peak is fitted to its magnitude, the zero-peak rows keep a target value of zero
+  const std::vector< std::size_t >& row_start = A.GetRowStart();
+  int num_voxels_peaks = sz_x*sz_y*sz_z*(dim_four_size-1);
+  for (int r=0; r<num_voxels_peaks; ++r)
+  {
+    if (row_start[r]==row_start[r+1])
+      continue;
+
+    itk::Index<4> idx4;
+    unsigned int linear_index = r;
+    idx4[0] = linear_index % sz_x; linear_index /= sz_x;
+    idx4[1] = linear_index % sz_y; linear_index /= sz_y;
+    idx4[2] = linear_index % sz_z; linear_index /= sz_z;
+
+    vnl_vector_fixed<float,3> peak;
+    for (int a=0; a<3; ++a)
+    {
+      idx4[3] = linear_index*3 + a;
+      peak[a] = m_PeakImage->GetPixel(idx4);
     }
+    b[r] = peak.magnitude();
+    m_NumCoveredDirections++;
+    m_MeanSignal += b[r];
   }
+
   m_MeanTractDensity /= (m_NumCoveredDirections*fiber_count);
   m_MeanSignal /= m_NumCoveredDirections;
-  A /= m_MeanTractDensity;
+  A.Scale(1.0/m_MeanTractDensity);
   b *= 100.0/m_MeanSignal;  // times 100 because we want to avoid too small values for computational reasons
 
   // NEW FIT
@@ -343,6 +375,7 @@ void FitFibersToImageFilter::GenerateData()
 
   cost = VnlCostFunction(m_NumUnknowns);
   cost.SetProblem(A, b, init_lambda, m_Regularization);
+  cost.m_Verbose = false;
   m_Weights.set_size(m_NumUnknowns);
   m_Weights.fill( 0.0 );
   vnl_lbfgsb minimizer(cost);
@@ -374,6 +407,7 @@ void FitFibersToImageFilter::GenerateData()
 
   MITK_INFO << "Fitting fibers";
   minimizer.set_trace(m_Verbose);
+  cost.m_Verbose = m_Verbose;
 
   minimizer.set_max_function_evals(m_MaxIterations);
   minimizer.minimize(m_Weights);
@@ -419,7 +453,7 @@ void FitFibersToImageFilter::GenerateData()
   MITK_INFO << "NumEvals: " << minimizer.get_num_evaluations();
   MITK_INFO << "NumIterations: " << minimizer.get_num_iterations();
   MITK_INFO << "Residual cost: " << minimizer.get_end_error();
-  m_RMSE = cost.S->get_rms_error(m_Weights);
+  m_RMSE = cost.get_rms_error(m_Weights);
   MITK_INFO << "Final RMS: " << m_RMSE;
 
   clock.Stop();
@@ -449,7 +483,7 @@ void FitFibersToImageFilter::GenerateData()
 
         ++fiber_count;
       }
-      double d_rms = cost.S->get_rms_error(temp_weights) - m_RMSE;
+      double d_rms = cost.get_rms_error(temp_weights) - m_RMSE;
       m_RmsDiffPerBundle[bundle] = d_rms;
       m_Tractograms.at(bundle)->Compress(0.1);
       m_Tractograms.at(bundle)->ColorFibersByFiberWeights(false, true);
@@ -463,7 +497,7 @@ void FitFibersToImageFilter::GenerateData()
       temp_weights.set_size(m_Weights.size());
       temp_weights.copy_in(m_Weights.data_block());
       temp_weights[i] = 0;
-      double d_rms = cost.S->get_rms_error(temp_weights) - m_RMSE;
+      double d_rms = cost.get_rms_error(temp_weights) - m_RMSE;
       m_RmsDiffPerBundle[i] = d_rms;
 
       m_Tractograms.at(i)->SetFiberWeights(m_Weights[i]);
@@ -474,7 +508,7 @@ void FitFibersToImageFilter::GenerateData()
   std::cout.rdbuf (old);
 
   // transform back
-  A *= m_MeanSignal/100.0;
+  A.Scale(m_MeanSignal/100.0);
   b *= m_MeanSignal/100.0;
 
   MITK_INFO << "Generating output images ...";
@@ -515,7 +549,7 @@ void FitFibersToImageFilter::GenerateOutputDiffImages()
   m_FittedImageDiff->FillBuffer(pix);
 
   vnl_vector<double> fitted_b; fitted_b.set_size(b.size());
-  cost.S->multiply(m_Weights, fitted_b);
+  A.Multiply(m_Weights, fitted_b);
 
   itk::ImageRegionIterator<VectorImgType> it1 = itk::ImageRegionIterator<VectorImgType>(m_DiffImage, m_DiffImage->GetLargestPossibleRegion());
   itk::ImageRegionIterator<VectorImgType> it2 = itk::ImageRegionIterator<VectorImgType>(m_FittedImageDiff, m_FittedImageDiff->GetLargestPossibleRegion());
@@ -616,7 +650,7 @@ void FitFibersToImageFilter::GenerateOutputPeakImages()
   m_FittedImage->FillBuffer(0.0);
 
   vnl_vector<double> fitted_b; fitted_b.set_size(b.size());
-  cost.S->multiply(m_Weights, fitted_b);
+  A.Multiply(m_Weights, fitted_b);
 
   for (unsigned int r=0; r<b.size(); r++)
   {
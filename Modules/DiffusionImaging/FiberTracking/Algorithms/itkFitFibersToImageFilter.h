@@ -6,14 +6,168 @@
 #include <itkImageSource.h>
 #include <mitkPeakImage.h>
 #include <vnl/algo/vnl_lbfgsb.h>
-#include <vnl/vnl_sparse_matrix.h>
-#include <vnl/vnl_sparse_matrix_linear_system.h>
 #include <itkImageDuplicator.h>
 #include <itkTimeProbe.h>
+#include <itkMemoryProbe.h>
+#include <algorithm>
+#include <vector>
 #include <itkMersenneTwisterRandomVariateGenerator.h>
 #include <mitkDiffusionPropertyHelper.h>
 #include <mitkDiffusionSignalModel.h>
 
+/**
+* \brief Sparse matrix stored both row-wise (CSR) and column-wise (CSC), so that the products with the matrix and with its transpose can be computed in parallel without write conflicts. */
+class CsrMatrix
+{
+public:
+
+  typedef std::vector< std::pair< unsigned int, double > > ColumnType;  ///< (row, value) entries of one column
+
+  CsrMatrix() : m_NumRows(0) {}
+
+  /** Builds the matrix from its columns. The entries of a column may be unsorted, entries with the same row are summed up. The columns are cleared to free their memory. */
+  void SetColumns(unsigned int num_rows, std::vector< ColumnType >& columns)
+  {
+    m_NumRows = num_rows;
+    int num_cols = columns.size();
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int c=0; c<num_cols; ++c)
+    {
+      ColumnType& col = columns[c];
+      std::sort(col.begin(), col.end(), [](const std::pair< unsigned int, double >& a, const std::pair< unsigned int, double >& b){ return a.first<b.first; });
+      std::size_t n = 0;
+      for (std::size_t k=0; k<col.size(); ++k)
+      {
+        if (n>0 && col[n-1].first==col[k].first)
+          col[n-1].second += col[k].second;
+        else
+          col[n++] = col[k];
+      }
+      col.resize(n);
+    }
+
+    m_ColStart.assign(num_cols+1, 0);
+    for (int c=0; c<num_cols; ++c)
+      m_ColStart[c+1] = m_ColStart[c] + columns[c].size();
+    std::size_t nnz = m_ColStart.back();
+    m_ColRows.resize(nnz);
+    m_ColValues.resize(nnz);
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int c=0; c<num_cols; ++c)
+    {
+      std::size_t k = m_ColStart[c];
+      for (auto& e : columns[c])
+      {
+        m_ColRows[k] = e.first;
+        m_ColValues[k] = e.second;
+        ++k;
+      }
+      ColumnType().swap(columns[c]);
+    }
+    columns.clear();
+
+    // transpose by counting sort; columns are visited in ascending order, so each row is sorted as well
+    m_RowStart.assign((std::size_t)m_NumRows+1, 0);
+    for (std::size_t k=0; k<nnz; ++k)
+      ++m_RowStart[m_ColRows[k]+1];
+    for (unsigned int r=0; r<m_NumRows; ++r)
+      m_RowStart[r+1] += m_RowStart[r];
+
+    m_RowCols.resize(nnz);
+    m_RowValues.resize(nnz);
+    std::vector< std::size_t > pos(m_RowStart.begin(), m_RowStart.end()-1);
+    for (int c=0; c<num_cols; ++c)
+      for (std::size_t k=m_ColStart[c]; k<m_ColStart[c+1]; ++k)
+      {
+        std::size_t& p = pos[m_ColRows[k]];
+        m_RowCols[p] = c;
+        m_RowValues[p] = m_ColValues[k];
+        ++p;
+      }
+  }
+
+  /** y = A*x */
+  void Multiply(const vnl_vector<double>& x, vnl_vector<double>& y) const
+  {
+    y.set_size(m_NumRows);
+#pragma omp parallel for schedule(dynamic, 4096)
+    for (int r=0; r<(int)m_NumRows; ++r)
+    {
+      double sum = 0;
+      for (std::size_t k=m_RowStart[r]; k<m_RowStart[r+1]; ++k)
+        sum += m_RowValues[k]*x[m_RowCols[k]];
+      y[r] = sum;
+    }
+  }
+
+  /** x = A^T*y */
+  void TransposeMultiply(const vnl_vector<double>& y, vnl_vector<double>& x) const
+  {
+    int num_cols = GetNumColumns();
+    x.set_size(num_cols);
+#pragma omp parallel for schedule(dynamic, 256)
+    for (int c=0; c<num_cols; ++c)
+    {
+      double sum = 0;
+      for (std::size_t k=m_ColStart[c]; k<m_ColStart[c+1]; ++k)
+        sum += m_ColValues[k]*y[m_ColRows[k]];
+      x[c] = sum;
+    }
+  }
+
+  /** Same as Multiply with all stored entries set to one. */
+  void PatternMultiply(const vnl_vector<double>& x, vnl_vector<double>& y) const
+  {
+    y.set_size(m_NumRows);
+#pragma omp parallel for schedule(dynamic, 4096)
+    for (int r=0; r<(int)m_NumRows; ++r)
+    {
+      double sum = 0;
+      for (std::size_t k=m_RowStart[r]; k<m_RowStart[r+1]; ++k)
+        sum += x[m_RowCols[k]];
+      y[r] = sum;
+    }
+  }
+
+  void Scale(double factor)
+  {
+    int nnz = (int)m_RowValues.size();
+#pragma omp parallel for
+    for (int k=0; k<nnz; ++k)
+    {
+      m_RowValues[k] *= factor;
+      m_ColValues[k] *= factor;
+    }
+  }
+
+  unsigned int GetNumRows() const { return m_NumRows; }
+  unsigned int GetNumColumns() const { return m_ColStart.empty() ? 0 : m_ColStart.size()-1; }
+  std::size_t GetNumEntries() const { return m_RowValues.size(); }
+  std::size_t GetNumEntries(unsigned int row) const { return m_RowStart[row+1]-m_RowStart[row]; }
+  /** Memory used by the matrix in bytes. */
+  std::size_t GetMemorySize() const
+  {
+    return (m_RowStart.size() + m_ColStart.size())*sizeof(std::size_t) + 2*GetNumEntries()*(sizeof(unsigned int) + sizeof(double));
+  }
+
+  const std::vector< std::size_t >& GetRowStart() const { return m_RowStart; }
+  const std::vector< unsigned int >& GetRowColumns() const { return m_RowCols; }
+  const std::vector< std::size_t >& GetColumnStart() const { return m_ColStart; }
+  const std::vector< unsigned int >& GetColumnRows() const { return m_ColRows; }
+
+protected:
+
+  unsigned int                  m_NumRows;
+  std::vector< std::size_t >    m_RowStart;
+  std::vector< unsigned int >   m_RowCols;
+  std::vector< double >         m_RowValues;
+  std::vector< std::size_t >    m_ColStart;
+  std::vector< unsigned int >   m_ColRows;
+  std::vector< double >         m_ColValues;
+};
+
 class VnlCostFunction : public vnl_cost_function
 {
 public:
@@ -26,37 +180,40 @@ public:
     NONE
   };
 
-  vnl_sparse_matrix_linear_system< double >* S;
-  vnl_sparse_matrix< double > m_A;
-  vnl_sparse_matrix< double > m_A_Ones; // matrix indicating active weights with 1
-  vnl_vector< double > m_b;
+  const CsrMatrix* m_A;
+  const vnl_vector< double >* m_b;
   double m_Lambda;  // regularization factor
+  bool m_Verbose;   // report runtime and memory of each evaluation
+  unsigned int m_NumEvaluations;
 
   vnl_vector<double> row_sums;  // number of active weights per row
   vnl_vector<double> local_weight_means;  // mean weight of each row
+  vnl_vector<double> residuals;
   REGU regularization;
 
-  void SetProblem(vnl_sparse_matrix< double >& A, vnl_vector<double>& b, double lambda, REGU regu)
+  void SetProblem(const CsrMatrix& A, const vnl_vector<double>& b, double lambda, REGU regu)
   {
-    S = new vnl_sparse_matrix_linear_system<double>(A, b);
-    m_A = A;
-    m_b = b;
+    m_A = &A;
+    m_b = &b;
     m_Lambda = lambda;
+    m_NumEvaluations = 0;
 
-    m_A_Ones.set_size(m_A.rows(), m_A.cols());
-    m_A.reset();
-    while (m_A.next())
-      m_A_Ones.put(m_A.getrow(), m_A.getcolumn(), 1);
-
-    unsigned int N = m_b.size();
-    vnl_vector<double> ones; ones.set_size(dim); ones.fill(1.0);
+    unsigned int N = b.size();
     row_sums.set_size(N);
-    m_A_Ones.mult(ones, row_sums);
+    for (unsigned int r=0; r<N; ++r)
+      row_sums[r] = A.GetNumEntries(r);
     local_weight_means.set_size(N);
+    residuals.set_size(N);
     regularization = regu;
   }
 
   VnlCostFunction(const int NumVars=0) : vnl_cost_function(NumVars)
+    , m_A(nullptr)
+    , m_b(nullptr)
+    , m_Lambda(0)
+    , m_Verbose(false)
+    , m_NumEvaluations(0)
+    , regularization(NONE)
   {
   }
 
@@ -77,19 +234,26 @@ public:
   // Regularization: voxel-weise mean squared deaviation of weights from voxel-wise mean weight (enforce locally uniform weights)
   void regu_localMSE(vnl_vector<double> const &x, double& cost)
   {
-    m_A_Ones.mult(x, local_weight_means);
+    m_A->PatternMultiply(x, local_weight_means);
     local_weight_means = element_quotient(local_weight_means, row_sums);
 
-    m_A_Ones.reset();
+    const std::vector< std::size_t >& row_start = m_A->GetRowStart();
+    const std::vector< unsigned int >& row_cols = m_A->GetRowColumns();
+    int N = m_A->GetNumRows();
     double regu = 0;
-    while (m_A_Ones.next())
+#pragma omp parallel for schedule(dynamic, 4096) reduction(+:regu)
+    for (int r=0; r<N; ++r)
     {
-      double d = 0;
-      if (x[m_A_Ones.getcolumn()]>local_weight_means[m_A_Ones.getrow()])
-        d = std::exp(x[m_A_Ones.getcolumn()]) - std::exp(local_weight_means[m_A_Ones.getrow()]);
-      else
-        d = x[m_A_Ones.getcolumn()] - local_weight_means[m_A_Ones.getrow()];
-      regu += d*d;
+      for (std::size_t k=row_start[r]; k<row_start[r+1]; ++k)
+      {
+        unsigned int c = row_cols[k];
+        double d = 0;
+        if (x[c]>local_weight_means[r])
+          d = std::exp(x[c]) - std::exp(local_weight_means[r]);
+        else
+          d = x[c] - local_weight_means[r];
+        regu += d*d;
+      }
     }
     cost += m_Lambda*regu/dim;
   }
@@ -117,25 +281,29 @@ public:
 
   void grad_regu_localMSE(vnl_vector<double> const &x, vnl_vector<double> &dx)
   {
-    m_A_Ones.mult(x, local_weight_means);
+    m_A->PatternMultiply(x, local_weight_means);
     local_weight_means = element_quotient(local_weight_means, row_sums);
 
-    vnl_vector<double> exp_x = x.apply(std::exp);
     vnl_vector<double> exp_means = local_weight_means.apply(std::exp);
 
-    vnl_vector<double> tdx(dim, 0);
-    m_A_Ones.reset();
-    while (m_A_Ones.next())
+    // accumulated per column, so that each thread only writes its own gradient entries
+    const std::vector< std::size_t >& col_start = m_A->GetColumnStart();
+    const std::vector< unsigned int >& col_rows = m_A->GetColumnRows();
+#pragma omp parallel for schedule(dynamic, 256)
+    for (int c=0; c<dim; ++c)
     {
-      int c = m_A_Ones.getcolumn();
-      int r = m_A_Ones.getrow();
-
-      if (x[c]>local_weight_means[r])
-        tdx[c] += exp_x[c] * ( exp_x[c] - exp_means[r] );
-      else
-        tdx[c] += x[c] - local_weight_means[r];
+      double exp_x = std::exp(x[c]);
+      double tdx = 0;
+      for (std::size_t k=col_start[c]; k<col_start[c+1]; ++k)
+      {
+        unsigned int r = col_rows[k];
+        if (x[c]>local_weight_means[r])
+          tdx += exp_x * ( exp_x - exp_means[r] );
+        else
+          tdx += x[c] - local_weight_means[r];
+      }
+      dx[c] += tdx*2.0*m_Lambda/dim;
     }
-    dx += tdx*2.0*m_Lambda/dim;
   }
 
   void calc_regularization(vnl_vector<double> const &x, double& cost)
@@ -158,39 +326,59 @@ public:
       grad_regu_MSM(x,dx);
   }
 
-  // cost function
-  double f(vnl_vector<double> const &x)
+  double get_rms_error(vnl_vector<double> const &x)
   {
-    // RMS error
-    double cost = S->get_rms_error(x);
-    cost *= cost;
-
-    // regularize
-    calc_regularization(x, cost);
-
-    return cost;
+    m_A->Multiply(x, residuals);
+    residuals -= *m_b;
+    return residuals.rms();
   }
 
-  // gradient of cost function
-  void gradf(vnl_vector<double> const &x, vnl_vector<double> &dx)
+  // cost function and gradient; the residuals are shared by both
+  void compute(vnl_vector<double> const &x, double *f, vnl_vector<double> *g) override
   {
-    dx.fill(0.0);
-    unsigned int N = m_b.size();
+    itk::TimeProbe clock;
+    clock.Start();
 
-    // calculate output difference d
-    vnl_vector<double> d; d.set_size(N);
-    S->multiply(x,d);
-    d -= m_b;
+    unsigned int N = m_b->size();
+    m_A->Multiply(x, residuals);
+    residuals -= *m_b;
 
-    S->transpose_multiply(d, dx);
-    dx *= 2.0/N;
+    if (f!=nullptr)
+    {
+      // RMS error
+      double cost = residuals.squared_magnitude()/N;
 
-    if (regularization==Local_MSE)
-      grad_regu_localMSE(x,dx);
-    else if (regularization==MSE)
-      grad_regu_MSE(x,dx);
-    else if (regularization==MSM)
-      grad_regu_MSM(x,dx);
+      // regularize
+      calc_regularization(x, cost);
+      *f = cost;
+    }
+
+    if (g!=nullptr)
+    {
+      m_A->TransposeMultiply(residuals, *g);
+      *g *= 2.0/N;
+      calc_regularization_gradient(x, *g);
+    }
+
+    clock.Stop();
+    ++m_NumEvaluations;
+    if (m_Verbose)
+    {
+      itk::MemoryProbe memory;
+      MITK_INFO << "Evaluation " << m_NumEvaluations << ": " << (f!=nullptr ? *f : 0) << " (" << clock.GetTotal() << "s, " << memory.GetInstantValue()/1024 << " MB)";
+    }
+  }
+
+  double f(vnl_vector<double> const &x) override
+  {
+    double cost = 0;
+    compute(x, &cost, nullptr);
+    return cost;
+  }
+
+  void gradf(vnl_vector<double> const &x, vnl_vector<double> &dx) override
+  {
+    compute(x, nullptr, &dx);
   }
 };
 
@@ -333,7 +521,7 @@ protected:
 
   mitk::DiffusionSignalModel<>*               m_SignalModel;
 
-  vnl_sparse_matrix<double>                   A;
+  CsrMatrix                                   A;
   vnl_vector<double>                          b;
   VnlCostFunction                             cost;
   int                                         sz_x;
@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkStandardFileLocations.h>
 #include <mitkFiberBuilder.h>
 #include <mitkMetropolisHastingsSampler.h>
+#include <mitkParallelMetropolisHastingsSampler.h>
 //#include <mitkEnergyComputer.h>
 #include <itkTensorImageToOdfImageFilter.h>
 #include <mitkGibbsEnergyComputer.h>
@@ -35,6 +36,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 // #include <QFile>
 #include <tinyxml.h>
 #include <math.h>
+#include <algorithm>
 #include <boost/progress.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
@@ -66,7 +68,9 @@ GibbsTrackingFilter< ItkOdfImageType >::GibbsTrackingFilter():
   m_RandomSeed(-1),
   m_LoadParameterFile(""),
   m_LutPath(""),
-  m_IsInValidState(true)
+  m_IsInValidState(true),
+  m_ParallelSampling(false),
+  m_DomainSize(6)
 {
 
 }
@@ -248,11 +252,17 @@ void GibbsTrackingFilter< ItkOdfImageType >::GenerateData()
   ParticleGrid* particleGrid;
   GibbsEnergyComputer* encomp;
   MetropolisHastingsSampler* sampler;
+  ParallelMetropolisHastingsSampler* parallelSampler = nullptr;
   try{
     particleGrid = new ParticleGrid(m_MaskImage, m_ParticleLength, m_ParticleGridCellCapacity);
     encomp = new GibbsEnergyComputer(m_OdfImage, m_MaskImage, particleGrid, interpolator, randGen);
     encomp->SetParameters(m_ParticleWeight,m_ParticleWidth,m_ConnectionPotential*m_ParticleLength*m_ParticleLength,m_CurvatureThreshold,m_InexBalance,m_ParticlePotential);
     sampler = new MetropolisHastingsSampler(particleGrid, encomp, randGen, m_CurvatureThreshold);
+    if (m_ParallelSampling)
+    {
+      parallelSampler = new ParallelMetropolisHastingsSampler(particleGrid, m_OdfImage, m_MaskImage, interpolator, m_ParticleGridCellCapacity, randGen->GetIntegerVariate(), m_CurvatureThreshold, m_DomainSize);
+      parallelSampler->SetParameters(m_ParticleWeight,m_ParticleWidth,m_ConnectionPotential*m_ParticleLength*m_ParticleLength,m_CurvatureThreshold,m_InexBalance,m_ParticlePotential);
+    }
   }
   catch(...)
   {
@@ -274,6 +284,8 @@ void GibbsTrackingFilter< ItkOdfImageType >::GenerateData()
   MITK_INFO << "Min. fiber length: " << m_MinFiberLength;
   MITK_INFO << "Curvature threshold: " << m_CurvatureThreshold;
   MITK_INFO << "Random seed: " << m_RandomSeed;
+  if (parallelSampler!=nullptr)
+    MITK_INFO << "Parallel sampling: " << parallelSampler->GetNumThreads() << " threads, domain size " << m_DomainSize;
   MITK_INFO << "----------------------------------------";
 
   // main loop
@@ -287,17 +299,36 @@ void GibbsTrackingFilter< ItkOdfImageType >::GenerateData()
     while (m_CurrentIteration<m_Iterations)
     {
       just_built_fibers = false;
-      ++disp;
-      m_CurrentIteration++;
+
+      // in parallel mode a whole sweep over all spatial domains is one step
+      unsigned long numProposals = 1;
+      if (parallelSampler!=nullptr)
+      {
+        unsigned long sweepSize = m_ParallelSweepSize;
+        numProposals = std::min(sweepSize, (unsigned long)ceil(m_Iterations-m_CurrentIteration));
+      }
+      // in parallel mode all proposals of a sweep use the temperature at its start
+      double sweepStart = m_CurrentIteration;
+      disp += numProposals;
+      m_CurrentIteration += numProposals;
       if (m_AbortTracking)
         break;
 
       // update temperatur for simulated annealing process
       float temperature = m_StartTemperature * exp(alpha*m_CurrentIteration/m_Iterations);
-      sampler->SetTemperature(temperature);
-      sampler->MakeProposal();
-
-      m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/m_CurrentIteration;
+      if (parallelSampler!=nullptr)
+      {
+        temperature = m_StartTemperature * exp(alpha*sweepStart/m_Iterations);
+        parallelSampler->SetTemperature(temperature);
+        parallelSampler->MakeProposals(numProposals);
+        m_ProposalAcceptance = (float)parallelSampler->GetNumAcceptedProposals()/m_CurrentIteration;
+      }
+      else
+      {
+        sampler->SetTemperature(temperature);
+        sampler->MakeProposal();
+        m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/m_CurrentIteration;
+      }
       m_NumParticles = particleGrid->m_NumParticles;
       m_NumConnections = particleGrid->m_NumConnections;
 
@@ -321,6 +352,7 @@ void GibbsTrackingFilter< ItkOdfImageType >::GenerateData()
   }
   clock.Stop();
 
+  delete parallelSampler;
   delete sampler;
   delete encomp;
   delete interpolator;
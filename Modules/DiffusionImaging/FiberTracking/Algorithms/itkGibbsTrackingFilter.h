@@ -74,6 +74,8 @@ public:
     itkSetMacro( LoadParameterFile, std::string )   ///< Parameter file.
     itkSetMacro( SaveParameterFile, std::string )
     itkSetMacro( LutPath, std::string )             ///< Path to lookuptables. Default is binary directory.
+    itkSetMacro( ParallelSampling, bool )           ///< Sample spatial domains of the particle grid concurrently.
+    itkSetMacro( DomainSize, int )                  ///< Edge length of the spatial domains in particle grid cells (parallel sampling only).
 
     /** Getter. */
     itkGetMacro( ParticleWeight, float )
@@ -86,6 +88,7 @@ public:
     itkGetMacro( CurrentIteration, double)
     itkGetMacro( Iterations, double)
     itkGetMacro( IsInValidState, bool)
+    itkGetMacro( ParallelSampling, bool )
     FiberPolyDataType GetFiberBundle();             ///< Output fibers
 
     void SetDicomProperties(mitk::FiberBundle::Pointer fib);
@@ -141,11 +144,14 @@ protected:
     std::string     m_SaveParameterFile;    ///< filename of parameter file (writer)
     std::string     m_LutPath;              ///< path to lookuptables used by the sphere interpolator
     bool            m_IsInValidState;       ///< Whether the filter is in a valid state, false if error occured
+    bool            m_ParallelSampling;     ///< sample checkerboard coloured spatial domains of the particle grid concurrently instead of running a single markov chain
+    int             m_DomainSize;           ///< edge length of the spatial domains in grid cells
 
     FiberPolyDataType m_FiberPolyData;      ///< container for reconstructed fibers
 
     //Constant values
     static const int m_ParticleGridCellCapacity = 1024;
+    static const unsigned long m_ParallelSweepSize = 1000000;    ///< proposals per sweep over all domains in parallel mode, the temperature of a sweep is computed from the iteration at its start
 };
 }
 
@@ -32,6 +32,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <TrackingHandlers/mitkTrackingHandlerTensor.h>
 #include <TrackingHandlers/mitkTrackingHandlerRandomForest.h>
 #include <mitkDiffusionFunctionCollection.h>
+#include <vtkIdTypeArray.h>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -86,17 +87,33 @@ StreamlineTrackingFilter
 
 std::string StreamlineTrackingFilter::GetStatusText()
 {
-  std::string status = "Seedpoints processed: " + boost::lexical_cast<std::string>(m_Progress) + "/" + boost::lexical_cast<std::string>(m_SeedPoints.size());
+  unsigned int progress = m_Progress;
+  unsigned int current_tracts = m_CurrentTracts;
+  std::string status = "Seedpoints processed: " + boost::lexical_cast<std::string>(progress) + "/" + boost::lexical_cast<std::string>(m_SeedPoints.size());
   if (m_SeedPoints.size()>0)
-    status += " (" + boost::lexical_cast<std::string>(100*m_Progress/m_SeedPoints.size()) + "%)";
+    status += " (" + boost::lexical_cast<std::string>(100*progress/m_SeedPoints.size()) + "%)";
   if (m_MaxNumTracts>0)
-    status += "\nFibers accepted: " + boost::lexical_cast<std::string>(m_CurrentTracts) + "/" + boost::lexical_cast<std::string>(m_MaxNumTracts);
+    status += "\nFibers accepted: " + boost::lexical_cast<std::string>(current_tracts) + "/" + boost::lexical_cast<std::string>(m_MaxNumTracts);
   else
-    status += "\nFibers accepted: " + boost::lexical_cast<std::string>(m_CurrentTracts);
+    status += "\nFibers accepted: " + boost::lexical_cast<std::string>(current_tracts);
+  status += "\nStreamlines/s: " + boost::lexical_cast<std::string>(static_cast<int>(GetStreamlinesPerSecond()));
 
   return status;
 }
 
+double StreamlineTrackingFilter::GetStreamlinesPerSecond()
+{
+  // m_EndTime is reset in BeforeTracking, so it lies before m_StartTime while tracking is running
+  std::chrono::time_point<std::chrono::system_clock> end = m_EndTime;
+  if (end < m_StartTime)
+    end = std::chrono::system_clock::now();
+
+  double seconds = std::chrono::duration_cast<std::chrono::milliseconds>(end - m_StartTime).count()/1000.0;
+  if (seconds<=0)
+    return 0;
+  return m_CurrentTracts/seconds;
+}
+
 void StreamlineTrackingFilter::BeforeTracking()
 {
   m_StopTracking = false;
@@ -235,6 +252,7 @@ void StreamlineTrackingFilter::BeforeTracking()
   m_AlternativePointset = mitk::PointSet::New();
   m_StopVotePointset = mitk::PointSet::New();
   m_StartTime = std::chrono::system_clock::now();
+  m_EndTime = std::chrono::time_point<std::chrono::system_clock>();
 
   if (m_DemoMode)
     omp_set_num_threads(1);
@@ -316,7 +334,7 @@ std::vector< vnl_vector_fixed<float,3> > StreamlineTrackingFilter::CreateDirecti
 }
 
 
-vnl_vector_fixed<float,3> StreamlineTrackingFilter::GetNewDirection(itk::Point<float, 3> &pos, std::deque<vnl_vector_fixed<float, 3> >& olddirs, itk::Index<3> &oldIndex)
+vnl_vector_fixed<float,3> StreamlineTrackingFilter::GetNewDirection(itk::Point<float, 3> &pos, std::deque<vnl_vector_fixed<float, 3> >& olddirs, itk::Index<3> &oldIndex, mitk::TrackingDataHandler::BoostRngType& rng)
 {
   if (m_DemoMode)
   {
@@ -327,7 +345,7 @@ vnl_vector_fixed<float,3> StreamlineTrackingFilter::GetNewDirection(itk::Point<f
   vnl_vector_fixed<float,3> direction; direction.fill(0);
 
   if (mitk::imv::IsInsideMask<float>(pos, m_InterpolateMask, m_MaskInterpolator) && !mitk::imv::IsInsideMask<float>(pos, m_InterpolateMask, m_StopInterpolator))
-    direction = m_TrackingHandler->ProposeDirection(pos, olddirs, oldIndex); // get direction proposal at current streamline position
+    direction = m_TrackingHandler->ProposeDirection(pos, olddirs, oldIndex, rng); // get direction proposal at current streamline position
   else
     return direction;
 
@@ -343,11 +361,11 @@ vnl_vector_fixed<float,3> StreamlineTrackingFilter::GetNewDirection(itk::Point<f
     bool is_stop_voter = false;
     if (m_Random && m_RandomSampling)
     {
-      d[0] = m_TrackingHandler->GetRandDouble(-0.5, 0.5);
-      d[1] = m_TrackingHandler->GetRandDouble(-0.5, 0.5);
-      d[2] = m_TrackingHandler->GetRandDouble(-0.5, 0.5);
+      d[0] = mitk::TrackingDataHandler::GetRandDouble(rng, -0.5, 0.5);
+      d[1] = mitk::TrackingDataHandler::GetRandDouble(rng, -0.5, 0.5);
+      d[2] = mitk::TrackingDataHandler::GetRandDouble(rng, -0.5, 0.5);
       d.normalize();
-      d *= m_TrackingHandler->GetRandDouble(0,m_SamplingDistance);
+      d *= mitk::TrackingDataHandler::GetRandDouble(rng, 0, m_SamplingDistance);
     }
     else
     {
@@ -369,7 +387,7 @@ vnl_vector_fixed<float,3> StreamlineTrackingFilter::GetNewDirection(itk::Point<f
 
     vnl_vector_fixed<float,3> tempDir; tempDir.fill(0.0);
     if (mitk::imv::IsInsideMask<float>(sample_pos, m_InterpolateMask, m_MaskInterpolator))
-      tempDir = m_TrackingHandler->ProposeDirection(sample_pos, olddirs, oldIndex); // sample neighborhood
+      tempDir = m_TrackingHandler->ProposeDirection(sample_pos, olddirs, oldIndex, rng); // sample neighborhood
     if (tempDir.magnitude()>mitk::eps)
     {
       direction += tempDir;
@@ -397,7 +415,7 @@ vnl_vector_fixed<float,3> StreamlineTrackingFilter::GetNewDirection(itk::Point<f
       alternatives++;
       vnl_vector_fixed<float,3> tempDir; tempDir.fill(0.0);
       if (mitk::imv::IsInsideMask<float>(sample_pos, m_InterpolateMask, m_MaskInterpolator))
-        tempDir = m_TrackingHandler->ProposeDirection(sample_pos, olddirs, oldIndex); // sample neighborhood
+        tempDir = m_TrackingHandler->ProposeDirection(sample_pos, olddirs, oldIndex, rng); // sample neighborhood
 
       if (tempDir.magnitude()>mitk::eps)  // are we back in the white matter?
       {
@@ -432,7 +450,7 @@ vnl_vector_fixed<float,3> StreamlineTrackingFilter::GetNewDirection(itk::Point<f
 }
 
 
-float StreamlineTrackingFilter::FollowStreamline(itk::Point<float, 3> pos, vnl_vector_fixed<float,3> dir, FiberType* fib, float tractLength, bool front)
+float StreamlineTrackingFilter::FollowStreamline(itk::Point<float, 3> pos, vnl_vector_fixed<float,3> dir, FiberType* fib, float tractLength, bool front, mitk::TrackingDataHandler::BoostRngType& rng)
 {
   vnl_vector_fixed<float,3> zero_dir; zero_dir.fill(0.0);
   std::deque< vnl_vector_fixed<float,3> > last_dirs;
@@ -500,7 +518,7 @@ float StreamlineTrackingFilter::FollowStreamline(itk::Point<float, 3> pos, vnl_v
     last_dirs.push_back(dir);
     if (last_dirs.size()>m_NumPreviousDirections)
       last_dirs.pop_front();
-    dir = GetNewDirection(pos, last_dirs, oldIndex);
+    dir = GetNewDirection(pos, last_dirs, oldIndex, rng);
 
     while (m_PauseTracking){}
 
@@ -632,109 +650,155 @@ void StreamlineTrackingFilter::GenerateData()
   int num_seeds = m_SeedPoints.size();
   itk::Index<3> zeroIndex; zeroIndex.Fill(0);
   m_Progress = 0;
-  int i = 0;
   int print_interval = num_seeds/100;
   if (print_interval<100)
     m_Verbose=false;
 
+  // The seeds are handed out to the threads in chunks of consecutive seeds. Each chunk collects its accepted
+  // streamlines in its own buffer, so the threads never wait for each other, and the buffers are concatenated
+  // in seed order after tracking. Chunks are always finished once started and handed out in increasing order,
+  // so the processed seeds form a prefix of the seed list and the resulting tractogram (also when limited by
+  // m_MaxNumTracts) does not depend on the number of threads.
+  const int chunk_size = m_DemoMode ? 1 : 64;
+  const int num_chunks = (num_seeds + chunk_size - 1)/chunk_size;
+  std::vector< BundleType > chunk_fibers(num_chunks);
+  std::atomic< int > next_chunk(0);
+
+  // The random numbers of each streamline are drawn from its own generator, which is seeded from the seed index,
+  // so probabilistic tracking does not depend on the thread that tracks a seed either.
+
+  // In probability map mode, the fibers are not kept but added to a map per thread. The first thread uses the
+  // output map directly, so it can be displayed in demo mode. If m_MaxNumTracts is reached, which fibers are
+  // contained in the map depends on the scheduling of the threads.
+  std::vector< ItkDoubleImgType::Pointer > thread_probmaps(m_UseOutputProbabilityMap ? omp_get_max_threads() : 0);
+  if (m_UseOutputProbabilityMap)
+    thread_probmaps[0] = m_OutputProbabilityMap;
+
 #pragma omp parallel
-  while (i<num_seeds && !m_StopTracking)
+  while (!m_StopTracking)
   {
-
-
-    int temp_i = 0;
-#pragma omp critical
+    ItkDoubleImgType* probmap = nullptr;
+    if (m_UseOutputProbabilityMap)
     {
-      temp_i = i;
-      i++;
+      ItkDoubleImgType::Pointer& thread_probmap = thread_probmaps[omp_get_thread_num()];
+      if (thread_probmap.IsNull())
+      {
+        thread_probmap = ItkDoubleImgType::New();
+        thread_probmap->CopyInformation(m_OutputProbabilityMap);
+        thread_probmap->SetRegions(m_OutputProbabilityMap->GetLargestPossibleRegion());
+        thread_probmap->Allocate();
+        thread_probmap->FillBuffer(0);
+      }
+      probmap = thread_probmap;
     }
 
-    if (temp_i>=num_seeds || m_StopTracking)
-      continue;
-    else if (m_Verbose && i%print_interval==0)
-#pragma omp critical
-    {
-      m_Progress += print_interval;
-      std::cout << "                                                                                                     \r";
-      if (m_MaxNumTracts>0)
-        std::cout << "Tried: " << m_Progress << "/" << num_seeds << " | Accepted: " << m_CurrentTracts << "/" << m_MaxNumTracts << '\r';
-      else
-        std::cout << "Tried: " << m_Progress << "/" << num_seeds << " | Accepted: " << m_CurrentTracts << '\r';
-      cout.flush();
-    }
+    const int chunk = next_chunk++;
+    if (chunk>=num_chunks)
+      break;
+
+    const int first_seed = chunk*chunk_size;
+    const int last_seed = std::min(first_seed + chunk_size, num_seeds);
+    mitk::TrackingDataHandler::BoostRngType rng;
 
-    const itk::Point<float> worldPos = m_SeedPoints.at(temp_i);
-    FiberType fib;
-    float tractLength = 0;
-    unsigned int counter = 0;
-
-    // get starting direction
-    vnl_vector_fixed<float,3> dir; dir.fill(0.0);
-    std::deque< vnl_vector_fixed<float,3> > olddirs;
-    while (olddirs.size()<m_NumPreviousDirections)
-      olddirs.push_back(dir); // start without old directions (only zero directions)
-
-    /// START DIR
-    //    vnl_vector_fixed< float, 3 > gm_start_dir;
-    //    if (m_ControlGmEndings)
-    //    {
-    //      gm_start_dir[0] = m_GmStubs[temp_i][1][0] - m_GmStubs[temp_i][0][0];
-    //      gm_start_dir[1] = m_GmStubs[temp_i][1][1] - m_GmStubs[temp_i][0][1];
-    //      gm_start_dir[2] = m_GmStubs[temp_i][1][2] - m_GmStubs[temp_i][0][2];
-    //      gm_start_dir.normalize();
-    //      olddirs.pop_back();
-    //      olddirs.push_back(gm_start_dir);
-    //    }
-
-    if (mitk::imv::IsInsideMask<float>(worldPos, m_InterpolateMask, m_MaskInterpolator))
-      dir = m_TrackingHandler->ProposeDirection(worldPos, olddirs, zeroIndex);
-
-    if (dir.magnitude()>0.0001)
+    for (int temp_i=first_seed; temp_i<last_seed; ++temp_i)
     {
-      /// START DIR
-      //      if (m_ControlGmEndings)
-      //      {
-      //        float a = dot_product(gm_start_dir, dir);
-      //        if (a<0)
-      //          dir = -dir;
-      //      }
+      const itk::Point<float> worldPos = m_SeedPoints.at(temp_i);
+      FiberType fib;
+      float tractLength = 0;
+      unsigned int counter = 0;
 
-      // forward tracking
-      tractLength = FollowStreamline(worldPos, dir, &fib, 0, false);
-      fib.push_front(worldPos);
+      // get starting direction
+      vnl_vector_fixed<float,3> dir; dir.fill(0.0);
+      std::deque< vnl_vector_fixed<float,3> > olddirs;
+      while (olddirs.size()<m_NumPreviousDirections)
+        olddirs.push_back(dir); // start without old directions (only zero directions)
 
-      // backward tracking (only if we don't explicitely start in the GM)
-      tractLength = FollowStreamline(worldPos, -dir, &fib, tractLength, true);
+      m_TrackingHandler->InitStreamlineRng(rng, temp_i);
 
-      counter = fib.size();
+      if (mitk::imv::IsInsideMask<float>(worldPos, m_InterpolateMask, m_MaskInterpolator))
+        dir = m_TrackingHandler->ProposeDirection(worldPos, olddirs, zeroIndex, rng);
 
-      if (tractLength>=m_MinTractLength && counter>=2)
+      if (dir.magnitude()>0.0001)
       {
-#pragma omp critical
-        if ( IsValidFiber(&fib) )
+        // forward tracking
+        tractLength = FollowStreamline(worldPos, dir, &fib, 0, false, rng);
+        fib.push_front(worldPos);
+
+        // backward tracking (only if we don't explicitely start in the GM)
+        tractLength = FollowStreamline(worldPos, -dir, &fib, tractLength, true, rng);
+
+        counter = fib.size();
+
+        if (tractLength>=m_MinTractLength && counter>=2 && IsValidFiber(&fib))
         {
-          if (!m_StopTracking)
+          unsigned int accepted = ++m_CurrentTracts;
+          if (probmap != nullptr)
           {
-            if (!m_UseOutputProbabilityMap)
-              m_Tractogram.push_back(fib);
-            else
-              FiberToProbmap(&fib);
-            m_CurrentTracts++;
+            if (m_MaxNumTracts <= 0 || accepted <= static_cast<unsigned int>(m_MaxNumTracts))
+              FiberToProbmap(&fib, probmap);
           }
-          if (m_MaxNumTracts > 0 && m_CurrentTracts>=static_cast<unsigned int>(m_MaxNumTracts))
+          else if (m_DemoMode)
+            m_Tractogram.push_back(fib);  // demo mode runs single threaded and displays m_Tractogram while tracking
+          else
+            chunk_fibers[chunk].push_back(fib);
+
+          if (m_MaxNumTracts > 0 && accepted==static_cast<unsigned int>(m_MaxNumTracts))
           {
-            if (!m_StopTracking)
-            {
-              std::cout << "                                                                                                     \r";
-              MITK_INFO << "Reconstructed maximum number of tracts (" << m_CurrentTracts << "). Stopping tractography.";
-            }
+            std::cout << "                                                                                                     \r";
+            MITK_INFO << "Reconstructed maximum number of tracts (" << accepted << "). Stopping tractography.";
             m_StopTracking = true;
           }
         }
       }
+    }
+
+    unsigned int progress = (m_Progress += last_seed - first_seed);
+    if (m_Verbose && progress/print_interval != (progress - (last_seed - first_seed))/print_interval)
+#pragma omp critical
+    {
+      std::cout << "                                                                                                     \r";
+      if (m_MaxNumTracts>0)
+        std::cout << "Tried: " << progress << "/" << num_seeds << " | Accepted: " << m_CurrentTracts << "/" << m_MaxNumTracts << '\r';
+      else
+        std::cout << "Tried: " << progress << "/" << num_seeds << " | Accepted: " << m_CurrentTracts << '\r';
+      cout.flush();
+    }
+  }
+
+  // merge the chunk buffers in seed order
+  std::size_t num_fibers = m_Tractogram.size();
+  for (const auto& fibers : chunk_fibers)
+    num_fibers += fibers.size();
+  m_Tractogram.reserve(num_fibers);
+  for (auto& fibers : chunk_fibers)
+  {
+    for (auto& fib : fibers)
+      m_Tractogram.push_back(std::move(fib));
+    BundleType().swap(fibers);
+  }
+  if (m_MaxNumTracts > 0 && m_Tractogram.size()>static_cast<std::size_t>(m_MaxNumTracts))
+    m_Tractogram.resize(m_MaxNumTracts);
 
+  if (m_UseOutputProbabilityMap)
+  {
+    // sum up the maps of the threads
+    double* output = m_OutputProbabilityMap->GetBufferPointer();
+    const std::size_t num_pixels = m_OutputProbabilityMap->GetLargestPossibleRegion().GetNumberOfPixels();
+    for (std::size_t t=1; t<thread_probmaps.size(); ++t)
+    {
+      if (thread_probmaps[t].IsNull())
+        continue;
+      const double* input = thread_probmaps[t]->GetBufferPointer();
+      for (std::size_t i=0; i<num_pixels; ++i)
+        output[i] += input[i];
+      thread_probmaps[t] = nullptr;
     }
+
+    if (m_MaxNumTracts > 0 && m_CurrentTracts>static_cast<unsigned int>(m_MaxNumTracts))
+      m_CurrentTracts = m_MaxNumTracts;
   }
+  else
+    m_CurrentTracts = m_Tractogram.size();
 
   this->AfterTracking();
 }
@@ -761,18 +825,18 @@ bool StreamlineTrackingFilter::IsValidFiber(FiberType* fib)
   return true;
 }
 
-void StreamlineTrackingFilter::FiberToProbmap(FiberType* fib)
+void StreamlineTrackingFilter::FiberToProbmap(FiberType* fib, ItkDoubleImgType* probmap)
 {
   ItkDoubleImgType::IndexType last_idx; last_idx.Fill(0);
   for (auto p : *fib)
   {
     ItkDoubleImgType::IndexType idx;
-    m_OutputProbabilityMap->TransformPhysicalPointToIndex(p, idx);
+    probmap->TransformPhysicalPointToIndex(p, idx);
 
     if (idx != last_idx)
     {
-      if (m_OutputProbabilityMap->GetLargestPossibleRegion().IsInside(idx))
-        m_OutputProbabilityMap->SetPixel(idx, m_OutputProbabilityMap->GetPixel(idx)+1);
+      if (probmap->GetLargestPossibleRegion().IsInside(idx))
+        probmap->SetPixel(idx, probmap->GetPixel(idx)+1);
       last_idx = idx;
     }
   }
@@ -784,21 +848,41 @@ void StreamlineTrackingFilter::BuildFibers(bool check)
     return;
 
   m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-  vtkSmartPointer<vtkCellArray> vNewLines = vtkSmartPointer<vtkCellArray>::New();
-  vtkSmartPointer<vtkPoints> vNewPoints = vtkSmartPointer<vtkPoints>::New();
 
+  // the first point id of each fiber, so that points and cells can be written in parallel
+  std::vector< vtkIdType > offsets(m_Tractogram.size()+1, 0);
   for (unsigned int i=0; i<m_Tractogram.size(); i++)
-  {
-    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-    FiberType fib = m_Tractogram.at(i);
-    for (FiberType::iterator it = fib.begin(); it!=fib.end(); ++it)
+    offsets[i+1] = offsets[i] + m_Tractogram.at(i).size();
+
+  vtkSmartPointer<vtkPoints> vNewPoints = vtkSmartPointer<vtkPoints>::New();
+  vNewPoints->SetDataTypeToFloat();
+  vNewPoints->SetNumberOfPoints(offsets.back());
+  float* point_data = static_cast<float*>(vNewPoints->GetVoidPointer(0));
+
+  // cell array layout: number of points of the cell followed by its point ids
+  vtkSmartPointer<vtkIdTypeArray> cell_data = vtkSmartPointer<vtkIdTypeArray>::New();
+  cell_data->SetNumberOfValues(offsets.back() + m_Tractogram.size());
+  vtkIdType* cell_ptr = cell_data->GetPointer(0);
+
+#pragma omp parallel for
+  for (int i=0; i<static_cast<int>(m_Tractogram.size()); i++)
+  {
+    const FiberType& fib = m_Tractogram.at(i);
+    vtkIdType id = offsets[i];
+    vtkIdType* cell = cell_ptr + offsets[i] + i;
+    *cell++ = fib.size();
+    for (const auto& p : fib)
     {
-      vtkIdType id = vNewPoints->InsertNextPoint((*it).GetDataPointer());
-      container->GetPointIds()->InsertNextId(id);
+      point_data[3*id] = p[0];
+      point_data[3*id+1] = p[1];
+      point_data[3*id+2] = p[2];
+      *cell++ = id++;
     }
-    vNewLines->InsertNextCell(container);
   }
 
+  vtkSmartPointer<vtkCellArray> vNewLines = vtkSmartPointer<vtkCellArray>::New();
+  vNewLines->SetCells(m_Tractogram.size(), cell_data);
+
   if (check)
     for (int i=0; i<m_BuildFibersReady; i++)
       m_Tractogram.pop_back();
@@ -837,6 +921,7 @@ void StreamlineTrackingFilter::AfterTracking()
   mm %= 60;
   ss %= 60;
   MITK_INFO << "Tracking took " << hh.count() << "h, " << mm.count() << "m and " << ss.count() << "s";
+  MITK_INFO << "Tracking speed: " << GetStreamlinesPerSecond() << " streamlines/s";
 
   m_SeedPoints.clear();
 }
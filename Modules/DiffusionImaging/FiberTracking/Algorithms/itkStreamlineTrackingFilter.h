@@ -33,6 +33,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkDiffusionPropertyHelper.h>
 #include <mitkPointSet.h>
 #include <chrono>
+#include <atomic>
 #include <TrackingHandlers/mitkTrackingDataHandler.h>
 #include <MitkFiberTrackingExports.h>
 #include <mitkFiberBundle.h>
@@ -130,6 +131,8 @@ public:
 
   std::string GetStatusText();
 
+  double GetStreamlinesPerSecond();   ///< Number of accepted streamlines per second of the current (or last) tracking run
+
 protected:
 
   void GenerateData() override;
@@ -138,11 +141,11 @@ protected:
   ~StreamlineTrackingFilter() {}
 
   bool IsValidFiber(FiberType* fib);  ///< Check endpoints
-  void FiberToProbmap(FiberType* fib);
+  void FiberToProbmap(FiberType* fib, ItkDoubleImgType* probmap);
   void GetSeedPointsFromSeedImage();
   void CalculateNewPosition(itk::Point<float, 3>& pos, vnl_vector_fixed<float,3>& dir);    ///< Calculate next integration step.
-  float FollowStreamline(itk::Point<float, 3> start_pos, vnl_vector_fixed<float,3> dir, FiberType* fib, float tractLength, bool front);       ///< Start streamline in one direction.
-  vnl_vector_fixed<float,3> GetNewDirection(itk::Point<float, 3>& pos, std::deque< vnl_vector_fixed<float,3> >& olddirs, itk::Index<3>& oldIndex); ///< Determine new direction by sample voting at the current position taking the last progression direction into account.
+  float FollowStreamline(itk::Point<float, 3> start_pos, vnl_vector_fixed<float,3> dir, FiberType* fib, float tractLength, bool front, mitk::TrackingDataHandler::BoostRngType& rng);       ///< Start streamline in one direction.
+  vnl_vector_fixed<float,3> GetNewDirection(itk::Point<float, 3>& pos, std::deque< vnl_vector_fixed<float,3> >& olddirs, itk::Index<3>& oldIndex, mitk::TrackingDataHandler::BoostRngType& rng); ///< Determine new direction by sample voting at the current position taking the last progression direction into account.
 
   std::vector< vnl_vector_fixed<float,3> > CreateDirections(int NPoints);
 
@@ -188,9 +191,9 @@ protected:
   bool                                m_Random;
   bool                                m_UseOutputProbabilityMap;
   std::vector< itk::Point<float> >    m_SeedPoints;
-  unsigned int                        m_CurrentTracts;
-  unsigned int                        m_Progress;
-  bool                                m_StopTracking;
+  std::atomic< unsigned int >         m_CurrentTracts;
+  std::atomic< unsigned int >         m_Progress;
+  std::atomic< bool >                 m_StopTracking;
   bool                                m_InterpolateMask;
 
   void BuildFibers(bool check);
@@ -19,6 +19,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <math.h>
 #include <boost/progress.hpp>
 #include <vnl/vnl_sparse_matrix.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <xmmintrin.h>
+#define MITK_TRACT_CLUSTERING_SSE
+#endif
 
 namespace itk{
 
@@ -31,6 +39,10 @@ TractClusteringFilter::TractClusteringFilter()
   , m_DoResampling(true)
   , m_FilterMask(nullptr)
   , m_OverlapThreshold(0.0)
+  , m_UseFastMetrics(false)
+  , m_MeanWeight(0)
+  , m_MaxWeight(0)
+  , m_CenterWeight(0)
 {
 
 }
@@ -71,7 +83,7 @@ void TractClusteringFilter::SetDistances(const std::vector<float> &Distances)
   m_Distances = Distances;
 }
 
-float TractClusteringFilter::CalcOverlap(vnl_matrix<float>& t)
+float TractClusteringFilter::CalcOverlap(const vnl_matrix<float>& t)
 {
   float overlap = 0;
   if (m_FilterMask.IsNotNull())
@@ -131,76 +143,309 @@ std::vector<vnl_matrix<float> > TractClusteringFilter::ResampleFibers(mitk::Fibe
   return out_fib;
 }
 
-std::vector< TractClusteringFilter::Cluster > TractClusteringFilter::ClusterStep(std::vector< long > f_indices, std::vector<float> distances)
+bool TractClusteringFilter::InitFastMetrics()
+{
+  m_MeanWeight = 0;
+  m_MaxWeight = 0;
+  for (auto m : m_Metrics)
+  {
+    if (dynamic_cast<mitk::ClusteringMetricEuclideanMean*>(m)!=nullptr)
+      m_MeanWeight += m->GetScale();
+    else if (dynamic_cast<mitk::ClusteringMetricEuclideanMax*>(m)!=nullptr)
+      m_MaxWeight += m->GetScale();
+    else
+      return false;
+  }
+  m_MeanWeight /= m_Metrics.size();
+  m_MaxWeight /= m_Metrics.size();
+
+  // mean and max point distance are both at least the distance between the centers of mass.
+  // the bound is slightly relaxed so that rounding errors never discard the closest centroid.
+  m_CenterWeight = 0;
+  if (m_MeanWeight>=0 && m_MaxWeight>=0)
+    m_CenterWeight = 0.999f*(m_MeanWeight + m_MaxWeight);
+  return true;
+}
+
+void TractClusteringFilter::EuclideanDistances(const float* s, const float* t, const float* t_flipped, unsigned int num_points, float* d)
+{
+  const float* sx = s;
+  const float* sy = s + num_points;
+  const float* sz = s + 2*num_points;
+  const float* tx = t;
+  const float* ty = t + num_points;
+  const float* tz = t + 2*num_points;
+  const float* fx = t_flipped;
+  const float* fy = t_flipped + num_points;
+  const float* fz = t_flipped + 2*num_points;
+
+  float sum_d = 0;
+  float max_d = 0;
+  float sum_f = 0;
+  float max_f = 0;
+  unsigned int i = 0;
+
+#ifdef MITK_TRACT_CLUSTERING_SSE
+  if (num_points>=4)
+  {
+    __m128 v_sum_d = _mm_setzero_ps();
+    __m128 v_max_d = _mm_setzero_ps();
+    __m128 v_sum_f = _mm_setzero_ps();
+    __m128 v_max_f = _mm_setzero_ps();
+    for (; i+4<=num_points; i+=4)
+    {
+      __m128 x = _mm_loadu_ps(sx+i);
+      __m128 y = _mm_loadu_ps(sy+i);
+      __m128 z = _mm_loadu_ps(sz+i);
+
+      __m128 dx = _mm_sub_ps(x, _mm_loadu_ps(tx+i));
+      __m128 dy = _mm_sub_ps(y, _mm_loadu_ps(ty+i));
+      __m128 dz = _mm_sub_ps(z, _mm_loadu_ps(tz+i));
+      __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+      v_sum_d = _mm_add_ps(v_sum_d, dist);
+      v_max_d = _mm_max_ps(v_max_d, dist);
+
+      dx = _mm_sub_ps(x, _mm_loadu_ps(fx+i));
+      dy = _mm_sub_ps(y, _mm_loadu_ps(fy+i));
+      dz = _mm_sub_ps(z, _mm_loadu_ps(fz+i));
+      dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+      v_sum_f = _mm_add_ps(v_sum_f, dist);
+      v_max_f = _mm_max_ps(v_max_f, dist);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, v_sum_d);
+    sum_d = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_ps(lanes, v_max_d);
+    max_d = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    _mm_storeu_ps(lanes, v_sum_f);
+    sum_f = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_ps(lanes, v_max_f);
+    max_f = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+  }
+#endif
+
+  for (; i<num_points; ++i)
+  {
+    float dx = sx[i]-tx[i];
+    float dy = sy[i]-ty[i];
+    float dz = sz[i]-tz[i];
+    float dist = std::sqrt(dx*dx + dy*dy + dz*dz);
+    sum_d += dist;
+    max_d = std::max(max_d, dist);
+
+    dx = sx[i]-fx[i];
+    dy = sy[i]-fy[i];
+    dz = sz[i]-fz[i];
+    dist = std::sqrt(dx*dx + dy*dy + dz*dz);
+    sum_f += dist;
+    max_f = std::max(max_f, dist);
+  }
+
+  d[0] = sum_d;
+  d[1] = max_d;
+  d[2] = sum_f;
+  d[3] = max_f;
+}
+
+float TractClusteringFilter::FastDistance(const float* s, const float* t, const float* t_flipped, bool& flipped) const
+{
+  float d[4];
+  EuclideanDistances(s, t, t_flipped, m_NumPoints, d);
+
+  // same orientation criterion as mitk::ClusteringMetricEuclideanMean and mitk::ClusteringMetricEuclideanMax
+  flipped = d[0]>d[2];
+  if (flipped)
+    return m_MeanWeight*d[2]/m_NumPoints + m_MaxWeight*d[3];
+  return m_MeanWeight*d[0]/m_NumPoints + m_MaxWeight*d[1];
+}
+
+void TractClusteringFilter::AppendFlatCentroid(const Cluster& c, std::vector< float >& centroids, std::vector< float >& flipped, std::vector< float >& centers)
+{
+  const unsigned int P = m_NumPoints;
+  std::size_t offset = centroids.size();
+  centroids.resize(offset + 3*P);
+  flipped.resize(offset + 3*P);
+  for (unsigned int a=0; a<3; ++a)
+  {
+    float center = 0;
+    for (unsigned int j=0; j<P; ++j)
+    {
+      float v = c.h(a, j)/c.n;
+      centroids[offset + a*P + j] = v;
+      flipped[offset + a*P + P-j-1] = v;
+      center += v;
+    }
+    centers.push_back(center/P);
+  }
+}
+
+void TractClusteringFilter::ScanCentroids(int first, int last, const float* s, const float* s_center, const std::vector< float >& centroids, const std::vector< float >& flipped, const std::vector< float >& centers, int& index, float& distance, bool& flip) const
+{
+  const unsigned int stride = 3*m_NumPoints;
+  const float w2 = m_CenterWeight*m_CenterWeight;
+  for (int k=first; k<last; ++k)
+  {
+    float cx = s_center[0]-centers[3*k];
+    float cy = s_center[1]-centers[3*k+1];
+    float cz = s_center[2]-centers[3*k+2];
+    if (w2*(cx*cx + cy*cy + cz*cz) >= distance*distance)
+      continue;
+
+    bool f = false;
+    float d = FastDistance(s, centroids.data() + k*stride, flipped.data() + k*stride, f);
+    if (d<distance)
+    {
+      distance = d;
+      index = k;
+      flip = f;
+    }
+  }
+}
+
+void TractClusteringFilter::FindClosestCentroid(const float* s, const float* s_center, const std::vector< float >& centroids, const std::vector< float >& flipped, const std::vector< float >& centers, int& index, float& distance, bool& flip) const
+{
+  const int block_size = 256;
+  int num_centroids = centers.size()/3;
+  int num_blocks = (num_centroids + block_size - 1)/block_size;
+  if (num_blocks<4)
+  {
+    ScanCentroids(0, num_centroids, s, s_center, centroids, flipped, centers, index, distance, flip);
+    return;
+  }
+
+  std::vector< int > block_index(num_blocks, -1);
+  std::vector< float > block_distance(num_blocks, distance);
+  std::vector< char > block_flip(num_blocks, 0);
+#pragma omp parallel for
+  for (int b=0; b<num_blocks; ++b)
+  {
+    bool f = false;
+    ScanCentroids(b*block_size, std::min((b+1)*block_size, num_centroids), s, s_center, centroids, flipped, centers, block_index[b], block_distance[b], f);
+    block_flip[b] = f;
+  }
+
+  // blocks are merged in order, so ties are resolved in favor of the smallest centroid index
+  for (int b=0; b<num_blocks; ++b)
+  {
+    if (block_index[b]>=0 && block_distance[b]<distance)
+    {
+      distance = block_distance[b];
+      index = block_index[b];
+      flip = block_flip[b];
+    }
+  }
+}
+
+std::vector< TractClusteringFilter::Cluster > TractClusteringFilter::ClusterStep(const std::vector< long >& f_indices, std::vector<float> distances)
 {
   float dist_thres = distances.back();
   distances.pop_back();
   std::vector< Cluster > C;
 
   int N = f_indices.size();
+  const unsigned int stride = 3*m_NumPoints;
+
+  // means of the current clusters, only used by the fast metrics
+  std::vector< float > centroids;
+  std::vector< float > flipped;
+  std::vector< float > centers;
 
   Cluster c1;
   c1.I.push_back(f_indices.at(0));
   c1.h = T[f_indices.at(0)];
   c1.n = 1;
   C.push_back(c1);
+  if (m_UseFastMetrics)
+    AppendFlatCentroid(C.back(), centroids, flipped, centers);
   if (f_indices.size()==1)
     return C;
 
   for (int i=1; i<N; ++i)
   {
-    vnl_matrix<float> t = T.at(f_indices.at(i));
+    long f_idx = f_indices.at(i);
+    vnl_matrix<float>& t = T[f_idx];
 
     int min_cluster_index = -1;
     float min_cluster_distance = 99999;
     bool flip = false;
 
-    for (unsigned int k=0; k<C.size(); ++k)
+    if (m_UseFastMetrics)
+    {
+      min_cluster_distance = dist_thres;
+      FindClosestCentroid(m_FlatT.data() + f_idx*stride, m_FlatCenters.data() + 3*f_idx, centroids, flipped, centers, min_cluster_index, min_cluster_distance, flip);
+    }
+    else
     {
-      vnl_matrix<float> v = C.at(k).h / C.at(k).n;
-      bool f = false;
-      float d = 0;
-      for (auto m : m_Metrics)
-        d += m->CalculateDistance(t, v, f);
-      d /= m_Metrics.size();
-
-      if (d<min_cluster_distance)
+      for (unsigned int k=0; k<C.size(); ++k)
       {
-        min_cluster_distance = d;
-        min_cluster_index = k;
-        flip = f;
+        vnl_matrix<float> v = C.at(k).h / C.at(k).n;
+        bool f = false;
+        float d = 0;
+        for (auto m : m_Metrics)
+          d += m->CalculateDistance(t, v, f);
+        d /= m_Metrics.size();
+
+        if (d<min_cluster_distance)
+        {
+          min_cluster_distance = d;
+          min_cluster_index = k;
+          flip = f;
+        }
       }
     }
 
     if (min_cluster_index>=0 && min_cluster_distance<dist_thres)
     {
-      C[min_cluster_index].I.push_back(f_indices.at(i));
+      Cluster& c = C[min_cluster_index];
+      c.I.push_back(f_idx);
       if (!flip)
-        C[min_cluster_index].h += t;
+        c.h += t;
       else
-        C[min_cluster_index].h += t.fliplr();
-      C[min_cluster_index].n += 1;
+        c.h += t.fliplr();
+      c.n += 1;
+
+      if (m_UseFastMetrics)
+      {
+        // update the mean of the cluster in place
+        std::size_t offset = min_cluster_index*stride;
+        for (unsigned int a=0; a<3; ++a)
+        {
+          float center = 0;
+          for (unsigned int j=0; j<m_NumPoints; ++j)
+          {
+            float v = c.h(a, j)/c.n;
+            centroids[offset + a*m_NumPoints + j] = v;
+            flipped[offset + a*m_NumPoints + m_NumPoints-j-1] = v;
+            center += v;
+          }
+          centers[3*min_cluster_index + a] = center/m_NumPoints;
+        }
+      }
     }
     else
     {
       Cluster c;
-      c.I.push_back(f_indices.at(i));
+      c.I.push_back(f_idx);
       c.h = t;
       c.n = 1;
       C.push_back(c);
+      if (m_UseFastMetrics)
+        AppendFlatCentroid(C.back(), centroids, flipped, centers);
     }
   }
 
   if (!distances.empty())
   {
-    std::vector< Cluster > outC;
-#pragma omp parallel for
+    // each thread writes to its own slot, the results are concatenated in cluster order afterwards
+    std::vector< std::vector< Cluster > > subClusters(C.size());
+#pragma omp parallel for schedule(dynamic)
     for (int c=0; c<(int)C.size(); c++)
-    {
+      subClusters[c] = ClusterStep(C.at(c).I, distances);
 
-      std::vector< Cluster > tempC = ClusterStep(C.at(c).I, distances);
+    std::vector< Cluster > outC;
+    for (auto& tempC : subClusters)
       AppendCluster(outC, tempC);
-    }
     return outC;
   }
   else
@@ -209,8 +454,7 @@ std::vector< TractClusteringFilter::Cluster > TractClusteringFilter::ClusterStep
 
 void TractClusteringFilter::AppendCluster(std::vector< Cluster >& a, std::vector< Cluster >&b)
 {
-  for (auto c : b)
-    a.push_back(c);
+  a.insert(a.end(), b.begin(), b.end());
 }
 
 void TractClusteringFilter::MergeDuplicateClusters(std::vector< TractClusteringFilter::Cluster >& clusters)
@@ -218,6 +462,7 @@ void TractClusteringFilter::MergeDuplicateClusters(std::vector< TractClusteringF
   if (m_MergeDuplicateThreshold<0)
     m_MergeDuplicateThreshold = m_Distances.at(0)/2;
   bool found = true;
+  const unsigned int stride = 3*m_NumPoints;
 
   MITK_INFO << "Merging duplicate clusters with distance threshold " << m_MergeDuplicateThreshold;
   int start = 0;
@@ -227,54 +472,75 @@ void TractClusteringFilter::MergeDuplicateClusters(std::vector< TractClusteringF
     std::cout << "Number of clusters: " << clusters.size() << '\r';
     cout.flush();
 
+    std::vector< float > centroids;
+    std::vector< float > flipped;
+    std::vector< float > centers;
+    if (m_UseFastMetrics)
+    {
+      for (const Cluster& c : clusters)
+        AppendFlatCentroid(c, centroids, flipped, centers);
+    }
+
     found = false;
     for (int k1=start; k1<(int)clusters.size(); ++k1)
     {
-      Cluster c1 = clusters.at(k1);
+      const Cluster& c1 = clusters.at(k1);
       vnl_matrix<float> t = c1.h / c1.n;
 
-      std::vector< int > merge_indices;
-      std::vector< bool > flip_indices;
+      std::vector< char > merge(clusters.size(), 0);
+      std::vector< char > flip(clusters.size(), 0);
 
 #pragma omp parallel for
       for (int k2=0; k2<(int)clusters.size(); ++k2)
       {
-        if (k1!=k2)
+        if (k1==k2)
+          continue;
+
+        bool f = false;
+        float d = 0;
+        if (m_UseFastMetrics)
+        {
+          int idx = -1;
+          d = m_MergeDuplicateThreshold;
+          ScanCentroids(k2, k2+1, centroids.data() + k1*stride, centers.data() + 3*k1, centroids, flipped, centers, idx, d, f);
+          if (idx<0)
+            continue;
+        }
+        else
         {
-          Cluster c2 = clusters.at(k2);
+          const Cluster& c2 = clusters.at(k2);
           vnl_matrix<float> v = c2.h / c2.n;
-          bool f = false;
-
-//          d = m_Metric->CalculateDistance(t, v, f);  // alwayse use MDF?
-          float d = 0;
           for (auto m : m_Metrics)
             d += m->CalculateDistance(t, v, f);
           d /= m_Metrics.size();
+        }
 
-#pragma omp critical
-          if (d<m_MergeDuplicateThreshold)
-          {
-            merge_indices.push_back(k2);
-            flip_indices.push_back(f);
-          }
+        if (d<m_MergeDuplicateThreshold)
+        {
+          merge[k2] = 1;
+          flip[k2] = f;
         }
       }
 
-      for (unsigned int i=0; i<merge_indices.size(); ++i)
+      std::vector< int > merge_indices;
+      for (int k2=0; k2<(int)clusters.size(); ++k2)
       {
-        Cluster c2 = clusters.at(merge_indices.at(i));
+        if (!merge[k2])
+          continue;
+        merge_indices.push_back(k2);
+
+        const Cluster& c2 = clusters.at(k2);
         for (int i=0; i<c2.n; ++i)
         {
           clusters[k1].I.push_back(c2.I.at(i));
           clusters[k1].n += 1;
         }
-        if (!flip_indices.at(i))
+        if (!flip[k2])
           clusters[k1].h += c2.h;
         else
           clusters[k1].h += c2.h.fliplr();
       }
 
-      std::sort(merge_indices.begin(), merge_indices.end());
       for (unsigned int i=0; i<merge_indices.size(); ++i)
       {
         clusters.erase (clusters.begin()+merge_indices.at(i)-i);
@@ -298,63 +564,124 @@ std::vector<TractClusteringFilter::Cluster> TractClusteringFilter::AddToKnownClu
   Cluster no_fit;
   no_fit.h = zero_h;
 
+  std::vector< float > flat_centroids;
+  std::vector< float > flipped;
+  std::vector< float > centers;
   for (unsigned int i=0; i<centroids.size(); ++i)
   {
+    if (m_UseFastMetrics)
+    {
+      Cluster temp;
+      temp.h = centroids.at(i);
+      temp.n = 1;
+      AppendFlatCentroid(temp, flat_centroids, flipped, centers);
+    }
+
     Cluster c;
     c.h.set_size(T.at(0).rows(), T.at(0).cols()); c.h.fill(0.0);
     c.f_id = i;
     C.push_back(c);
   }
 
-#pragma omp parallel for
-  for (int i=0; i<N; ++i)
-  {
-    vnl_matrix<float> t = T.at(f_indices.at(i));
+  // the assignments are collected per fiber and added to the clusters afterwards
+  std::vector< int > assignment(N, -1);
+  std::vector< char > flips(N, 0);
 
-    int min_cluster_index = -1;
-    float min_cluster_distance = 99999;
-    bool flip = false;
-
-    if (CalcOverlap(t)>=m_OverlapThreshold)
+  if (m_UseFastMetrics)
+  {
+    // blocks of fibers are compared to blocks of centroids, so that each centroid block stays in the cache while it is used
+    const int fiber_block_size = 64;
+    const int centroid_block_size = 32;
+    const unsigned int stride = 3*m_NumPoints;
+    int num_centroids = centroids.size();
+    int num_blocks = (N + fiber_block_size - 1)/fiber_block_size;
+
+#pragma omp parallel for schedule(dynamic)
+    for (int b=0; b<num_blocks; ++b)
     {
-      int c_idx = 0;
-      for (vnl_matrix<float> centroid : centroids)
+      int first = b*fiber_block_size;
+      int last = std::min(first + fiber_block_size, N);
+
+      float min_distance[fiber_block_size];
+      bool use_fiber[fiber_block_size];
+      for (int i=first; i<last; ++i)
       {
-        bool f = false;
-        float d = 0;
-        for (auto m : m_Metrics)
-          d += m->CalculateDistance(t, centroid, f);
-        d /= m_Metrics.size();
+        min_distance[i-first] = dist_thres;
+        use_fiber[i-first] = CalcOverlap(T.at(f_indices.at(i)))>=m_OverlapThreshold;
+      }
 
-        if (d<min_cluster_distance)
+      for (int k=0; k<num_centroids; k+=centroid_block_size)
+      {
+        int k_last = std::min(k + centroid_block_size, num_centroids);
+        for (int i=first; i<last; ++i)
         {
-          min_cluster_distance = d;
-          min_cluster_index = c_idx;
-          flip = f;
+          if (!use_fiber[i-first])
+            continue;
+          long f_idx = f_indices.at(i);
+          bool f = flips[i];
+          ScanCentroids(k, k_last, m_FlatT.data() + f_idx*stride, m_FlatCenters.data() + 3*f_idx, flat_centroids, flipped, centers, assignment[i], min_distance[i-first], f);
+          flips[i] = f;
         }
-        ++c_idx;
       }
     }
-
-    if (min_cluster_index>=0 && min_cluster_distance<dist_thres)
+  }
+  else
+  {
+#pragma omp parallel for
+    for (int i=0; i<N; ++i)
     {
-#pragma omp critical
+      vnl_matrix<float>& t = T[f_indices.at(i)];
+
+      int min_cluster_index = -1;
+      float min_cluster_distance = 99999;
+      bool flip = false;
+
+      if (CalcOverlap(t)>=m_OverlapThreshold)
       {
-        C[min_cluster_index].I.push_back(f_indices.at(i));
-        if (!flip)
-          C[min_cluster_index].h += t;
-        else
-          C[min_cluster_index].h += t.fliplr();
-        C[min_cluster_index].n += 1;
+        int c_idx = 0;
+        for (vnl_matrix<float>& centroid : centroids)
+        {
+          bool f = false;
+          float d = 0;
+          for (auto m : m_Metrics)
+            d += m->CalculateDistance(t, centroid, f);
+          d /= m_Metrics.size();
+
+          if (d<min_cluster_distance)
+          {
+            min_cluster_distance = d;
+            min_cluster_index = c_idx;
+            flip = f;
+          }
+          ++c_idx;
+        }
+      }
+
+      if (min_cluster_index>=0 && min_cluster_distance<dist_thres)
+      {
+        assignment[i] = min_cluster_index;
+        flips[i] = flip;
       }
     }
+  }
+
+  for (int i=0; i<N; ++i)
+  {
+    if (assignment[i]>=0)
+    {
+      Cluster& c = C[assignment[i]];
+      const vnl_matrix<float>& t = T.at(f_indices.at(i));
+      c.I.push_back(f_indices.at(i));
+      if (!flips[i])
+        c.h += t;
+      else
+        c.h += t.fliplr();
+      c.n += 1;
+    }
     else
     {
-#pragma omp critical
-      {
-        no_fit.I.push_back(f_indices.at(i));
-        no_fit.n++;
-      }
+      no_fit.I.push_back(f_indices.at(i));
+      no_fit.n++;
     }
   }
   C.push_back(no_fit);
@@ -382,6 +709,24 @@ void TractClusteringFilter::GenerateData()
     return;
   }
 
+  m_FlatT.clear();
+  m_FlatCenters.clear();
+  m_UseFastMetrics = InitFastMetrics() && T.at(0).cols()==m_NumPoints;
+  if (m_UseFastMetrics)
+  {
+    // vnl matrices are stored row-wise, so each resampled fiber already consists of its x, y and z arrays
+    const unsigned int stride = 3*m_NumPoints;
+    m_FlatT.resize(T.size()*stride);
+    m_FlatCenters.resize(3*T.size());
+    for (unsigned int i=0; i<T.size(); ++i)
+    {
+      std::memcpy(m_FlatT.data() + i*stride, T.at(i).data_block(), stride*sizeof(float));
+      for (unsigned int a=0; a<3; ++a)
+        m_FlatCenters[3*i+a] = T.at(i).get_row(a).mean();
+    }
+    MITK_INFO << "Using fast euclidean distance kernel";
+  }
+
   std::vector< long > f_indices;
   for (unsigned int i=0; i<T.size(); ++i)
     f_indices.push_back(i);
@@ -21,6 +21,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkFiberBundle.h>
 #include <mitkFiberfoxParameters.h>
 #include <mitkClusteringMetric.h>
+#include <mitkClusteringMetricEuclideanMean.h>
+#include <mitkClusteringMetricEuclideanMax.h>
 
 // ITK
 #include <itkProcessObject.h>
@@ -102,14 +104,27 @@ protected:
 
   void GenerateData() override;
   std::vector< vnl_matrix<float> > ResampleFibers(FiberBundle::Pointer tractogram);
-  float CalcOverlap(vnl_matrix<float>& t);
+  float CalcOverlap(const vnl_matrix<float>& t);
 
-  std::vector< Cluster > ClusterStep(std::vector< long > f_indices, std::vector< float > distances);
+  std::vector< Cluster > ClusterStep(const std::vector< long >& f_indices, std::vector< float > distances);
 
   void MergeDuplicateClusters(std::vector< TractClusteringFilter::Cluster >& clusters);
   std::vector< Cluster > AddToKnownClusters(std::vector< long > f_indices, std::vector<vnl_matrix<float> > &centroids);
   void AppendCluster(std::vector< Cluster >& a, std::vector< Cluster >&b);
 
+  /** Checks whether all metrics are euclidean mean or max metrics, which can be evaluated by the fast distance kernel. */
+  bool InitFastMetrics();
+  /** Appends the mean of the cluster in direct and reversed point order, as well as its center of mass, to the flat centroid arrays. */
+  void AppendFlatCentroid(const Cluster& c, std::vector< float >& centroids, std::vector< float >& flipped, std::vector< float >& centers);
+  /** Searches the centroids [first, last) for the one closest to the fiber s. Only centroids closer than the input distance are considered. */
+  void ScanCentroids(int first, int last, const float* s, const float* s_center, const std::vector< float >& centroids, const std::vector< float >& flipped, const std::vector< float >& centers, int& index, float& distance, bool& flip) const;
+  /** Same as ScanCentroids for all centroids. Large centroid sets are scanned in parallel blocks. */
+  void FindClosestCentroid(const float* s, const float* s_center, const std::vector< float >& centroids, const std::vector< float >& flipped, const std::vector< float >& centers, int& index, float& distance, bool& flip) const;
+  /** Combined distance of the euclidean mean and max metrics. */
+  float FastDistance(const float* s, const float* t, const float* t_flipped, bool& flipped) const;
+  /** Sum and maximum of the point distances between s and t as well as between s and t_flipped. All fibers are stored as x, y and z arrays of num_points values each. */
+  static void EuclideanDistances(const float* s, const float* t, const float* t_flipped, unsigned int num_points, float* d);
+
   TractClusteringFilter();
   virtual ~TractClusteringFilter();
 
@@ -129,6 +144,13 @@ protected:
   float                                       m_OverlapThreshold;
   std::vector< mitk::ClusteringMetric* >      m_Metrics;
   std::vector< std::vector< long > >          m_OutFiberIndices;
+
+  bool                                        m_UseFastMetrics;
+  float                                       m_MeanWeight;     ///< summed scale of the euclidean mean metrics divided by the number of metrics
+  float                                       m_MaxWeight;      ///< summed scale of the euclidean max metrics divided by the number of metrics
+  float                                       m_CenterWeight;   ///< the distance between the centers of mass times this weight is a lower bound of the fast distance
+  std::vector< float >                        m_FlatT;          ///< resampled fibers as contiguous x, y and z arrays
+  std::vector< float >                        m_FlatCenters;    ///< center of mass of each resampled fiber
 };
 }
 
@@ -0,0 +1,260 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkCompactFiberStorage.h"
+
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPoints.h>
+#include <algorithm>
+#include <cmath>
+
+mitk::CompactFiberStorage::CompactFiberStorage()
+  : m_Offsets(1, 0)
+{
+}
+
+void mitk::CompactFiberStorage::Clear()
+{
+  m_X.clear(); m_X.shrink_to_fit();
+  m_Y.clear(); m_Y.shrink_to_fit();
+  m_Z.clear(); m_Z.shrink_to_fit();
+  m_Offsets.assign(1, 0);
+  m_Offsets.shrink_to_fit();
+}
+
+void mitk::CompactFiberStorage::Resize(unsigned long numPoints)
+{
+  m_X.resize(numPoints); m_X.shrink_to_fit();
+  m_Y.resize(numPoints); m_Y.shrink_to_fit();
+  m_Z.resize(numPoints); m_Z.shrink_to_fit();
+}
+
+void mitk::CompactFiberStorage::SetPolyData(vtkPolyData* polyData, std::vector< vtkIdType >* pointIds)
+{
+  m_Offsets.assign(1, 0);
+  if (polyData==nullptr || polyData->GetLines()==nullptr || polyData->GetPoints()==nullptr)
+  {
+    this->Clear();
+    if (pointIds!=nullptr)
+      pointIds->clear();
+    return;
+  }
+
+  vtkCellArray* lines = polyData->GetLines();
+  vtkIdType numPoints = 0;
+  vtkIdType* ids = nullptr;
+
+  m_Offsets.reserve(lines->GetNumberOfCells()+1);
+  lines->InitTraversal();
+  while (lines->GetNextCell(numPoints, ids))
+    m_Offsets.push_back(m_Offsets.back() + numPoints);
+  m_Offsets.shrink_to_fit();
+  this->Resize(m_Offsets.back());
+  if (pointIds!=nullptr)
+    pointIds->resize(m_Offsets.back());
+
+  vtkPoints* points = polyData->GetPoints();
+  unsigned long k = 0;
+  lines->InitTraversal();
+  while (lines->GetNextCell(numPoints, ids))
+  {
+    for (vtkIdType j=0; j<numPoints; ++j, ++k)
+    {
+      double p[3];
+      points->GetPoint(ids[j], p);
+      m_X[k] = p[0];
+      m_Y[k] = p[1];
+      m_Z[k] = p[2];
+      if (pointIds!=nullptr)
+        (*pointIds)[k] = ids[j];
+    }
+  }
+}
+
+vtkSmartPointer<vtkPolyData> mitk::CompactFiberStorage::GetPolyData() const
+{
+  int numFibers = this->GetNumberOfFibers();
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataTypeToFloat();
+  points->SetNumberOfPoints(this->GetNumberOfPoints());
+  float* point_data = static_cast<float*>(points->GetVoidPointer(0));
+
+  // cell array layout: number of points of the cell followed by its point ids
+  vtkSmartPointer<vtkIdTypeArray> cell_data = vtkSmartPointer<vtkIdTypeArray>::New();
+  cell_data->SetNumberOfValues(this->GetNumberOfPoints() + numFibers);
+  vtkIdType* cell_ptr = cell_data->GetPointer(0);
+
+#pragma omp parallel for
+  for (int i=0; i<numFibers; i++)
+  {
+    vtkIdType* cell = cell_ptr + m_Offsets[i] + i;
+    *cell++ = m_Offsets[i+1]-m_Offsets[i];
+    for (unsigned long id=m_Offsets[i]; id<m_Offsets[i+1]; ++id)
+    {
+      point_data[3*id] = m_X[id];
+      point_data[3*id+1] = m_Y[id];
+      point_data[3*id+2] = m_Z[id];
+      *cell++ = id;
+    }
+  }
+
+  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+  lines->SetCells(numFibers, cell_data);
+
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetLines(lines);
+  return polyData;
+}
+
+void mitk::CompactFiberStorage::SetFibers(const FiberContainerType& fibers)
+{
+  m_Offsets.assign(fibers.size()+1, 0);
+  m_Offsets.shrink_to_fit();
+  for (unsigned int i=0; i<fibers.size(); i++)
+    m_Offsets[i+1] = m_Offsets[i] + fibers.at(i).size();
+  this->Resize(m_Offsets.back());
+
+#pragma omp parallel for
+  for (int i=0; i<(int)fibers.size(); i++)
+  {
+    unsigned long k = m_Offsets[i];
+    for (const VertexType& v : fibers[i])
+    {
+      m_X[k] = v[0];
+      m_Y[k] = v[1];
+      m_Z[k] = v[2];
+      ++k;
+    }
+  }
+}
+
+void mitk::CompactFiberStorage::SetFibers(const CompactFiberStorage& source, const std::vector< long >& fiberIds)
+{
+  m_Offsets.assign(fiberIds.size()+1, 0);
+  m_Offsets.shrink_to_fit();
+  for (unsigned int i=0; i<fiberIds.size(); i++)
+    m_Offsets[i+1] = m_Offsets[i] + source.GetNumberOfPoints(fiberIds.at(i));
+  this->Resize(m_Offsets.back());
+
+#pragma omp parallel for
+  for (int i=0; i<(int)fiberIds.size(); i++)
+  {
+    unsigned long first = source.m_Offsets[fiberIds[i]];
+    unsigned long last = source.m_Offsets[fiberIds[i]+1];
+    std::copy(source.m_X.begin()+first, source.m_X.begin()+last, m_X.begin()+m_Offsets[i]);
+    std::copy(source.m_Y.begin()+first, source.m_Y.begin()+last, m_Y.begin()+m_Offsets[i]);
+    std::copy(source.m_Z.begin()+first, source.m_Z.begin()+last, m_Z.begin()+m_Offsets[i]);
+  }
+}
+
+void mitk::CompactFiberStorage::GetFiber(unsigned long fiber, FiberType& vertices) const
+{
+  vertices.resize(this->GetNumberOfPoints(fiber));
+  unsigned long k = m_Offsets[fiber];
+  for (VertexType& v : vertices)
+  {
+    v[0] = m_X[k];
+    v[1] = m_Y[k];
+    v[2] = m_Z[k];
+    ++k;
+  }
+}
+
+void mitk::CompactFiberStorage::AddFiber(const float* points, unsigned long numPoints)
+{
+  for (unsigned long j=0; j<numPoints; ++j)
+  {
+    m_X.push_back(points[3*j]);
+    m_Y.push_back(points[3*j+1]);
+    m_Z.push_back(points[3*j+2]);
+  }
+  m_Offsets.push_back(m_Offsets.back() + numPoints);
+}
+
+void mitk::CompactFiberStorage::Swap(CompactFiberStorage& other)
+{
+  m_X.swap(other.m_X);
+  m_Y.swap(other.m_Y);
+  m_Z.swap(other.m_Z);
+  m_Offsets.swap(other.m_Offsets);
+}
+
+void mitk::CompactFiberStorage::Transform(const vnl_matrix_fixed< double, 3, 3 >& matrix, const vnl_vector_fixed< double, 3 >& offset)
+{
+  const double m00 = matrix[0][0], m01 = matrix[0][1], m02 = matrix[0][2];
+  const double m10 = matrix[1][0], m11 = matrix[1][1], m12 = matrix[1][2];
+  const double m20 = matrix[2][0], m21 = matrix[2][1], m22 = matrix[2][2];
+  const double o0 = offset[0], o1 = offset[1], o2 = offset[2];
+  float* x = m_X.data();
+  float* y = m_Y.data();
+  float* z = m_Z.data();
+
+  // parallel over fibers, the inner loop over the consecutive points of a fiber is vectorized
+  int numFibers = this->GetNumberOfFibers();
+#pragma omp parallel for
+  for (int i=0; i<numFibers; i++)
+  {
+    for (unsigned long k=m_Offsets[i]; k<m_Offsets[i+1]; ++k)
+    {
+      double px = x[k], py = y[k], pz = z[k];
+      x[k] = m00*px + m01*py + m02*pz + o0;
+      y[k] = m10*px + m11*py + m12*pz + o1;
+      z[k] = m20*px + m21*py + m22*pz + o2;
+    }
+  }
+}
+
+void mitk::CompactFiberStorage::GetBounds(double bounds[6]) const
+{
+  if (m_X.empty())
+  {
+    bounds[0] = bounds[2] = bounds[4] = 0;
+    bounds[1] = bounds[3] = bounds[5] = -1;
+    return;
+  }
+
+  const std::vector< float >* axes[3] = { &m_X, &m_Y, &m_Z };
+  for (int a=0; a<3; ++a)
+  {
+    auto minmax = std::minmax_element(axes[a]->begin(), axes[a]->end());
+    bounds[2*a] = *minmax.first;
+    bounds[2*a+1] = *minmax.second;
+  }
+}
+
+std::vector< float > mitk::CompactFiberStorage::GetFiberLengths() const
+{
+  int numFibers = this->GetNumberOfFibers();
+  std::vector< float > lengths(numFibers, 0);
+
+#pragma omp parallel for
+  for (int i=0; i<numFibers; i++)
+  {
+    double length = 0;
+    for (unsigned long k=m_Offsets[i]+1; k<m_Offsets[i+1]; ++k)
+    {
+      double dx = m_X[k]-m_X[k-1];
+      double dy = m_Y[k]-m_Y[k-1];
+      double dz = m_Z[k]-m_Z[k-1];
+      length += std::sqrt(dx*dx + dy*dy + dz*dz);
+    }
+    lengths[i] = length;
+  }
+  return lengths;
+}
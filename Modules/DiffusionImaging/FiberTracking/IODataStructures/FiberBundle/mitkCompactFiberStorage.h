@@ -0,0 +1,91 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_CompactFiberStorage_H
+#define _MITK_CompactFiberStorage_H
+
+#include <MitkFiberTrackingExports.h>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vnl/vnl_vector_fixed.h>
+#include <vnl/vnl_matrix_fixed.h>
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Contiguous structure-of-arrays container for streamlines.
+  *
+  * The point coordinates of all fibers are stored in three float arrays, one per axis, with the points of
+  * each fiber stored consecutively. An offset array of size GetNumberOfFibers()+1 indexes the first point of each fiber.
+  * Compared to a vtkPolyData this needs neither a separate cell array nor per-cell objects to access the points,
+  * and bulk operations on all points can be executed in parallel and vectorized.
+  */
+class MITKFIBERTRACKING_EXPORT CompactFiberStorage
+{
+public:
+
+  typedef vnl_vector_fixed< double, 3 >   VertexType;
+  typedef std::vector< VertexType >       FiberType;
+  typedef std::vector< FiberType >        FiberContainerType;
+
+  CompactFiberStorage();
+
+  void Clear();
+
+  /** Copies the lines of the polydata. If pointIds is given, it receives the polydata point id of each stored point. */
+  void SetPolyData(vtkPolyData* polyData, std::vector< vtkIdType >* pointIds = nullptr);
+  /** Creates a polydata containing one polyline per fiber. */
+  vtkSmartPointer<vtkPolyData> GetPolyData() const;
+
+  /** Replaces the stored fibers. */
+  void SetFibers(const FiberContainerType& fibers);
+  /** Copies the fibers with the given indices from the source storage. */
+  void SetFibers(const CompactFiberStorage& source, const std::vector< long >& fiberIds);
+  void GetFiber(unsigned long fiber, FiberType& vertices) const;
+  /** Appends a fiber given by numPoints interleaved xyz coordinates. */
+  void AddFiber(const float* points, unsigned long numPoints);
+  void Swap(CompactFiberStorage& other);
+
+  unsigned long GetNumberOfFibers() const { return m_Offsets.size()-1; }
+  unsigned long GetNumberOfPoints() const { return m_Offsets.back(); }
+  unsigned long GetNumberOfPoints(unsigned long fiber) const { return m_Offsets[fiber+1]-m_Offsets[fiber]; }
+  unsigned long GetFirstPoint(unsigned long fiber) const { return m_Offsets[fiber]; }
+
+  const float* GetX() const { return m_X.data(); }
+  const float* GetY() const { return m_Y.data(); }
+  const float* GetZ() const { return m_Z.data(); }
+
+  /** Applies p' = matrix*p + offset to all points. */
+  void Transform(const vnl_matrix_fixed< double, 3, 3 >& matrix, const vnl_vector_fixed< double, 3 >& offset);
+
+  void GetBounds(double bounds[6]) const;
+  std::vector< float > GetFiberLengths() const;
+
+private:
+
+  void Resize(unsigned long numPoints);
+
+  std::vector< float >          m_X;
+  std::vector< float >          m_Y;
+  std::vector< float >          m_Z;
+  std::vector< unsigned long >  m_Offsets;
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_CompactFiberStorage_H */
@@ -51,7 +51,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 const char* mitk::FiberBundle::FIBER_ID_ARRAY = "Fiber_IDs";
 
 mitk::FiberBundle::FiberBundle( vtkPolyData* fiberPolyData )
-  : m_NumFibers(0)
+  : m_FiberPolyDataOutdated(false)
+  , m_UseCompactStorage(false)
+  , m_NumFibers(0)
 {
   m_FiberWeights = vtkSmartPointer<vtkFloatArray>::New();
   m_FiberWeights->SetName("FIBER_WEIGHTS");
@@ -77,7 +79,8 @@ mitk::FiberBundle::~FiberBundle()
 
 mitk::FiberBundle::Pointer mitk::FiberBundle::GetDeepCopy()
 {
-  mitk::FiberBundle::Pointer newFib = mitk::FiberBundle::New(m_FiberPolyData);
+  mitk::FiberBundle::Pointer newFib = mitk::FiberBundle::New(this->GetFiberPolyData());
+  newFib->SetUseCompactStorage(m_UseCompactStorage);
   newFib->SetFiberColors(this->m_FiberColors);
   newFib->SetFiberWeights(this->m_FiberWeights);
   return newFib;
@@ -85,6 +88,24 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::GetDeepCopy()
 
 vtkSmartPointer<vtkPolyData> mitk::FiberBundle::GeneratePolyDataByIds(std::vector<long> fiberIds, vtkSmartPointer<vtkFloatArray> weights)
 {
+  if (m_UseCompactStorage)
+  {
+    for (long id : fiberIds)
+      if (id < 0 || id>=GetNumFibers())
+      {
+        MITK_INFO << "FiberID can not be negative or >NumFibers!!! check id Extraction!" << id;
+        return vtkSmartPointer<vtkPolyData>::New();
+      }
+
+    weights->SetNumberOfValues(fiberIds.size());
+    for (unsigned int i=0; i<fiberIds.size(); ++i)
+      weights->SetValue(i, this->GetFiberWeight(fiberIds.at(i)));
+
+    CompactFiberStorage subset;
+    subset.SetFibers(m_CompactFibers, fiberIds);
+    return subset.GetPolyData();
+  }
+
   vtkSmartPointer<vtkPolyData> newFiberPolyData = vtkSmartPointer<vtkPolyData>::New();
   vtkSmartPointer<vtkCellArray> newLineSet = vtkSmartPointer<vtkCellArray>::New();
   vtkSmartPointer<vtkPoints> newPointSet = vtkSmartPointer<vtkPoints>::New();
@@ -124,6 +145,7 @@ vtkSmartPointer<vtkPolyData> mitk::FiberBundle::GeneratePolyDataByIds(std::vecto
 // merge two fiber bundles
 mitk::FiberBundle::Pointer mitk::FiberBundle::AddBundles(std::vector< mitk::FiberBundle::Pointer > fibs)
 {
+  this->UpdateFiberPolyData();
   vtkSmartPointer<vtkPolyData> vNewPolyData = vtkSmartPointer<vtkPolyData>::New();
   vtkSmartPointer<vtkCellArray> vNewLines = vtkSmartPointer<vtkCellArray>::New();
   vtkSmartPointer<vtkPoints> vNewPoints = vtkSmartPointer<vtkPoints>::New();
@@ -194,6 +216,7 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::AddBundles(std::vector< mitk::Fibe
 // merge two fiber bundles
 mitk::FiberBundle::Pointer mitk::FiberBundle::AddBundle(mitk::FiberBundle* fib)
 {
+  this->UpdateFiberPolyData();
   if (fib==nullptr)
     return this->GetDeepCopy();
 
@@ -262,6 +285,7 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::AddBundle(mitk::FiberBundle* fib)
 // Only retain fibers with a weight larger than the specified threshold
 mitk::FiberBundle::Pointer mitk::FiberBundle::FilterByWeights(float weight_thr, bool invert)
 {
+  this->UpdateFiberPolyData();
   vtkSmartPointer<vtkPolyData> vNewPolyData = vtkSmartPointer<vtkPolyData>::New();
   vtkSmartPointer<vtkCellArray> vNewLines = vtkSmartPointer<vtkCellArray>::New();
   vtkSmartPointer<vtkPoints> vNewPoints = vtkSmartPointer<vtkPoints>::New();
@@ -304,6 +328,7 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::FilterByWeights(float weight_thr,
 // Only retain a subsample of the fibers
 mitk::FiberBundle::Pointer mitk::FiberBundle::SubsampleFibers(float factor)
 {
+  this->UpdateFiberPolyData();
   vtkSmartPointer<vtkPolyData> vNewPolyData = vtkSmartPointer<vtkPolyData>::New();
   vtkSmartPointer<vtkCellArray> vNewLines = vtkSmartPointer<vtkCellArray>::New();
   vtkSmartPointer<vtkPoints> vNewPoints = vtkSmartPointer<vtkPoints>::New();
@@ -354,6 +379,7 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::SubsampleFibers(float factor)
 // subtract two fiber bundles
 mitk::FiberBundle::Pointer mitk::FiberBundle::SubtractBundle(mitk::FiberBundle* fib)
 {
+  this->UpdateFiberPolyData();
   if (fib==nullptr)
     return this->GetDeepCopy();
 
@@ -499,6 +525,14 @@ itk::Point<float, 3> mitk::FiberBundle::GetItkPoint(double point[3])
  */
 void mitk::FiberBundle::SetFiberPolyData(vtkSmartPointer<vtkPolyData> fiberPD, bool updateGeometry)
 {
+  m_SpatialIndex.reset();
+  if (m_UseCompactStorage)
+  {
+    m_CompactFibers.SetPolyData(fiberPD);
+    this->CompactFibersModified(updateGeometry);
+    return;
+  }
+
   if (fiberPD == nullptr)
     this->m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
   else
@@ -517,9 +551,138 @@ void mitk::FiberBundle::SetFiberPolyData(vtkSmartPointer<vtkPolyData> fiberPD, b
  */
 vtkSmartPointer<vtkPolyData> mitk::FiberBundle::GetFiberPolyData() const
 {
+  return this->UpdateFiberPolyData();
+}
+
+void mitk::FiberBundle::ReleaseFiberPolyData()
+{
+  std::lock_guard<std::mutex> lock(m_CacheMutex);
+  if (!m_UseCompactStorage)
+    return;
+
+  m_FiberPolyData = nullptr;
+  m_FiberIdDataSet = nullptr;
+  m_FiberPolyDataOutdated = true;
+}
+
+void mitk::FiberBundle::SetUseCompactStorage(bool useCompactStorage)
+{
+  if (useCompactStorage == m_UseCompactStorage)
+    return;
+
+  if (useCompactStorage)
+  {
+    // the compact storage orders the points by fiber, so the point colors are reordered accordingly
+    std::vector< vtkIdType > pointIds;
+    m_CompactFibers.SetPolyData(m_FiberPolyData, &pointIds);
+    if (m_FiberColors!=nullptr && m_FiberColors->GetNumberOfTuples()==m_FiberPolyData->GetNumberOfPoints())
+    {
+      vtkSmartPointer<vtkUnsignedCharArray> colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+      colors->SetNumberOfComponents(4);
+      colors->SetName("FIBER_COLORS");
+      colors->SetNumberOfTuples(pointIds.size());
+      for (unsigned long i=0; i<pointIds.size(); ++i)
+        colors->SetTypedTuple(i, m_FiberColors->GetPointer(4*pointIds[i]));
+      m_FiberColors = colors;
+    }
+    else
+      m_FiberColors = nullptr;
+
+    m_UseCompactStorage = true;
+    m_FiberPolyData = nullptr;
+    m_FiberIdDataSet = nullptr;
+    m_FiberPolyDataOutdated = true;
+    if (m_FiberColors==nullptr)
+      this->ColorFibersByOrientation();
+  }
+  else
+  {
+    this->UpdateFiberPolyData();
+    m_UseCompactStorage = false;
+    m_CompactFibers.Clear();
+  }
+}
+
+void mitk::FiberBundle::SetCompactFibers(CompactFiberStorage& fibers)
+{
+  m_UseCompactStorage = true;
+  m_CompactFibers.Swap(fibers);
+  fibers.Clear();
+  m_FiberColors = nullptr;
+  this->CompactFibersModified();
+}
+
+/*
+ * create the vtkPolyData from the compact storage if it does not reflect the current fibers
+ */
+vtkSmartPointer<vtkPolyData> mitk::FiberBundle::UpdateFiberPolyData() const
+{
+  std::lock_guard<std::mutex> lock(m_CacheMutex);
+  if (m_FiberPolyDataOutdated)
+  {
+    m_FiberPolyData = m_CompactFibers.GetPolyData();
+    m_FiberPolyDataOutdated = false;
+    this->GenerateFiberIds();
+  }
   return m_FiberPolyData;
 }
 
+/*
+ * the compact storage has been changed; release the outdated vtkPolyData and update the derived fiber properties
+ */
+void mitk::FiberBundle::CompactFibersModified(bool updateGeometry)
+{
+  m_FiberPolyData = nullptr;
+  m_FiberIdDataSet = nullptr;
+  m_FiberPolyDataOutdated = true;
+  m_NumFibers = m_CompactFibers.GetNumberOfFibers();
+
+  ColorFibersByOrientation();
+  if (updateGeometry)
+    UpdateFiberGeometry();
+}
+
+/*
+ * build the spatial index of the fiber segments if necessary
+ */
+const mitk::FiberSpatialIndex* mitk::FiberBundle::GetSpatialIndex() const
+{
+  std::lock_guard<std::mutex> lock(m_CacheMutex);
+  if (m_SpatialIndex==nullptr)
+  {
+    if (m_UseCompactStorage)
+      m_SpatialIndex.reset(new FiberSpatialIndex(m_CompactFibers));
+    else
+    {
+      CompactFiberStorage fibers;
+      fibers.SetPolyData(m_FiberPolyData);
+      m_SpatialIndex.reset(new FiberSpatialIndex(fibers));
+    }
+  }
+  return m_SpatialIndex.get();
+}
+
+void mitk::FiberBundle::TransformCompactFibers(const vnl_matrix_fixed< double, 3, 3 >& matrix, const vnl_vector_fixed< double, 3 >& offset)
+{
+  m_CompactFibers.Transform(matrix, offset);
+  this->CompactFibersModified();
+}
+
+void mitk::FiberBundle::SetFibers(const CompactFiberStorage::FiberContainerType& fibers)
+{
+  if (m_UseCompactStorage)
+  {
+    m_CompactFibers.SetFibers(fibers);
+    this->CompactFibersModified();
+  }
+  else
+  {
+    CompactFiberStorage storage;
+    storage.SetFibers(fibers);
+    this->SetFiberPolyData(storage.GetPolyData(), true);
+  }
+}
+
 void mitk::FiberBundle::ColorFibersByOrientation()
 {
   //===== FOR WRITING A TEST ========================
@@ -530,6 +693,50 @@ void mitk::FiberBundle::ColorFibersByOrientation()
   //  + one fiber with 0 points
   //=================================================
 
+  if (m_UseCompactStorage)
+  {
+    unsigned long numOfPoints = m_CompactFibers.GetNumberOfPoints();
+    m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    m_FiberColors->SetNumberOfComponents(4);
+    m_FiberColors->SetName("FIBER_COLORS");
+    m_FiberColors->SetNumberOfTuples(numOfPoints);
+    unsigned char* colors = m_FiberColors->GetPointer(0);
+    std::fill(colors, colors + 4*numOfPoints, 0);
+
+    const float* x = m_CompactFibers.GetX();
+    const float* y = m_CompactFibers.GetY();
+    const float* z = m_CompactFibers.GetZ();
+    int numOfFibers = m_CompactFibers.GetNumberOfFibers();
+#pragma omp parallel for
+    for (int fi=0; fi<numOfFibers; ++fi)
+    {
+      unsigned long first = m_CompactFibers.GetFirstPoint(fi);
+      unsigned long pointsPerFiber = m_CompactFibers.GetNumberOfPoints(fi);
+      if (pointsPerFiber < 2)
+        continue;
+
+      for (unsigned long k=first; k<first+pointsPerFiber; ++k)
+      {
+        // same directions as below: central difference for inner points, one-sided at the fiber ends
+        unsigned long prev = k>first ? k-1 : k;
+        unsigned long next = k<first+pointsPerFiber-1 ? k+1 : k;
+        vnl_vector_fixed< double, 3 > diff;
+        diff[0] = x[next]-x[prev];
+        diff[1] = y[next]-y[prev];
+        diff[2] = z[next]-z[prev];
+        diff.normalize();
+
+        colors[4*k] = (unsigned char) (255.0 * std::fabs(diff[0]));
+        colors[4*k+1] = (unsigned char) (255.0 * std::fabs(diff[1]));
+        colors[4*k+2] = (unsigned char) (255.0 * std::fabs(diff[2]));
+        colors[4*k+3] = (unsigned char) (255.0);
+      }
+    }
+    m_UpdateTime3D.Modified();
+    m_UpdateTime2D.Modified();
+    return;
+  }
+
   vtkPoints* extrPoints = nullptr;
   extrPoints = m_FiberPolyData->GetPoints();
   int numOfPoints = 0;
@@ -637,6 +844,7 @@ void mitk::FiberBundle::ColorFibersByOrientation()
 
 void mitk::FiberBundle::ColorFibersByCurvature(bool, bool normalize)
 {
+  this->UpdateFiberPolyData();
   double window = 5;
 
   //colors and alpha value for each single point, RGBA = 4 components
@@ -791,6 +999,7 @@ void mitk::FiberBundle::ColorFibersByScalarMap(mitk::Image::Pointer FAimage, boo
 template <typename TPixel>
 void mitk::FiberBundle::ColorFibersByScalarMap(const mitk::PixelType, mitk::Image::Pointer image, bool opacity, bool normalize)
 {
+  this->UpdateFiberPolyData();
   m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
   m_FiberColors->Allocate(m_FiberPolyData->GetNumberOfPoints() * 4);
   m_FiberColors->SetNumberOfComponents(4);
@@ -855,6 +1064,7 @@ void mitk::FiberBundle::ColorFibersByScalarMap(const mitk::PixelType, mitk::Imag
 
 void mitk::FiberBundle::ColorFibersByFiberWeights(bool opacity, bool normalize)
 {
+  this->UpdateFiberPolyData();
   m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
   m_FiberColors->Allocate(m_FiberPolyData->GetNumberOfPoints() * 4);
   m_FiberColors->SetNumberOfComponents(4);
@@ -921,13 +1131,14 @@ void mitk::FiberBundle::ColorFibersByFiberWeights(bool opacity, bool normalize)
 
 void mitk::FiberBundle::SetFiberColors(float r, float g, float b, float alpha)
 {
+  long numPoints = m_UseCompactStorage ? m_CompactFibers.GetNumberOfPoints() : m_FiberPolyData->GetNumberOfPoints();
   m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
-  m_FiberColors->Allocate(m_FiberPolyData->GetNumberOfPoints() * 4);
+  m_FiberColors->Allocate(numPoints * 4);
   m_FiberColors->SetNumberOfComponents(4);
   m_FiberColors->SetName("FIBER_COLORS");
 
   unsigned char rgba[4] = {0,0,0,0};
-  for(long i=0; i<m_FiberPolyData->GetNumberOfPoints(); ++i)
+  for(long i=0; i<numPoints; ++i)
   {
     rgba[0] = (unsigned char) r;
     rgba[1] = (unsigned char) g;
@@ -939,7 +1150,7 @@ void mitk::FiberBundle::SetFiberColors(float r, float g, float b, float alpha)
   m_UpdateTime2D.Modified();
 }
 
-void mitk::FiberBundle::GenerateFiberIds()
+void mitk::FiberBundle::GenerateFiberIds() const
 {
   if (m_FiberPolyData == nullptr)
     return;
@@ -958,6 +1169,7 @@ void mitk::FiberBundle::GenerateFiberIds()
 
 float mitk::FiberBundle::GetOverlap(ItkUcharImgType* mask, bool do_resampling)
 {
+  this->UpdateFiberPolyData();
   vtkSmartPointer<vtkPolyData> PolyData = m_FiberPolyData;
   mitk::FiberBundle::Pointer fibCopy = this;
   if (do_resampling)
@@ -1093,6 +1305,19 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(DataNode* roi,
 
   if (tmp.size()<=0)
     return mitk::FiberBundle::New();
+
+  if (m_UseCompactStorage)
+  {
+    // copy the fibers directly between the compact storages, without a detour via vtkPolyData
+    CompactFiberStorage subset;
+    subset.SetFibers(m_CompactFibers, tmp);
+    mitk::FiberBundle::Pointer fib = mitk::FiberBundle::New();
+    fib->SetCompactFibers(subset);
+    for (unsigned int i=0; i<tmp.size(); ++i)
+      fib->SetFiberWeight(i, this->GetFiberWeight(tmp.at(i)));
+    return fib;
+  }
+
   vtkSmartPointer<vtkFloatArray> weights = vtkSmartPointer<vtkFloatArray>::New();
   vtkSmartPointer<vtkPolyData> pTmp = GeneratePolyDataByIds(tmp, weights);
   mitk::FiberBundle::Pointer fib = mitk::FiberBundle::New(pTmp);
@@ -1171,9 +1396,12 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
   }
   else if ( dynamic_cast<mitk::PlanarFigure*>(roi->GetData()) )  // actual extraction
   {
+    // only the segments in the grid cells overlapping the bounding box of the figure are tested
+    double bounds[6];
     if ( dynamic_cast<mitk::PlanarPolygon*>(roi->GetData()) )
     {
       mitk::PlanarFigure::Pointer planarPoly = dynamic_cast<mitk::PlanarFigure*>(roi->GetData());
+      double tolerance = 0.001;
 
       //create vtkPolygon using controlpoints from planarFigure polygon
       vtkSmartPointer<vtkPolygon> polygonVtk = vtkSmartPointer<vtkPolygon>::New();
@@ -1183,39 +1411,25 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
         vtkIdType id = polygonVtk->GetPoints()->InsertNextPoint(p[0], p[1], p[2] );
         polygonVtk->GetPointIds()->InsertNextId(id);
       }
+      polygonVtk->GetPoints()->GetBounds(bounds);
+      double margin = tolerance*std::max(1.0, std::sqrt(polygonVtk->GetLength2()));
+      for (int a=0; a<3; ++a)
+      {
+        bounds[2*a] -= margin;
+        bounds[2*a+1] += margin;
+      }
 
       MITK_INFO << "Extracting with polygon";
-      boost::progress_display disp(m_NumFibers);
-      for (int i=0; i<m_NumFibers; i++)
+      result = this->ExtractIntersectingFibers(bounds, [&](double* p1, double* p2)
       {
-        ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        for (int j=0; j<numPoints-1; j++)
-        {
-          // Inputs
-          double p1[3] = {0,0,0};
-          points->GetPoint(j, p1);
-          double p2[3] = {0,0,0};
-          points->GetPoint(j+1, p2);
-          double tolerance = 0.001;
-
-          // Outputs
-          double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
-          double x[3] = {0,0,0}; // The coordinate of the intersection
-          double pcoords[3] = {0,0,0};
-          int subId = 0;
-
-          int iD = polygonVtk->IntersectWithLine(p1, p2, tolerance, t, x, pcoords, subId);
-          if (iD!=0)
-          {
-            result.push_back(i);
-            break;
-          }
-        }
-      }
+        // Outputs
+        double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
+        double x[3] = {0,0,0}; // The coordinate of the intersection
+        double pcoords[3] = {0,0,0};
+        int subId = 0;
+
+        return polygonVtk->IntersectWithLine(p1, p2, tolerance, t, x, pcoords, subId)!=0;
+      });
     }
     else if ( dynamic_cast<mitk::PlanarCircle*>(roi->GetData()) )
     {
@@ -1228,64 +1442,121 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
       mitk::Point3D V2w  = planarFigure->GetWorldControlPoint(1); //radiusPoint
 
       double radius = V1w.EuclideanDistanceTo(V2w);
+      // extent of the circle along each axis
+      for (int a=0; a<3; ++a)
+      {
+        double extent = radius*std::sqrt(std::max(0.0, 1.0-planeNormal[a]*planeNormal[a])) + 0.001;
+        bounds[2*a] = V1w[a]-extent;
+        bounds[2*a+1] = V1w[a]+extent;
+      }
       radius *= radius;
 
       MITK_INFO << "Extracting with circle";
-      boost::progress_display disp(m_NumFibers);
-      for (int i=0; i<m_NumFibers; i++)
+      result = this->ExtractIntersectingFibers(bounds, [&](double* p1, double* p2)
       {
-        ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        // Outputs
+        double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
+        double x[3] = {0,0,0}; // The coordinate of the intersection
+
+        int iD = vtkPlane::IntersectWithLine(p1,p2,planeNormal.GetDataPointer(),V1w.GetDataPointer(),t,x);
+        if (iD==0)
+          return false;
+        double dist = (x[0]-V1w[0])*(x[0]-V1w[0])+(x[1]-V1w[1])*(x[1]-V1w[1])+(x[2]-V1w[2])*(x[2]-V1w[2]);
+        return dist <= radius;
+      });
+    }
+    return result;
+  }
 
-        for (int j=0; j<numPoints-1; j++)
-        {
-          // Inputs
-          double p1[3] = {0,0,0};
-          points->GetPoint(j, p1);
-          double p2[3] = {0,0,0};
-          points->GetPoint(j+1, p2);
+  return result;
+}
 
-          // Outputs
-          double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
-          double x[3] = {0,0,0}; // The coordinate of the intersection
+std::vector<long> mitk::FiberBundle::ExtractIntersectingFibers(const double bounds[6], const std::function< bool(double*, double*) >& intersects) const
+{
+  std::vector< FiberSpatialIndex::SegmentRun > runs;
+  this->GetSpatialIndex()->GetSegmentRuns(bounds, runs);
+  std::sort(runs.begin(), runs.end(), [](const FiberSpatialIndex::SegmentRun& a, const FiberSpatialIndex::SegmentRun& b)
+  {
+    return a.Fiber<b.Fiber || (a.Fiber==b.Fiber && a.FirstSegment<b.FirstSegment);
+  });
 
-          int iD = vtkPlane::IntersectWithLine(p1,p2,planeNormal.GetDataPointer(),V1w.GetDataPointer(),t,x);
+  std::vector<long> result;
+  for (std::size_t r=0; r<runs.size(); ++r)
+  {
+    unsigned int fiber = runs[r].Fiber;
+    if (!result.empty() && result.back()==fiber)
+      continue;
 
-          if (iD!=0)
-          {
-            double dist = (x[0]-V1w[0])*(x[0]-V1w[0])+(x[1]-V1w[1])*(x[1]-V1w[1])+(x[2]-V1w[2])*(x[2]-V1w[2]);
-            if( dist <= radius)
-            {
-              result.push_back(i);
-              break;
-            }
-          }
-        }
+    unsigned long numPoints = 0;
+    unsigned long firstPoint = 0;
+    vtkIdType* pointIds = nullptr;
+    if (m_UseCompactStorage)
+    {
+      numPoints = m_CompactFibers.GetNumberOfPoints(fiber);
+      firstPoint = m_CompactFibers.GetFirstPoint(fiber);
+    }
+    else
+    {
+      vtkIdType n = 0;
+      m_FiberPolyData->GetCellPoints(fiber, n, pointIds);
+      numPoints = n;
+    }
+
+    for (unsigned int j=runs[r].FirstSegment; j<=runs[r].LastSegment && j+1<numPoints; ++j)
+    {
+      double p1[3] = {0,0,0};
+      double p2[3] = {0,0,0};
+      if (m_UseCompactStorage)
+      {
+        unsigned long k = firstPoint + j;
+        p1[0] = m_CompactFibers.GetX()[k];   p1[1] = m_CompactFibers.GetY()[k];   p1[2] = m_CompactFibers.GetZ()[k];
+        p2[0] = m_CompactFibers.GetX()[k+1]; p2[1] = m_CompactFibers.GetY()[k+1]; p2[2] = m_CompactFibers.GetZ()[k+1];
+      }
+      else
+      {
+        m_FiberPolyData->GetPoint(pointIds[j], p1);
+        m_FiberPolyData->GetPoint(pointIds[j+1], p2);
+      }
+
+      if (intersects(p1, p2))
+      {
+        result.push_back(fiber);
+        break;
       }
     }
-    return result;
   }
-
   return result;
 }
 
 void mitk::FiberBundle::UpdateFiberGeometry()
 {
-  vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
-  cleaner->SetInputData(m_FiberPolyData);
-  cleaner->PointMergingOff();
-  cleaner->Update();
-  m_FiberPolyData = cleaner->GetOutput();
+  // all operations changing the fibers end here, so the spatial index is discarded
+  m_SpatialIndex.reset();
+
+  unsigned long numPoints = 0;
+  if (m_UseCompactStorage)
+  {
+    // the compact storage contains no unused points, so it does not need to be cleaned
+    m_NumFibers = m_CompactFibers.GetNumberOfFibers();
+    numPoints = m_CompactFibers.GetNumberOfPoints();
+  }
+  else
+  {
+    vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
+    cleaner->SetInputData(m_FiberPolyData);
+    cleaner->PointMergingOff();
+    cleaner->Update();
+    m_FiberPolyData = cleaner->GetOutput();
+    m_NumFibers = m_FiberPolyData->GetNumberOfCells();
+    numPoints = m_FiberPolyData->GetNumberOfPoints();
+  }
 
   m_FiberLengths.clear();
   m_MeanFiberLength = 0;
   m_MedianFiberLength = 0;
   m_LengthStDev = 0;
-  m_NumFibers = m_FiberPolyData->GetNumberOfCells();
 
-  if (m_FiberColors==nullptr || m_FiberColors->GetNumberOfTuples()!=m_FiberPolyData->GetNumberOfPoints())
+  if (m_FiberColors==nullptr || (unsigned long)m_FiberColors->GetNumberOfTuples()!=numPoints)
     this->ColorFibersByOrientation();
 
   if (m_FiberWeights->GetNumberOfValues()!=m_NumFibers)
@@ -1308,39 +1579,44 @@ void mitk::FiberBundle::UpdateFiberGeometry()
     return;
   }
   double b[6];
-  m_FiberPolyData->GetBounds(b);
-
-  // calculate statistics
-  for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+  if (m_UseCompactStorage)
   {
-    vtkCell* cell = m_FiberPolyData->GetCell(i);
-    int p = cell->GetNumberOfPoints();
-    vtkPoints* points = cell->GetPoints();
-    float length = 0;
-    for (int j=0; j<p-1; j++)
+    m_CompactFibers.GetBounds(b);
+    m_FiberLengths = m_CompactFibers.GetFiberLengths();
+  }
+  else
+  {
+    m_FiberPolyData->GetBounds(b);
+    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
     {
-      double p1[3];
-      points->GetPoint(j, p1);
-      double p2[3];
-      points->GetPoint(j+1, p2);
+      vtkCell* cell = m_FiberPolyData->GetCell(i);
+      int p = cell->GetNumberOfPoints();
+      vtkPoints* points = cell->GetPoints();
+      float length = 0;
+      for (int j=0; j<p-1; j++)
+      {
+        double p1[3];
+        points->GetPoint(j, p1);
+        double p2[3];
+        points->GetPoint(j+1, p2);
 
-      float dist = std::sqrt((p1[0]-p2[0])*(p1[0]-p2[0])+(p1[1]-p2[1])*(p1[1]-p2[1])+(p1[2]-p2[2])*(p1[2]-p2[2]));
-      length += dist;
+        float dist = std::sqrt((p1[0]-p2[0])*(p1[0]-p2[0])+(p1[1]-p2[1])*(p1[1]-p2[1])+(p1[2]-p2[2])*(p1[2]-p2[2]));
+        length += dist;
+      }
+      m_FiberLengths.push_back(length);
     }
-    m_FiberLengths.push_back(length);
+  }
+
+  // calculate statistics
+  m_MinFiberLength = m_FiberLengths.at(0);
+  m_MaxFiberLength = m_FiberLengths.at(0);
+  for (float length : m_FiberLengths)
+  {
     m_MeanFiberLength += length;
-    if (i==0)
-    {
+    if (length<m_MinFiberLength)
       m_MinFiberLength = length;
+    if (length>m_MaxFiberLength)
       m_MaxFiberLength = length;
-    }
-    else
-    {
-      if (length<m_MinFiberLength)
-        m_MinFiberLength = length;
-      if (length>m_MaxFiberLength)
-        m_MaxFiberLength = length;
-    }
   }
   m_MeanFiberLength /= m_NumFibers;
 
@@ -1395,7 +1671,8 @@ void mitk::FiberBundle::SetFiberWeight(unsigned int fiber, float weight)
 
 void mitk::FiberBundle::SetFiberColors(vtkSmartPointer<vtkUnsignedCharArray> fiberColors)
 {
-  for(long i=0; i<m_FiberPolyData->GetNumberOfPoints(); ++i)
+  long numPoints = m_UseCompactStorage ? m_CompactFibers.GetNumberOfPoints() : m_FiberPolyData->GetNumberOfPoints();
+  for(long i=0; i<numPoints; ++i)
   {
     unsigned char source[4] = {0,0,0,0};
     fiberColors->GetTypedTuple(i, source);
@@ -1511,6 +1788,14 @@ void mitk::FiberBundle::TransformFibers(double rx, double ry, double rz, double
   mitk::BaseGeometry::Pointer geom = this->GetGeometry();
   mitk::Point3D center = geom->GetCenter();
 
+  if (m_UseCompactStorage)
+  {
+    vnl_vector_fixed< double, 3 > c; c[0] = center[0]; c[1] = center[1]; c[2] = center[2];
+    vnl_vector_fixed< double, 3 > t; t[0] = tx; t[1] = ty; t[2] = tz;
+    this->TransformCompactFibers(rot, c + t - rot*c);
+    return;
+  }
+
   vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
   vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
 
@@ -1571,6 +1856,14 @@ void mitk::FiberBundle::RotateAroundAxis(double x, double y, double z)
   mitk::BaseGeometry::Pointer geom = this->GetGeometry();
   mitk::Point3D center = geom->GetCenter();
 
+  if (m_UseCompactStorage)
+  {
+    vnl_matrix_fixed< double, 3, 3 > rot = rotZ*rotY*rotX;
+    vnl_vector_fixed< double, 3 > c; c[0] = center[0]; c[1] = center[1]; c[2] = center[2];
+    this->TransformCompactFibers(rot, c - rot*c);
+    return;
+  }
+
   vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
   vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
 
@@ -1607,11 +1900,26 @@ void mitk::FiberBundle::RotateAroundAxis(double x, double y, double z)
 void mitk::FiberBundle::ScaleFibers(double x, double y, double z, bool subtractCenter)
 {
   MITK_INFO << "Scaling fibers";
-  boost::progress_display disp(m_NumFibers);
 
   mitk::BaseGeometry* geom = this->GetGeometry();
   mitk::Point3D c = geom->GetCenter();
 
+  if (m_UseCompactStorage)
+  {
+    vnl_matrix_fixed< double, 3, 3 > scale; scale.set_identity();
+    scale[0][0] = x; scale[1][1] = y; scale[2][2] = z;
+    vnl_vector_fixed< double, 3 > offset(0.0);
+    if (subtractCenter)
+    {
+      vnl_vector_fixed< double, 3 > center; center[0] = c[0]; center[1] = c[1]; center[2] = c[2];
+      offset = center - scale*center;
+    }
+    this->TransformCompactFibers(scale, offset);
+    return;
+  }
+
+  boost::progress_display disp(m_NumFibers);
+
   vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
   vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
 
@@ -1651,6 +1959,14 @@ void mitk::FiberBundle::ScaleFibers(double x, double y, double z, bool subtractC
 
 void mitk::FiberBundle::TranslateFibers(double x, double y, double z)
 {
+  if (m_UseCompactStorage)
+  {
+    vnl_matrix_fixed< double, 3, 3 > identity; identity.set_identity();
+    vnl_vector_fixed< double, 3 > offset; offset[0] = x; offset[1] = y; offset[2] = z;
+    this->TransformCompactFibers(identity, offset);
+    return;
+  }
+
   vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
   vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
 
@@ -1685,6 +2001,15 @@ void mitk::FiberBundle::MirrorFibers(unsigned int axis)
     return;
 
   MITK_INFO << "Mirroring fibers";
+
+  if (m_UseCompactStorage)
+  {
+    vnl_matrix_fixed< double, 3, 3 > mirror; mirror.set_identity();
+    mirror[axis][axis] = -1;
+    this->TransformCompactFibers(mirror, vnl_vector_fixed< double, 3 >(0.0));
+    return;
+  }
+
   boost::progress_display disp(m_NumFibers);
 
   vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
@@ -1716,6 +2041,7 @@ void mitk::FiberBundle::MirrorFibers(unsigned int axis)
 
 void mitk::FiberBundle::RemoveDir(vnl_vector_fixed<double,3> dir, double threshold)
 {
+  this->UpdateFiberPolyData();
   dir.normalize();
   vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
   vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
@@ -1779,6 +2105,7 @@ void mitk::FiberBundle::RemoveDir(vnl_vector_fixed<double,3> dir, double thresho
 
 bool mitk::FiberBundle::ApplyCurvatureThreshold(float minRadius, bool deleteFibers)
 {
+  this->UpdateFiberPolyData();
   if (minRadius<0)
     return true;
 
@@ -1859,6 +2186,7 @@ bool mitk::FiberBundle::ApplyCurvatureThreshold(float minRadius, bool deleteFibe
 
 bool mitk::FiberBundle::RemoveShortFibers(float lengthInMM)
 {
+  this->UpdateFiberPolyData();
   MITK_INFO << "Removing short fibers";
   if (lengthInMM<=0 || lengthInMM<m_MinFiberLength)
   {
@@ -1911,6 +2239,7 @@ bool mitk::FiberBundle::RemoveShortFibers(float lengthInMM)
 
 bool mitk::FiberBundle::RemoveLongFibers(float lengthInMM)
 {
+  this->UpdateFiberPolyData();
   if (lengthInMM<=0 || lengthInMM>m_MaxFiberLength)
     return true;
 
@@ -1957,17 +2286,9 @@ void mitk::FiberBundle::ResampleSpline(float pointDistance, double tension, doub
   if (pointDistance<=0)
     return;
 
-  vtkSmartPointer<vtkPoints> vtkSmoothPoints = vtkSmartPointer<vtkPoints>::New(); //in smoothpoints the interpolated points representing a fiber are stored.
-
-  //in vtkcells all polylines are stored, actually all id's of them are stored
-  vtkSmartPointer<vtkCellArray> vtkSmoothCells = vtkSmartPointer<vtkCellArray>::New(); //cellcontainer for smoothed lines
-
   MITK_INFO << "Smoothing fibers";
-  vtkSmartPointer<vtkFloatArray> newFiberWeights = vtkSmartPointer<vtkFloatArray>::New();
-  newFiberWeights->SetName("FIBER_WEIGHTS");
-  newFiberWeights->SetNumberOfValues(m_NumFibers);
 
-  std::vector< vtkSmartPointer<vtkPolyLine> > resampled_streamlines;
+  CompactFiberStorage::FiberContainerType resampled_streamlines;
   resampled_streamlines.resize(m_NumFibers);
 
   boost::progress_display disp(m_NumFibers);
@@ -1975,16 +2296,30 @@ void mitk::FiberBundle::ResampleSpline(float pointDistance, double tension, doub
   for (int i=0; i<m_NumFibers; i++)
   {
     vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
-    float length = 0;
-#pragma omp critical
+    float length = m_FiberLengths.at(i);
+    if (m_UseCompactStorage)
     {
-      length = m_FiberLengths.at(i);
+      const float* x = m_CompactFibers.GetX();
+      const float* y = m_CompactFibers.GetY();
+      const float* z = m_CompactFibers.GetZ();
+      unsigned long first = m_CompactFibers.GetFirstPoint(i);
+      newPoints->SetNumberOfPoints(m_CompactFibers.GetNumberOfPoints(i));
+      for (vtkIdType j=0; j<newPoints->GetNumberOfPoints(); j++)
+        newPoints->SetPoint(j, x[first+j], y[first+j], z[first+j]);
+#pragma omp critical
       ++disp;
-      vtkCell* cell = m_FiberPolyData->GetCell(i);
-      int numPoints = cell->GetNumberOfPoints();
-      vtkPoints* points = cell->GetPoints();
-      for (int j=0; j<numPoints; j++)
-        newPoints->InsertNextPoint(points->GetPoint(j));
+    }
+    else
+    {
+#pragma omp critical
+      {
+        ++disp;
+        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        int numPoints = cell->GetNumberOfPoints();
+        vtkPoints* points = cell->GetPoints();
+        for (int j=0; j<numPoints; j++)
+          newPoints->InsertNextPoint(points->GetPoint(j));
+      }
     }
 
     int sampling = std::ceil(length/pointDistance);
@@ -2012,29 +2347,13 @@ void mitk::FiberBundle::ResampleSpline(float pointDistance, double tension, doub
     vtkPolyData* outputFunction = functionSource->GetOutput();
     vtkPoints* tmpSmoothPnts = outputFunction->GetPoints(); //smoothPoints of current fiber
 
-    vtkSmartPointer<vtkPolyLine> smoothLine = vtkSmartPointer<vtkPolyLine>::New();
-
-#pragma omp critical
-    {
-      for (int j=0; j<tmpSmoothPnts->GetNumberOfPoints(); j++)
-      {
-        vtkIdType id = vtkSmoothPoints->InsertNextPoint(tmpSmoothPnts->GetPoint(j));
-        smoothLine->GetPointIds()->InsertNextId(id);
-      }
-
-      resampled_streamlines[i] = smoothLine;
-    }
+    CompactFiberStorage::FiberType& smoothLine = resampled_streamlines[i];
+    smoothLine.resize(tmpSmoothPnts->GetNumberOfPoints());
+    for (int j=0; j<tmpSmoothPnts->GetNumberOfPoints(); j++)
+      tmpSmoothPnts->GetPoint(j, smoothLine[j].data_block());
   }
 
-  for (auto container : resampled_streamlines)
-  {
-    vtkSmoothCells->InsertNextCell(container);
-  }
-
-  m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-  m_FiberPolyData->SetPoints(vtkSmoothPoints);
-  m_FiberPolyData->SetLines(vtkSmoothCells);
-  this->SetFiberPolyData(m_FiberPolyData, true);
+  this->SetFibers(resampled_streamlines);
 }
 
 void mitk::FiberBundle::ResampleSpline(float pointDistance)
@@ -2044,49 +2363,53 @@ void mitk::FiberBundle::ResampleSpline(float pointDistance)
 
 unsigned long mitk::FiberBundle::GetNumberOfPoints() const
 {
-  unsigned long points = 0;
-  for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
-  {
-    vtkCell* cell = m_FiberPolyData->GetCell(i);
-    points += cell->GetNumberOfPoints();
-  }
-  return points;
+  if (m_UseCompactStorage)
+    return m_CompactFibers.GetNumberOfPoints();
+
+  // each line is stored as its number of points followed by the point ids
+  vtkCellArray* lines = m_FiberPolyData->GetLines();
+  return lines->GetNumberOfConnectivityEntries() - lines->GetNumberOfCells();
 }
 
 void mitk::FiberBundle::Compress(float error)
 {
-  vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-  vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
   MITK_INFO << "Compressing fibers";
   unsigned long numRemovedPoints = 0;
-  boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-  vtkSmartPointer<vtkFloatArray> newFiberWeights = vtkSmartPointer<vtkFloatArray>::New();
-  newFiberWeights->SetName("FIBER_WEIGHTS");
-  newFiberWeights->SetNumberOfValues(m_NumFibers);
+  boost::progress_display disp(m_NumFibers);
+
+  // the compressed fibers keep their order, so the fiber weights remain valid
+  CompactFiberStorage::FiberContainerType compressed_streamlines;
+  compressed_streamlines.resize(m_NumFibers);
 
 #pragma omp parallel for
-  for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+  for (int i=0; i<m_NumFibers; i++)
   {
 
     std::vector< vnl_vector_fixed< double, 3 > > vertices;
-    float weight = 1;
 
-#pragma omp critical
+    if (m_UseCompactStorage)
     {
+      m_CompactFibers.GetFiber(i, vertices);
+#pragma omp critical
       ++disp;
-      weight = m_FiberWeights->GetValue(i);
-      vtkCell* cell = m_FiberPolyData->GetCell(i);
-      int numPoints = cell->GetNumberOfPoints();
-      vtkPoints* points = cell->GetPoints();
-
-      for (int j=0; j<numPoints; j++)
+    }
+    else
+    {
+#pragma omp critical
       {
-        double cand[3];
-        points->GetPoint(j, cand);
-        vnl_vector_fixed< double, 3 > candV;
-        candV[0]=cand[0]; candV[1]=cand[1]; candV[2]=cand[2];
-        vertices.push_back(candV);
+        ++disp;
+        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        int numPoints = cell->GetNumberOfPoints();
+        vtkPoints* points = cell->GetPoints();
+
+        for (int j=0; j<numPoints; j++)
+        {
+          double cand[3];
+          points->GetPoint(j, cand);
+          vnl_vector_fixed< double, 3 > candV;
+          candV[0]=cand[0]; candV[1]=cand[1]; candV[2]=cand[2];
+          vertices.push_back(candV);
+        }
       }
     }
 
@@ -2095,7 +2418,6 @@ void mitk::FiberBundle::Compress(float error)
     std::vector< int > removedPoints; removedPoints.resize(numPoints, 0);
     removedPoints[0]=-1; removedPoints[numPoints-1]=-1;
 
-    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
     int remCounter = 0;
 
     bool pointFound = true;
@@ -2155,34 +2477,22 @@ void mitk::FiberBundle::Compress(float error)
       }
     }
 
+    CompactFiberStorage::FiberType& container = compressed_streamlines[i];
+    container.reserve(numPoints-remCounter);
     for (int j=0; j<numPoints; j++)
     {
       if (removedPoints[j]<=0)
-      {
-#pragma omp critical
-        {
-          vtkIdType id = vtkNewPoints->InsertNextPoint(vertices.at(j).data_block());
-          container->GetPointIds()->InsertNextId(id);
-        }
-      }
+        container.push_back(vertices.at(j));
     }
 
 #pragma omp critical
-    {
-      newFiberWeights->SetValue(vtkNewCells->GetNumberOfCells(), weight);
-      numRemovedPoints += remCounter;
-      vtkNewCells->InsertNextCell(container);
-    }
+    numRemovedPoints += remCounter;
   }
 
-  if (vtkNewCells->GetNumberOfCells()>0)
+  if (m_NumFibers>0)
   {
     MITK_INFO << "Removed points: " << numRemovedPoints;
-    SetFiberWeights(newFiberWeights);
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+    this->SetFibers(compressed_streamlines);
   }
 }
 
@@ -2196,6 +2506,7 @@ void mitk::FiberBundle::ResampleToNumPoints(unsigned int targetPoints)
   bool unequal_fibs = true;
   while (unequal_fibs)
   {
+    this->UpdateFiberPolyData();
     vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
     vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
 
@@ -2315,49 +2626,47 @@ void mitk::FiberBundle::ResampleToNumPoints(unsigned int targetPoints)
 
 void mitk::FiberBundle::ResampleLinear(double pointDistance)
 {
-  vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-  vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
   MITK_INFO << "Resampling fibers (linear)";
-  boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-  vtkSmartPointer<vtkFloatArray> newFiberWeights = vtkSmartPointer<vtkFloatArray>::New();
-  newFiberWeights->SetName("FIBER_WEIGHTS");
-  newFiberWeights->SetNumberOfValues(m_NumFibers);
+  boost::progress_display disp(m_NumFibers);
 
-  std::vector< vtkSmartPointer<vtkPolyLine> > resampled_streamlines;
-  resampled_streamlines.resize(m_FiberPolyData->GetNumberOfCells());
+  CompactFiberStorage::FiberContainerType resampled_streamlines;
+  resampled_streamlines.resize(m_NumFibers);
 
 #pragma omp parallel for
-  for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+  for (int i=0; i<m_NumFibers; i++)
   {
 
     std::vector< vnl_vector_fixed< double, 3 > > vertices;
 
-#pragma omp critical
+    if (m_UseCompactStorage)
     {
+      m_CompactFibers.GetFiber(i, vertices);
+#pragma omp critical
       ++disp;
-      vtkCell* cell = m_FiberPolyData->GetCell(i);
-      int numPoints = cell->GetNumberOfPoints();
-      vtkPoints* points = cell->GetPoints();
-
-      for (int j=0; j<numPoints; j++)
+    }
+    else
+    {
+#pragma omp critical
       {
-        double cand[3];
-        points->GetPoint(j, cand);
-        vnl_vector_fixed< double, 3 > candV;
-        candV[0]=cand[0]; candV[1]=cand[1]; candV[2]=cand[2];
-        vertices.push_back(candV);
+        ++disp;
+        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        int numPoints = cell->GetNumberOfPoints();
+        vtkPoints* points = cell->GetPoints();
+
+        for (int j=0; j<numPoints; j++)
+        {
+          double cand[3];
+          points->GetPoint(j, cand);
+          vnl_vector_fixed< double, 3 > candV;
+          candV[0]=cand[0]; candV[1]=cand[1]; candV[2]=cand[2];
+          vertices.push_back(candV);
+        }
       }
     }
 
-    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    CompactFiberStorage::FiberType& container = resampled_streamlines[i];
     vnl_vector_fixed< double, 3 > lastV = vertices.at(0);
-
-#pragma omp critical
-    {
-      vtkIdType id = vtkNewPoints->InsertNextPoint(lastV.data_block());
-      container->GetPointIds()->InsertNextId(id);
-    }
+    container.push_back(lastV);
     for (unsigned int j=1; j<vertices.size(); j++)
     {
       vnl_vector_fixed< double, 3 > vec = vertices.at(j) - lastV;
@@ -2394,46 +2703,24 @@ void mitk::FiberBundle::ResampleLinear(double pointDistance)
           j--;
         }
 
-#pragma omp critical
-        {
-          vtkIdType id = vtkNewPoints->InsertNextPoint(newV.data_block());
-          container->GetPointIds()->InsertNextId(id);
-        }
+        container.push_back(newV);
         lastV = newV;
       }
       else if (j==vertices.size()-1 && new_dist>0.0001)
       {
-#pragma omp critical
-        {
-          vtkIdType id = vtkNewPoints->InsertNextPoint(vertices.at(j).data_block());
-          container->GetPointIds()->InsertNextId(id);
-        }
+        container.push_back(vertices.at(j));
       }
     }
-
-#pragma omp critical
-    {
-      resampled_streamlines[i] = container;
-    }
-  }
-
-  for (auto container : resampled_streamlines)
-  {
-    vtkNewCells->InsertNextCell(container);
   }
 
-  if (vtkNewCells->GetNumberOfCells()>0)
-  {
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
-  }
+  if (m_NumFibers>0)
+    this->SetFibers(resampled_streamlines);
 }
 
 // reapply selected colorcoding in case PolyData structure has changed
 bool mitk::FiberBundle::Equals(mitk::FiberBundle* fib, double eps)
 {
+  this->UpdateFiberPolyData();
   if (fib==nullptr)
   {
     MITK_INFO << "Reference bundle is nullptr!";
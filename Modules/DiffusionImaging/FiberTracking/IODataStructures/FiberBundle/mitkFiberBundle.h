@@ -26,6 +26,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkPlanarFigure.h>
 #include <mitkPixelTypeTraits.h>
 #include <mitkPlanarFigureComposite.h>
+#include <mitkCompactFiberStorage.h>
+#include <mitkFiberSpatialIndex.h>
 
 
 //includes storing fiberdata
@@ -36,6 +38,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkTransform.h>
 #include <vtkFloatArray.h>
 
+#include <memory>
+#include <mutex>
+#include <functional>
+
 
 namespace mitk {
 
@@ -116,7 +122,27 @@ public:
     void SetFiberWeight(unsigned int fiber, float weight);
     void SetFiberWeights(vtkSmartPointer<vtkFloatArray> weights);
     void SetFiberPolyData(vtkSmartPointer<vtkPolyData>, bool updateGeometry = true);
+    /** With the compact storage, the vtkPolyData is created on the first request and kept until ReleaseFiberPolyData() is called or the fibers change. Safe to call concurrently. */
     vtkSmartPointer<vtkPolyData> GetFiberPolyData() const;
+    /** Releases the vtkPolyData created from the compact storage, e.g. when the bundle is not displayed any more. Users still holding it keep it alive. Without the compact storage, the vtkPolyData is the fiber container and is kept. */
+    void ReleaseFiberPolyData();
+
+    /**
+     * \brief Keep the fibers in a CompactFiberStorage instead of a vtkPolyData.
+     *
+     * Transformations, resampling, compression and subset extraction then operate directly on the compact storage.
+     * The vtkPolyData is only created when it is requested, e.g. by a mapper, and released again when the fibers change
+     * or ReleaseFiberPolyData() is called.
+     */
+    void SetUseCompactStorage(bool useCompactStorage);
+    bool GetUseCompactStorage() const { return m_UseCompactStorage; }
+    /** Returns nullptr if the compact storage is not used. */
+    const CompactFiberStorage* GetCompactStorage() const { return m_UseCompactStorage ? &m_CompactFibers : nullptr; }
+    /** Switches to the compact storage and takes over the given fibers without copying them. The given storage is cleared. */
+    void SetCompactFibers(CompactFiberStorage& fibers);
+
+    /** Grid of the fiber segments used for ROI queries. It is built on first use and discarded when the fibers are modified. */
+    const FiberSpatialIndex* GetSpatialIndex() const;
     itkGetConstMacro( NumFibers, int)
     //itkGetMacro( FiberSampling, int)
     itkGetConstMacro( MinFiberLength, float )
@@ -148,18 +174,33 @@ protected:
     FiberBundle( vtkPolyData* fiberPolyData = nullptr );
     virtual ~FiberBundle();
 
-    void                            GenerateFiberIds();
+    void                            GenerateFiberIds() const;
     itk::Point<float, 3>            GetItkPoint(double point[3]);
     void                            UpdateFiberGeometry();
+    vtkSmartPointer<vtkPolyData>    UpdateFiberPolyData() const;
+    void                            CompactFibersModified(bool updateGeometry = true);
+    void                            TransformCompactFibers(const vnl_matrix_fixed< double, 3, 3 >& matrix, const vnl_vector_fixed< double, 3 >& offset);
+    void                            SetFibers(const CompactFiberStorage::FiberContainerType& fibers);
+    /** Returns the sorted ids of the fibers with a segment in the index cells overlapping the bounds for which intersects(p1, p2) is true. */
+    std::vector<long>               ExtractIntersectingFibers(const double bounds[6], const std::function< bool(double*, double*) >& intersects) const;
     virtual void                    PrintSelf(std::ostream &os, itk::Indent indent) const override;
 
 private:
 
-    // actual fiber container
-    vtkSmartPointer<vtkPolyData>  m_FiberPolyData;
+    // actual fiber container; created on demand from m_CompactFibers if the compact storage is used
+    mutable vtkSmartPointer<vtkPolyData>  m_FiberPolyData;
+    mutable bool                          m_FiberPolyDataOutdated;
 
     // contains fiber ids
-    vtkSmartPointer<vtkDataSet>   m_FiberIdDataSet;
+    mutable vtkSmartPointer<vtkDataSet>   m_FiberIdDataSet;
+
+    bool                  m_UseCompactStorage;
+    CompactFiberStorage   m_CompactFibers;
+
+    mutable std::unique_ptr< FiberSpatialIndex > m_SpatialIndex;
+
+    // guards the creation of m_FiberPolyData, m_FiberIdDataSet and m_SpatialIndex in const methods
+    mutable std::mutex    m_CacheMutex;
 
     int   m_NumFibers;
 
@@ -0,0 +1,177 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberSpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+  // upper limit of the grid size along each axis, which bounds the memory of the cell offsets
+  const int MaxCellsPerAxis = 128;
+  // average number of segments per cell aimed at by the automatic cell size
+  const double SegmentsPerCell = 8;
+  // number of fibers whose runs are collected in parallel before they are appended to the cell lists
+  const int FibersPerBlock = 65536;
+
+  typedef std::pair< unsigned int, mitk::FiberSpatialIndex::SegmentRun > CellRunType;
+}
+
+mitk::FiberSpatialIndex::FiberSpatialIndex(const CompactFiberStorage& fibers, double cellSize)
+  : m_NumFibers(fibers.GetNumberOfFibers())
+  , m_CellSize(cellSize)
+{
+  double b[6];
+  fibers.GetBounds(b);
+  if (fibers.GetNumberOfPoints()==0)
+    std::fill(b, b+6, 0.0);
+
+  double maxExtent = 0;
+  double volume = 1;
+  for (int a=0; a<3; ++a)
+  {
+    double extent = b[2*a+1]-b[2*a];
+    maxExtent = std::max(maxExtent, extent);
+    volume *= std::max(extent, 0.001);
+  }
+
+  if (m_CellSize<=0)
+  {
+    double numSegments = std::max(1.0, (double)(fibers.GetNumberOfPoints() - fibers.GetNumberOfFibers()));
+    m_CellSize = std::cbrt(volume*SegmentsPerCell/numSegments);
+  }
+  m_CellSize = std::max(m_CellSize, maxExtent/(MaxCellsPerAxis-1));
+  if (m_CellSize<=0)
+    m_CellSize = 1;
+
+  unsigned int numCells = 1;
+  for (int a=0; a<3; ++a)
+  {
+    m_Origin[a] = b[2*a];
+    m_Size[a] = std::min(MaxCellsPerAxis, (int)((b[2*a+1]-b[2*a])/m_CellSize)+1);
+    numCells *= m_Size[a];
+  }
+
+  const float* coords[3] = { fibers.GetX(), fibers.GetY(), fibers.GetZ() };
+  std::vector< CellRunType > cell_runs;
+
+  for (int block=0; block<(int)m_NumFibers; block+=FibersPerBlock)
+  {
+    int blockSize = std::min(FibersPerBlock, (int)m_NumFibers-block);
+    std::vector< std::vector< CellRunType > > block_runs(blockSize);
+
+#pragma omp parallel for
+    for (int f=0; f<blockSize; f++)
+    {
+      unsigned int fiber = block+f;
+      unsigned long first = fibers.GetFirstPoint(fiber);
+      unsigned long numPoints = fibers.GetNumberOfPoints(fiber);
+      if (numPoints==0)
+        continue;
+
+      // all (cell, segment) pairs of the fiber, sorted so that consecutive segments in the same cell can be merged
+      std::vector< std::pair< unsigned int, unsigned int > > cell_segments;
+      unsigned long numSegments = std::max(numPoints-1, 1ul);
+      for (unsigned long j=0; j<numSegments; ++j)
+      {
+        int lo[3], hi[3];
+        unsigned long p1 = first+j;
+        unsigned long p2 = first+std::min(j+1, numPoints-1);
+        for (int a=0; a<3; ++a)
+        {
+          float v1 = coords[a][p1];
+          float v2 = coords[a][p2];
+          lo[a] = std::max(0, std::min(m_Size[a]-1, (int)((std::min(v1, v2)-m_Origin[a])/m_CellSize)));
+          hi[a] = std::max(0, std::min(m_Size[a]-1, (int)((std::max(v1, v2)-m_Origin[a])/m_CellSize)));
+        }
+        for (int z=lo[2]; z<=hi[2]; ++z)
+          for (int y=lo[1]; y<=hi[1]; ++y)
+            for (int x=lo[0]; x<=hi[0]; ++x)
+              cell_segments.push_back(std::make_pair((unsigned int)(x + m_Size[0]*(y + m_Size[1]*z)), (unsigned int)j));
+      }
+      std::sort(cell_segments.begin(), cell_segments.end());
+
+      std::vector< CellRunType >& runs = block_runs[f];
+      for (const auto& cs : cell_segments)
+      {
+        if (!runs.empty() && runs.back().first==cs.first && runs.back().second.LastSegment+1==cs.second)
+          runs.back().second.LastSegment = cs.second;
+        else
+          runs.push_back(std::make_pair(cs.first, SegmentRun{fiber, cs.second, cs.second}));
+      }
+    }
+
+    for (auto& runs : block_runs)
+      cell_runs.insert(cell_runs.end(), runs.begin(), runs.end());
+  }
+
+  // counting sort by cell; within each cell the runs stay ordered by fiber
+  m_CellOffsets.assign(numCells+1, 0);
+  for (const auto& cr : cell_runs)
+    ++m_CellOffsets[cr.first+1];
+  for (unsigned int c=0; c<numCells; ++c)
+    m_CellOffsets[c+1] += m_CellOffsets[c];
+
+  m_Runs.resize(cell_runs.size());
+  std::vector< std::size_t > next(m_CellOffsets.begin(), m_CellOffsets.end()-1);
+  for (const auto& cr : cell_runs)
+    m_Runs[next[cr.first]++] = cr.second;
+}
+
+bool mitk::FiberSpatialIndex::GetCellRange(const double bounds[6], int first[3], int last[3]) const
+{
+  for (int a=0; a<3; ++a)
+  {
+    double lo = std::floor((bounds[2*a]-m_Origin[a])/m_CellSize);
+    double hi = std::floor((bounds[2*a+1]-m_Origin[a])/m_CellSize);
+    if (hi<0 || lo>=m_Size[a] || hi<lo)
+      return false;
+    first[a] = std::max(0.0, lo);
+    last[a] = std::min((double)m_Size[a]-1, hi);
+  }
+  return true;
+}
+
+void mitk::FiberSpatialIndex::GetSegmentRuns(const double bounds[6], std::vector< SegmentRun >& runs) const
+{
+  int first[3], last[3];
+  if (!GetCellRange(bounds, first, last))
+    return;
+
+  for (int z=first[2]; z<=last[2]; ++z)
+    for (int y=first[1]; y<=last[1]; ++y)
+      for (int x=first[0]; x<=last[0]; ++x)
+      {
+        unsigned int c = x + m_Size[0]*(y + m_Size[1]*z);
+        runs.insert(runs.end(), m_Runs.begin()+m_CellOffsets[c], m_Runs.begin()+m_CellOffsets[c+1]);
+      }
+}
+
+std::vector< long > mitk::FiberSpatialIndex::GetFibers(const double bounds[6]) const
+{
+  std::vector< SegmentRun > runs;
+  this->GetSegmentRuns(bounds, runs);
+
+  std::vector< long > ids;
+  ids.reserve(runs.size());
+  for (const SegmentRun& run : runs)
+    ids.push_back(run.Fiber);
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  return ids;
+}
@@ -0,0 +1,75 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_FiberSpatialIndex_H
+#define _MITK_FiberSpatialIndex_H
+
+#include <MitkFiberTrackingExports.h>
+#include <mitkCompactFiberStorage.h>
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Uniform grid over the fiber segments of a tractogram.
+  *
+  * Every grid cell lists the runs of consecutive segments of each fiber whose bounding boxes overlap the cell.
+  * Segment j of a fiber connects its points j and j+1; fibers consisting of a single point are stored as segment 0.
+  * Region queries only return the segments in the cells overlapping the query box, so exact intersection tests
+  * can be restricted to these candidates. The index does not keep a reference to the fibers and has to be
+  * rebuilt whenever they change.
+  */
+class MITKFIBERTRACKING_EXPORT FiberSpatialIndex
+{
+public:
+
+  struct SegmentRun
+  {
+    unsigned int Fiber;
+    unsigned int FirstSegment;
+    unsigned int LastSegment;
+  };
+
+  /** cellSize<=0 selects the cell size automatically from the bounds and the number of segments. */
+  FiberSpatialIndex(const CompactFiberStorage& fibers, double cellSize=0);
+
+  /** Appends the segment runs in all cells overlapping the bounds (xmin, xmax, ymin, ymax, zmin, zmax). Runs of the same fiber may overlap. */
+  void GetSegmentRuns(const double bounds[6], std::vector< SegmentRun >& runs) const;
+  /** Returns the sorted ids of all fibers with segments in cells overlapping the bounds. */
+  std::vector< long > GetFibers(const double bounds[6]) const;
+
+  unsigned long GetNumberOfFibers() const { return m_NumFibers; }
+  double GetCellSize() const { return m_CellSize; }
+  unsigned long GetNumberOfCells() const { return m_CellOffsets.size()-1; }
+  unsigned long GetNumberOfRuns() const { return m_Runs.size(); }
+
+private:
+
+  /** Computes the range of cells overlapped by the bounds; returns false if there is none. */
+  bool GetCellRange(const double bounds[6], int first[3], int last[3]) const;
+
+  unsigned long                   m_NumFibers;
+  double                          m_Origin[3];
+  double                          m_CellSize;
+  int                             m_Size[3];
+  std::vector< std::size_t >      m_CellOffsets;  ///< the runs of cell c are m_Runs[m_CellOffsets[c]] ... m_Runs[m_CellOffsets[c+1]-1]
+  std::vector< SegmentRun >       m_Runs;
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberSpatialIndex_H */
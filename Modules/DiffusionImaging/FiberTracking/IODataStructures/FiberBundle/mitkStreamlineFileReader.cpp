@@ -0,0 +1,333 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkStreamlineFileReader.h"
+
+#include <mitkExceptionMacro.h>
+#include <mitkGeometry3D.h>
+#include <itksys/SystemTools.hxx>
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+mitk::StreamlineFileReader::StreamlineFileReader()
+  : m_File(nullptr)
+  , m_IsTck(false)
+  , m_BufferSize(1<<23)
+  , m_BufferPos(0)
+  , m_BufferEnd(0)
+  , m_NumFibersInHeader(-1)
+  , m_FiberIndex(0)
+  , m_NumRead(0)
+  , m_NumSkipped(0)
+  , m_SubsamplingStep(1)
+  , m_MinLength(-1)
+  , m_MaxLength(-1)
+{
+  std::memset(&m_TrkHeader, 0, sizeof(m_TrkHeader));
+  m_Flip[0] = m_Flip[1] = m_Flip[2] = 1;
+}
+
+mitk::StreamlineFileReader::~StreamlineFileReader()
+{
+  this->Close();
+}
+
+void mitk::StreamlineFileReader::Open(const std::string& filename)
+{
+  this->Close();
+
+  std::string ext = itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(filename));
+  if (ext!=".trk" && ext!=".tck")
+    mitkThrow() << "Unsupported streamline file format: " << filename;
+
+  m_File = std::fopen(filename.c_str(), "rb");
+  if (m_File==nullptr)
+    mitkThrow() << "Unable to open file " << filename;
+
+  m_Filename = filename;
+  m_IsTck = ext==".tck";
+  m_Buffer.resize(std::max(m_BufferSize, 1024ul));
+  m_BufferPos = m_BufferEnd = 0;
+  m_FiberIndex = m_NumRead = m_NumSkipped = 0;
+
+  if (m_IsTck)
+    this->ParseTckHeader();
+  else
+    this->ParseTrkHeader();
+}
+
+void mitk::StreamlineFileReader::Close()
+{
+  if (m_File!=nullptr)
+    std::fclose(m_File);
+  m_File = nullptr;
+  m_Buffer.clear();
+  m_Buffer.shrink_to_fit();
+}
+
+bool mitk::StreamlineFileReader::ReadBytes(void* data, std::size_t numBytes)
+{
+  char* out = static_cast<char*>(data);
+  while (numBytes>0)
+  {
+    if (m_BufferPos==m_BufferEnd)
+    {
+      m_BufferPos = 0;
+      m_BufferEnd = std::fread(m_Buffer.data(), 1, m_Buffer.size(), m_File);
+      if (m_BufferEnd==0)
+        return false;
+    }
+    std::size_t n = std::min(numBytes, m_BufferEnd-m_BufferPos);
+    std::memcpy(out, m_Buffer.data()+m_BufferPos, n);
+    m_BufferPos += n;
+    out += n;
+    numBytes -= n;
+  }
+  return true;
+}
+
+void mitk::StreamlineFileReader::Seek(long offset)
+{
+  std::fseek(m_File, offset, SEEK_SET);
+  m_BufferPos = m_BufferEnd = 0;
+}
+
+void mitk::StreamlineFileReader::ParseTckHeader()
+{
+  std::string header;
+  char c;
+  while (header.size()<3 || header.compare(header.size()-3, 3, "END")!=0)
+  {
+    if (!this->ReadBytes(&c, 1))
+      mitkThrow() << "Incomplete header in " << m_Filename;
+    header += c;
+  }
+  MITK_INFO << "TCK Header:";
+  MITK_INFO << header;
+
+  long offset = -1;
+  std::string datatype = "Float32LE";
+  std::size_t pos = 0;
+  while (pos<header.size())
+  {
+    std::size_t end = header.find('\n', pos);
+    if (end==std::string::npos)
+      end = header.size();
+    std::string line = header.substr(pos, end-pos);
+    pos = end+1;
+
+    std::size_t colon = line.find(':');
+    if (colon==std::string::npos)
+      continue;
+    std::string key = line.substr(0, colon);
+    std::string value = line.substr(colon+1);
+    value.erase(0, value.find_first_not_of(" \t"));
+    value.erase(value.find_last_not_of(" \t\r")+1);
+
+    try
+    {
+      if (key=="file")
+        offset = boost::lexical_cast<long>(value.substr(value.find_last_of(' ')+1));
+      else if (key=="count")
+        m_NumFibersInHeader = boost::lexical_cast<long>(value);
+      else if (key=="datatype")
+        datatype = value;
+    }
+    catch(...)
+    {
+
+    }
+  }
+
+  if (offset<0)
+    mitkThrow() << "Could not parse header size from " << m_Filename;
+  if (datatype!="Float32LE")
+    mitkThrow() << "Unsupported tck datatype " << datatype;
+
+  // MRtrix uses RAS coordinates
+  m_Flip[0] = -1;
+  m_Flip[1] = -1;
+  m_Flip[2] = 1;
+  this->Seek(offset);
+}
+
+void mitk::StreamlineFileReader::ParseTrkHeader()
+{
+  if (!this->ReadBytes(&m_TrkHeader, 1000) || std::strncmp(m_TrkHeader.id_string, "TRACK", 5)!=0)
+    mitkThrow() << "Invalid TrackVis header in " << m_Filename;
+  if (m_TrkHeader.n_scalars<0 || m_TrkHeader.n_properties<0)
+    mitkThrow() << "Invalid number of scalars or properties in " << m_Filename;
+
+  m_NumFibersInHeader = m_TrkHeader.n_count>0 ? m_TrkHeader.n_count : -1;
+  m_Flip[0] = m_TrkHeader.voxel_order[0]=='R' ? -1 : 1;
+  m_Flip[1] = m_TrkHeader.voxel_order[1]=='A' ? -1 : 1;
+  m_Flip[2] = m_TrkHeader.voxel_order[2]=='I' ? -1 : 1;
+}
+
+mitk::BaseGeometry::Pointer mitk::StreamlineFileReader::GetReferenceGeometry() const
+{
+  const TrackVis_header& h = m_TrkHeader;
+  if (m_IsTck || !(h.voxel_size[0]>0 && h.voxel_size[1]>0 && h.voxel_size[2]>0 && h.dim[0]>0 && h.dim[1]>0 && h.dim[2]>0))
+    return nullptr;
+
+  mitk::Geometry3D::Pointer geometry = mitk::Geometry3D::New();
+  vtkSmartPointer< vtkMatrix4x4 > matrix = vtkSmartPointer< vtkMatrix4x4 >::New();
+  matrix->Identity();
+  for (int i=0; i<3; ++i)
+    matrix->SetElement(i, i, m_Flip[i]);
+  geometry->SetIndexToWorldTransformByVtkMatrix(matrix);
+
+  mitk::Point3D origin;
+  mitk::Vector3D spacing;
+  for (int i=0; i<3; ++i)
+  {
+    origin[i] = h.origin[i];
+    spacing[i] = h.voxel_size[i];
+  }
+  geometry->SetOrigin(origin);
+  geometry->SetSpacing(spacing);
+  for (int i=0; i<3; ++i)
+    geometry->SetExtentInMM(i, h.voxel_size[i]*h.dim[i]);
+  return geometry.GetPointer();
+}
+
+bool mitk::StreamlineFileReader::ReadNextTckFiber()
+{
+  m_Points.clear();
+  float p[3];
+  while (this->ReadBytes(p, 12))
+  {
+    if (std::isinf(p[0]) || std::isinf(p[1]) || std::isinf(p[2]))
+      break;
+    if (std::isnan(p[0]) || std::isnan(p[1]) || std::isnan(p[2]))
+    {
+      // empty streamlines (consecutive separators) are skipped
+      if (m_Points.empty())
+        continue;
+      return true;
+    }
+    m_Points.insert(m_Points.end(), p, p+3);
+  }
+
+  // an unterminated streamline at the end of the file is kept
+  return !m_Points.empty();
+}
+
+bool mitk::StreamlineFileReader::ReadNextTrkFiber()
+{
+  int numPoints = 0;
+  if (!this->ReadBytes(&numPoints, 4))
+    return false;
+  if (numPoints<=0)
+    mitkThrow() << "Trying to read a fiber with " << numPoints << " points from " << m_Filename;
+
+  // each point is followed by its scalars, each streamline by its properties
+  int valuesPerPoint = 3 + m_TrkHeader.n_scalars;
+  m_TrkValues.resize((std::size_t)numPoints*valuesPerPoint + m_TrkHeader.n_properties);
+  if (!this->ReadBytes(m_TrkValues.data(), 4*m_TrkValues.size()))
+    mitkThrow() << "Unexpected end of file " << m_Filename;
+
+  m_Points.resize(3*(std::size_t)numPoints);
+  for (int j=0; j<numPoints; ++j)
+    for (int a=0; a<3; ++a)
+      m_Points[3*j+a] = m_TrkValues[j*valuesPerPoint+a];
+  return true;
+}
+
+bool mitk::StreamlineFileReader::ReadNextFiber()
+{
+  if (m_File==nullptr)
+    return false;
+  bool read = m_IsTck ? this->ReadNextTckFiber() : this->ReadNextTrkFiber();
+  if (!read)
+    return false;
+
+  for (std::size_t k=0; k<m_Points.size(); k+=3)
+  {
+    m_Points[k] *= m_Flip[0];
+    m_Points[k+1] *= m_Flip[1];
+    m_Points[k+2] *= m_Flip[2];
+  }
+  return true;
+}
+
+bool mitk::StreamlineFileReader::AcceptFiber()
+{
+  bool accept = (m_FiberIndex++ % m_SubsamplingStep)==0;
+  unsigned long numPoints = m_Points.size()/3;
+
+  if (accept && (m_MinLength>=0 || m_MaxLength>=0))
+  {
+    double length = 0;
+    for (unsigned long j=1; j<numPoints; ++j)
+    {
+      double dx = m_Points[3*j]-m_Points[3*j-3];
+      double dy = m_Points[3*j+1]-m_Points[3*j-2];
+      double dz = m_Points[3*j+2]-m_Points[3*j-1];
+      length += std::sqrt(dx*dx + dy*dy + dz*dz);
+    }
+    accept = (m_MinLength<0 || length>=m_MinLength) && (m_MaxLength<0 || length<=m_MaxLength);
+  }
+
+  if (accept && m_Filter)
+    accept = m_Filter(m_Points.data(), numPoints);
+
+  if (accept)
+    ++m_NumRead;
+  else
+    ++m_NumSkipped;
+  return accept;
+}
+
+bool mitk::StreamlineFileReader::ReadChunk(CompactFiberStorage& chunk, unsigned long maxPoints)
+{
+  chunk.Clear();
+  while (chunk.GetNumberOfPoints()<maxPoints && this->ReadNextFiber())
+  {
+    if (this->AcceptFiber())
+      chunk.AddFiber(m_Points.data(), m_Points.size()/3);
+  }
+  return chunk.GetNumberOfFibers()>0;
+}
+
+void mitk::StreamlineFileReader::ReadAll(CompactFiberStorage& fibers)
+{
+  while (this->ReadNextFiber())
+  {
+    if (this->AcceptFiber())
+      fibers.AddFiber(m_Points.data(), m_Points.size()/3);
+  }
+}
+
+mitk::FiberBundle::Pointer mitk::StreamlineFileReader::ReadFiberBundle(bool useCompactStorage)
+{
+  CompactFiberStorage fibers;
+  if (m_NumFibersInHeader>0)
+    MITK_INFO << "Reading " << m_NumFibersInHeader/m_SubsamplingStep << " of " << m_NumFibersInHeader << " streamlines";
+  this->ReadAll(fibers);
+
+  FiberBundle::Pointer fib = FiberBundle::New();
+  fib->SetCompactFibers(fibers);
+  fib->SetUseCompactStorage(useCompactStorage);
+  BaseGeometry::Pointer geometry = this->GetReferenceGeometry();
+  if (geometry.IsNotNull())
+    fib->SetReferenceGeometry(geometry);
+  return fib;
+}
@@ -0,0 +1,117 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_StreamlineFileReader_H
+#define _MITK_StreamlineFileReader_H
+
+#include <MitkFiberTrackingExports.h>
+#include <mitkCompactFiberStorage.h>
+#include <mitkFiberBundle.h>
+#include <mitkBaseGeometry.h>
+#include <mitkTrackvis.h>
+#include <functional>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Reads TrackVis (.trk) and MRtrix (.tck) tractograms streamline by streamline.
+  *
+  * The file is read sequentially through a fixed size buffer and the streamlines are returned in chunks of
+  * a bounded number of points, so tractograms larger than the available memory can be processed.
+  * Streamlines can be subsampled and filtered while reading; rejected streamlines are never stored.
+  * All coordinates are returned in LPS (MITK) space.
+  */
+class MITKFIBERTRACKING_EXPORT StreamlineFileReader
+{
+public:
+
+  /** Receives the interleaved xyz coordinates of a streamline; returns false to discard it. */
+  typedef std::function< bool(const float* points, unsigned long numPoints) > FilterType;
+
+  StreamlineFileReader();
+  ~StreamlineFileReader();
+
+  /** Opens the file and parses its header. The format is selected by the file extension. */
+  void Open(const std::string& filename);
+  void Close();
+
+  void SetBufferSize(unsigned long bytes) { m_BufferSize = bytes; }
+  /** Only every n-th streamline of the file is read (default 1: all streamlines). */
+  void SetSubsamplingStep(unsigned long step) { m_SubsamplingStep = step>0 ? step : 1; }
+  /** Streamlines shorter than minLength or longer than maxLength (in mm) are skipped. Negative values disable the check. */
+  void SetMinLength(float minLength) { m_MinLength = minLength; }
+  void SetMaxLength(float maxLength) { m_MaxLength = maxLength; }
+  void SetFilter(FilterType filter) { m_Filter = filter; }
+
+  /** Replaces the content of chunk with the next streamlines, stopping as soon as it holds at least maxPoints points. Returns false if the file contains no further streamlines. */
+  bool ReadChunk(CompactFiberStorage& chunk, unsigned long maxPoints = 1<<22);
+  /** Appends all remaining streamlines to fibers. */
+  void ReadAll(CompactFiberStorage& fibers);
+  /** Reads all remaining streamlines into a fiber bundle. Without the compact storage, its vtkPolyData is created once all streamlines are read. */
+  FiberBundle::Pointer ReadFiberBundle(bool useCompactStorage = true);
+
+  /** Number of streamlines according to the file header, -1 if unknown. */
+  long GetNumberOfFibersInHeader() const { return m_NumFibersInHeader; }
+  unsigned long GetNumberOfReadFibers() const { return m_NumRead; }
+  unsigned long GetNumberOfSkippedFibers() const { return m_NumSkipped; }
+
+  /** Image geometry stored in the TrackVis header; nullptr for .tck files or incomplete headers. */
+  BaseGeometry::Pointer GetReferenceGeometry() const;
+
+private:
+
+  bool ReadBytes(void* data, std::size_t numBytes);
+  void Seek(long offset);
+  void ParseTckHeader();
+  void ParseTrkHeader();
+  /** Reads the next streamline of the file into m_Points; returns false at the end of the file. */
+  bool ReadNextFiber();
+  bool ReadNextTckFiber();
+  bool ReadNextTrkFiber();
+  /** Applies subsampling, length criteria and the filter to the streamline in m_Points. */
+  bool AcceptFiber();
+
+  std::FILE*            m_File;
+  std::string           m_Filename;
+  bool                  m_IsTck;
+  TrackVis_header       m_TrkHeader;
+  float                 m_Flip[3];    ///< signs converting the file coordinates to LPS
+
+  std::vector< char >   m_Buffer;
+  unsigned long         m_BufferSize;
+  std::size_t           m_BufferPos;
+  std::size_t           m_BufferEnd;
+
+  std::vector< float >  m_Points;
+  std::vector< float >  m_TrkValues;
+  long                  m_NumFibersInHeader;
+  unsigned long         m_FiberIndex;
+  unsigned long         m_NumRead;
+  unsigned long         m_NumSkipped;
+
+  unsigned long         m_SubsamplingStep;
+  float                 m_MinLength;
+  float                 m_MaxLength;
+  FilterType            m_Filter;
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_StreamlineFileReader_H */
@@ -0,0 +1,229 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkStreamlineFileWriter.h"
+
+#include <mitkExceptionMacro.h>
+#include <itksys/SystemTools.hxx>
+#include <vtkPolyData.h>
+#include <vtkCellArray.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+  // the number of streamlines is written with a fixed width so that it can be updated in place
+  const int TckCountWidth = 10;
+}
+
+mitk::StreamlineFileWriter::StreamlineFileWriter()
+  : m_File(nullptr)
+  , m_IsTck(false)
+  , m_CountOffset(0)
+  , m_NumWritten(0)
+{
+  m_Flip[0] = m_Flip[1] = m_Flip[2] = 1;
+}
+
+mitk::StreamlineFileWriter::~StreamlineFileWriter()
+{
+  try
+  {
+    this->Close();
+  }
+  catch(...)
+  {
+
+  }
+}
+
+void mitk::StreamlineFileWriter::Write(const void* data, std::size_t numBytes)
+{
+  if (std::fwrite(data, 1, numBytes, m_File)!=numBytes)
+    mitkThrow() << "Error writing " << m_Filename;
+}
+
+void mitk::StreamlineFileWriter::Open(const std::string& filename, const BaseGeometry* geometry, bool lps)
+{
+  this->Close();
+
+  std::string ext = itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(filename));
+  if (ext!=".trk" && ext!=".tck")
+    mitkThrow() << "Unsupported streamline file format: " << filename;
+
+  m_File = std::fopen(filename.c_str(), "w+b");
+  if (m_File==nullptr)
+    mitkThrow() << "Unable to create file " << filename;
+  std::setvbuf(m_File, nullptr, _IOFBF, 1<<22);
+
+  m_Filename = filename;
+  m_IsTck = ext==".tck";
+  m_NumWritten = 0;
+
+  if (m_IsTck)
+  {
+    // MRtrix uses RAS coordinates
+    m_Flip[0] = -1;
+    m_Flip[1] = -1;
+    m_Flip[2] = 1;
+
+    std::string header = "mrtrix tracks\ncount: " + std::string(TckCountWidth, '0') + "\ndatatype: Float32LE\n";
+    m_CountOffset = header.find("count: ") + 7;
+
+    // the data offset is part of the header, so its length is determined iteratively
+    std::size_t offset = header.size();
+    std::string fileLine = "file: . " + std::to_string(offset) + "\nEND\n";
+    while (header.size() + fileLine.size() != offset)
+    {
+      offset = header.size() + fileLine.size();
+      fileLine = "file: . " + std::to_string(offset) + "\nEND\n";
+    }
+    header += fileLine;
+    this->Write(header.data(), header.size());
+  }
+  else
+  {
+    m_Flip[0] = lps ? 1 : -1;
+    m_Flip[1] = lps ? 1 : -1;
+    m_Flip[2] = 1;
+
+    TrackVis_header h;
+    std::memset(&h, 0, sizeof(h));
+    std::strcpy(h.id_string, "TRACK");
+    if (geometry!=nullptr)
+    {
+      for (int i=0; i<3; ++i)
+      {
+        h.dim[i] = geometry->GetExtent(i);
+        h.voxel_size[i] = geometry->GetSpacing()[i];
+        h.origin[i] = geometry->GetOrigin()[i];
+      }
+    }
+    std::strcpy(h.voxel_order, lps ? "LPS" : "RAS");
+    h.image_orientation_patient[0] = 1.0;
+    h.image_orientation_patient[4] = 1.0;
+    h.version = 1;
+    h.hdr_size = 1000;
+    m_CountOffset = 1000-12;
+    this->Write(&h, 1000);
+  }
+}
+
+void mitk::StreamlineFileWriter::AppendFiber(const float* points, unsigned long numPoints)
+{
+  if (m_File==nullptr)
+    mitkThrow() << "No streamline file opened.";
+
+  m_Points.resize(3*numPoints);
+  for (unsigned long k=0; k<3*numPoints; k+=3)
+  {
+    m_Points[k] = points[k]*m_Flip[0];
+    m_Points[k+1] = points[k+1]*m_Flip[1];
+    m_Points[k+2] = points[k+2]*m_Flip[2];
+  }
+
+  if (m_IsTck)
+  {
+    m_Points.resize(m_Points.size()+3, std::numeric_limits<float>::quiet_NaN());
+    this->Write(m_Points.data(), 4*m_Points.size());
+  }
+  else
+  {
+    int n = numPoints;
+    this->Write(&n, 4);
+    this->Write(m_Points.data(), 4*m_Points.size());
+  }
+  ++m_NumWritten;
+}
+
+void mitk::StreamlineFileWriter::Append(const CompactFiberStorage& fibers)
+{
+  std::vector< float > points;
+  for (unsigned long i=0; i<fibers.GetNumberOfFibers(); ++i)
+  {
+    unsigned long first = fibers.GetFirstPoint(i);
+    unsigned long numPoints = fibers.GetNumberOfPoints(i);
+    points.resize(3*numPoints);
+    for (unsigned long j=0; j<numPoints; ++j)
+    {
+      points[3*j] = fibers.GetX()[first+j];
+      points[3*j+1] = fibers.GetY()[first+j];
+      points[3*j+2] = fibers.GetZ()[first+j];
+    }
+    this->AppendFiber(points.data(), numPoints);
+  }
+}
+
+void mitk::StreamlineFileWriter::Append(const FiberBundle* fib)
+{
+  if (fib->GetCompactStorage()!=nullptr)
+  {
+    this->Append(*fib->GetCompactStorage());
+    return;
+  }
+
+  vtkSmartPointer<vtkPolyData> polyData = fib->GetFiberPolyData();
+  std::vector< float > points;
+  for (int i=0; i<fib->GetNumFibers(); ++i)
+  {
+    vtkIdType numPoints = 0;
+    vtkIdType* ids = nullptr;
+    polyData->GetCellPoints(i, numPoints, ids);
+    points.resize(3*numPoints);
+    for (vtkIdType j=0; j<numPoints; ++j)
+    {
+      double p[3];
+      polyData->GetPoint(ids[j], p);
+      points[3*j] = p[0];
+      points[3*j+1] = p[1];
+      points[3*j+2] = p[2];
+    }
+    this->AppendFiber(points.data(), numPoints);
+  }
+}
+
+void mitk::StreamlineFileWriter::Close()
+{
+  if (m_File==nullptr)
+    return;
+
+  std::FILE* file = m_File;
+  m_File = nullptr;
+  if (m_IsTck)
+  {
+    float end[3] = { std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() };
+    std::fwrite(end, 4, 3, file);
+
+    std::ostringstream count;
+    count.width(TckCountWidth);
+    count.fill('0');
+    count << m_NumWritten;
+    std::fseek(file, m_CountOffset, SEEK_SET);
+    std::fwrite(count.str().data(), 1, TckCountWidth, file);
+  }
+  else
+  {
+    int count = (int)std::min(m_NumWritten, (unsigned long)INT_MAX);
+    std::fseek(file, m_CountOffset, SEEK_SET);
+    std::fwrite(&count, 4, 1, file);
+  }
+  std::fclose(file);
+  m_Points.clear();
+  m_Points.shrink_to_fit();
+}
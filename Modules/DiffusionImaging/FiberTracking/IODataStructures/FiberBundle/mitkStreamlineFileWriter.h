@@ -0,0 +1,75 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_StreamlineFileWriter_H
+#define _MITK_StreamlineFileWriter_H
+
+#include <MitkFiberTrackingExports.h>
+#include <mitkCompactFiberStorage.h>
+#include <mitkFiberBundle.h>
+#include <mitkTrackvis.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Writes TrackVis (.trk) and MRtrix (.tck) tractograms incrementally.
+  *
+  * The header is written on Open() and the streamlines are appended in any number of chunks. Close() completes
+  * the file and updates the number of streamlines in the header. Only one streamline at a time is converted,
+  * so the memory needed does not depend on the size of the tractogram. Input coordinates are in LPS (MITK) space.
+  */
+class MITKFIBERTRACKING_EXPORT StreamlineFileWriter
+{
+public:
+
+  StreamlineFileWriter();
+  ~StreamlineFileWriter();
+
+  /**
+    * Creates the file; the format is selected by the file extension. The geometry is stored in the TrackVis header.
+    * TrackVis files are written in LPS or RAS space, MRtrix files always use RAS.
+    */
+  void Open(const std::string& filename, const BaseGeometry* geometry = nullptr, bool lps = true);
+  /** Finishes the file. Called automatically on destruction. */
+  void Close();
+
+  void Append(const CompactFiberStorage& fibers);
+  void Append(const FiberBundle* fib);
+  /** Appends a streamline given by numPoints interleaved xyz coordinates. */
+  void AppendFiber(const float* points, unsigned long numPoints);
+
+  unsigned long GetNumberOfWrittenFibers() const { return m_NumWritten; }
+
+private:
+
+  void Write(const void* data, std::size_t numBytes);
+
+  std::FILE*            m_File;
+  std::string           m_Filename;
+  bool                  m_IsTck;
+  float                 m_Flip[3];      ///< signs converting LPS to the file coordinates
+  long                  m_CountOffset;  ///< file position of the number of streamlines in the header
+  unsigned long         m_NumWritten;
+  std::vector< float >  m_Points;
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_StreamlineFileWriter_H */
@@ -20,6 +20,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itksys/SystemTools.hxx>
 #include <mitkTestingConfig.h>
 #include <mitkIOUtil.h>
+#include <mitkStreamlineFileReader.h>
+#include <mitkStreamlineFileWriter.h>
+#include <mitkTrackvis.h>
+#include <algorithm>
+#include <fstream>
 
 #include "mitkTestFixture.h"
 
@@ -28,6 +33,10 @@ class mitkFiberBundleReaderWriterTestSuite : public mitk::TestFixture
 
   CPPUNIT_TEST_SUITE(mitkFiberBundleReaderWriterTestSuite);
   MITK_TEST(Equal_SaveLoad_ReturnsTrue);
+  MITK_TEST(Equal_TrkRoundTrip_ReturnsTrue);
+  MITK_TEST(Equal_TckRoundTrip_ReturnsTrue);
+  MITK_TEST(Equal_TrackVisFiberReader_ReturnsTrue);
+  MITK_TEST(Equal_SubsamplingAndLengthFilter_ReturnsTrue);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -35,6 +44,59 @@ private:
   /** Members used inside the different (sub-)tests. All members are initialized via setUp().*/
   mitk::FiberBundle::Pointer fib1;
   mitk::FiberBundle::Pointer fib2;
+  mitk::CompactFiberStorage reference;
+
+  std::string GetOutputFile(const std::string& name)
+  {
+    return std::string(MITK_TEST_OUTPUT_DIR)+"/"+name;
+  }
+
+  /** Reads the first point of the first streamline directly from the file. */
+  void ReadFirstPoint(const std::string& filename, bool tck, float point[3])
+  {
+    std::ifstream file(filename, std::ios::binary);
+    std::streamoff offset = 1000+4;
+    if (tck)
+    {
+      std::string line;
+      while (std::getline(file, line) && line!="END")
+        if (line.compare(0, 8, "file: . ")==0)
+          offset = std::stol(line.substr(8));
+    }
+    file.seekg(offset);
+    file.read(reinterpret_cast<char*>(point), 12);
+    CPPUNIT_ASSERT_MESSAGE("First point read from "+filename, file.good());
+  }
+
+  /** Checks that the first point in the file is the first reference point multiplied by the flip signs. */
+  void CheckFirstPoint(const std::string& filename, bool tck, float flipX, float flipY)
+  {
+    float point[3];
+    ReadFirstPoint(filename, tck, point);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("x coordinate in file", flipX*reference.GetX()[0], point[0], 0.0001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("y coordinate in file", flipY*reference.GetY()[0], point[1], 0.0001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("z coordinate in file", reference.GetZ()[0], point[2], 0.0001);
+  }
+
+  /** Creates a fiber bundle of the reference fibers with the given indices. */
+  mitk::FiberBundle::Pointer GetReferenceFibers(const std::vector< long >& fiberIds)
+  {
+    mitk::CompactFiberStorage fibers;
+    fibers.SetFibers(reference, fiberIds);
+    mitk::FiberBundle::Pointer fib = mitk::FiberBundle::New();
+    fib->SetCompactFibers(fibers);
+    return fib;
+  }
+
+  /** A length between two fiber lengths at about the given quantile, away from both. */
+  float GetLengthThreshold(std::vector< float > lengths, float quantile)
+  {
+    std::sort(lengths.begin(), lengths.end());
+    std::size_t i = quantile*(lengths.size()-1);
+    while (i+2<lengths.size() && lengths[i+1]-lengths[i]<0.01)
+      ++i;
+    return 0.5*(lengths[i]+lengths[i+1]);
+  }
 
 public:
 
@@ -49,6 +111,7 @@ public:
     mitk::BaseData::Pointer baseData = fibInfile.at(0);
 
     fib1 = dynamic_cast<mitk::FiberBundle*>(baseData.GetPointer());
+    reference.SetPolyData(fib1->GetFiberPolyData());
   }
 
   void tearDown() override
@@ -66,6 +129,140 @@ public:
     //MITK_ASSERT_EQUAL(fib1, fib2, "A saved and re-loaded file should be equal");
   }
 
+  void Equal_TrkRoundTrip_ReturnsTrue()
+  {
+    for (bool lps : { true, false })
+    {
+      std::string filename = GetOutputFile(lps ? "writerTestLPS.trk" : "writerTestRAS.trk");
+      mitk::StreamlineFileWriter writer;
+      writer.Open(filename, fib1->GetGeometry(), lps);
+      writer.Append(fib1.GetPointer());
+      writer.Close();
+      CPPUNIT_ASSERT_EQUAL((unsigned long)fib1->GetNumFibers(), writer.GetNumberOfWrittenFibers());
+
+      // RAS files store -x and -y
+      CheckFirstPoint(filename, false, lps ? 1 : -1, lps ? 1 : -1);
+
+      mitk::StreamlineFileReader reader;
+      reader.Open(filename);
+      CPPUNIT_ASSERT_EQUAL((long)fib1->GetNumFibers(), reader.GetNumberOfFibersInHeader());
+      fib2 = reader.ReadFiberBundle();
+      CPPUNIT_ASSERT_MESSAGE("Should be equal", fib1->Equals(fib2));
+      CPPUNIT_ASSERT_EQUAL((unsigned long)fib1->GetNumFibers(), reader.GetNumberOfReadFibers());
+      CPPUNIT_ASSERT_EQUAL(0ul, reader.GetNumberOfSkippedFibers());
+
+      // the fiber bundle reader
+      fib2 = dynamic_cast<mitk::FiberBundle*>(mitk::IOUtil::Load(filename).at(0).GetPointer());
+      CPPUNIT_ASSERT_MESSAGE("Should be equal", fib1->Equals(fib2));
+    }
+  }
+
+  void Equal_TckRoundTrip_ReturnsTrue()
+  {
+    std::string filename = GetOutputFile("writerTest.tck");
+    mitk::StreamlineFileWriter writer;
+    writer.Open(filename);
+    writer.Append(fib1.GetPointer());
+    writer.Close();
+
+    // MRtrix files are in RAS space
+    CheckFirstPoint(filename, true, -1, -1);
+
+    mitk::StreamlineFileReader reader;
+    reader.Open(filename);
+    CPPUNIT_ASSERT_EQUAL((long)fib1->GetNumFibers(), reader.GetNumberOfFibersInHeader());
+    fib2 = reader.ReadFiberBundle(false);
+    CPPUNIT_ASSERT_MESSAGE("Should be equal", fib1->Equals(fib2));
+    CPPUNIT_ASSERT_EQUAL(0ul, reader.GetNumberOfSkippedFibers());
+
+    // the fiber bundle reader
+    fib2 = dynamic_cast<mitk::FiberBundle*>(mitk::IOUtil::Load(filename).at(0).GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Should be equal", fib1->Equals(fib2));
+  }
+
+  void Equal_TrackVisFiberReader_ReturnsTrue()
+  {
+    // files of the new writer are read by the previous TrackVis implementation, in LPS and RAS space
+    for (bool lps : { true, false })
+    {
+      std::string filename = GetOutputFile("writerTestTrackVis.trk");
+      mitk::StreamlineFileWriter writer;
+      writer.Open(filename, fib1->GetGeometry(), lps);
+      writer.Append(fib1.GetPointer());
+      writer.Close();
+
+      TrackVisFiberReader trk;
+      trk.open(filename);
+      fib2 = mitk::FiberBundle::New();
+      trk.read(fib2);
+      trk.close();
+      CPPUNIT_ASSERT_MESSAGE("Should be equal", fib1->Equals(fib2));
+    }
+
+    // files of the previous TrackVis implementation are read by the new reader
+    std::string filename = GetOutputFile("writerTestTrackVisOld.trk");
+    TrackVisFiberReader trk;
+    trk.create(filename, fib1.GetPointer(), true);
+    trk.writeHdr();
+    trk.append(fib1.GetPointer());
+    trk.close();
+
+    mitk::StreamlineFileReader reader;
+    reader.Open(filename);
+    fib2 = reader.ReadFiberBundle();
+    CPPUNIT_ASSERT_MESSAGE("Should be equal", fib1->Equals(fib2));
+  }
+
+  void Equal_SubsamplingAndLengthFilter_ReturnsTrue()
+  {
+    std::vector< float > lengths = reference.GetFiberLengths();
+    float minLength = GetLengthThreshold(lengths, 0.25);
+    float maxLength = GetLengthThreshold(lengths, 0.75);
+    const unsigned long step = 3;
+
+    std::vector< long > fiberIds;
+    for (unsigned long i=0; i<lengths.size(); i+=step)
+      if (lengths[i]>=minLength && lengths[i]<=maxLength)
+        fiberIds.push_back(i);
+    CPPUNIT_ASSERT_MESSAGE("Some fibers are filtered", !fiberIds.empty() && fiberIds.size()<(lengths.size()+step-1)/step);
+    mitk::FiberBundle::Pointer expected = GetReferenceFibers(fiberIds);
+
+    for (std::string name : { "filterTest.trk", "filterTest.tck" })
+    {
+      std::string filename = GetOutputFile(name);
+      mitk::StreamlineFileWriter writer;
+      writer.Open(filename, fib1->GetGeometry());
+      writer.Append(fib1.GetPointer());
+      writer.Close();
+
+      mitk::StreamlineFileReader reader;
+      reader.SetSubsamplingStep(step);
+      reader.SetMinLength(minLength);
+      reader.SetMaxLength(maxLength);
+      reader.SetBufferSize(4096);
+      reader.Open(filename);
+
+      // small chunks
+      mitk::CompactFiberStorage fibers;
+      mitk::CompactFiberStorage chunk;
+      std::vector< float > points;
+      while (reader.ReadChunk(chunk, 100))
+        for (unsigned long i=0; i<chunk.GetNumberOfFibers(); ++i)
+        {
+          points.clear();
+          for (unsigned long j=chunk.GetFirstPoint(i); j<chunk.GetFirstPoint(i+1); ++j)
+            points.insert(points.end(), { chunk.GetX()[j], chunk.GetY()[j], chunk.GetZ()[j] });
+          fibers.AddFiber(points.data(), chunk.GetNumberOfPoints(i));
+        }
+
+      fib2 = mitk::FiberBundle::New();
+      fib2->SetCompactFibers(fibers);
+      CPPUNIT_ASSERT_MESSAGE("Should be equal", expected->Equals(fib2));
+      CPPUNIT_ASSERT_EQUAL((unsigned long)fiberIds.size(), reader.GetNumberOfReadFibers());
+      CPPUNIT_ASSERT_EQUAL(lengths.size()-fiberIds.size(), (std::size_t)reader.GetNumberOfSkippedFibers());
+    }
+  }
+
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkFiberBundleReaderWriter)
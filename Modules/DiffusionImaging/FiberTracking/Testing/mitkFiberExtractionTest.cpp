@@ -83,6 +83,12 @@ int mitkFiberExtractionTest(int argc, char* argv[])
     MITK_INFO << "TEST2";
     MITK_TEST_CONDITION_REQUIRED(extractedFibs->Equals(testFibs),"check planar figure extraction");
 
+    mitk::FiberBundle::Pointer compactFibs = groundTruthFibs->GetDeepCopy();
+    compactFibs->SetUseCompactStorage(true);
+    mitk::FiberBundle::Pointer compactExtractedFibs = compactFibs->ExtractFiberSubset(pfcNode2, storage);
+    MITK_TEST_CONDITION_REQUIRED(compactExtractedFibs->GetUseCompactStorage(),"check planar figure extraction keeps compact storage");
+    MITK_TEST_CONDITION_REQUIRED(compactExtractedFibs->Equals(testFibs),"check planar figure extraction with compact storage");
+
     MITK_INFO << "TEST3";
     // test subtraction and addition
     mitk::FiberBundle::Pointer notExtractedFibs = groundTruthFibs->SubtractBundle(extractedFibs);
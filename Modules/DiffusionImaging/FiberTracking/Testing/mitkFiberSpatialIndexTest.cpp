@@ -0,0 +1,238 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkFiberBundle.h>
+#include <mitkFiberSpatialIndex.h>
+#include <mitkPlanarCircle.h>
+#include <mitkPlanarPolygon.h>
+#include <mitkPlaneGeometry.h>
+#include <mitkStandaloneDataStorage.h>
+#include <vtkCellArray.h>
+#include <vtkPolyLine.h>
+#include <vtkPlane.h>
+#include <vtkPolygon.h>
+#include <itksys/SystemTools.hxx>
+#include <random>
+#include "mitkTestFixture.h"
+
+class mitkFiberSpatialIndexTestSuite : public mitk::TestFixture
+{
+
+    CPPUNIT_TEST_SUITE(mitkFiberSpatialIndexTestSuite);
+    MITK_TEST(Test1);
+    MITK_TEST(Test2);
+    MITK_TEST(Test3);
+    MITK_TEST(Test4);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    /** Members used inside the different (sub-)tests. All members are initialized via setUp().*/
+    mitk::StandaloneDataStorage::Pointer  storage;
+    mitk::DataNode::Pointer               circleNode;
+    mitk::DataNode::Pointer               polygonNode;
+
+    /** Random walks through the volume [0,100]^3 that mostly run along the z-axis and cross the plane z=50. */
+    mitk::FiberBundle::Pointer CreateFibers(int numFibers, int numPoints)
+    {
+        std::mt19937 randGen(numFibers);
+        std::uniform_real_distribution< double > position(0, 100);
+        std::normal_distribution< double > step(0, 1);
+
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+        for (int i=0; i<numFibers; ++i)
+        {
+            double p[3] = {position(randGen), position(randGen), 50 - numPoints/2 + step(randGen)};
+            vtkSmartPointer<vtkPolyLine> line = vtkSmartPointer<vtkPolyLine>::New();
+            for (int j=0; j<numPoints; ++j)
+            {
+                line->GetPointIds()->InsertNextId(points->InsertNextPoint(p));
+                p[0] += step(randGen);
+                p[1] += step(randGen);
+                p[2] += 1 + 0.2*step(randGen);
+            }
+            lines->InsertNextCell(line);
+        }
+        vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+        polyData->SetPoints(points);
+        polyData->SetLines(lines);
+        return mitk::FiberBundle::New(polyData);
+    }
+
+    /** Reference result: tests every segment of every fiber. */
+    std::vector<long> ExtractBruteForce(mitk::FiberBundle::Pointer fib, mitk::DataNode::Pointer roi)
+    {
+        vtkSmartPointer<vtkPolyData> polyData = fib->GetFiberPolyData();
+        mitk::PlanarFigure* figure = dynamic_cast<mitk::PlanarFigure*>(roi->GetData());
+        mitk::Vector3D normal = figure->GetPlaneGeometry()->GetNormal();
+        normal.Normalize();
+        mitk::Point3D center = figure->GetWorldControlPoint(0);
+        double radius = center.SquaredEuclideanDistanceTo(figure->GetWorldControlPoint(1));
+
+        vtkSmartPointer<vtkPolygon> polygon = vtkSmartPointer<vtkPolygon>::New();
+        for (unsigned int i=0; i<figure->GetNumberOfControlPoints(); ++i)
+        {
+            mitk::Point3D p = figure->GetWorldControlPoint(i);
+            polygon->GetPointIds()->InsertNextId(polygon->GetPoints()->InsertNextPoint(p[0], p[1], p[2]));
+        }
+
+        std::vector<long> result;
+        for (int i=0; i<fib->GetNumFibers(); ++i)
+        {
+            vtkCell* cell = polyData->GetCell(i);
+            vtkPoints* points = cell->GetPoints();
+            for (int j=0; j<cell->GetNumberOfPoints()-1; ++j)
+            {
+                double p1[3], p2[3], x[3], pcoords[3], t;
+                int subId;
+                points->GetPoint(j, p1);
+                points->GetPoint(j+1, p2);
+
+                bool hit = false;
+                if (dynamic_cast<mitk::PlanarPolygon*>(figure))
+                    hit = polygon->IntersectWithLine(p1, p2, 0.001, t, x, pcoords, subId)!=0;
+                else if (vtkPlane::IntersectWithLine(p1, p2, normal.GetDataPointer(), center.GetDataPointer(), t, x)!=0)
+                    hit = (x[0]-center[0])*(x[0]-center[0]) + (x[1]-center[1])*(x[1]-center[1]) + (x[2]-center[2])*(x[2]-center[2]) <= radius;
+
+                if (hit)
+                {
+                    result.push_back(i);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    void CheckExtraction(mitk::FiberBundle::Pointer fib)
+    {
+        std::vector<long> reference = ExtractBruteForce(fib, circleNode);
+        std::vector<long> ids = fib->ExtractFiberIdSubset(circleNode, storage);
+        CPPUNIT_ASSERT_MESSAGE("Circle should intersect fibers", !reference.empty());
+        CPPUNIT_ASSERT_MESSAGE("Circle extraction should be equal to brute force", reference==ids);
+
+        reference = ExtractBruteForce(fib, polygonNode);
+        ids = fib->ExtractFiberIdSubset(polygonNode, storage);
+        CPPUNIT_ASSERT_MESSAGE("Polygon should intersect fibers", !reference.empty());
+        CPPUNIT_ASSERT_MESSAGE("Polygon extraction should be equal to brute force", reference==ids);
+    }
+
+public:
+
+    void setUp() override
+    {
+        storage = mitk::StandaloneDataStorage::New();
+
+        // figures in the plane z=50
+        mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+        plane->InitializeStandardPlane(100.0, 100.0);
+        mitk::Point3D origin;
+        origin[0] = 0; origin[1] = 0; origin[2] = 50;
+        plane->SetOrigin(origin);
+
+        mitk::Point2D p;
+        mitk::PlanarCircle::Pointer circle = mitk::PlanarCircle::New();
+        circle->SetPlaneGeometry(plane);
+        p[0] = 40; p[1] = 60;
+        circle->PlaceFigure(p);
+        p[0] = 50; p[1] = 60;
+        circle->SetCurrentControlPoint(p);
+        circleNode = mitk::DataNode::New();
+        circleNode->SetData(circle);
+
+        mitk::PlanarPolygon::Pointer polygon = mitk::PlanarPolygon::New();
+        polygon->SetPlaneGeometry(plane);
+        p[0] = 20; p[1] = 20;
+        polygon->PlaceFigure(p);
+        p[0] = 45; p[1] = 25;
+        polygon->SetCurrentControlPoint(p);
+        p[0] = 35; p[1] = 40;
+        polygon->AddControlPoint(p);
+        polygonNode = mitk::DataNode::New();
+        polygonNode->SetData(polygon);
+    }
+
+    void tearDown() override
+    {
+        storage = nullptr;
+        circleNode = nullptr;
+        polygonNode = nullptr;
+    }
+
+    void Test1()
+    {
+        MITK_INFO << "TEST 1: Index contains all segments";
+
+        mitk::FiberBundle::Pointer fib = CreateFibers(1000, 50);
+        const mitk::FiberSpatialIndex* index = fib->GetSpatialIndex();
+        CPPUNIT_ASSERT_MESSAGE("Should index all fibers", index->GetNumberOfFibers()==(unsigned long)fib->GetNumFibers());
+
+        double bounds[6];
+        fib->GetFiberPolyData()->GetBounds(bounds);
+        std::vector< mitk::FiberSpatialIndex::SegmentRun > runs;
+        index->GetSegmentRuns(bounds, runs);
+        std::vector< int > numSegments(fib->GetNumFibers(), 0);
+        for (auto run : runs)
+            numSegments[run.Fiber] += run.LastSegment - run.FirstSegment + 1;
+        for (auto n : numSegments)
+            CPPUNIT_ASSERT_MESSAGE("Every segment should be contained at least once", n>=49);
+
+        std::vector<long> ids = index->GetFibers(bounds);
+        CPPUNIT_ASSERT_MESSAGE("Query of the bundle bounds should return all fibers", (int)ids.size()==fib->GetNumFibers());
+    }
+
+    void Test2()
+    {
+        MITK_INFO << "TEST 2: Extraction equal to brute force";
+
+        mitk::FiberBundle::Pointer fib = CreateFibers(2000, 100);
+        CheckExtraction(fib);
+
+        fib->SetUseCompactStorage(true);
+        CheckExtraction(fib);
+    }
+
+    void Test3()
+    {
+        MITK_INFO << "TEST 3: Index is updated after modifications";
+
+        mitk::FiberBundle::Pointer fib = CreateFibers(2000, 100);
+        fib->GetSpatialIndex();
+        fib->TranslateFibers(5, -5, 2);
+        CheckExtraction(fib);
+
+        fib->SetUseCompactStorage(true);
+        fib->GetSpatialIndex();
+        fib->RotateAroundAxis(0, 0, 10);
+        CheckExtraction(fib);
+    }
+
+    void Test4()
+    {
+        MITK_INFO << "TEST 4: Index is reused by repeated queries";
+
+        mitk::FiberBundle::Pointer fib = CreateFibers(500, 20);
+        const mitk::FiberSpatialIndex* index = fib->GetSpatialIndex();
+        CheckExtraction(fib);
+        CPPUNIT_ASSERT_MESSAGE("Queries should not rebuild the index", index==fib->GetSpatialIndex());
+        CheckExtraction(fib);
+    }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkFiberSpatialIndex)
@@ -45,6 +45,23 @@ int mitkFiberTransformationTest(int argc, char* argv[])
         groundTruthFibs->MirrorFibers(2);
 
         MITK_TEST_CONDITION_REQUIRED(groundTruthFibs->Equals(transformedFibs),"check transformation")
+
+        mitk::FiberBundle::Pointer compactFibs = dynamic_cast<mitk::FiberBundle*>(mitk::IOUtil::Load(argv[1])[0].GetPointer());
+        compactFibs->SetUseCompactStorage(true);
+
+        compactFibs->RotateAroundAxis(90, 45, 10);
+        compactFibs->TranslateFibers(2, 3, 5);
+        compactFibs->ScaleFibers(1, 0.1, 1.3);
+        compactFibs->RemoveLongFibers(150);
+        compactFibs->RemoveShortFibers(20);
+        compactFibs->ResampleSpline(1.0);
+        compactFibs->ApplyCurvatureThreshold(3.0, true);
+        compactFibs->MirrorFibers(0);
+        compactFibs->MirrorFibers(1);
+        compactFibs->MirrorFibers(2);
+
+        MITK_TEST_CONDITION_REQUIRED(compactFibs->GetUseCompactStorage(),"check compact storage is retained")
+        MITK_TEST_CONDITION_REQUIRED(compactFibs->Equals(transformedFibs),"check transformation using compact storage")
     }
     catch(...) {
         return EXIT_FAILURE;
@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkGibbsTrackingFilter.h>
 #include <mitkFiberBundle.h>
 #include <mitkIOUtil.h>
+#include <omp.h>
 
 using namespace mitk;
 
@@ -81,6 +82,27 @@ int mitkGibbsTrackingTest(int argc, char* argv[])
     gibbsTracker->Update();
     fib2 = mitk::FiberBundle::New(gibbsTracker->GetFiberBundle());
     MITK_TEST_CONDITION_REQUIRED(!fib1->Equals(fib2), "check if gibbs tracking has changed after wrong seed");
+
+    // parallel sampling of spatial domains: each domain is seeded separately, so the result
+    // has to be reproducible and independent of the number of threads
+    gibbsTracker->SetRandomSeed(1);
+    gibbsTracker->SetParallelSampling(true);
+    gibbsTracker->Update();
+    mitk::FiberBundle::Pointer parallel1 = mitk::FiberBundle::New(gibbsTracker->GetFiberBundle());
+    MITK_TEST_CONDITION_REQUIRED(parallel1->GetNumFibers()>0, "check if parallel gibbs tracking produces fibers");
+
+    gibbsTracker->Modified();
+    gibbsTracker->Update();
+    mitk::FiberBundle::Pointer parallel2 = mitk::FiberBundle::New(gibbsTracker->GetFiberBundle());
+    MITK_TEST_CONDITION_REQUIRED(parallel1->Equals(parallel2), "check if parallel gibbs tracking is reproducible");
+
+    int numThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    gibbsTracker->Modified();
+    gibbsTracker->Update();
+    omp_set_num_threads(numThreads);
+    parallel2 = mitk::FiberBundle::New(gibbsTracker->GetFiberBundle());
+    MITK_TEST_CONDITION_REQUIRED(parallel1->Equals(parallel2), "check if parallel gibbs tracking is independent of the number of threads");
   }
   catch(...)
   {
@@ -39,6 +39,7 @@ class mitkStreamlineTractographyTestSuite : public mitk::TestFixture
   CPPUNIT_TEST_SUITE(mitkStreamlineTractographyTestSuite);
   MITK_TEST(Test_Peak1);
   MITK_TEST(Test_Peak2);
+  MITK_TEST(Test_Peak1_Multithreaded);
   MITK_TEST(Test_Tensor1);
   MITK_TEST(Test_Tensor2);
   MITK_TEST(Test_Tensor3);
@@ -48,6 +49,7 @@ class mitkStreamlineTractographyTestSuite : public mitk::TestFixture
   MITK_TEST(Test_Odf4);
   MITK_TEST(Test_Odf5);
   MITK_TEST(Test_Odf6);
+  MITK_TEST(Test_Odf5_Multithreaded);
   CPPUNIT_TEST_SUITE_END();
 
   typedef itk::VectorImage< short, 3>   ItkDwiType;
@@ -241,6 +243,26 @@ public:
     delete handler;
   }
 
+  void Test_Peak1_Multithreaded()
+  {
+    // the tractogram must not depend on the number of threads used for tracking
+    omp_set_num_threads(4);
+
+    mitk::TrackingHandlerPeaks* handler = new mitk::TrackingHandlerPeaks();
+    handler->SetPeakImage(itk_peak_image);
+    handler->SetPeakThreshold(peak_threshold);
+
+    SetupTracker(handler);
+    tracker->Update();
+
+    vtkSmartPointer< vtkPolyData > poly = tracker->GetFiberPolyData();
+    mitk::FiberBundle::Pointer outFib = mitk::FiberBundle::New(poly);
+
+    CheckFibResult("Test_Peak1.fib", outFib);
+
+    delete handler;
+  }
+
   void Test_Tensor1()
   {
     mitk::TrackingHandlerTensor* handler = new mitk::TrackingHandlerTensor();
@@ -422,6 +444,40 @@ public:
     delete handler;
   }
 
+  mitk::FiberBundle::Pointer TrackOdfProbabilistic(int num_threads)
+  {
+    omp_set_num_threads(num_threads);
+
+    mitk::TrackingHandlerOdf* handler = new mitk::TrackingHandlerOdf();
+    handler->SetOdfImage(itk_odf_image);
+    handler->SetGfaThreshold(gfa_threshold);
+    handler->SetOdfThreshold(0);
+    handler->SetSharpenOdfs(true);
+    handler->SetMode(mitk::TrackingDataHandler::MODE::PROBABILISTIC);
+
+    SetupTracker(handler);
+    tracker->SetSeedsPerVoxel(3);
+    tracker->Update();
+
+    vtkSmartPointer< vtkPolyData > poly = tracker->GetFiberPolyData();
+    mitk::FiberBundle::Pointer outFib = mitk::FiberBundle::New(poly);
+
+    delete handler;
+    return outFib;
+  }
+
+  void Test_Odf5_Multithreaded()
+  {
+    // probabilistic tracking has to be reproducible and must not depend on the number of threads
+    mitk::FiberBundle::Pointer fib1 = TrackOdfProbabilistic(4);
+    mitk::FiberBundle::Pointer fib2 = TrackOdfProbabilistic(4);
+    mitk::FiberBundle::Pointer fib3 = TrackOdfProbabilistic(1);
+
+    CPPUNIT_ASSERT_MESSAGE("Should track fibers", fib1->GetNumFibers()>0);
+    CPPUNIT_ASSERT_MESSAGE("Repeated multithreaded tracking should yield equal tractograms", fib1->Equals(fib2));
+    CPPUNIT_ASSERT_MESSAGE("Multithreaded and single threaded tracking should yield equal tractograms", fib1->Equals(fib3));
+  }
+
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkStreamlineTractography)
@@ -0,0 +1,111 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include <mitkStreamlineFileReader.h>
+#include <mitkStreamlineFileWriter.h>
+#include "mitkCommandLineParser.h"
+
+/*!
+\brief Convert and filter .trk and .tck tractograms chunk by chunk without loading the complete tractogram.
+*/
+int main(int argc, char* argv[])
+{
+    mitkCommandLineParser parser;
+
+    parser.setTitle("Streamline File Converter");
+    parser.setCategory("Fiber Tracking and Processing Methods");
+    parser.setDescription("Convert and filter .trk and .tck tractograms chunk by chunk without loading the complete tractogram.");
+    parser.setContributor("MIC");
+
+    parser.setArgumentPrefix("--", "-");
+    parser.addArgument("input", "i", mitkCommandLineParser::InputFile, "Input:", "input tractogram (.trk, .tck)", us::Any(), false);
+    parser.addArgument("outFile", "o", mitkCommandLineParser::OutputFile, "Output:", "output tractogram (.trk, .tck)", us::Any(), false);
+
+    parser.addArgument("subsample", "s", mitkCommandLineParser::Int, "Subsampling step:", "Only keep every n-th streamline", 1);
+    parser.addArgument("minLength", "l", mitkCommandLineParser::Float, "Minimum length:", "Minimum fiber length (in mm)");
+    parser.addArgument("maxLength", "m", mitkCommandLineParser::Float, "Maximum length:", "Maximum fiber length (in mm)");
+    parser.addArgument("chunkSize", "c", mitkCommandLineParser::Int, "Chunk size:", "Maximum number of points read at once (in millions)", 4);
+    parser.addArgument("ras", "", mitkCommandLineParser::Bool, "RAS:", "Save .trk files in RAS instead of LPS space");
+
+    std::map<std::string, us::Any> parsedArgs = parser.parseArguments(argc, argv);
+    if (parsedArgs.size()==0)
+        return EXIT_FAILURE;
+
+    std::string inFileName = us::any_cast<std::string>(parsedArgs["input"]);
+    std::string outFileName = us::any_cast<std::string>(parsedArgs["outFile"]);
+
+    int subsample = 1;
+    if (parsedArgs.count("subsample"))
+        subsample = us::any_cast<int>(parsedArgs["subsample"]);
+
+    float minFiberLength = -1;
+    if (parsedArgs.count("minLength"))
+        minFiberLength = us::any_cast<float>(parsedArgs["minLength"]);
+
+    float maxFiberLength = -1;
+    if (parsedArgs.count("maxLength"))
+        maxFiberLength = us::any_cast<float>(parsedArgs["maxLength"]);
+
+    int chunkSize = 4;
+    if (parsedArgs.count("chunkSize"))
+        chunkSize = us::any_cast<int>(parsedArgs["chunkSize"]);
+
+    bool ras = false;
+    if (parsedArgs.count("ras"))
+        ras = us::any_cast<bool>(parsedArgs["ras"]);
+
+    try
+    {
+        mitk::StreamlineFileReader reader;
+        reader.SetSubsamplingStep(subsample);
+        reader.SetMinLength(minFiberLength);
+        reader.SetMaxLength(maxFiberLength);
+        reader.Open(inFileName);
+
+        mitk::StreamlineFileWriter writer;
+        writer.Open(outFileName, reader.GetReferenceGeometry(), !ras);
+
+        mitk::CompactFiberStorage chunk;
+        while (reader.ReadChunk(chunk, std::max(chunkSize, 1)*1000000ul))
+        {
+            writer.Append(chunk);
+            std::cout << writer.GetNumberOfWrittenFibers() << " streamlines written" << std::endl;
+        }
+        writer.Close();
+
+        std::cout << "Kept " << reader.GetNumberOfReadFibers() << " and skipped " << reader.GetNumberOfSkippedFibers() << " streamlines";
+    }
+    catch (itk::ExceptionObject e)
+    {
+        std::cout << e;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception e)
+    {
+        std::cout << e.what();
+        return EXIT_FAILURE;
+    }
+    catch (...)
+    {
+        std::cout << "ERROR!?!";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -100,6 +100,7 @@ int main(int argc, char* argv[])
     parser.addArgument("shConvention", "s", mitkCommandLineParser::String, "SH coefficient:", "sh coefficient convention (FSL, MRtrix)", std::string("FSL"), true);
     parser.addArgument("outFile", "o", mitkCommandLineParser::OutputFile, "Output:", "output fiber bundle (.fib)", us::Any(), false);
     parser.addArgument("noFlip", "f", mitkCommandLineParser::Bool, "No flip:", "do not flip input image to match MITK coordinate convention");
+    parser.addArgument("parallel", "", mitkCommandLineParser::Bool, "Parallel:", "sample spatial domains of the particle grid in parallel");
 
     std::map<std::string, us::Any> parsedArgs = parser.parseArguments(argc, argv);
     if (parsedArgs.size()==0)
@@ -113,6 +114,10 @@ int main(int argc, char* argv[])
     if (parsedArgs.count("noFlip"))
         noFlip = us::any_cast<bool>(parsedArgs["noFlip"]);
 
+    bool parallel = false;
+    if (parsedArgs.count("parallel"))
+        parallel = us::any_cast<bool>(parsedArgs["parallel"]);
+
     try
     {
         // instantiate gibbs tracker
@@ -213,6 +218,7 @@ int main(int argc, char* argv[])
 
         gibbsTracker->SetDuplicateImage(false);
         gibbsTracker->SetLoadParameterFile( paramFileName );
+        gibbsTracker->SetParallelSampling( parallel );
 //        gibbsTracker->SetLutPath( "" );
         gibbsTracker->Update();
 
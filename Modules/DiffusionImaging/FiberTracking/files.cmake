@@ -4,6 +4,10 @@ set(CPP_FILES
 
   ## IO datastructures
   IODataStructures/FiberBundle/mitkFiberBundle.cpp
+  IODataStructures/FiberBundle/mitkCompactFiberStorage.cpp
+  IODataStructures/FiberBundle/mitkFiberSpatialIndex.cpp
+  IODataStructures/FiberBundle/mitkStreamlineFileReader.cpp
+  IODataStructures/FiberBundle/mitkStreamlineFileWriter.cpp
   IODataStructures/FiberBundle/mitkTrackvis.cpp
   IODataStructures/PlanarFigureComposite/mitkPlanarFigureComposite.cpp
   IODataStructures/mitkTractographyForest.cpp
@@ -13,6 +17,7 @@ set(CPP_FILES
   # Tractography
   Algorithms/GibbsTracking/mitkParticleGrid.cpp
   Algorithms/GibbsTracking/mitkMetropolisHastingsSampler.cpp
+  Algorithms/GibbsTracking/mitkParallelMetropolisHastingsSampler.cpp
   Algorithms/GibbsTracking/mitkEnergyComputer.cpp
   Algorithms/GibbsTracking/mitkGibbsEnergyComputer.cpp
   Algorithms/GibbsTracking/mitkFiberBuilder.cpp
@@ -28,6 +33,10 @@ set(CPP_FILES
 set(H_FILES
   # DataStructures -> FiberBundle
   IODataStructures/FiberBundle/mitkFiberBundle.h
+  IODataStructures/FiberBundle/mitkCompactFiberStorage.h
+  IODataStructures/FiberBundle/mitkFiberSpatialIndex.h
+  IODataStructures/FiberBundle/mitkStreamlineFileReader.h
+  IODataStructures/FiberBundle/mitkStreamlineFileWriter.h
   IODataStructures/FiberBundle/mitkTrackvis.h
   IODataStructures/mitkFiberfoxParameters.h
   IODataStructures/mitkTractographyForest.h
@@ -56,6 +65,7 @@ set(H_FILES
   Algorithms/GibbsTracking/mitkParticle.h
   Algorithms/GibbsTracking/mitkParticleGrid.h
   Algorithms/GibbsTracking/mitkMetropolisHastingsSampler.h
+  Algorithms/GibbsTracking/mitkParallelMetropolisHastingsSampler.h
   Algorithms/GibbsTracking/mitkSimpSamp.h
   Algorithms/GibbsTracking/mitkEnergyComputer.h
   Algorithms/GibbsTracking/mitkGibbsEnergyComputer.h
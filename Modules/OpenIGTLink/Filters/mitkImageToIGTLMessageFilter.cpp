@@ -146,7 +146,10 @@ void mitk::ImageToIGTLMessageFilter::GenerateData()
     }
     imgMsg->SetDimensions(sizes);
 
-    // Allocate and copy data.
+    // Allocate the message and copy the data of the first time step directly
+    // from the data item of the image into the pack buffer. The scalars have to
+    // be contiguous with the headers in the pack, so this single copy is the
+    // serialization of the pixel data.
     imgMsg->AllocatePack();
     imgMsg->AllocateScalars();
 
@@ -154,7 +157,7 @@ void mitk::ImageToIGTLMessageFilter::GenerateData()
     void* out = imgMsg->GetScalarPointer();
     {
       // Scoped, so that readAccess will be released ASAP.
-      mitk::ImageReadAccessor readAccess(img, img->GetChannelData(0));
+      mitk::ImageReadAccessor readAccess(img, img->GetVolumeData(0));
       const void* in = readAccess.GetData();
 
       memcpy(out, in, num_pixel * type.GetSize());
@@ -164,36 +167,43 @@ void mitk::ImageToIGTLMessageFilter::GenerateData()
     // swap by number of bytes for each component, but itk::ByteSwapper
     // is templated over element type, not over element size. So we need to
     // switch on the size and use types of the same size.
+    // On little endian systems there is nothing to do, so the data is not
+    // touched a second time.
     size_t num_scalars = num_pixel * type.GetNumberOfComponents();
-    switch (type.GetComponentType())
+    if (itk::ByteSwapper<short>::SystemIsBigEndian())
     {
-    case itk::ImageIOBase::CHAR:
-    case itk::ImageIOBase::UCHAR:
-      // No endian conversion necessary, because a char is exactly one byte!
-      break;
-    case itk::ImageIOBase::SHORT:
-    case itk::ImageIOBase::USHORT:
-      itk::ByteSwapper<short>::SwapRangeFromSystemToLittleEndian((short*)out,
-        num_scalars);
-      break;
-    case itk::ImageIOBase::INT:
-    case itk::ImageIOBase::UINT:
-      itk::ByteSwapper<int>::SwapRangeFromSystemToLittleEndian((int*)out,
-        num_scalars);
-      break;
-    case itk::ImageIOBase::LONG:
-    case itk::ImageIOBase::ULONG:
-      itk::ByteSwapper<long>::SwapRangeFromSystemToLittleEndian((long*)out,
-        num_scalars);
-      break;
-    case itk::ImageIOBase::FLOAT:
-      itk::ByteSwapper<float>::SwapRangeFromSystemToLittleEndian((float*)out,
-        num_scalars);
-      break;
-    case itk::ImageIOBase::DOUBLE:
-      itk::ByteSwapper<double>::SwapRangeFromSystemToLittleEndian(
-        (double*)out, num_scalars);
-      break;
+      switch (type.GetComponentType())
+      {
+      case itk::ImageIOBase::CHAR:
+      case itk::ImageIOBase::UCHAR:
+        // No endian conversion necessary, because a char is exactly one byte!
+        break;
+      case itk::ImageIOBase::SHORT:
+      case itk::ImageIOBase::USHORT:
+        itk::ByteSwapper<short>::SwapRangeFromSystemToLittleEndian((short*)out,
+          num_scalars);
+        break;
+      case itk::ImageIOBase::INT:
+      case itk::ImageIOBase::UINT:
+        itk::ByteSwapper<int>::SwapRangeFromSystemToLittleEndian((int*)out,
+          num_scalars);
+        break;
+      case itk::ImageIOBase::LONG:
+      case itk::ImageIOBase::ULONG:
+        itk::ByteSwapper<long>::SwapRangeFromSystemToLittleEndian((long*)out,
+          num_scalars);
+        break;
+      case itk::ImageIOBase::FLOAT:
+        itk::ByteSwapper<float>::SwapRangeFromSystemToLittleEndian((float*)out,
+          num_scalars);
+        break;
+      case itk::ImageIOBase::DOUBLE:
+        itk::ByteSwapper<double>::SwapRangeFromSystemToLittleEndian(
+          (double*)out, num_scalars);
+        break;
+      default:
+        break;
+      }
     }
 
     //copy timestamp of mitk image
@@ -2,4 +2,6 @@ set(MODULE_TESTS
    mitkOpenIGTLinkClientServerTest.cpp
    mitkOpenIGTLinkImageFactoryTest.cpp
    mitkOpenIGTLinkIGTLImageMessageFilterTest.cpp
+   mitkOpenIGTLinkLatencyTest.cpp
+   mitkIGTLMessageQueueTest.cpp
 )
@@ -0,0 +1,144 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+//TEST
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+//STD
+#include <thread>
+
+//MITK
+#include "mitkIGTLMessageQueue.h"
+
+//IGTL
+#include "igtlImageMessage.h"
+#include "igtlStatusMessage.h"
+#include "igtlTrackingDataMessage.h"
+
+class mitkIGTLMessageQueueTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkIGTLMessageQueueTestSuite);
+  MITK_TEST(PushMessage_DifferentTypes_SortedIntoQueues);
+  MITK_TEST(PushMessage_NoBuffering_KeepsLatestMessage);
+  MITK_TEST(PushMessage_FullQueue_DropsOldestMessage);
+  MITK_TEST(PushMessage_ConcurrentConsumer_ReceivesMessagesInOrder);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::IGTLMessageQueue::Pointer m_Queue;
+
+  igtl::MessageBase::Pointer CreateStatusMessage(int code)
+  {
+    igtl::StatusMessage::Pointer message = igtl::StatusMessage::New();
+    message->SetSubCode(code);
+    return message.GetPointer();
+  }
+
+  int GetCode(igtl::MessageBase::Pointer message)
+  {
+    return static_cast<int>(dynamic_cast<igtl::StatusMessage*>(message.GetPointer())->GetSubCode());
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_Queue = mitk::IGTLMessageQueue::New();
+  }
+
+  void tearDown() override
+  {
+    m_Queue = nullptr;
+  }
+
+  void PushMessage_DifferentTypes_SortedIntoQueues()
+  {
+    igtl::ImageMessage::Pointer image = igtl::ImageMessage::New();
+    image->SetDimensions(4, 4, 4);
+    m_Queue->PushMessage(image.GetPointer());
+    m_Queue->PushMessage(igtl::TrackingDataMessage::New().GetPointer());
+    m_Queue->PushMessage(this->CreateStatusMessage(0));
+
+    CPPUNIT_ASSERT_EQUAL(3, m_Queue->GetSize());
+    CPPUNIT_ASSERT_EQUAL(1u, m_Queue->GetQueueDepth(mitk::IGTLMessageQueue::TrackingDataQueue));
+    CPPUNIT_ASSERT(m_Queue->PullImage2dMessage().IsNull());
+    CPPUNIT_ASSERT(m_Queue->PullImage3dMessage().IsNotNull());
+    CPPUNIT_ASSERT(m_Queue->PullTrackingMessage().IsNotNull());
+    CPPUNIT_ASSERT(m_Queue->PullMiscMessage().IsNotNull());
+    CPPUNIT_ASSERT_EQUAL(0, m_Queue->GetSize());
+  }
+
+  void PushMessage_NoBuffering_KeepsLatestMessage()
+  {
+    m_Queue->EnableNoBufferingMode(true);
+    for (int i = 0; i < 5; ++i)
+      m_Queue->PushMessage(this->CreateStatusMessage(i));
+
+    CPPUNIT_ASSERT_EQUAL(1u, m_Queue->GetQueueDepth(mitk::IGTLMessageQueue::MiscQueue));
+    CPPUNIT_ASSERT_EQUAL(4ull, m_Queue->GetNumberOfDroppedMessages(mitk::IGTLMessageQueue::MiscQueue));
+    CPPUNIT_ASSERT_EQUAL(4, this->GetCode(m_Queue->PullMiscMessage()));
+  }
+
+  void PushMessage_FullQueue_DropsOldestMessage()
+  {
+    m_Queue->EnableNoBufferingMode(false);
+    m_Queue->SetCapacity(mitk::IGTLMessageQueue::MiscQueue, 4);
+    CPPUNIT_ASSERT_EQUAL(4u, m_Queue->GetCapacity(mitk::IGTLMessageQueue::MiscQueue));
+
+    for (int i = 0; i < 6; ++i)
+      m_Queue->PushMessage(this->CreateStatusMessage(i));
+
+    CPPUNIT_ASSERT_EQUAL(4u, m_Queue->GetQueueDepth(mitk::IGTLMessageQueue::MiscQueue));
+    CPPUNIT_ASSERT_EQUAL(2ull, m_Queue->GetNumberOfDroppedMessages(mitk::IGTLMessageQueue::MiscQueue));
+    for (int i = 2; i < 6; ++i)
+      CPPUNIT_ASSERT_EQUAL(i, this->GetCode(m_Queue->PullMiscMessage()));
+    CPPUNIT_ASSERT(m_Queue->PullMiscMessage().IsNull());
+  }
+
+  void PushMessage_ConcurrentConsumer_ReceivesMessagesInOrder()
+  {
+    const int numberOfMessages = 10000;
+    m_Queue->EnableNoBufferingMode(false);
+
+    std::thread producer([this, numberOfMessages]()
+    {
+      for (int i = 0; i < numberOfMessages; ++i)
+        m_Queue->PushMessage(this->CreateStatusMessage(i));
+    });
+
+    int received = 0;
+    int last = -1;
+    bool ordered = true;
+    while (last != numberOfMessages - 1)
+    {
+      igtl::MessageBase::Pointer message = m_Queue->PullMiscMessage();
+      if (message.IsNull())
+        continue;
+      int code = this->GetCode(message);
+      ordered = ordered && code > last;
+      last = code;
+      ++received;
+    }
+    producer.join();
+
+    CPPUNIT_ASSERT_MESSAGE("Messages are received in the order they were pushed", ordered);
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned long long>(numberOfMessages),
+      received + m_Queue->GetNumberOfDroppedMessages(mitk::IGTLMessageQueue::MiscQueue));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkIGTLMessageQueue)
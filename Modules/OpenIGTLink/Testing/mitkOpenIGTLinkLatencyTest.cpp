@@ -0,0 +1,132 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+//TEST
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+//STD
+#include <thread>
+#include <chrono>
+
+//ITK
+#include <itkTimeProbe.h>
+
+//MITK
+#include "mitkIGTLServer.h"
+#include "mitkIGTLClient.h"
+#include "mitkIGTLMessageFactory.h"
+
+//IGTL
+#include "igtlStatusMessage.h"
+
+static const int PORT = 35353;
+static const std::string HOSTNAME = "localhost";
+static const int NUMBER_OF_ROUND_TRIPS = 200;
+
+/**
+ * Loopback benchmark of the OpenIGTLink communication threads: a status message is
+ * sent from the server to the client and back and the round trip time is logged.
+ */
+class mitkOpenIGTLinkLatencyTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkOpenIGTLinkLatencyTestSuite);
+  MITK_TEST(Benchmark_RoundTripLatency);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::IGTLServer::Pointer m_Server;
+  mitk::IGTLClient::Pointer m_Client;
+  mitk::IGTLMessageFactory::Pointer m_MessageFactory;
+
+  /** Busy waits for the next misc message of the given device, returns nullptr after one second */
+  igtl::MessageBase::Pointer WaitForMessage(mitk::IGTLDevice* device)
+  {
+    auto start = std::chrono::steady_clock::now();
+    igtl::MessageBase::Pointer message;
+    while ((message = device->GetMessageQueue()->PullMiscMessage()).IsNull())
+    {
+      if (std::chrono::steady_clock::now() - start > std::chrono::seconds(1))
+        break;
+      std::this_thread::yield();
+    }
+    return message;
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_MessageFactory = mitk::IGTLMessageFactory::New();
+    m_Server = mitk::IGTLServer::New(true);
+    m_Client = mitk::IGTLClient::New(true);
+
+    m_Server->SetHostname(HOSTNAME);
+    m_Server->SetName("Latency Test Server");
+    m_Server->SetPortNumber(PORT);
+
+    m_Client->SetHostname(HOSTNAME);
+    m_Client->SetName("Latency Test Client");
+    m_Client->SetPortNumber(PORT);
+  }
+
+  void tearDown() override
+  {
+    m_Server = nullptr;
+    m_Client = nullptr;
+    m_MessageFactory = nullptr;
+  }
+
+  void Benchmark_RoundTripLatency()
+  {
+    CPPUNIT_ASSERT_MESSAGE("Could not open Connection with Server", m_Server->OpenConnection());
+    m_Server->StartCommunication();
+    CPPUNIT_ASSERT_MESSAGE("Could not connect to Server", m_Client->OpenConnection());
+    CPPUNIT_ASSERT_MESSAGE("Could not start communication with client", m_Client->StartCommunication());
+
+    // wait until the server accepted the client
+    for (int i = 0; i < 100 && m_Server->GetNumberOfConnections() == 0; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    igtl::MessageBase::Pointer message = m_MessageFactory->CreateInstance("STATUS");
+    dynamic_cast<igtl::StatusMessage*>(message.GetPointer())->SetStatusString("ping");
+
+    itk::TimeProbe probe;
+    int completedRoundTrips = 0;
+    for (int i = 0; i < NUMBER_OF_ROUND_TRIPS; ++i)
+    {
+      probe.Start();
+      m_Server->SendMessage(mitk::IGTLMessage::New(message));
+      if (this->WaitForMessage(m_Client).IsNull())
+        break;
+      m_Client->SendMessage(mitk::IGTLMessage::New(message));
+      if (this->WaitForMessage(m_Server).IsNull())
+        break;
+      probe.Stop();
+      ++completedRoundTrips;
+    }
+
+    CPPUNIT_ASSERT(m_Client->CloseConnection());
+    CPPUNIT_ASSERT(m_Server->CloseConnection());
+
+    MITK_INFO << "OpenIGTLink loopback round trip: " << probe.GetMean() * 1000.0 << " ms ("
+              << completedRoundTrips << " round trips)";
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All messages were received", NUMBER_OF_ROUND_TRIPS, completedRoundTrips);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkOpenIGTLinkLatency)
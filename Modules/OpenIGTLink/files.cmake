@@ -10,6 +10,7 @@ set(CPP_FILES
   mitkIGTLMessageCloneHandler.h
   mitkIGTLDummyMessage.cpp
   mitkIGTLMessageQueue.cpp
+  mitkIGTLRingBuffer.h
   mitkIGTLMessageProvider.cpp
   mitkIGTLMeasurements.cpp
   mitkIGTLModuleActivator.cpp
@@ -82,6 +82,13 @@ bool mitk::IGTLClient::OpenConnection()
 void mitk::IGTLClient::Receive()
 {
   //MITK_INFO << "Trying to receive message";
+  //sleep until the server sent something, this returns immediately when data
+  //arrives
+  SocketListType sockets;
+  sockets.push_back(this->m_Socket);
+  if (WaitForIncomingData(sockets, WAIT_TIMEOUT_MSEC).empty())
+    return;
+
   //try to receive a message, if the socket is not present anymore stop the
   //communication
   unsigned int status = this->ReceivePrivate(this->m_Socket);
@@ -98,6 +105,10 @@ void mitk::IGTLClient::Send()
 {
   mitk::IGTLMessage::Pointer mitkMessage;
 
+  //sleep until a message is queued or the communication is stopped
+  if (!this->m_MessageQueue->WaitForSendMessage(WAIT_TIMEOUT_MSEC))
+    return;
+
   //get the latest message from the queue
   mitkMessage = this->m_MessageQueue->PullSendMessage();
 
@@ -113,9 +124,8 @@ void mitk::IGTLClient::Send()
 
 void mitk::IGTLClient::StopCommunicationWithSocket(igtl::Socket* /*socket*/)
 {
-  m_StopCommunicationMutex->Lock();
   m_StopCommunication = true;
-  m_StopCommunicationMutex->Unlock();
+  m_MessageQueue->WakeUpSendWaiters();
 }
 
 unsigned int mitk::IGTLClient::GetNumberOfConnections()
@@ -19,8 +19,15 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include "mitkIGTTimeStamp.h"
 #include <itkMutexLockHolder.h>
 #include <itksys/SystemTools.hxx>
+#include <algorithm>
 #include <cstring>
 
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#include <winsock2.h>
+#else
+#include <sys/select.h>
+#endif
+
 #include <igtlTransformMessage.h>
 #include <mitkIGTLMessageCommon.h>
 
@@ -33,6 +40,30 @@ See LICENSE.txt or http://www.mitk.org for details.
 static const int SOCKET_SEND_RECEIVE_TIMEOUT_MSEC = 100;
 typedef itk::MutexLockHolder<itk::FastMutexLock> MutexLockHolder;
 
+namespace
+{
+  /**
+  * \brief Reads the descriptor of an igtl::Socket, which is needed for select().
+  *
+  * igtl::Socket has no public accessor for its descriptor, and the sockets are created by OpenIGTLink
+  * (e.g. igtl::ServerSocket::WaitForConnection()), so they cannot be instances of an own subclass.
+  * This subclass only names the protected member igtl::Socket::m_SocketDescriptor and applies the
+  * resulting pointer to member to any igtl::Socket, which is well-defined C++. It depends on the name
+  * and type (int, negative if not connected) of this member in the OpenIGTLink version of the superbuild
+  * (CMakeExternals/OpenIGTLink.cmake) and has to be revisited when OpenIGTLink is updated.
+  */
+  class SocketDescriptorAccessor : public igtl::Socket
+  {
+  public:
+    static int GetDescriptor(const igtl::Socket* socket)
+    {
+      // the type of &SocketDescriptorAccessor::m_SocketDescriptor is int igtl::Socket::*
+      const int igtl::Socket::*descriptor = &SocketDescriptorAccessor::m_SocketDescriptor;
+      return socket->*descriptor;
+    }
+  };
+}
+
 mitk::IGTLDevice::IGTLDevice(bool ReadFully) :
 //  m_Data(mitk::DeviceDataUnspecified),
 m_State(mitk::IGTLDevice::Setup),
@@ -43,7 +74,6 @@ m_PortNumber(-1),
 m_MultiThreader(nullptr), m_SendThreadID(0), m_ReceiveThreadID(0), m_ConnectThreadID(0)
 {
   m_ReadFully = ReadFully;
-  m_StopCommunicationMutex = itk::FastMutexLock::New();
   m_StateMutex = itk::FastMutexLock::New();
   //  m_LatestMessageMutex = itk::FastMutexLock::New();
   m_SendingFinishedMutex = itk::FastMutexLock::New();
@@ -307,25 +337,11 @@ void mitk::IGTLDevice::RunCommunication(void (IGTLDevice::*ComFunction)(void), i
     // keep lock until end of scope
     MutexLockHolder communicationFinishedLockHolder(*mutex);
 
-    // Because m_StopCommunication is used by two threads, access has to be guarded
-    // by a mutex. To minimize thread locking, a local copy is used here
-    bool localStopCommunication;
-
-    // update the local copy of m_StopCommunication
-    this->m_StopCommunicationMutex->Lock();
-    localStopCommunication = this->m_StopCommunication;
-    this->m_StopCommunicationMutex->Unlock();
-    while ((this->GetState() == Running) && (localStopCommunication == false))
+    // the communication functions block until there is something to do (or
+    // WAIT_TIMEOUT_MSEC elapsed), so there is no need to sleep here
+    while ((this->GetState() == Running) && !m_StopCommunication)
     {
       (this->*ComFunction)();
-
-      /* Update the local copy of m_StopCommunication */
-      this->m_StopCommunicationMutex->Lock();
-      localStopCommunication = m_StopCommunication;
-      this->m_StopCommunicationMutex->Unlock();
-
-      // time to relax, this sets the maximum ever possible framerate to 1000 Hz
-      itksys::SystemTools::Delay(1);
     }
   }
   catch (...)
@@ -355,10 +371,7 @@ bool mitk::IGTLDevice::StartCommunication()
   // set a timeout for the sending and receiving
   this->m_Socket->SetTimeout(SOCKET_SEND_RECEIVE_TIMEOUT_MSEC);
 
-  // update the local copy of m_StopCommunication
-  this->m_StopCommunicationMutex->Lock();
   this->m_StopCommunication = false;
-  this->m_StopCommunicationMutex->Unlock();
 
   // transfer the execution rights to tracking thread
   m_SendingFinishedMutex->Unlock();
@@ -380,11 +393,9 @@ bool mitk::IGTLDevice::StopCommunication()
 {
   if (this->GetState() == Running) // Only if the object is in the correct state
   {
-    // m_StopCommunication is used by two threads, so we have to ensure correct
-    // thread handling
-    m_StopCommunicationMutex->Lock();
     m_StopCommunication = true;
-    m_StopCommunicationMutex->Unlock();
+    // wake up the send thread, it might wait for a new message
+    m_MessageQueue->WakeUpSendWaiters();
     // we have to wait here that the other thread recognizes the STOP-command
     // and executes it
     m_SendingFinishedMutex->Lock();
@@ -444,6 +455,49 @@ bool mitk::IGTLDevice::SendRTSMessage(const char* type)
 void mitk::IGTLDevice::Connect()
 {
   MITK_DEBUG << "mitk::IGTLDevice::Connect();";
+  // nothing to accept, do not let the connect thread spin
+  itksys::SystemTools::Delay(WAIT_TIMEOUT_MSEC);
+}
+
+mitk::IGTLDevice::SocketListType mitk::IGTLDevice::WaitForIncomingData(
+  const SocketListType& sockets, unsigned int timeoutMSec)
+{
+  SocketListType readableSockets;
+
+  fd_set readSet;
+  FD_ZERO(&readSet);
+  int maxDescriptor = -1;
+  for (const auto& socket : sockets)
+  {
+    int descriptor = SocketDescriptorAccessor::GetDescriptor(socket);
+    if (descriptor < 0)
+      continue;
+    FD_SET(descriptor, &readSet);
+    maxDescriptor = std::max(maxDescriptor, descriptor);
+  }
+
+  if (maxDescriptor < 0)
+  {
+    // e.g. no client is connected to a server
+    itksys::SystemTools::Delay(timeoutMSec);
+    return readableSockets;
+  }
+
+  timeval timeout;
+  timeout.tv_sec = timeoutMSec / 1000;
+  timeout.tv_usec = (timeoutMSec % 1000) * 1000;
+
+  int result = select(maxDescriptor + 1, &readSet, nullptr, nullptr, &timeout);
+  if (result == 0)
+    return readableSockets;
+
+  for (const auto& socket : sockets)
+  {
+    int descriptor = SocketDescriptorAccessor::GetDescriptor(socket);
+    if (descriptor >= 0 && (result < 0 || FD_ISSET(descriptor, &readSet)))
+      readableSockets.push_back(socket);
+  }
+  return readableSockets;
 }
 
 igtl::ImageMessage::Pointer mitk::IGTLDevice::GetNextImage2dMessage()
@@ -24,6 +24,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkFastMutexLock.h"
 #include "itkMultiThreader.h"
 
+//std
+#include <atomic>
+#include <list>
+
 //igtl
 #include "igtlSocket.h"
 #include "igtlMessageBase.h"
@@ -107,7 +111,9 @@ namespace mitk {
      * \brief Continuously calls the given function
      *
      * This may only be called if the device is in Running state and only from
-     * a seperate thread.
+     * a seperate thread. The function has to block until there is something to
+     * do, e.g. with WaitForIncomingData(), but not longer than
+     * WAIT_TIMEOUT_MSEC so that a stop request is recognized in time.
      *
      * \param ComFunction function pointer that specifies the method to be executed
      * \param mutex the mutex that corresponds to the function pointer
@@ -293,6 +299,28 @@ namespace mitk {
     */
     unsigned int ReceivePrivate(igtl::Socket* device);
 
+    typedef std::list<igtl::Socket::Pointer> SocketListType;
+
+    /**
+    * \brief Waits until at least one of the given sockets has incoming data
+    * or the timeout elapsed.
+    *
+    * Uses select() on the socket descriptors, so the calling thread sleeps
+    * until data arrives instead of polling the sockets. If there is no socket
+    * to wait for the method just sleeps for the given time.
+    *
+    * \param sockets the sockets to watch
+    * \param timeoutMSec maximum time to wait in milliseconds
+    * \return the sockets that can be read without blocking. If select()
+    * failed all watched sockets are returned, so that ReceivePrivate() can
+    * detect closed connections.
+    */
+    static SocketListType WaitForIncomingData(const SocketListType& sockets, unsigned int timeoutMSec);
+
+    /** maximum time in ms the communication threads block while waiting for
+    data, messages or connections before they check for a stop request */
+    static const unsigned int WAIT_TIMEOUT_MSEC = 20;
+
     /**
     * \brief Call this method to send a message. The message will be read from
     * the queue.
@@ -328,10 +356,8 @@ namespace mitk {
     /** the name of this device */
     std::string m_Name;
 
-    /** signal used to stop the thread*/
-    bool m_StopCommunication;
-    /** mutex to control access to m_StopCommunication */
-    itk::FastMutexLock::Pointer m_StopCommunicationMutex;
+    /** signal used to stop the threads, checked by them in every iteration */
+    std::atomic<bool> m_StopCommunication;
     /** mutex used to make sure that the send thread is just started once */
     itk::FastMutexLock::Pointer m_SendingFinishedMutex;
     /** mutex used to make sure that the receive thread is just started once */
@@ -18,204 +18,120 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <string>
 #include "igtlMessageBase.h"
 
+#include <chrono>
+
+namespace
+{
+  // images are large, so fewer of them are buffered
+  const unsigned int DEFAULT_CAPACITY = 1024;
+  const unsigned int DEFAULT_IMAGE_CAPACITY = 32;
+}
+
 void mitk::IGTLMessageQueue::PushSendMessage(mitk::IGTLMessage::Pointer message)
 {
-  this->m_Mutex->Lock();
-  if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-    m_SendQueue.clear();
+  m_SendQueue->Push(message);
 
-  m_SendQueue.push_back(message);
-  this->m_Mutex->Unlock();
+  this->WakeUpSendWaiters();
 }
 
-void mitk::IGTLMessageQueue::PushCommandMessage(igtl::MessageBase::Pointer message)
+bool mitk::IGTLMessageQueue::WaitForSendMessage(unsigned int timeoutMSec)
 {
-  this->m_Mutex->Lock();
-  if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-    m_CommandQueue.clear();
+  std::unique_lock<std::mutex> lock(m_SendSignalMutex);
+  unsigned long wakeUps = m_SendWakeUps;
 
-  m_CommandQueue.push_back(message);
-  this->m_Mutex->Unlock();
+  auto hasSendMessage = [this]() { return this->m_SendQueue->GetSize() > 0; };
+
+  if (hasSendMessage())
+    return true;
+
+  m_SendSignal.wait_for(lock, std::chrono::milliseconds(timeoutMSec),
+    [this, wakeUps]() { return m_SendWakeUps != wakeUps; });
+
+  return hasSendMessage();
 }
 
-void mitk::IGTLMessageQueue::PushMessage(igtl::MessageBase::Pointer msg)
+void mitk::IGTLMessageQueue::WakeUpSendWaiters()
 {
-  this->m_Mutex->Lock();
+  {
+    std::lock_guard<std::mutex> lock(m_SendSignalMutex);
+    ++m_SendWakeUps;
+  }
+  m_SendSignal.notify_all();
+}
 
-  std::stringstream infolog;
+void mitk::IGTLMessageQueue::PushCommandMessage(igtl::MessageBase::Pointer message)
+{
+  m_ReceiveQueues[CommandQueue]->Push(message);
+}
 
-  infolog << "Received message of type ";
+void mitk::IGTLMessageQueue::PushMessage(igtl::MessageBase::Pointer msg)
+{
+  QueueType queue = MiscQueue;
 
   if (dynamic_cast<igtl::TrackingDataMessage*>(msg.GetPointer()) != nullptr)
   {
-    if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-      m_TrackingDataQueue.clear();
-
-    this->m_TrackingDataQueue.push_back(dynamic_cast<igtl::TrackingDataMessage*>(msg.GetPointer()));
-
-    infolog << "TDATA";
+    queue = TrackingDataQueue;
   }
   else if (dynamic_cast<igtl::TransformMessage*>(msg.GetPointer()) != nullptr)
   {
-    if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-      m_TransformQueue.clear();
-
-    this->m_TransformQueue.push_back(dynamic_cast<igtl::TransformMessage*>(msg.GetPointer()));
-
-    infolog << "TRANSFORM";
+    queue = TransformQueue;
   }
   else if (dynamic_cast<igtl::StringMessage*>(msg.GetPointer()) != nullptr)
   {
-    if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-      m_StringQueue.clear();
-
-    this->m_StringQueue.push_back(dynamic_cast<igtl::StringMessage*>(msg.GetPointer()));
-
-    infolog << "STRING";
+    queue = StringQueue;
   }
   else if (dynamic_cast<igtl::ImageMessage*>(msg.GetPointer()) != nullptr)
   {
-    igtl::ImageMessage::Pointer imageMsg = dynamic_cast<igtl::ImageMessage*>(msg.GetPointer());
-    int* dim = new int[3];
-    imageMsg->GetDimensions(dim);
-    if (dim[2] > 1)
-    {
-      if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-        m_Image3dQueue.clear();
-
-      this->m_Image3dQueue.push_back(dynamic_cast<igtl::ImageMessage*>(msg.GetPointer()));
-
-      infolog << "IMAGE3D";
-    }
-    else
-    {
-      if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-        m_Image2dQueue.clear();
-
-      this->m_Image2dQueue.push_back(dynamic_cast<igtl::ImageMessage*>(msg.GetPointer()));
-
-      infolog << "IMAGE2D";
-    }
+    int dim[3];
+    static_cast<igtl::ImageMessage*>(msg.GetPointer())->GetDimensions(dim);
+    queue = dim[2] > 1 ? Image3dQueue : Image2dQueue;
   }
-  else
-  {
-    if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-      m_MiscQueue.clear();
 
-    this->m_MiscQueue.push_back(msg);
-
-    infolog << "OTHER";
-  }
+  m_ReceiveQueues[queue]->Push(msg);
 
+  this->m_Mutex->Lock();
   m_Latest_Message = msg;
-
-  //MITK_INFO << infolog.str();
-
   this->m_Mutex->Unlock();
 }
 
 mitk::IGTLMessage::Pointer mitk::IGTLMessageQueue::PullSendMessage()
 {
-  mitk::IGTLMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_SendQueue.size() > 0)
-  {
-    ret = this->m_SendQueue.front();
-    this->m_SendQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return m_SendQueue->Pop();
 }
 
 igtl::MessageBase::Pointer mitk::IGTLMessageQueue::PullMiscMessage()
 {
-  igtl::MessageBase::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_MiscQueue.size() > 0)
-  {
-    ret = this->m_MiscQueue.front();
-    this->m_MiscQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return m_ReceiveQueues[MiscQueue]->Pop();
 }
 
 igtl::ImageMessage::Pointer mitk::IGTLMessageQueue::PullImage2dMessage()
 {
-  igtl::ImageMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_Image2dQueue.size() > 0)
-  {
-    ret = this->m_Image2dQueue.front();
-    this->m_Image2dQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return static_cast<igtl::ImageMessage*>(m_ReceiveQueues[Image2dQueue]->Pop().GetPointer());
 }
 
 igtl::ImageMessage::Pointer mitk::IGTLMessageQueue::PullImage3dMessage()
 {
-  igtl::ImageMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_Image3dQueue.size() > 0)
-  {
-    ret = this->m_Image3dQueue.front();
-    this->m_Image3dQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return static_cast<igtl::ImageMessage*>(m_ReceiveQueues[Image3dQueue]->Pop().GetPointer());
 }
 
 igtl::TrackingDataMessage::Pointer mitk::IGTLMessageQueue::PullTrackingMessage()
 {
-  igtl::TrackingDataMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_TrackingDataQueue.size() > 0)
-  {
-    ret = this->m_TrackingDataQueue.front();
-    this->m_TrackingDataQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return static_cast<igtl::TrackingDataMessage*>(m_ReceiveQueues[TrackingDataQueue]->Pop().GetPointer());
 }
 
 igtl::MessageBase::Pointer mitk::IGTLMessageQueue::PullCommandMessage()
 {
-  igtl::MessageBase::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_CommandQueue.size() > 0)
-  {
-    ret = this->m_CommandQueue.front();
-    this->m_CommandQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return m_ReceiveQueues[CommandQueue]->Pop();
 }
 
 igtl::StringMessage::Pointer mitk::IGTLMessageQueue::PullStringMessage()
 {
-  igtl::StringMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_StringQueue.size() > 0)
-  {
-    ret = this->m_StringQueue.front();
-    this->m_StringQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return static_cast<igtl::StringMessage*>(m_ReceiveQueues[StringQueue]->Pop().GetPointer());
 }
 
 igtl::TransformMessage::Pointer mitk::IGTLMessageQueue::PullTransformMessage()
 {
-  igtl::TransformMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_TransformQueue.size() > 0)
-  {
-    ret = this->m_TransformQueue.front();
-    this->m_TransformQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
-  return ret;
+  return static_cast<igtl::TransformMessage*>(m_ReceiveQueues[TransformQueue]->Pop().GetPointer());
 }
 
 std::string mitk::IGTLMessageQueue::GetNextMsgInformationString()
@@ -286,27 +202,80 @@ std::string mitk::IGTLMessageQueue::GetLatestMsgDeviceType()
 
 int mitk::IGTLMessageQueue::GetSize()
 {
-  return (this->m_CommandQueue.size() + this->m_Image2dQueue.size() + this->m_Image3dQueue.size() + this->m_MiscQueue.size()
-    + this->m_StringQueue.size() + this->m_TrackingDataQueue.size() + this->m_TransformQueue.size());
+  std::size_t size = 0;
+  for (int queue = 0; queue < SendQueue; ++queue)
+    size += m_ReceiveQueues[queue]->GetSize();
+  return static_cast<int>(size);
 }
 
 void mitk::IGTLMessageQueue::EnableNoBufferingMode(bool enable)
 {
-  this->m_Mutex->Lock();
-  if (enable)
-    this->m_BufferingType = IGTLMessageQueue::BufferingType::NoBuffering;
+  DropPolicy policy = enable ? ReceiveBufferType::LatestOnly : ReceiveBufferType::DropOldest;
+  for (int queue = 0; queue <= SendQueue; ++queue)
+    this->SetDropPolicy(static_cast<QueueType>(queue), policy);
+}
+
+void mitk::IGTLMessageQueue::SetDropPolicy(QueueType queue, DropPolicy policy)
+{
+  if (queue == SendQueue)
+    m_SendQueue->SetDropPolicy(static_cast<SendBufferType::DropPolicy>(policy));
   else
-    this->m_BufferingType = IGTLMessageQueue::BufferingType::Infinit;
-  this->m_Mutex->Unlock();
+    m_ReceiveQueues[queue]->SetDropPolicy(policy);
+}
+
+mitk::IGTLMessageQueue::DropPolicy mitk::IGTLMessageQueue::GetDropPolicy(QueueType queue)
+{
+  if (queue == SendQueue)
+    return static_cast<DropPolicy>(m_SendQueue->GetDropPolicy());
+  return m_ReceiveQueues[queue]->GetDropPolicy();
+}
+
+void mitk::IGTLMessageQueue::SetCapacity(QueueType queue, unsigned int capacity)
+{
+  DropPolicy policy = this->GetDropPolicy(queue);
+  if (queue == SendQueue)
+    m_SendQueue.reset(new SendBufferType(capacity));
+  else
+    m_ReceiveQueues[queue].reset(new ReceiveBufferType(capacity));
+  this->SetDropPolicy(queue, policy);
+}
+
+unsigned int mitk::IGTLMessageQueue::GetCapacity(QueueType queue)
+{
+  if (queue == SendQueue)
+    return static_cast<unsigned int>(m_SendQueue->GetCapacity());
+  return static_cast<unsigned int>(m_ReceiveQueues[queue]->GetCapacity());
+}
+
+unsigned int mitk::IGTLMessageQueue::GetQueueDepth(QueueType queue)
+{
+  if (queue == SendQueue)
+    return static_cast<unsigned int>(m_SendQueue->GetSize());
+  return static_cast<unsigned int>(m_ReceiveQueues[queue]->GetSize());
+}
+
+unsigned long long mitk::IGTLMessageQueue::GetNumberOfDroppedMessages(QueueType queue)
+{
+  if (queue == SendQueue)
+    return m_SendQueue->GetNumberOfDroppedItems();
+  return m_ReceiveQueues[queue]->GetNumberOfDroppedItems();
 }
 
 mitk::IGTLMessageQueue::IGTLMessageQueue()
 {
   this->m_Mutex = itk::FastMutexLock::New();
-  this->m_BufferingType = IGTLMessageQueue::NoBuffering;
+  this->m_SendWakeUps = 0;
+
+  for (int queue = 0; queue < SendQueue; ++queue)
+  {
+    unsigned int capacity = (queue == Image2dQueue || queue == Image3dQueue) ? DEFAULT_IMAGE_CAPACITY : DEFAULT_CAPACITY;
+    m_ReceiveQueues[queue].reset(new ReceiveBufferType(capacity));
+  }
+  m_SendQueue.reset(new SendBufferType(DEFAULT_CAPACITY));
+
+  this->EnableNoBufferingMode(true);
 }
 
 mitk::IGTLMessageQueue::~IGTLMessageQueue()
 {
-  this->m_Mutex->Unlock();
 }
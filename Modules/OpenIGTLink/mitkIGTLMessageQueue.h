@@ -23,8 +23,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkFastMutexLock.h"
 #include "mitkCommon.h"
 
-#include <deque>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <mitkIGTLMessage.h>
+#include "mitkIGTLRingBuffer.h"
 
 //OpenIGTLink
 #include "igtlMessageBase.h"
@@ -38,6 +41,12 @@ namespace mitk {
   * \class IGTLMessageQueue
   * \brief Thread safe message queue to store OpenIGTLink messages.
   *
+  * Every message type is stored in its own lock-free ring buffer, so pushing
+  * and pulling e.g. a large image does not block the tracking data. The
+  * buffers have a fixed capacity; if a buffer is full the oldest message is
+  * dropped. The queue depth and the number of dropped messages can be queried
+  * per queue.
+  *
   * \ingroup OpenIGTLink
   */
   class MITKOPENIGTLINK_EXPORT IGTLMessageQueue : public itk::Object
@@ -54,6 +63,16 @@ namespace mitk {
        */
     enum BufferingType { Infinit, NoBuffering };
 
+    /**
+    * \brief The queues of the different message types
+    */
+    enum QueueType { CommandQueue, Image2dQueue, Image3dQueue, TransformQueue,
+      TrackingDataQueue, StringQueue, MiscQueue, SendQueue };
+
+    typedef IGTLRingBuffer<igtl::MessageBase::Pointer> ReceiveBufferType;
+    typedef IGTLRingBuffer<mitk::IGTLMessage::Pointer> SendBufferType;
+    typedef ReceiveBufferType::DropPolicy DropPolicy;
+
     void PushSendMessage(mitk::IGTLMessage::Pointer message);
 
     /**
@@ -77,6 +96,19 @@ namespace mitk {
     igtl::TransformMessage::Pointer PullTransformMessage();
     mitk::IGTLMessage::Pointer PullSendMessage();
 
+    /**
+    * \brief Blocks until a message is pushed to the send queue, WakeUpSendWaiters()
+    * is called or the timeout elapsed.
+    *
+    * \return true if the send queue contains a message
+    */
+    bool WaitForSendMessage(unsigned int timeoutMSec);
+
+    /**
+    * \brief Lets all threads that are waiting in WaitForSendMessage() return
+    */
+    void WakeUpSendWaiters();
+
     /**
     * \brief Get the number of messages in the queue
     */
@@ -105,38 +137,70 @@ namespace mitk {
     std::string GetLatestMsgDeviceType();
 
     /**
-     */
+    * \brief Sets the policy of all queues: NoBuffering keeps just the latest
+    * message (LatestOnly), Infinit keeps as many messages as the capacity of
+    * the queue allows (DropOldest).
+    */
     void EnableNoBufferingMode(bool enable);
 
+    /**
+    * \brief Sets the drop policy of a single queue
+    */
+    void SetDropPolicy(QueueType queue, DropPolicy policy);
+    DropPolicy GetDropPolicy(QueueType queue);
+
+    /**
+    * \brief Sets the maximum number of messages of the given queue (rounded
+    * up to a power of two).
+    *
+    * The stored messages of this queue are discarded. This must not be called
+    * while other threads access the queue, i.e. before the communication of
+    * the device is started.
+    */
+    void SetCapacity(QueueType queue, unsigned int capacity);
+    unsigned int GetCapacity(QueueType queue);
+
+    /**
+    * \brief Returns the number of messages that are currently in the queue
+    */
+    unsigned int GetQueueDepth(QueueType queue);
+
+    /**
+    * \brief Returns the number of messages that were dropped by the queue
+    * because it was full or because of the LatestOnly policy
+    */
+    unsigned long long GetNumberOfDroppedMessages(QueueType queue);
+
   protected:
     IGTLMessageQueue();
     virtual ~IGTLMessageQueue();
 
   protected:
     /**
-    * \brief Mutex to take car of the queue
+    * \brief Mutex to take care of the latest message
     */
     itk::FastMutexLock::Pointer m_Mutex;
 
     /**
-    * \brief the queue that stores pointer to the inserted messages
+    * \brief the lock-free buffers of the received messages, one per queue type
+    * (all types before SendQueue)
     */
-    std::deque< igtl::MessageBase::Pointer > m_CommandQueue;
-    std::deque< igtl::ImageMessage::Pointer > m_Image2dQueue;
-    std::deque< igtl::ImageMessage::Pointer > m_Image3dQueue;
-    std::deque< igtl::TransformMessage::Pointer > m_TransformQueue;
-    std::deque< igtl::TrackingDataMessage::Pointer > m_TrackingDataQueue;
-    std::deque< igtl::StringMessage::Pointer > m_StringQueue;
-    std::deque< igtl::MessageBase::Pointer > m_MiscQueue;
+    std::unique_ptr<ReceiveBufferType> m_ReceiveQueues[SendQueue];
 
-    std::deque< mitk::IGTLMessage::Pointer > m_SendQueue;
+    /**
+    * \brief the lock-free buffer of the messages that shall be sent
+    */
+    std::unique_ptr<SendBufferType> m_SendQueue;
 
     igtl::MessageBase::Pointer m_Latest_Message;
 
     /**
-    * \brief defines the kind of buffering
+    * \brief Signals the send thread that a message was pushed or that it
+    * should wake up. m_SendWakeUps is incremented with every signal.
     */
-    BufferingType m_BufferingType;
+    std::mutex m_SendSignalMutex;
+    std::condition_variable m_SendSignal;
+    unsigned long m_SendWakeUps;
   };
 }
 
@@ -0,0 +1,236 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKIGTLRINGBUFFER_H
+#define MITKIGTLRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace mitk {
+  /**
+  * \class IGTLRingBuffer
+  * \brief Bounded lock-free ring buffer for (smart pointers to) OpenIGTLink
+  * messages.
+  *
+  * Push() never blocks and never fails: if the buffer is full, the oldest
+  * items are dropped and counted. With the LatestOnly policy the buffer only
+  * keeps the newest item, i.e. every push drops all items that were not pulled
+  * yet.
+  *
+  * Each cell carries a sequence number that tells producers and consumers
+  * whether it can be written or read (D. Vyukov's bounded queue). Dropping is
+  * implemented as a pop by the producer, so the buffer is safe for several
+  * producers and consumers. Items are copied in and out of the cells, so T
+  * should be cheap to copy, e.g. an itk::SmartPointer.
+  *
+  * \ingroup OpenIGTLink
+  */
+  template <typename T>
+  class IGTLRingBuffer
+  {
+  public:
+    enum DropPolicy { DropOldest, LatestOnly };
+
+    /**
+    * \param capacity maximum number of stored items, rounded up to the next
+    * power of two (at least 2)
+    */
+    explicit IGTLRingBuffer(std::size_t capacity)
+      : m_EnqueuePosition(0), m_DequeuePosition(0), m_NumberOfDroppedItems(0), m_Policy(DropOldest)
+    {
+      std::size_t size = 2;
+      while (size < capacity)
+        size *= 2;
+
+      m_Mask = size - 1;
+      m_Cells.reset(new Cell[size]);
+      for (std::size_t i = 0; i < size; ++i)
+        m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    IGTLRingBuffer(const IGTLRingBuffer&) = delete;
+    IGTLRingBuffer& operator=(const IGTLRingBuffer&) = delete;
+
+    /**
+    * \brief Adds the item, dropping the oldest items if the buffer is full or
+    * all other items if the policy is LatestOnly
+    */
+    void Push(const T& item)
+    {
+      if (this->GetDropPolicy() == LatestOnly)
+        this->DropAll();
+
+      while (!this->TryPush(item))
+      {
+        T dropped;
+        if (this->TryPop(dropped))
+          ++m_NumberOfDroppedItems;
+      }
+    }
+
+    /**
+    * \brief Adds the item if the buffer is not full
+    */
+    bool TryPush(const T& item)
+    {
+      Cell* cell;
+      std::size_t position = m_EnqueuePosition.load(std::memory_order_relaxed);
+      while (true)
+      {
+        cell = &m_Cells[position & m_Mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (difference == 0)
+        {
+          if (m_EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if (difference < 0)
+        {
+          return false; // full
+        }
+        else
+        {
+          position = m_EnqueuePosition.load(std::memory_order_relaxed);
+        }
+      }
+
+      cell->data = item;
+      cell->sequence.store(position + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+    * \brief Removes the oldest item and copies it to the given one
+    * \return false if the buffer is empty
+    */
+    bool TryPop(T& item)
+    {
+      Cell* cell;
+      std::size_t position = m_DequeuePosition.load(std::memory_order_relaxed);
+      while (true)
+      {
+        cell = &m_Cells[position & m_Mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+        if (difference == 0)
+        {
+          if (m_DequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if (difference < 0)
+        {
+          return false; // empty
+        }
+        else
+        {
+          position = m_DequeuePosition.load(std::memory_order_relaxed);
+        }
+      }
+
+      item = cell->data;
+      // do not keep the message alive until the cell is reused
+      cell->data = T();
+      cell->sequence.store(position + m_Mask + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+    * \brief Removes and returns the oldest item or a default constructed one
+    * (nullptr for smart pointers) if the buffer is empty
+    */
+    T Pop()
+    {
+      T item = T();
+      this->TryPop(item);
+      return item;
+    }
+
+    /**
+    * \brief Removes all items, they are counted as dropped
+    */
+    void DropAll()
+    {
+      T dropped;
+      while (this->TryPop(dropped))
+        ++m_NumberOfDroppedItems;
+    }
+
+    /**
+    * \brief Returns the number of stored items. This is a snapshot if other
+    * threads push or pop meanwhile.
+    */
+    std::size_t GetSize() const
+    {
+      std::size_t dequeuePosition = m_DequeuePosition.load(std::memory_order_relaxed);
+      std::size_t enqueuePosition = m_EnqueuePosition.load(std::memory_order_relaxed);
+      return enqueuePosition > dequeuePosition ? enqueuePosition - dequeuePosition : 0;
+    }
+
+    std::size_t GetCapacity() const
+    {
+      return m_Mask + 1;
+    }
+
+    /**
+    * \brief Returns the number of items that were dropped because the buffer
+    * was full or because of the LatestOnly policy
+    */
+    unsigned long long GetNumberOfDroppedItems() const
+    {
+      return m_NumberOfDroppedItems.load(std::memory_order_relaxed);
+    }
+
+    void ResetNumberOfDroppedItems()
+    {
+      m_NumberOfDroppedItems.store(0, std::memory_order_relaxed);
+    }
+
+    void SetDropPolicy(DropPolicy policy)
+    {
+      m_Policy.store(policy, std::memory_order_relaxed);
+    }
+
+    DropPolicy GetDropPolicy() const
+    {
+      return m_Policy.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct Cell
+    {
+      std::atomic<std::size_t> sequence;
+      T data;
+    };
+
+    std::unique_ptr<Cell[]> m_Cells;
+    std::size_t m_Mask;
+
+    // the padding keeps the positions on separate cache lines to avoid false
+    // sharing between producer and consumer
+    char m_Padding0[64];
+    std::atomic<std::size_t> m_EnqueuePosition;
+    char m_Padding1[64];
+    std::atomic<std::size_t> m_DequeuePosition;
+    char m_Padding2[64];
+    std::atomic<unsigned long long> m_NumberOfDroppedItems;
+    std::atomic<DropPolicy> m_Policy;
+  };
+}
+
+#endif
@@ -16,6 +16,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkIGTLServer.h"
 #include <stdio.h>
+#include <algorithm>
 
 #include <itksys/SystemTools.hxx>
 #include <itkMutexLockHolder.h>
@@ -94,7 +95,7 @@ void mitk::IGTLServer::Connect()
   igtl::Socket::Pointer socket;
   //check if another igtl device wants to connect to this socket
   socket =
-    ((igtl::ServerSocket*)(this->m_Socket.GetPointer()))->WaitForConnection(1);
+    ((igtl::ServerSocket*)(this->m_Socket.GetPointer()))->WaitForConnection(WAIT_TIMEOUT_MSEC);
   //if there is a new connection the socket is not null
   if (socket.IsNotNull())
   {
@@ -115,22 +116,33 @@ void mitk::IGTLServer::Receive()
   unsigned int status = IGTL_STATUS_OK;
   SocketListType socketsToBeRemoved;
 
-  //the server can be connected with several clients, therefore it has to check
-  //all registered clients
-  SocketListIteratorType it;
+  //the server can be connected with several clients, therefore it has to wait
+  //for all registered clients. This is done on a copy of the list without
+  //holding the lock, so that new clients can be registered meanwhile.
   m_ReceiveListMutex->Lock();
-  auto it_end = this->m_RegisteredClients.end();
-  for (it = this->m_RegisteredClients.begin(); it != it_end; ++it)
+  SocketListType registeredClients(this->m_RegisteredClients);
+  m_ReceiveListMutex->Unlock();
+
+  SocketListType readableClients =
+    WaitForIncomingData(registeredClients, WAIT_TIMEOUT_MSEC);
+
+  m_ReceiveListMutex->Lock();
+  for (auto& client : readableClients)
   {
+    //the client might have been removed while waiting
+    if (std::find(this->m_RegisteredClients.begin(),
+      this->m_RegisteredClients.end(), client) == this->m_RegisteredClients.end())
+      continue;
+
     //it is possible that ReceivePrivate detects that the current socket is
     //already disconnected. Therefore, it is necessary to remove this socket
     //from the registered clients list
-    status = this->ReceivePrivate(*it);
+    status = this->ReceivePrivate(client);
     if (status == IGTL_STATUS_NOT_PRESENT)
     {
       //remember this socket for later, it is not a good idea to remove it
       //from the list directly because we iterate over the list at this point
-      socketsToBeRemoved.push_back(*it);
+      socketsToBeRemoved.push_back(client);
       MITK_WARN("IGTLServer") << "Lost connection to a client socket. ";
     }
     else if (status != 1)
@@ -150,6 +162,10 @@ void mitk::IGTLServer::Receive()
 
 void mitk::IGTLServer::Send()
 {
+  //sleep until a message is queued or the communication is stopped
+  if (!this->m_MessageQueue->WaitForSendMessage(WAIT_TIMEOUT_MSEC))
+    return;
+
   //get the latest message from the queue
   mitk::IGTLMessage::Pointer curMessage = this->m_MessageQueue->PullSendMessage();
 
@@ -19,17 +19,18 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkPhotoacousticBeamformingFilter.h"
 #include "mitkProperties.h"
 #include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
 #include <algorithm>
 #include <itkImageIOBase.h>
 #include <chrono>
 #include <cmath>
-#include <thread>
-#include <itkImageIOBase.h>
+#include <atomic>
 #include "mitkImageCast.h"
 #include <mitkPhotoacousticOCLBeamformer.h>
 
 
-mitk::BeamformingFilter::BeamformingFilter() : m_OutputData(nullptr), m_InputData(nullptr)
+mitk::BeamformingFilter::BeamformingFilter() : m_ApodWindow(nullptr), m_ApodArraySize(0), m_ApodWindowType(beamformingSettings::Apodization::Box),
+  m_JobGeneration(0), m_BusyWorkers(0), m_StopWorkers(false), m_Kernels(&BeamformingKernels::GetBeamformingKernels())
 {
   this->SetNumberOfIndexedInputs(1);
   this->SetNumberOfRequiredInputs(1);
@@ -44,6 +45,8 @@ void mitk::BeamformingFilter::SetProgressHandle(std::function<void(int, std::str
 
 mitk::BeamformingFilter::~BeamformingFilter()
 {
+  StopWorkers();
+  delete[] m_ApodWindow;
 }
 
 void mitk::BeamformingFilter::GenerateInputRequestedRegion()
@@ -110,111 +113,92 @@ void mitk::BeamformingFilter::GenerateData()
   unsigned int oclInputDimLastChunk[3] = { input->GetDimension(0), input->GetDimension(1), input->GetDimension(2) % chunkSize };
 
   const int apodArraySize = m_Conf.TransducerElements * 4; // set the resolution of the apodization array
-  float* ApodWindow;
-
-  // calculate the appropiate apodization window
-  switch (m_Conf.Apod)
-  {
-  case beamformingSettings::Apodization::Hann:
-    ApodWindow = VonHannFunction(apodArraySize);
-    break;
-  case beamformingSettings::Apodization::Hamm:
-    ApodWindow = HammFunction(apodArraySize);
-    break;
-  case beamformingSettings::Apodization::Box:
-    ApodWindow = BoxFunction(apodArraySize);
-    break;
-  default:
-    ApodWindow = BoxFunction(apodArraySize);
-    break;
-  }
-
-  int progInterval = output->GetDimension(2) / 20 > 1 ? output->GetDimension(2) / 20 : 1;
-  // the interval at which we update the gui progress bar
+  float* ApodWindow = GetApodizationWindow(apodArraySize);
 
   auto begin = std::chrono::high_resolution_clock::now(); // debbuging the performance...
   if (!m_Conf.UseGPU)
   {
-    for (unsigned int i = 0; i < output->GetDimension(2); ++i) // seperate Slices should get Beamforming seperately applied
+    // first, we convert any data to float, which we use by default
+    if (input->GetPixelType().GetTypeAsString() != "scalar (float)" && input->GetPixelType().GetTypeAsString() != " (float)")
     {
-      mitk::ImageReadAccessor inputReadAccessor(input, input->GetSliceData(i));
+      MITK_INFO << "Pixel type is not float, abort";
+      return;
+    }
 
-      m_OutputData = new float[m_Conf.ReconstructionLines*m_Conf.SamplesPerLine];
-      m_InputDataPuffer = new float[input->GetDimension(0)*input->GetDimension(1)];
+    mitk::ImageReadAccessor inputReadAccessor(input);
+    mitk::ImageWriteAccessor outputWriteAccessor(output);
 
-      // first, we convert any data to float, which we use by default
-      if (input->GetPixelType().GetTypeAsString() == "scalar (float)" || input->GetPixelType().GetTypeAsString() == " (float)")
-      {
-        m_InputData = (float*)inputReadAccessor.GetData();
-      }
-      else
-      {
-        MITK_INFO << "Pixel type is not float, abort";
-        return;
-      }
+    float* inputData = (float*)const_cast<void*>(inputReadAccessor.GetData());
+    float* outputData = (float*)outputWriteAccessor.GetData();
 
-      // fill the image with zeros
-      for (int l = 0; l < outputDim[0]; ++l)
-      {
-        for (int s = 0; s < outputDim[1]; ++s)
-        {
-          m_OutputData[l*(short)outputDim[1] + s] = 0;
-        }
-      }
+    const unsigned int slices = output->GetDimension(2);
+    const unsigned int inputSliceSize = input->GetDimension(0) * input->GetDimension(1);
+    const unsigned int outputSliceSize = output->GetDimension(0) * output->GetDimension(1);
 
-      std::thread *threads = new std::thread[(short)outputDim[0]];
+    // fill the image with zeros
+    std::fill(outputData, outputData + (size_t)outputSliceSize * slices, 0.0f);
 
-      // every line will be beamformed in a seperate thread
-      if (m_Conf.Algorithm == beamformingSettings::BeamformingAlgorithm::DAS)
-      {
-        if (m_Conf.DelayCalculationMethod == beamformingSettings::DelayCalc::QuadApprox)
-        {
-          for (short line = 0; line < outputDim[0]; ++line)
-          {
-            threads[line] = std::thread(&BeamformingFilter::DASQuadraticLine, this, m_InputData, m_OutputData, inputDim, outputDim, line, ApodWindow, apodArraySize);
-          }
-        }
-        else if (m_Conf.DelayCalculationMethod == beamformingSettings::DelayCalc::Spherical)
-        {
-          for (short line = 0; line < outputDim[0]; ++line)
-          {
-            threads[line] = std::thread(&BeamformingFilter::DASSphericalLine, this, m_InputData, m_OutputData, inputDim, outputDim, line, ApodWindow, apodArraySize);
-          }
-        }
-      }
-      else if (m_Conf.Algorithm == beamformingSettings::BeamformingAlgorithm::DMAS)
+    // the output lines of all slices are split into tiles of adjacent lines, which are handed out to the
+    // worker threads on demand; this way several slices are reconstructed concurrently and the threads
+    // rarely write to the same cache lines of the output
+    const unsigned int linesPerTile = m_Conf.LinesPerTile > 0 ? m_Conf.LinesPerTile : 1;
+    const unsigned int tilesPerSlice = (output->GetDimension(0) + linesPerTile - 1) / linesPerTile;
+    const unsigned int numberOfTiles = tilesPerSlice * slices;
+
+    std::atomic<unsigned int> nextTile(0);
+    std::atomic<unsigned int> finishedTiles(0);
+
+    unsigned int numberOfThreads = m_Conf.NumberOfThreads;
+    if (numberOfThreads == 0)
+      numberOfThreads = std::thread::hardware_concurrency();
+    if (numberOfThreads == 0)
+      numberOfThreads = 1;
+    StartWorkers(std::min(numberOfThreads, numberOfTiles > 0 ? numberOfTiles : 1));
+
+    auto beamformTiles = [&](unsigned int)
+    {
+      // local copies, as the line functions take the dimensions by pointer
+      float threadInputDim[2] = { inputDim[0], inputDim[1] };
+      float threadOutputDim[2] = { outputDim[0], outputDim[1] };
+
+      for (unsigned int tile = nextTile++; tile < numberOfTiles; tile = nextTile++)
       {
-        if (m_Conf.DelayCalculationMethod == beamformingSettings::DelayCalc::QuadApprox)
+        unsigned int slice = tile / tilesPerSlice;
+        short firstLine = (short)((tile % tilesPerSlice) * linesPerTile);
+        short lastLine = (short)std::min((unsigned int)firstLine + linesPerTile, output->GetDimension(0));
+
+        float* sliceInput = inputData + (size_t)slice * inputSliceSize;
+        float* sliceOutput = outputData + (size_t)slice * outputSliceSize;
+
+        for (short line = firstLine; line < lastLine; ++line)
         {
-          for (short line = 0; line < outputDim[0]; ++line)
+          if (m_Conf.Algorithm == beamformingSettings::BeamformingAlgorithm::DAS)
           {
-            threads[line] = std::thread(&BeamformingFilter::DMASQuadraticLine, this, m_InputData, m_OutputData, inputDim, outputDim, line, ApodWindow, apodArraySize);
+            if (m_Conf.DelayCalculationMethod == beamformingSettings::DelayCalc::QuadApprox)
+              DASQuadraticLine(sliceInput, sliceOutput, threadInputDim, threadOutputDim, line, ApodWindow, apodArraySize);
+            else if (m_Conf.DelayCalculationMethod == beamformingSettings::DelayCalc::Spherical)
+              DASSphericalLine(sliceInput, sliceOutput, threadInputDim, threadOutputDim, line, ApodWindow, apodArraySize);
           }
-        }
-        else if (m_Conf.DelayCalculationMethod == beamformingSettings::DelayCalc::Spherical)
-        {
-          for (short line = 0; line < outputDim[0]; ++line)
+          else if (m_Conf.Algorithm == beamformingSettings::BeamformingAlgorithm::DMAS)
           {
-            threads[line] = std::thread(&BeamformingFilter::DMASSphericalLine, this, m_InputData, m_OutputData, inputDim, outputDim, line, ApodWindow, apodArraySize);
+            if (m_Conf.DelayCalculationMethod == beamformingSettings::DelayCalc::QuadApprox)
+              DMASQuadraticLine(sliceInput, sliceOutput, threadInputDim, threadOutputDim, line, ApodWindow, apodArraySize);
+            else if (m_Conf.DelayCalculationMethod == beamformingSettings::DelayCalc::Spherical)
+              DMASSphericalLine(sliceInput, sliceOutput, threadInputDim, threadOutputDim, line, ApodWindow, apodArraySize);
           }
         }
+        ++finishedTiles;
       }
-      // wait for all lines to finish
-      for (short line = 0; line < outputDim[0]; ++line)
-      {
-        threads[line].join();
-      }
+    };
 
-      output->SetSlice(m_OutputData, i);
-
-      if (i % progInterval == 0)
-        m_ProgressHandle((int)((i + 1) / (float)output->GetDimension(2) * 100), "performing reconstruction");
+    // the gui progress bar is updated from this thread only
+    auto reportProgress = [&]()
+    {
+      m_ProgressHandle((int)(finishedTiles / (float)(numberOfTiles > 0 ? numberOfTiles : 1) * 100), "performing reconstruction");
+    };
 
-      delete[] m_OutputData;
-      delete[] m_InputDataPuffer;
-      m_OutputData = nullptr;
-      m_InputData = nullptr;
-    }
+    MITK_INFO << "Beamforming on " << m_Workers.size() << " threads using the " << m_Kernels->Name << " kernels";
+    RunOnWorkers(beamformTiles, reportProgress);
   }
   else
   {
@@ -305,7 +289,112 @@ void mitk::BeamformingFilter::GenerateData()
   m_TimeOfHeaderInitialization.Modified();
 
   auto end = std::chrono::high_resolution_clock::now();
-  MITK_INFO << "Beamforming of " << output->GetDimension(2) << " Images completed in " << ((float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()) / 1000000 << "ms" << std::endl;
+  float elapsedMilliseconds = ((float)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()) / 1000000;
+  MITK_INFO << "Beamforming of " << output->GetDimension(2) << " Images completed in " << elapsedMilliseconds << "ms ("
+    << (elapsedMilliseconds > 0 ? output->GetDimension(2) * 1000 / elapsedMilliseconds : 0) << " frames/s)" << std::endl;
+}
+
+float* mitk::BeamformingFilter::GetApodizationWindow(int apodArraySize)
+{
+  if (m_ApodWindow != nullptr && m_ApodArraySize == apodArraySize && m_ApodWindowType == m_Conf.Apod)
+    return m_ApodWindow;
+
+  delete[] m_ApodWindow;
+
+  // calculate the appropiate apodization window
+  switch (m_Conf.Apod)
+  {
+  case beamformingSettings::Apodization::Hann:
+    m_ApodWindow = VonHannFunction(apodArraySize);
+    break;
+  case beamformingSettings::Apodization::Hamm:
+    m_ApodWindow = HammFunction(apodArraySize);
+    break;
+  case beamformingSettings::Apodization::Box:
+    m_ApodWindow = BoxFunction(apodArraySize);
+    break;
+  default:
+    m_ApodWindow = BoxFunction(apodArraySize);
+    break;
+  }
+
+  m_ApodArraySize = apodArraySize;
+  m_ApodWindowType = m_Conf.Apod;
+
+  return m_ApodWindow;
+}
+
+void mitk::BeamformingFilter::StartWorkers(unsigned int numberOfThreads)
+{
+  if (m_Workers.size() == numberOfThreads)
+    return;
+
+  StopWorkers();
+
+  m_StopWorkers = false;
+  for (unsigned int threadId = 0; threadId < numberOfThreads; ++threadId)
+  {
+    // the workers are handed the current job generation, so a job posted before they are scheduled is not missed
+    m_Workers.push_back(std::thread(&BeamformingFilter::WorkerLoop, this, threadId, m_JobGeneration));
+  }
+}
+
+void mitk::BeamformingFilter::StopWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_WorkMutex);
+    m_StopWorkers = true;
+  }
+  m_WorkAvailable.notify_all();
+
+  for (auto& worker : m_Workers)
+  {
+    worker.join();
+  }
+  m_Workers.clear();
+}
+
+void mitk::BeamformingFilter::WorkerLoop(unsigned int threadId, unsigned long lastGeneration)
+{
+  while (true)
+  {
+    std::function<void(unsigned int)> job;
+    {
+      std::unique_lock<std::mutex> lock(m_WorkMutex);
+      m_WorkAvailable.wait(lock, [&] { return m_StopWorkers || m_JobGeneration != lastGeneration; });
+      if (m_StopWorkers)
+        return;
+      lastGeneration = m_JobGeneration;
+      job = m_CurrentJob;
+    }
+
+    job(threadId);
+
+    {
+      std::lock_guard<std::mutex> lock(m_WorkMutex);
+      if (--m_BusyWorkers == 0)
+        m_WorkDone.notify_all();
+    }
+  }
+}
+
+void mitk::BeamformingFilter::RunOnWorkers(std::function<void(unsigned int)> job, std::function<void()> progressCallback)
+{
+  std::unique_lock<std::mutex> lock(m_WorkMutex);
+  m_CurrentJob = job;
+  m_BusyWorkers = (unsigned int)m_Workers.size();
+  ++m_JobGeneration;
+  m_WorkAvailable.notify_all();
+
+  while (!m_WorkDone.wait_for(lock, std::chrono::milliseconds(100), [&] { return m_BusyWorkers == 0; }))
+  {
+    lock.unlock();
+    progressCallback();
+    lock.lock();
+  }
+  progressCallback();
+
+  m_CurrentJob = nullptr;
 }
 
 void mitk::BeamformingFilter::Configure(beamformingSettings settings)
@@ -357,7 +446,6 @@ void mitk::BeamformingFilter::DASQuadraticLine(float* input, float* output, floa
   float& outputS = outputDim[1];
   float& outputL = outputDim[0];
 
-  short AddSample = 0;
   short maxLine = 0;
   short minLine = 0;
   float delayMultiplicator = 0;
@@ -369,11 +457,19 @@ void mitk::BeamformingFilter::DASQuadraticLine(float* input, float* output, floa
   float part_multiplicator = tan_phi * m_Conf.TimeSpacing * m_Conf.SpeedOfSound / m_Conf.Pitch * m_Conf.ReconstructionLines / m_Conf.TransducerElements;
   float apod_mult = 1;
 
-  short usedLines = (maxLine - minLine);
+  int usedLines = (maxLine - minLine);
 
   //quadratic delay
   l_i = line / outputL * inputL;
 
+  BeamformingKernels::SampleParameters parameters;
+  parameters.Input = input;
+  parameters.InputLines = (int)inputL;
+  parameters.InputSamples = (int)inputS;
+  parameters.Spherical = false;
+  parameters.TruncateBeforeOffset = false;
+  parameters.Apodisation = apodisation;
+
   for (short sample = 0; sample < outputS; ++sample)
   {
     s_i = (float)sample / outputS * inputS / 2;
@@ -385,20 +481,20 @@ void mitk::BeamformingFilter::DASQuadraticLine(float* input, float* output, floa
 
     maxLine = (short)std::min((l_i + part) + 1, inputL);
     minLine = (short)std::max((l_i - part), 0.0f);
-    usedLines = (maxLine - minLine);
 
     apod_mult = apodArraySize / (maxLine - minLine);
 
     delayMultiplicator = pow((1 / (m_Conf.TimeSpacing*m_Conf.SpeedOfSound) * (m_Conf.Pitch*m_Conf.TransducerElements) / inputL), 2) / s_i / 2;
+    parameters.Multiplicator = delayMultiplicator;
 
-    for (short l_s = minLine; l_s < maxLine; ++l_s)
-    {
-      AddSample = delayMultiplicator * pow((l_s - l_i), 2) + s_i + (1 - m_Conf.Photoacoustic)*s_i;
-      if (AddSample < inputS && AddSample >= 0) 
-        output[sample*(short)outputL + line] += input[l_s + AddSample*(short)inputL] * apodisation[(short)((l_s - minLine)*apod_mult)];
-      else
-        --usedLines;
-    }
+    parameters.MinLine = minLine;
+    parameters.Count = maxLine - minLine;
+    parameters.LineOffset = minLine - l_i;
+    parameters.Sample = s_i;
+    parameters.Offset = (1 - m_Conf.Photoacoustic)*s_i;
+    parameters.ApodisationMultiplicator = apod_mult;
+
+    output[sample*(short)outputL + line] = m_Kernels->DelayAndSum(parameters, &usedLines);
     output[sample*(short)outputL + line] = output[sample*(short)outputL + line] / usedLines;
   }
 }
@@ -411,7 +507,6 @@ void mitk::BeamformingFilter::DASSphericalLine(float* input, float* output, floa
   float& outputS = outputDim[1];
   float& outputL = outputDim[0];
 
-  short AddSample = 0;
   short maxLine = 0;
   short minLine = 0;
   float l_i = 0;
@@ -422,12 +517,21 @@ void mitk::BeamformingFilter::DASSphericalLine(float* input, float* output, floa
   float part_multiplicator = tan_phi * m_Conf.TimeSpacing * m_Conf.SpeedOfSound / m_Conf.Pitch * m_Conf.ReconstructionLines / m_Conf.TransducerElements;
   float apod_mult = 1;
 
-  short usedLines = (maxLine - minLine);
+  int usedLines = (maxLine - minLine);
 
   //exact delay
 
   l_i = (float)line / outputL * inputL;
 
+  BeamformingKernels::SampleParameters parameters;
+  parameters.Input = input;
+  parameters.InputLines = (int)inputL;
+  parameters.InputSamples = (int)inputS;
+  parameters.Spherical = true;
+  parameters.TruncateBeforeOffset = true;
+  parameters.Apodisation = apodisation;
+  parameters.Multiplicator = 1 / (m_Conf.TimeSpacing*m_Conf.SpeedOfSound) * (m_Conf.Pitch*m_Conf.TransducerElements) / inputL;
+
   for (short sample = 0; sample < outputS; ++sample)
   {
     s_i = (float)sample / outputS * inputS / 2;
@@ -439,22 +543,17 @@ void mitk::BeamformingFilter::DASSphericalLine(float* input, float* output, floa
 
     maxLine = (short)std::min((l_i + part) + 1, inputL);
     minLine = (short)std::max((l_i - part), 0.0f);
-    usedLines = (maxLine - minLine);
 
     apod_mult = apodArraySize / (maxLine - minLine);
 
-    for (short l_s = minLine; l_s < maxLine; ++l_s)
-    {
-      AddSample = (int)sqrt(
-        pow(s_i, 2)
-        +
-        pow((1 / (m_Conf.TimeSpacing*m_Conf.SpeedOfSound) * ((l_s - l_i)*m_Conf.Pitch*m_Conf.TransducerElements) / inputL), 2)
-      ) + (1 - m_Conf.Photoacoustic)*s_i;
-      if (AddSample < inputS && AddSample >= 0) 
-        output[sample*(short)outputL + line] += input[l_s + AddSample*(short)inputL] * apodisation[(short)((l_s - minLine)*apod_mult)];
-      else
-        --usedLines;
-    }
+    parameters.MinLine = minLine;
+    parameters.Count = maxLine - minLine;
+    parameters.LineOffset = minLine - l_i;
+    parameters.Sample = s_i;
+    parameters.Offset = (1 - m_Conf.Photoacoustic)*s_i;
+    parameters.ApodisationMultiplicator = apod_mult;
+
+    output[sample*(short)outputL + line] = m_Kernels->DelayAndSum(parameters, &usedLines);
     output[sample*(short)outputL + line] = output[sample*(short)outputL + line] / usedLines;
   }
 }
@@ -478,12 +577,19 @@ void mitk::BeamformingFilter::DMASQuadraticLine(float* input, float* output, flo
   float part_multiplicator = tan_phi * m_Conf.TimeSpacing * m_Conf.SpeedOfSound / m_Conf.Pitch * m_Conf.ReconstructionLines / m_Conf.TransducerElements;
   float apod_mult = 1;
 
-  float mult = 0;
-  short usedLines = (maxLine - minLine);
+  int usedLines = (maxLine - minLine);
 
   //quadratic delay
   l_i = line / outputL * inputL;
 
+  BeamformingKernels::SampleParameters parameters;
+  parameters.Input = input;
+  parameters.InputLines = (int)inputL;
+  parameters.InputSamples = (int)inputS;
+  parameters.Spherical = false;
+  parameters.TruncateBeforeOffset = true;
+  parameters.Apodisation = apodisation;
+
   for (short sample = 0; sample < outputS; ++sample)
   {
     s_i = sample / outputS * inputS / 2;
@@ -495,39 +601,21 @@ void mitk::BeamformingFilter::DMASQuadraticLine(float* input, float* output, flo
 
     maxLine = (short)std::min((l_i + part) + 1, inputL);
     minLine = (short)std::max((l_i - part), 0.0f);
-    usedLines = (maxLine - minLine);
 
     apod_mult = apodArraySize / (maxLine - minLine);
 
     delayMultiplicator = pow((1 / (m_Conf.TimeSpacing*m_Conf.SpeedOfSound) * (m_Conf.Pitch*m_Conf.TransducerElements) / inputL), 2) / s_i / 2;
+    parameters.Multiplicator = delayMultiplicator;
 
-    //calculate the AddSamples beforehand to save some time
-    short* AddSample = new short[maxLine - minLine];
-    for (short l_s = 0; l_s < maxLine - minLine; ++l_s)
-    {
-      AddSample[l_s] = (short)(delayMultiplicator * pow((minLine + l_s - l_i), 2) + s_i) + (1 - m_Conf.Photoacoustic)*s_i;
-    }
-
-    for (short l_s1 = minLine; l_s1 < maxLine - 1; ++l_s1)
-    {
-      if (AddSample[l_s1 - minLine] < (short)inputS && AddSample[l_s1 - minLine] >= 0)
-      {
-        for (short l_s2 = l_s1 + 1; l_s2 < maxLine; ++l_s2)
-        {
-          if (AddSample[l_s2 - minLine] < inputS && AddSample[l_s2 - minLine] >= 0)
-          {
-            mult = input[l_s2 + AddSample[l_s2 - minLine] * (short)inputL] * apodisation[(short)((l_s2 - minLine)*apod_mult)] * input[l_s1 + AddSample[l_s1 - minLine] * (short)inputL] * apodisation[(short)((l_s1 - minLine)*apod_mult)];
-            output[sample*(short)outputL + line] += sqrt(abs(mult)) * ((mult > 0) - (mult < 0));
-          }
-        }
-      }
-      else
-        --usedLines;
-    }
+    parameters.MinLine = minLine;
+    parameters.Count = maxLine - minLine;
+    parameters.LineOffset = minLine - l_i;
+    parameters.Sample = s_i;
+    parameters.Offset = (1 - m_Conf.Photoacoustic)*s_i;
+    parameters.ApodisationMultiplicator = apod_mult;
 
+    output[sample*(short)outputL + line] = m_Kernels->DelayMultiplyAndSum(parameters, &usedLines);
     output[sample*(short)outputL + line] = 10 * output[sample*(short)outputL + line] / (pow(usedLines, 2) - (usedLines - 1));
-
-    delete[] AddSample;
   }
 }
 
@@ -549,14 +637,21 @@ void mitk::BeamformingFilter::DMASSphericalLine(float* input, float* output, flo
   float part_multiplicator = tan_phi * m_Conf.TimeSpacing * m_Conf.SpeedOfSound / m_Conf.Pitch * m_Conf.ReconstructionLines / m_Conf.TransducerElements;
   float apod_mult = 1;
 
-  float mult = 0;
-
-  short usedLines = (maxLine - minLine);
+  int usedLines = (maxLine - minLine);
 
   //exact delay
 
   l_i = line / outputL * inputL;
 
+  BeamformingKernels::SampleParameters parameters;
+  parameters.Input = input;
+  parameters.InputLines = (int)inputL;
+  parameters.InputSamples = (int)inputS;
+  parameters.Spherical = true;
+  parameters.TruncateBeforeOffset = true;
+  parameters.Apodisation = apodisation;
+  parameters.Multiplicator = 1 / (m_Conf.TimeSpacing*m_Conf.SpeedOfSound) * (m_Conf.Pitch*m_Conf.TransducerElements) / inputL;
+
   for (short sample = 0; sample < outputS; ++sample)
   {
     s_i = sample / outputS * inputS / 2;
@@ -568,40 +663,17 @@ void mitk::BeamformingFilter::DMASSphericalLine(float* input, float* output, flo
 
     maxLine = (short)std::min((l_i + part) + 1, inputL);
     minLine = (short)std::max((l_i - part), 0.0f);
-    usedLines = (maxLine - minLine);
 
     apod_mult = apodArraySize / (maxLine - minLine);
 
-    //calculate the AddSamples beforehand to save some time
-    short* AddSample = new short[maxLine - minLine];
-    for (short l_s = 0; l_s < maxLine - minLine; ++l_s)
-    {
-      AddSample[l_s] = (short)sqrt(
-        pow(s_i, 2)
-        +
-        pow((1 / (m_Conf.TimeSpacing*m_Conf.SpeedOfSound) * ((minLine + l_s - l_i)*m_Conf.Pitch*m_Conf.TransducerElements) / inputL), 2)
-      ) + (1 - m_Conf.Photoacoustic)*s_i;
-    }
-
-    for (short l_s1 = minLine; l_s1 < maxLine - 1; ++l_s1)
-    {
-      if (AddSample[l_s1 - minLine] < inputS && AddSample[l_s1 - minLine] >= 0)
-      {
-        for (short l_s2 = l_s1 + 1; l_s2 < maxLine; ++l_s2)
-        {
-          if (AddSample[l_s2 - minLine] < inputS && AddSample[l_s2 - minLine] >= 0)
-          {
-            mult = input[l_s2 + AddSample[l_s2 - minLine] * (short)inputL] * apodisation[(int)((l_s2 - minLine)*apod_mult)] * input[l_s1 + AddSample[l_s1 - minLine] * (short)inputL] * apodisation[(int)((l_s1 - minLine)*apod_mult)];
-            output[sample*(short)outputL + line] += sqrt(abs(mult)) * ((mult > 0) - (mult < 0));
-          }
-        }
-      }
-      else
-        --usedLines;
-    }
+    parameters.MinLine = minLine;
+    parameters.Count = maxLine - minLine;
+    parameters.LineOffset = minLine - l_i;
+    parameters.Sample = s_i;
+    parameters.Offset = (1 - m_Conf.Photoacoustic)*s_i;
+    parameters.ApodisationMultiplicator = apod_mult;
 
+    output[sample*(short)outputL + line] = m_Kernels->DelayMultiplyAndSum(parameters, &usedLines);
     output[sample*(short)outputL + line] = 10 * output[sample*(short)outputL + line] / (pow(usedLines, 2) - (usedLines - 1));
-
-    delete[] AddSample;
   }
 }
@@ -19,7 +19,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define MITK_PHOTOACOUSTICS_BEAMFORMING_FILTER
 
 #include "mitkImageToImageFilter.h"
+#include "mitkPhotoacousticBeamformingKernels.h"
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
 
 namespace mitk {
 
@@ -62,6 +67,9 @@ namespace mitk {
       float BPHighPass = 50;
       float BPLowPass = 50;
       bool UseBP = false;
+
+      unsigned int NumberOfThreads = 0; // 0: use all available cores for the CPU path
+      unsigned int LinesPerTile = 8; // number of adjacent output lines scheduled as one unit of work
     };
 
     void Configure(beamformingSettings settings);
@@ -96,9 +104,35 @@ namespace mitk {
     void DMASQuadraticLine(float* input, float* output, float inputDim[2], float outputDim[2], const short& line, float* apodisation, const short& apodArraySize);
     void DMASSphericalLine(float* input, float* output, float inputDim[2], float outputDim[2], const short& line, float* apodisation, const short& apodArraySize);
 
-    float* m_OutputData;
-    float* m_InputData;
-    float* m_InputDataPuffer;
+    //##Description
+    //## @brief Returns the apodization window for the current settings; it is only recomputed when the apodization type or size changes
+    float* GetApodizationWindow(int apodArraySize);
+
+    //##Description
+    //## @brief Starts the persistent worker threads used by the CPU path, if they are not running with the requested count yet
+    void StartWorkers(unsigned int numberOfThreads);
+    void StopWorkers();
+    void WorkerLoop(unsigned int threadId, unsigned long lastGeneration);
+
+    //##Description
+    //## @brief Runs job(threadId) once on every worker and blocks until all of them returned.
+    //## While waiting, progressCallback is invoked periodically from the calling thread.
+    void RunOnWorkers(std::function<void(unsigned int)> job, std::function<void()> progressCallback);
+
+    float* m_ApodWindow;
+    int m_ApodArraySize;
+    beamformingSettings::Apodization m_ApodWindowType;
+
+    std::vector<std::thread> m_Workers;
+    std::mutex m_WorkMutex;
+    std::condition_variable m_WorkAvailable;
+    std::condition_variable m_WorkDone;
+    std::function<void(unsigned int)> m_CurrentJob;
+    unsigned long m_JobGeneration;
+    unsigned int m_BusyWorkers;
+    bool m_StopWorkers;
+
+    const BeamformingKernels::KernelSet* m_Kernels;
 
     beamformingSettings m_Conf;
   };
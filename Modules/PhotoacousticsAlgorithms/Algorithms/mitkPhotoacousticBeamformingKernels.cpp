@@ -0,0 +1,127 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkPhotoacousticBeamformingKernels.h"
+#include <cmath>
+
+#if defined(MITK_PA_SIMD_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+  // returns the delayed sample index of element k, or -1 if the element does not contribute
+  inline int Delay(const mitk::BeamformingKernels::SampleParameters& p, int k)
+  {
+    float x = k + p.LineOffset;
+    float v = p.Spherical ? std::sqrt(p.Sample * p.Sample + (p.Multiplicator * x) * (p.Multiplicator * x))
+                          : p.Multiplicator * x * x + p.Sample;
+    if (p.TruncateBeforeOffset)
+      v = std::trunc(v);
+    v += p.Offset;
+
+    // the comparisons also reject NaN, which occurs for the first sample of the quadratic approximation
+    if (v > -1 && v < p.InputSamples)
+      return (int)v;
+    return -1;
+  }
+
+  float DelayAndSumScalar(const mitk::BeamformingKernels::SampleParameters& p, int* usedLines)
+  {
+    float sum = 0;
+    int valid = 0;
+    for (int k = 0; k < p.Count; ++k)
+    {
+      int delay = Delay(p, k);
+      if (delay < 0)
+        continue;
+      sum += p.Input[p.MinLine + k + delay * p.InputLines] * p.Apodisation[(int)(k * p.ApodisationMultiplicator)];
+      ++valid;
+    }
+    *usedLines = valid;
+    return sum;
+  }
+
+  float DelayMultiplyAndSumScalar(const mitk::BeamformingKernels::SampleParameters& p, int* usedLines)
+  {
+    // with b = sign(a) * sqrt(|a|), the sum over all pairs sign(a_i a_j) sqrt(|a_i a_j|) = sum_{i<j} b_i b_j
+    // equals ((sum b)^2 - sum b^2) / 2, which needs a single pass over the elements
+    double sum = 0;
+    double sumOfSquares = 0;
+    int invalid = 0;
+    for (int k = 0; k < p.Count; ++k)
+    {
+      int delay = Delay(p, k);
+      if (delay < 0)
+      {
+        if (k < p.Count - 1)
+          ++invalid;
+        continue;
+      }
+      float a = p.Input[p.MinLine + k + delay * p.InputLines] * p.Apodisation[(int)(k * p.ApodisationMultiplicator)];
+      sum += std::copysign(std::sqrt(std::fabs(a)), a);
+      sumOfSquares += std::fabs(a);
+    }
+    *usedLines = p.Count - invalid;
+    return (float)((sum * sum - sumOfSquares) / 2);
+  }
+
+  bool CPUSupports(bool avx2)
+  {
+#if defined(MITK_PA_SIMD_KERNELS) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    if (!avx2)
+      return (info[2] & (1 << 19)) != 0;
+    // AVX2 additionally needs the OS to save the ymm registers
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (maxLeaf < 7 || !osxsave || (_xgetbv(0) & 6) != 6)
+      return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(MITK_PA_SIMD_KERNELS)
+    __builtin_cpu_init();
+    return avx2 ? __builtin_cpu_supports("avx2") != 0 : __builtin_cpu_supports("sse4.1") != 0;
+#else
+    (void)avx2;
+    return false;
+#endif
+  }
+
+  const mitk::BeamformingKernels::KernelSet& SelectKernels()
+  {
+    // the SIMD translation units must not be entered before the CPU has been checked
+    if (CPUSupports(true) && mitk::BeamformingKernels::GetAVX2Kernels() != nullptr)
+      return *mitk::BeamformingKernels::GetAVX2Kernels();
+    if (CPUSupports(false) && mitk::BeamformingKernels::GetSSE41Kernels() != nullptr)
+      return *mitk::BeamformingKernels::GetSSE41Kernels();
+    return mitk::BeamformingKernels::GetScalarKernels();
+  }
+}
+
+const mitk::BeamformingKernels::KernelSet& mitk::BeamformingKernels::GetScalarKernels()
+{
+  static const KernelSet kernels = { "scalar", &DelayAndSumScalar, &DelayMultiplyAndSumScalar };
+  return kernels;
+}
+
+const mitk::BeamformingKernels::KernelSet& mitk::BeamformingKernels::GetBeamformingKernels()
+{
+  static const KernelSet& kernels = SelectKernels();
+  return kernels;
+}
@@ -0,0 +1,89 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITK_PHOTOACOUSTICS_BEAMFORMING_KERNELS
+#define MITK_PHOTOACOUSTICS_BEAMFORMING_KERNELS
+
+#include "MitkPhotoacousticsAlgorithmsExports.h"
+
+namespace mitk {
+
+  //##Documentation
+  //## @brief Inner loops of the CPU beamformer, i.e. the sum over all receive elements contributing to one output sample.
+  //##
+  //## The kernels exist as a scalar reference implementation and, on x86, as SSE4.1 and AVX2 variants.
+  //## GetBeamformingKernels() selects the fastest variant supported by the executing CPU.
+  //## @ingroup Process
+  namespace BeamformingKernels
+  {
+    //##Documentation
+    //## @brief Describes the receive elements MinLine ... MinLine + Count - 1 used for one output sample.
+    //##
+    //## The delay of element k is computed as
+    //## v = Spherical ? sqrt(Sample^2 + (Multiplicator * (k + LineOffset))^2) : Multiplicator * (k + LineOffset)^2 + Sample,
+    //## which is truncated to a full sample if TruncateBeforeOffset is set, before Offset is added and the result is truncated.
+    //## Elements whose delay lies outside of [0, InputSamples) do not contribute.
+    struct SampleParameters
+    {
+      const float* Input;
+      int InputLines;
+      int InputSamples;
+
+      int MinLine;
+      int Count;
+
+      bool Spherical;
+      bool TruncateBeforeOffset;
+      float LineOffset; // MinLine - l_i
+      float Multiplicator;
+      float Sample; // s_i
+      float Offset; // (1 - photoacoustic) * s_i
+
+      const float* Apodisation;
+      float ApodisationMultiplicator;
+    };
+
+    //##Description
+    //## @brief Returns the apodised delay-and-sum of all valid elements; usedLines is set to the number of valid elements.
+    typedef float(*DelayAndSumFunction)(const SampleParameters& parameters, int* usedLines);
+
+    //##Description
+    //## @brief Returns sum_{i<j} sign(a_i a_j) sqrt(|a_i a_j|) of the apodised, delayed samples a of all valid elements;
+    //## usedLines is set to Count minus the number of invalid elements amongst the first Count - 1 ones.
+    typedef float(*DelayMultiplyAndSumFunction)(const SampleParameters& parameters, int* usedLines);
+
+    struct KernelSet
+    {
+      const char* Name;
+      DelayAndSumFunction DelayAndSum;
+      DelayMultiplyAndSumFunction DelayMultiplyAndSum;
+    };
+
+    //##Description
+    //## @brief Returns the fastest kernel set supported by this CPU; the choice is made once, on first call.
+    MITKPHOTOACOUSTICSALGORITHMS_EXPORT const KernelSet& GetBeamformingKernels();
+
+    MITKPHOTOACOUSTICSALGORITHMS_EXPORT const KernelSet& GetScalarKernels();
+
+    //##Description
+    //## @brief Return nullptr if the module was built without the respective SIMD variant.
+    MITKPHOTOACOUSTICSALGORITHMS_EXPORT const KernelSet* GetSSE41Kernels();
+    MITKPHOTOACOUSTICSALGORITHMS_EXPORT const KernelSet* GetAVX2Kernels();
+  }
+
+} // namespace mitk
+
+#endif //MITK_PHOTOACOUSTICS_BEAMFORMING_KERNELS
@@ -0,0 +1,152 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+// This file is compiled with AVX2 code generation enabled. It must only be entered after
+// GetBeamformingKernels() checked the CPU, so do not add code here that is used elsewhere.
+
+#include "mitkPhotoacousticBeamformingKernels.h"
+
+#if defined(MITK_PA_SIMD_KERNELS) && defined(__AVX2__)
+
+#include <immintrin.h>
+
+namespace
+{
+  typedef mitk::BeamformingKernels::SampleParameters SampleParameters;
+
+  inline float HorizontalSum(__m256 v)
+  {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+  }
+
+  inline double HorizontalSum(__m256d v)
+  {
+    __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    sum = _mm_add_sd(sum, _mm_unpackhi_pd(sum, sum));
+    return _mm_cvtsd_f64(sum);
+  }
+
+  // converts the lanes to double and adds the upper half to the lower one
+  inline __m256d AddHalves(__m256 v)
+  {
+    return _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+  }
+
+  // computes the apodised samples of the elements k ... k + 7; lanes of invalid elements are zero and cleared in valid
+  inline __m256 DelayedSamples(const SampleParameters& p, int k, __m256& valid)
+  {
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 kf = _mm256_add_ps(_mm256_set1_ps((float)k), lane);
+    __m256 x = _mm256_add_ps(kf, _mm256_set1_ps(p.LineOffset));
+    __m256 multiplicator = _mm256_set1_ps(p.Multiplicator);
+    __m256 sample = _mm256_set1_ps(p.Sample);
+
+    __m256 v;
+    if (p.Spherical)
+    {
+      __m256 mx = _mm256_mul_ps(multiplicator, x);
+      v = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(sample, sample), _mm256_mul_ps(mx, mx)));
+    }
+    else
+    {
+      v = _mm256_add_ps(_mm256_mul_ps(multiplicator, _mm256_mul_ps(x, x)), sample);
+    }
+    if (p.TruncateBeforeOffset)
+      v = _mm256_round_ps(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    v = _mm256_add_ps(v, _mm256_set1_ps(p.Offset));
+
+    // ordered comparisons, so NaN delays are rejected as well
+    valid = _mm256_and_ps(_mm256_cmp_ps(kf, _mm256_set1_ps((float)p.Count), _CMP_LT_OQ),
+      _mm256_and_ps(_mm256_cmp_ps(v, _mm256_set1_ps(-1.0f), _CMP_GT_OQ),
+        _mm256_cmp_ps(v, _mm256_set1_ps((float)p.InputSamples), _CMP_LT_OQ)));
+    __m256i validMask = _mm256_castps_si256(valid);
+
+    __m256i line = _mm256_add_epi32(_mm256_set1_epi32(p.MinLine + k), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i index = _mm256_add_epi32(line, _mm256_mullo_epi32(_mm256_cvttps_epi32(v), _mm256_set1_epi32(p.InputLines)));
+    index = _mm256_and_si256(index, validMask);
+    __m256i apodIndex = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(kf, _mm256_set1_ps(p.ApodisationMultiplicator))), validMask);
+
+    __m256 input = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), p.Input, index, valid, 4);
+    __m256 apodisation = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), p.Apodisation, apodIndex, valid, 4);
+    return _mm256_mul_ps(input, apodisation);
+  }
+
+  float DelayAndSumAVX2(const SampleParameters& p, int* usedLines)
+  {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 sum = _mm256_setzero_ps();
+    __m256 validCount = _mm256_setzero_ps();
+
+    for (int k = 0; k < p.Count; k += 8)
+    {
+      __m256 valid;
+      sum = _mm256_add_ps(sum, DelayedSamples(p, k, valid));
+      validCount = _mm256_add_ps(validCount, _mm256_and_ps(valid, one));
+    }
+
+    *usedLines = (int)HorizontalSum(validCount);
+    return HorizontalSum(sum);
+  }
+
+  float DelayMultiplyAndSumAVX2(const SampleParameters& p, int* usedLines)
+  {
+    // see DelayMultiplyAndSumScalar: sum_{i<j} b_i b_j = ((sum b)^2 - sum b^2) / 2 with b = sign(a) * sqrt(|a|)
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 lastCounted = _mm256_set1_ps((float)(p.Count - 1));
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    // sum * sum and sumOfSquares mostly cancel, so both are accumulated in double as in the scalar kernel
+    __m256d sum = _mm256_setzero_pd();
+    __m256d sumOfSquares = _mm256_setzero_pd();
+    __m256 invalidCount = _mm256_setzero_ps();
+
+    for (int k = 0; k < p.Count; k += 8)
+    {
+      __m256 valid;
+      __m256 a = DelayedSamples(p, k, valid);
+      __m256 absA = _mm256_andnot_ps(signMask, a);
+      __m256 b = _mm256_or_ps(_mm256_sqrt_ps(absA), _mm256_and_ps(a, signMask));
+      sum = _mm256_add_pd(sum, AddHalves(b));
+      sumOfSquares = _mm256_add_pd(sumOfSquares, AddHalves(absA));
+
+      __m256 counted = _mm256_cmp_ps(_mm256_add_ps(_mm256_set1_ps((float)k), lane), lastCounted, _CMP_LT_OQ);
+      invalidCount = _mm256_add_ps(invalidCount, _mm256_and_ps(_mm256_andnot_ps(valid, counted), one));
+    }
+
+    double totalSum = HorizontalSum(sum);
+    double totalSumOfSquares = HorizontalSum(sumOfSquares);
+    *usedLines = p.Count - (int)HorizontalSum(invalidCount);
+    return (float)((totalSum * totalSum - totalSumOfSquares) / 2);
+  }
+}
+
+const mitk::BeamformingKernels::KernelSet* mitk::BeamformingKernels::GetAVX2Kernels()
+{
+  static const KernelSet kernels = { "AVX2", &DelayAndSumAVX2, &DelayMultiplyAndSumAVX2 };
+  return &kernels;
+}
+
+#else
+
+const mitk::BeamformingKernels::KernelSet* mitk::BeamformingKernels::GetAVX2Kernels()
+{
+  return nullptr;
+}
+
+#endif
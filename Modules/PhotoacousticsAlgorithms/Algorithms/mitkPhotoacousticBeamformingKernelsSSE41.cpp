@@ -0,0 +1,156 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+// This file is compiled with SSE4.1 code generation enabled. It must only be entered after
+// GetBeamformingKernels() checked the CPU, so do not add code here that is used elsewhere.
+
+#include "mitkPhotoacousticBeamformingKernels.h"
+
+#if defined(MITK_PA_SIMD_KERNELS) && (defined(__SSE4_1__) || defined(_MSC_VER))
+
+#include <smmintrin.h>
+
+namespace
+{
+  typedef mitk::BeamformingKernels::SampleParameters SampleParameters;
+
+  inline float HorizontalSum(__m128 v)
+  {
+    __m128 sum = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+  }
+
+  inline double HorizontalSum(__m128d v)
+  {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+  }
+
+  // converts the lanes to double and adds the upper half to the lower one
+  inline __m128d AddHalves(__m128 v)
+  {
+    return _mm_add_pd(_mm_cvtps_pd(v), _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+  }
+
+  // computes the apodised samples of the elements k ... k + 3; lanes of invalid elements are zero and cleared in valid
+  inline __m128 DelayedSamples(const SampleParameters& p, int k, __m128& valid)
+  {
+    const __m128 lane = _mm_setr_ps(0, 1, 2, 3);
+    __m128 kf = _mm_add_ps(_mm_set1_ps((float)k), lane);
+    __m128 x = _mm_add_ps(kf, _mm_set1_ps(p.LineOffset));
+    __m128 multiplicator = _mm_set1_ps(p.Multiplicator);
+    __m128 sample = _mm_set1_ps(p.Sample);
+
+    __m128 v;
+    if (p.Spherical)
+    {
+      __m128 mx = _mm_mul_ps(multiplicator, x);
+      v = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(sample, sample), _mm_mul_ps(mx, mx)));
+    }
+    else
+    {
+      v = _mm_add_ps(_mm_mul_ps(multiplicator, _mm_mul_ps(x, x)), sample);
+    }
+    if (p.TruncateBeforeOffset)
+      v = _mm_round_ps(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    v = _mm_add_ps(v, _mm_set1_ps(p.Offset));
+
+    // the comparisons are false for NaN, so NaN delays are rejected as well
+    valid = _mm_and_ps(_mm_cmplt_ps(kf, _mm_set1_ps((float)p.Count)),
+      _mm_and_ps(_mm_cmpgt_ps(v, _mm_set1_ps(-1.0f)), _mm_cmplt_ps(v, _mm_set1_ps((float)p.InputSamples))));
+
+    __m128i line = _mm_add_epi32(_mm_set1_epi32(p.MinLine + k), _mm_setr_epi32(0, 1, 2, 3));
+    __m128i index = _mm_add_epi32(line, _mm_mullo_epi32(_mm_cvttps_epi32(v), _mm_set1_epi32(p.InputLines)));
+    __m128i apodIndex = _mm_cvttps_epi32(_mm_mul_ps(kf, _mm_set1_ps(p.ApodisationMultiplicator)));
+
+    // SSE has no gather instruction, the indices are resolved one lane at a time
+    alignas(16) int indices[4];
+    alignas(16) int apodIndices[4];
+    alignas(16) float products[4] = { 0, 0, 0, 0 };
+    _mm_store_si128((__m128i*)indices, index);
+    _mm_store_si128((__m128i*)apodIndices, apodIndex);
+    int validLanes = _mm_movemask_ps(valid);
+    for (int l = 0; l < 4; ++l)
+    {
+      if (validLanes & (1 << l))
+        products[l] = p.Input[indices[l]] * p.Apodisation[apodIndices[l]];
+    }
+    return _mm_load_ps(products);
+  }
+
+  float DelayAndSumSSE41(const SampleParameters& p, int* usedLines)
+  {
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 sum = _mm_setzero_ps();
+    __m128 validCount = _mm_setzero_ps();
+
+    for (int k = 0; k < p.Count; k += 4)
+    {
+      __m128 valid;
+      sum = _mm_add_ps(sum, DelayedSamples(p, k, valid));
+      validCount = _mm_add_ps(validCount, _mm_and_ps(valid, one));
+    }
+
+    *usedLines = (int)HorizontalSum(validCount);
+    return HorizontalSum(sum);
+  }
+
+  float DelayMultiplyAndSumSSE41(const SampleParameters& p, int* usedLines)
+  {
+    // see DelayMultiplyAndSumScalar: sum_{i<j} b_i b_j = ((sum b)^2 - sum b^2) / 2 with b = sign(a) * sqrt(|a|)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 lastCounted = _mm_set1_ps((float)(p.Count - 1));
+    const __m128 lane = _mm_setr_ps(0, 1, 2, 3);
+    // sum * sum and sumOfSquares mostly cancel, so both are accumulated in double as in the scalar kernel
+    __m128d sum = _mm_setzero_pd();
+    __m128d sumOfSquares = _mm_setzero_pd();
+    __m128 invalidCount = _mm_setzero_ps();
+
+    for (int k = 0; k < p.Count; k += 4)
+    {
+      __m128 valid;
+      __m128 a = DelayedSamples(p, k, valid);
+      __m128 absA = _mm_andnot_ps(signMask, a);
+      __m128 b = _mm_or_ps(_mm_sqrt_ps(absA), _mm_and_ps(a, signMask));
+      sum = _mm_add_pd(sum, AddHalves(b));
+      sumOfSquares = _mm_add_pd(sumOfSquares, AddHalves(absA));
+
+      __m128 counted = _mm_cmplt_ps(_mm_add_ps(_mm_set1_ps((float)k), lane), lastCounted);
+      invalidCount = _mm_add_ps(invalidCount, _mm_and_ps(_mm_andnot_ps(valid, counted), one));
+    }
+
+    double totalSum = HorizontalSum(sum);
+    double totalSumOfSquares = HorizontalSum(sumOfSquares);
+    *usedLines = p.Count - (int)HorizontalSum(invalidCount);
+    return (float)((totalSum * totalSum - totalSumOfSquares) / 2);
+  }
+}
+
+const mitk::BeamformingKernels::KernelSet* mitk::BeamformingKernels::GetSSE41Kernels()
+{
+  static const KernelSet kernels = { "SSE4.1", &DelayAndSumSSE41, &DelayMultiplyAndSumSSE41 };
+  return &kernels;
+}
+
+#else
+
+const mitk::BeamformingKernels::KernelSet* mitk::BeamformingKernels::GetSSE41Kernels()
+{
+  return nullptr;
+}
+
+#endif
@@ -2,6 +2,9 @@ set(CPP_FILES
   mitkPhotoacousticImage.cpp
   
   Algorithms/mitkPhotoacousticBeamformingFilter.cpp
+  Algorithms/mitkPhotoacousticBeamformingKernels.cpp
+  Algorithms/mitkPhotoacousticBeamformingKernelsSSE41.cpp
+  Algorithms/mitkPhotoacousticBeamformingKernelsAVX2.cpp
   
   Algorithms/OCL/mitkPhotoacousticOCLBeamformer.cpp
   
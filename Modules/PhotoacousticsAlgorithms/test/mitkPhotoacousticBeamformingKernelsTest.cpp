@@ -0,0 +1,176 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkPhotoacousticBeamformingKernels.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+class mitkPhotoacousticBeamformingKernelsTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkPhotoacousticBeamformingKernelsTestSuite);
+  MITK_TEST(testSIMDKernelsEqualScalarKernels);
+  MITK_TEST(testDelayMultiplyAndSumOfCancellingSamples);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  static const int InputLines = 64;
+  static const int InputSamples = 200;
+  static const int ApodisationLength = 128;
+
+  std::vector<float> m_Input;
+  std::vector<float> m_Apodisation;
+  float m_MaxSample;
+  std::vector<const mitk::BeamformingKernels::KernelSet*> m_SIMDKernels;
+
+  void SetInput(float (*sampleValue)(int line, int sample))
+  {
+    m_Input.resize(InputLines * InputSamples);
+    m_MaxSample = 0;
+    for (int line = 0; line < InputLines; ++line)
+    {
+      for (int sample = 0; sample < InputSamples; ++sample)
+      {
+        m_Input[line + sample * InputLines] = sampleValue(line, sample);
+        m_MaxSample = std::max(m_MaxSample, std::fabs(sampleValue(line, sample)));
+      }
+    }
+  }
+
+  // deterministic samples in [-1, 1]
+  static float NoiseSample(int line, int sample)
+  {
+    unsigned int seed = (unsigned int)(line * 7919 + sample * 104729) * 1103515245u + 12345u;
+    return ((seed >> 8) % 20001) / 10000.0f - 1.0f;
+  }
+
+  // large samples of alternating sign
+  static float AlternatingSample(int line, int)
+  {
+    return (line % 2 ? -1.0f : 1.0f) * (1000.0f + line);
+  }
+
+  mitk::BeamformingKernels::SampleParameters CreateParameters(int count, bool spherical, bool truncateBeforeOffset,
+    float sample, float offset)
+  {
+    mitk::BeamformingKernels::SampleParameters parameters;
+    parameters.Input = m_Input.data();
+    parameters.InputLines = InputLines;
+    parameters.InputSamples = InputSamples;
+    parameters.MinLine = (InputLines - count) / 2;
+    parameters.Count = count;
+    parameters.Spherical = spherical;
+    parameters.TruncateBeforeOffset = truncateBeforeOffset;
+    parameters.LineOffset = parameters.MinLine - 31.5f;
+    parameters.Multiplicator = spherical ? 2.3f : 0.05f;
+    parameters.Sample = sample;
+    parameters.Offset = offset;
+    parameters.Apodisation = m_Apodisation.data();
+    parameters.ApodisationMultiplicator = (float)ApodisationLength / count;
+    return parameters;
+  }
+
+  void CheckKernels(const mitk::BeamformingKernels::KernelSet& kernels,
+    const mitk::BeamformingKernels::SampleParameters& parameters)
+  {
+    const mitk::BeamformingKernels::KernelSet& scalar = mitk::BeamformingKernels::GetScalarKernels();
+    const std::string name(kernels.Name);
+    // the apodisation weights are at most 1, which bounds the magnitude of the terms of DAS
+    const double magnitude = (double)parameters.Count * m_MaxSample;
+
+    int scalarUsedLines = -1;
+    int usedLines = -1;
+    float expected = scalar.DelayAndSum(parameters, &scalarUsedLines);
+    float actual = kernels.DelayAndSum(parameters, &usedLines);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE(name + " DAS uses the lines of the scalar kernel", scalarUsedLines, usedLines);
+    // the SIMD kernels add the lanes in another order
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(name + " DAS equals the scalar kernel", expected, actual, 1e-5 * magnitude);
+
+    scalarUsedLines = -1;
+    usedLines = -1;
+    expected = scalar.DelayMultiplyAndSum(parameters, &scalarUsedLines);
+    actual = kernels.DelayMultiplyAndSum(parameters, &usedLines);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE(name + " DMAS uses the lines of the scalar kernel", scalarUsedLines, usedLines);
+    // the sums are accumulated in double, so only the final conversion to float remains
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(name + " DMAS equals the scalar kernel", expected, actual,
+      1e-6 * (1 + std::fabs(expected)));
+  }
+
+public:
+
+  void setUp() override
+  {
+    SetInput(&NoiseSample);
+
+    m_Apodisation.resize(ApodisationLength);
+    for (int i = 0; i < ApodisationLength; ++i)
+      m_Apodisation[i] = 0.5f - 0.5f * std::cos(2 * 3.14159265f * (i + 0.5f) / ApodisationLength);
+
+    // GetBeamformingKernels() only selects variants supported by this CPU; AVX2 implies SSE4.1
+    m_SIMDKernels.clear();
+    const mitk::BeamformingKernels::KernelSet* selected = &mitk::BeamformingKernels::GetBeamformingKernels();
+    if (selected != &mitk::BeamformingKernels::GetScalarKernels())
+      m_SIMDKernels.push_back(selected);
+    if (selected == mitk::BeamformingKernels::GetAVX2Kernels() && mitk::BeamformingKernels::GetSSE41Kernels() != nullptr)
+      m_SIMDKernels.push_back(mitk::BeamformingKernels::GetSSE41Kernels());
+  }
+
+  void tearDown() override
+  {
+    m_Input.clear();
+    m_Apodisation.clear();
+    m_SIMDKernels.clear();
+  }
+
+  void testSIMDKernelsEqualScalarKernels()
+  {
+    if (m_SIMDKernels.empty())
+      MITK_INFO << "No SIMD beamforming kernels are supported, only the scalar kernels are used.";
+
+    // counts that are no multiple of the vector width leave lanes of the last iteration unused; the samples and
+    // offsets move parts of the elements out of the input, so that invalid elements occur at both ends
+    const int counts[] = { 1, 3, 8, 13, 37, 64 };
+    const float samples[] = { 0.5f, 57.3f, 185.9f };
+    const float offsets[] = { 0.0f, -40.5f };
+
+    for (auto kernels : m_SIMDKernels)
+      for (int count : counts)
+        for (int spherical = 0; spherical < 2; ++spherical)
+          for (int truncate = 0; truncate < 2; ++truncate)
+            for (float sample : samples)
+              for (float offset : offsets)
+                CheckKernels(*kernels, CreateParameters(count, spherical != 0, truncate != 0, sample, offset));
+  }
+
+  void testDelayMultiplyAndSumOfCancellingSamples()
+  {
+    // (sum b)^2 and sum b^2 are large and nearly cancel each other
+    SetInput(&AlternatingSample);
+
+    for (auto kernels : m_SIMDKernels)
+      for (int count : { 2, 13, 64 })
+        for (int spherical = 0; spherical < 2; ++spherical)
+          CheckKernels(*kernels, CreateParameters(count, spherical != 0, true, 20.0f, 0.0f));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkPhotoacousticBeamformingKernels)
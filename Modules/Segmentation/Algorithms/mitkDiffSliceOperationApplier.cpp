@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkDiffSliceOperation.h"
 #include "mitkRenderingManager.h"
 #include "mitkSegTool2D.h"
+#include "mitkSegmentationInterpolationController.h"
 #include <mitkExtractSliceFilter.h>
 #include <mitkVtkImageOverwrite.h>
 
@@ -68,8 +69,22 @@ void mitk::DiffSliceOperationApplier::ExecuteOperation(Operation *operation)
 
     // make sure the modification is rendered
     RenderingManager::GetInstance()->RequestUpdateAll();
+
+    // only the region around the slice has to be recounted by the interpolator
+    SegmentationInterpolationController *interpolator =
+      SegmentationInterpolationController::InterpolatorForImage(imageOperation->GetImage());
+    if (interpolator)
+      interpolator->BlockModified(true);
+
     imageOperation->GetImage()->Modified();
 
+    if (interpolator)
+    {
+      interpolator->SetChangedRegion(dynamic_cast<PlaneGeometry *>(imageOperation->GetWorldGeometry()),
+                                     imageOperation->GetTimeStep());
+      interpolator->BlockModified(false);
+    }
+
     mitk::ExtractSliceFilter::Pointer extractor2 = mitk::ExtractSliceFilter::New();
     extractor2->SetInput(imageOperation->GetImage());
     extractor2->SetTimeStep(imageOperation->GetTimeStep());
@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageTimeSelector.h"
 #include <mitkExtractSliceFilter.h>
 #include <mitkImageAccessByItk.h>
+#include <mitkPixelTypeMultiplex.h>
 //#include <mitkPlaneGeometry.h>
 
 #include "mitkShapeBasedInterpolationAlgorithm.h"
@@ -29,6 +30,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImage.h>
 #include <itkImageSliceConstIteratorWithIndex.h>
 
+#include <algorithm>
+#include <cmath>
+
 mitk::SegmentationInterpolationController::InterpolatorMapType
   mitk::SegmentationInterpolationController::s_InterpolatorForImage; // static member initialization
 
@@ -46,7 +50,8 @@ mitk::SegmentationInterpolationController *mitk::SegmentationInterpolationContro
   }
 }
 
-mitk::SegmentationInterpolationController::SegmentationInterpolationController() : m_BlockModified(false)
+mitk::SegmentationInterpolationController::SegmentationInterpolationController()
+  : m_BlockModified(false), m_2DInterpolationActivated(false)
 {
 }
 
@@ -96,6 +101,7 @@ void mitk::SegmentationInterpolationController::SetSegmentationVolume(const Imag
 {
   // clear old information (remove all time steps
   m_SegmentationCountInSlice.clear();
+  m_SlabCountInSlice.clear();
 
   // delete this from the list of interpolators
   auto iter = s_InterpolatorForImage.find(segmentation);
@@ -134,6 +140,18 @@ void mitk::SegmentationInterpolationController::SetSegmentationVolume(const Imag
     }
   }
 
+  unsigned int numberOfSlabs = (m_Segmentation->GetDimension(2) + s_SlabSize - 1) / s_SlabSize;
+  m_SlabCountInSlice.resize(m_Segmentation->GetTimeSteps());
+  for (unsigned int timeStep = 0; timeStep < m_Segmentation->GetTimeSteps(); ++timeStep)
+  {
+    m_SlabCountInSlice[timeStep].resize(numberOfSlabs);
+    for (unsigned int slab = 0; slab < numberOfSlabs; ++slab)
+    {
+      m_SlabCountInSlice[timeStep][slab].countInSlice0.assign(m_Segmentation->GetDimension(0), 0);
+      m_SlabCountInSlice[timeStep][slab].countInSlice1.assign(m_Segmentation->GetDimension(1), 0);
+    }
+  }
+
   s_InterpolatorForImage.insert(std::make_pair(m_Segmentation, this));
 
   // for all timesteps
@@ -197,6 +215,70 @@ void mitk::SegmentationInterpolationController::SetChangedVolume(const Image *sl
   Modified();
 }
 
+void mitk::SegmentationInterpolationController::SetChangedRegion(const itk::ImageRegion<3> &region,
+                                                                 unsigned int timeStep)
+{
+  if (m_Segmentation.IsNull() || !m_2DInterpolationActivated)
+    return;
+  if (timeStep >= m_SlabCountInSlice.size() || m_SlabCountInSlice[timeStep].empty())
+    return;
+
+  itk::ImageRegion<3> changedRegion(region);
+  itk::ImageRegion<3>::SizeType size;
+  for (unsigned int dim = 0; dim < 3; ++dim)
+    size[dim] = m_Segmentation->GetDimension(dim);
+  itk::ImageRegion<3> largestRegion(size);
+  if (!changedRegion.Crop(largestRegion))
+    return;
+
+  unsigned int firstSlab = changedRegion.GetIndex(2) / s_SlabSize;
+  unsigned int lastSlab = (changedRegion.GetIndex(2) + changedRegion.GetSize(2) - 1) / s_SlabSize;
+
+  // the slabs are read directly from the segmentation, without copying the time step
+  mitkPixelTypeMultiplex4(ScanSlabs, m_Segmentation->GetPixelType(), m_Segmentation, timeStep, firstSlab, lastSlab);
+
+  Modified();
+}
+
+void mitk::SegmentationInterpolationController::SetChangedRegion(const PlaneGeometry *slicePlane, unsigned int timeStep)
+{
+  if (m_Segmentation.IsNull() || !m_2DInterpolationActivated)
+    return;
+
+  if (!slicePlane)
+  {
+    // without a plane the changed region is unknown
+    SetSegmentationVolume(m_Segmentation);
+    return;
+  }
+
+  // bounding box of the plane in index coordinates of the segmentation
+  const BaseGeometry *geometry = m_Segmentation->GetGeometry(timeStep);
+  Point3D lower, upper;
+  for (int corner = 0; corner < 8; ++corner)
+  {
+    Point3D index;
+    geometry->WorldToIndex(slicePlane->GetCornerPoint(corner), index);
+    for (unsigned int dim = 0; dim < 3; ++dim)
+    {
+      lower[dim] = corner == 0 ? index[dim] : std::min(lower[dim], index[dim]);
+      upper[dim] = corner == 0 ? index[dim] : std::max(upper[dim], index[dim]);
+    }
+  }
+
+  // add a margin of one voxel, the reslicer rounds positions to the nearest voxel
+  itk::ImageRegion<3> region;
+  for (unsigned int dim = 0; dim < 3; ++dim)
+  {
+    itk::IndexValueType first = static_cast<itk::IndexValueType>(std::floor(lower[dim])) - 1;
+    itk::IndexValueType last = static_cast<itk::IndexValueType>(std::ceil(upper[dim])) + 1;
+    region.SetIndex(dim, first);
+    region.SetSize(dim, last - first + 1);
+  }
+
+  SetChangedRegion(region, timeStep);
+}
+
 void mitk::SegmentationInterpolationController::SetChangedSlice(const Image *sliceDiff,
                                                                 unsigned int sliceDimension,
                                                                 unsigned int sliceIndex,
@@ -267,14 +349,23 @@ void mitk::SegmentationInterpolationController::ScanChangedSlice(const itk::Imag
   unsigned int dim0max = m_SegmentationCountInSlice[timeStep][dim0].size();
   unsigned int dim1max = m_SegmentationCountInSlice[timeStep][dim1].size();
 
+  unsigned int index[3];
+  index[sliceDimension] = sliceIndex;
+
   // scan the slice from two directions
   // and set the flags for the two dimensions of the slice
   for (unsigned int v = 0; v < dim1max; ++v)
   {
+    index[dim1] = v;
     for (unsigned int u = 0; u < dim0max; ++u)
     {
+      index[dim0] = u;
       DATATYPE value = *(pixelData + u + v * dim0max);
 
+      SlabCount &slabCount = m_SlabCountInSlice[timeStep][index[2] / s_SlabSize];
+      slabCount.countInSlice0[index[0]] = static_cast<unsigned int>(slabCount.countInSlice0[index[0]] + value);
+      slabCount.countInSlice1[index[1]] = static_cast<unsigned int>(slabCount.countInSlice1[index[1]] + value);
+
       assert((signed)m_SegmentationCountInSlice[timeStep][dim0][u] + (signed)value >=
              0); // just for debugging. This must always be true, otherwise some counting is going wrong
       assert((signed)m_SegmentationCountInSlice[timeStep][dim1][v] + (signed)value >= 0);
@@ -328,6 +419,10 @@ void mitk::SegmentationInterpolationController::ScanChangedVolume(const itk::Ima
 
         TPixel value = iter.Get();
 
+        SlabCount &slabCount = m_SlabCountInSlice[timeStep][z / s_SlabSize];
+        slabCount.countInSlice0[x] = static_cast<unsigned int>(slabCount.countInSlice0[x] + value);
+        slabCount.countInSlice1[y] = static_cast<unsigned int>(slabCount.countInSlice1[y] + value);
+
         assert((signed)m_SegmentationCountInSlice[timeStep][0][x] + (signed)value >=
                0); // just for debugging. This must always be true, otherwise some counting is going wrong
         assert((signed)m_SegmentationCountInSlice[timeStep][1][y] + (signed)value >= 0);
@@ -361,15 +456,80 @@ void mitk::SegmentationInterpolationController::ScanWholeVolume(const itk::Image
   if (timeStep >= m_SegmentationCountInSlice.size())
     return;
 
-  ImageReadAccessor readAccess(volume, volume->GetVolumeData(timeStep));
+  if (m_SlabCountInSlice[timeStep].empty())
+    return;
+
+  ScanSlabs<DATATYPE>(volume->GetPixelType(), volume, timeStep, 0, m_SlabCountInSlice[timeStep].size() - 1);
+}
+
+template <typename DATATYPE>
+void mitk::SegmentationInterpolationController::ScanSlabs(const PixelType &,
+                                                          const Image *volume,
+                                                          unsigned int timeStep,
+                                                          unsigned int firstSlab,
+                                                          unsigned int lastSlab)
+{
+  if (!volume)
+    return;
+  if (timeStep >= m_SlabCountInSlice.size())
+    return;
+  if (lastSlab >= m_SlabCountInSlice[timeStep].size())
+    lastSlab = m_SlabCountInSlice[timeStep].size() - 1;
+  if (firstSlab > lastSlab)
+    return;
 
-  for (unsigned int slice = 0; slice < volume->GetDimension(2); ++slice)
+  ImageReadAccessor readAccess(volume, volume->GetVolumeData(timeStep));
+  const auto *rawVolume =
+    static_cast<const DATATYPE *>(readAccess.GetData()); // we again promise not to change anything, we'll just count
+
+  const unsigned int dim0max = volume->GetDimension(0);
+  const unsigned int dim1max = volume->GetDimension(1);
+  const unsigned int dim2max = volume->GetDimension(2);
+  DirtyVectorType &countInSlice2 = m_SegmentationCountInSlice[timeStep][2];
+
+  // the slabs are counted independently of each other (each slab writes only its own slices in dimension 2)
+  std::vector<SlabCount> newSlabCounts(lastSlab - firstSlab + 1);
+#pragma omp parallel for schedule(dynamic)
+  for (int slabIndex = 0; slabIndex < static_cast<int>(newSlabCounts.size()); ++slabIndex)
   {
-    const auto *rawVolume =
-      static_cast<const DATATYPE *>(readAccess.GetData()); // we again promise not to change anything, we'll just count
-    const DATATYPE *rawSlice = rawVolume + (volume->GetDimension(0) * volume->GetDimension(1) * slice);
+    SlabCount &slabCount = newSlabCounts[slabIndex];
+    slabCount.countInSlice0.assign(dim0max, 0);
+    slabCount.countInSlice1.assign(dim1max, 0);
 
-    ScanChangedSlice<DATATYPE>(nullptr, SetChangedSliceOptions(2, slice, 0, 1, timeStep, rawSlice));
+    unsigned int firstSlice = (firstSlab + slabIndex) * s_SlabSize;
+    unsigned int endSlice = std::min(firstSlice + s_SlabSize, dim2max);
+    for (unsigned int slice = firstSlice; slice < endSlice; ++slice)
+    {
+      const DATATYPE *rawSlice = rawVolume + static_cast<size_t>(dim0max) * dim1max * slice;
+      int numberOfPixels(0); // number of pixels in this slice that are not 0
+      for (unsigned int v = 0; v < dim1max; ++v)
+      {
+        const DATATYPE *rawLine = rawSlice + static_cast<size_t>(v) * dim0max;
+        for (unsigned int u = 0; u < dim0max; ++u)
+        {
+          DATATYPE value = rawLine[u];
+          slabCount.countInSlice0[u] = static_cast<unsigned int>(slabCount.countInSlice0[u] + value);
+          slabCount.countInSlice1[v] = static_cast<unsigned int>(slabCount.countInSlice1[v] + value);
+          numberOfPixels += static_cast<int>(value);
+        }
+      }
+      countInSlice2[slice] = numberOfPixels;
+    }
+  }
+
+  // replace the old contribution of the recounted slabs
+  DirtyVectorType &countInSlice0 = m_SegmentationCountInSlice[timeStep][0];
+  DirtyVectorType &countInSlice1 = m_SegmentationCountInSlice[timeStep][1];
+  for (unsigned int slabIndex = 0; slabIndex < newSlabCounts.size(); ++slabIndex)
+  {
+    SlabCount &oldSlabCount = m_SlabCountInSlice[timeStep][firstSlab + slabIndex];
+    SlabCount &newSlabCount = newSlabCounts[slabIndex];
+    for (unsigned int u = 0; u < dim0max; ++u)
+      countInSlice0[u] += newSlabCount.countInSlice0[u] - oldSlabCount.countInSlice0[u];
+    for (unsigned int v = 0; v < dim1max; ++v)
+      countInSlice1[v] += newSlabCount.countInSlice1[v] - oldSlabCount.countInSlice1[v];
+    oldSlabCount.countInSlice0.swap(newSlabCount.countInSlice0);
+    oldSlabCount.countInSlice1.swap(newSlabCount.countInSlice1);
   }
 }
 
@@ -69,6 +69,11 @@ namespace mitk
 
     \image html slice_based_segmentation_interpolator.png
 
+    To avoid rescanning the whole volume after a change of a region, the counts for dimensions 0 and 1 are
+    additionally stored per slab of s_SlabSize slices in dimension 2 (m_SlabCountInSlice). SetChangedRegion()
+    recounts only the slabs that intersect the changed region. Scans of the whole volume process the slabs in
+    parallel.
+
     $Author$
   */
   class MITKSEGMENTATION_EXPORT SegmentationInterpolationController : public itk::Object
@@ -134,6 +139,33 @@ namespace mitk
                          unsigned int timeStep);
     void SetChangedVolume(const Image *sliceDiff, unsigned int timeStep);
 
+    /**
+      \brief Update after the content of a region of the segmentation was changed.
+
+      Recounts all slabs of the segmentation that intersect the region. Use this instead of a scan of the whole
+      volume when no difference image is available, e.g. after a slice was written into the volume.
+
+      \param region Changed region in index coordinates of the segmentation.
+
+      \param timeStep Which time step is changed
+    */
+    void SetChangedRegion(const itk::ImageRegion<3> &region, unsigned int timeStep);
+
+    /**
+      \brief Update after a (possibly oblique) slice was written into the segmentation.
+
+      Only dimension 2 is split into slabs, so this is cheap for axial slices only: the bounding box of an axial
+      slice intersects one slab (two, if the margin of one voxel crosses a slab border). A sagittal or coronal slice
+      spans all slices in dimension 2, so all slabs are recounted, which costs as much as SetSegmentationVolume().
+      The slabs cannot be narrowed down to the slice, because the counts of dimensions 0 and 1 of a slab are
+      recounted as a whole and the previous content of the slice is not known.
+
+      \param slicePlane Geometry of the written slice, its bounding box determines the changed region.
+
+      \param timeStep Which time step is changed
+    */
+    void SetChangedRegion(const PlaneGeometry *slicePlane, unsigned int timeStep);
+
     /**
       \brief Generates an interpolated image for the given slice.
 
@@ -187,6 +219,14 @@ namespace mitk
     typedef std::vector<std::vector<DirtyVectorType>> TimeResolvedDirtyVectorType;
     typedef std::map<const Image *, SegmentationInterpolationController *> InterpolatorMapType;
 
+    /// contribution of one slab to the counts of the slices in dimension 0 and 1
+    struct SlabCount
+    {
+      DirtyVectorType countInSlice0;
+      DirtyVectorType countInSlice1;
+    };
+    typedef std::vector<std::vector<SlabCount>> TimeResolvedSlabCountType;
+
     SegmentationInterpolationController(); // purposely hidden
     ~SegmentationInterpolationController() override;
 
@@ -200,6 +240,14 @@ namespace mitk
     template <typename DATATYPE>
     void ScanWholeVolume(const itk::Image<DATATYPE, 3> *, const Image *volume, unsigned int timeStep);
 
+    /// recount the slabs firstSlab to lastSlab (inclusive) of a volume
+    template <typename DATATYPE>
+    void ScanSlabs(const PixelType &,
+                   const Image *volume,
+                   unsigned int timeStep,
+                   unsigned int firstSlab,
+                   unsigned int lastSlab);
+
     void PrintStatus();
 
     /**
@@ -213,6 +261,15 @@ namespace mitk
     */
     TimeResolvedDirtyVectorType m_SegmentationCountInSlice;
 
+    /**
+      Counts of m_SegmentationCountInSlice[timeStep][0] and [1] split into slabs of s_SlabSize slices in dimension 2,
+      i.e. m_SlabCountInSlice[timeStep][slab].countInSlice0[index] sums up to m_SegmentationCountInSlice[timeStep][0][index].
+    */
+    TimeResolvedSlabCountType m_SlabCountInSlice;
+
+    /// number of slices in dimension 2 that form one slab
+    static const unsigned int s_SlabSize = 16;
+
     static InterpolatorMapType s_InterpolatorForImage;
 
     Image::ConstPointer m_Segmentation;
@@ -37,6 +37,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 // Includes for 3DSurfaceInterpolation
 #include "mitkImageTimeSelector.h"
 #include "mitkImageToContourFilter.h"
+#include "mitkSegmentationInterpolationController.h"
 #include "mitkSurfaceInterpolationController.h"
 
 // includes for resling and overwriting
@@ -404,10 +405,21 @@ void mitk::SegTool2D::WriteSliceToVolume(mitk::SegTool2D::SliceInformation slice
   extractor->Modified();
   extractor->Update();
 
-  // the image was modified within the pipeline, but not marked so
+  // the image was modified within the pipeline, but not marked so.
+  // the interpolator only needs to recount the region around the slice instead of the whole volume
+  SegmentationInterpolationController *interpolator = SegmentationInterpolationController::InterpolatorForImage(image);
+  if (interpolator)
+    interpolator->BlockModified(true);
+
   image->Modified();
   image->GetVtkImageData()->Modified();
 
+  if (interpolator)
+  {
+    interpolator->SetChangedRegion(sliceInfo.plane, sliceInfo.timestep);
+    interpolator->BlockModified(false);
+  }
+
   /*============= BEGIN undo/redo feature block ========================*/
   // specify the undo operation with the edited slice
   auto *doOperation =
@@ -29,12 +29,33 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkTool.h>
 #include <mitkVtkImageOverwrite.h>
 
+// Gives access to the slice counts of the controller
+class TestSegmentationInterpolationController : public mitk::SegmentationInterpolationController
+{
+public:
+  mitkClassMacro(TestSegmentationInterpolationController, mitk::SegmentationInterpolationController);
+  itkFactorylessNewMacro(Self);
+
+  unsigned int GetNumberOfSlices(unsigned int dim) const
+  {
+    return static_cast<unsigned int>(m_SegmentationCountInSlice[0][dim].size());
+  }
+
+  unsigned int GetCountInSlice(unsigned int dim, unsigned int index) const
+  {
+    return m_SegmentationCountInSlice[0][dim][index];
+  }
+};
+
 class mitkSegmentationInterpolationTestSuite : public mitk::TestFixture
 {
   CPPUNIT_TEST_SUITE(mitkSegmentationInterpolationTestSuite);
   MITK_TEST(Equal_Axial_TestInterpolationAndReferenceInterpolation_ReturnsTrue);
   MITK_TEST(Equal_Frontal_TestInterpolationAndReferenceInterpolation_ReturnsTrue);
   MITK_TEST(Equal_Sagittal_TestInterpolationAndReferenceInterpolation_ReturnsTrue);
+  MITK_TEST(Equal_Axial_ChangedRegionCountsAndFullScanCounts_ReturnsTrue);
+  MITK_TEST(Equal_Frontal_ChangedRegionCountsAndFullScanCounts_ReturnsTrue);
+  MITK_TEST(Equal_Sagittal_ChangedRegionCountsAndFullScanCounts_ReturnsTrue);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -148,6 +169,78 @@ private:
     }
   }
 
+  // Edits a slice, updates the counts by SetChangedRegion() and compares them to the counts of a full scan
+  void testChangedRegionRoutine(mitk::SliceNavigationController::ViewDirection viewDirection, int dim)
+  {
+    // a cube around the center point crosses the slab borders in dimension 2 (slices 16 and 32)
+    {
+      mitk::ImagePixelWriteAccessor<mitk::Tool::DefaultSegmentationDataType, 3> writeAccessor(m_SegmentationImage);
+      itk::Index<3> currentPoint;
+      for (int i = -8; i <= 8; ++i)
+        for (int j = -8; j <= 8; ++j)
+          for (int k = -8; k <= 8; ++k)
+          {
+            currentPoint[0] = m_CenterPoint[0] + i;
+            currentPoint[1] = m_CenterPoint[1] + j;
+            currentPoint[2] = m_CenterPoint[2] + k;
+            writeAccessor.SetPixelByIndexSafe(currentPoint, 1);
+          }
+    }
+
+    TestSegmentationInterpolationController::Pointer incrementalController =
+      TestSegmentationInterpolationController::New();
+    incrementalController->Activate2DInterpolation(true);
+    incrementalController->BlockModified(true);
+    incrementalController->SetSegmentationVolume(m_SegmentationImage);
+    const unsigned int countBefore = incrementalController->GetCountInSlice(dim, m_CenterPoint[dim]);
+
+    // invert a square in the center slice, this adds and removes segmentation pixels
+    {
+      mitk::ImagePixelWriteAccessor<mitk::Tool::DefaultSegmentationDataType, 3> writeAccessor(m_SegmentationImage);
+      itk::Index<3> currentPoint = m_CenterPoint;
+      for (int i = -12; i <= 12; ++i)
+      {
+        for (int j = -12; j <= 12; ++j)
+        {
+          currentPoint[(dim + 1) % 3] = m_CenterPoint[(dim + 1) % 3] + i;
+          currentPoint[(dim + 2) % 3] = m_CenterPoint[(dim + 2) % 3] + j;
+          writeAccessor.SetPixelByIndexSafe(
+            currentPoint,
+            static_cast<mitk::Tool::DefaultSegmentationDataType>(1 - writeAccessor.GetPixelByIndexSafe(currentPoint)));
+        }
+      }
+    }
+
+    mitk::SliceNavigationController::Pointer navigationController = mitk::SliceNavigationController::New();
+    navigationController->SetInputWorldTimeGeometry(m_SegmentationImage->GetTimeGeometry());
+    navigationController->Update(viewDirection);
+    mitk::Point3D pointMM;
+    m_SegmentationImage->GetTimeGeometry()->GetGeometryForTimeStep(0)->IndexToWorld(m_CenterPoint, pointMM);
+    navigationController->SelectSliceByPoint(pointMM);
+    incrementalController->SetChangedRegion(navigationController->GetCurrentPlaneGeometry(), 0);
+
+    CPPUNIT_ASSERT_MESSAGE("Edit of the slice is not counted",
+                           incrementalController->GetCountInSlice(dim, m_CenterPoint[dim]) != countBefore);
+
+    TestSegmentationInterpolationController::Pointer fullScanController =
+      TestSegmentationInterpolationController::New();
+    fullScanController->Activate2DInterpolation(true);
+    fullScanController->BlockModified(true);
+    fullScanController->SetSegmentationVolume(m_SegmentationImage);
+
+    for (unsigned int countDim = 0; countDim < 3; ++countDim)
+    {
+      CPPUNIT_ASSERT_EQUAL(fullScanController->GetNumberOfSlices(countDim),
+                           incrementalController->GetNumberOfSlices(countDim));
+      for (unsigned int index = 0; index < fullScanController->GetNumberOfSlices(countDim); ++index)
+      {
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Count of changed region differs from count of full scan",
+                                     fullScanController->GetCountInSlice(countDim, index),
+                                     incrementalController->GetCountInSlice(countDim, index));
+      }
+    }
+  }
+
   mitk::Image::Pointer m_ReferenceImage;
   mitk::Image::Pointer m_SegmentationImage;
   itk::Index<3> m_CenterPoint;
@@ -203,6 +296,21 @@ public:
     mitk::SliceNavigationController::ViewDirection viewDirection = mitk::SliceNavigationController::Sagittal;
     testRoutine(viewDirection);
   }
+
+  void Equal_Axial_ChangedRegionCountsAndFullScanCounts_ReturnsTrue()
+  {
+    testChangedRegionRoutine(mitk::SliceNavigationController::Axial, 2);
+  }
+
+  void Equal_Frontal_ChangedRegionCountsAndFullScanCounts_ReturnsTrue()
+  {
+    testChangedRegionRoutine(mitk::SliceNavigationController::Frontal, 1);
+  }
+
+  void Equal_Sagittal_ChangedRegionCountsAndFullScanCounts_ReturnsTrue()
+  {
+    testChangedRegionRoutine(mitk::SliceNavigationController::Sagittal, 0);
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkSegmentationInterpolation)
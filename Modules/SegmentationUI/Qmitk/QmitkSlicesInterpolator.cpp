@@ -141,6 +141,12 @@ QmitkSlicesInterpolator::QmitkSlicesInterpolator(QWidget *parent, const char * /
   command2->SetCallbackFunction(this, &QmitkSlicesInterpolator::OnSurfaceInterpolationInfoChanged);
   SurfaceInterpolationInfoChangedObserverTag = m_SurfaceInterpolator->AddObserver(itk::ModifiedEvent(), command2);
 
+  itk::ReceptorMemberCommand<QmitkSlicesInterpolator>::Pointer command3 =
+    itk::ReceptorMemberCommand<QmitkSlicesInterpolator>::New();
+  command3->SetCallbackFunction(this, &QmitkSlicesInterpolator::OnSurfaceInterpolationFinishedEvent);
+  SurfaceInterpolationFinishedObserverTag =
+    m_SurfaceInterpolator->AddObserver(mitk::SurfaceInterpolationFinishedEvent(), command3);
+
   // feedback node and its visualization properties
   m_FeedbackNode = mitk::DataNode::New();
   mitk::CoreObjectFactory::GetInstance()->SetDefaultProperties(m_FeedbackNode);
@@ -187,12 +193,8 @@ QmitkSlicesInterpolator::QmitkSlicesInterpolator(QWidget *parent, const char * /
     QWidget::layout()->setContentsMargins(0, 0, 0, 0);
   }
 
-  // For running 3D Interpolation in background
-  // create a QFuture and a QFutureWatcher
-
-  connect(&m_Watcher, SIGNAL(started()), this, SLOT(StartUpdateInterpolationTimer()));
-  connect(&m_Watcher, SIGNAL(finished()), this, SLOT(OnSurfaceInterpolationFinished()));
-  connect(&m_Watcher, SIGNAL(finished()), this, SLOT(StopUpdateInterpolationTimer()));
+  // The 3D interpolation runs in the background (see Run3DInterpolation), the timer
+  // lets the surface blink while it is updated
   m_Timer = new QTimer(this);
   connect(m_Timer, SIGNAL(timeout()), this, SLOT(ChangeSurfaceColor()));
 }
@@ -337,6 +339,7 @@ QmitkSlicesInterpolator::~QmitkSlicesInterpolator()
   // remove observer
   m_Interpolator->RemoveObserver(InterpolationInfoChangedObserverTag);
   m_SurfaceInterpolator->RemoveObserver(SurfaceInterpolationInfoChangedObserverTag);
+  m_SurfaceInterpolator->RemoveObserver(SurfaceInterpolationFinishedObserverTag);
 
   delete m_Timer;
 }
@@ -593,6 +596,8 @@ void QmitkSlicesInterpolator::Interpolate(mitk::PlaneGeometry *plane,
 
 void QmitkSlicesInterpolator::OnSurfaceInterpolationFinished()
 {
+  m_SurfaceInterpolator->ApplyAsyncInterpolationResult();
+
   mitk::Surface::Pointer interpolatedSurface = m_SurfaceInterpolator->GetInterpolationResult();
   mitk::DataNode *workingNode = m_ToolManager->GetWorkingData(0);
 
@@ -1066,7 +1071,9 @@ void QmitkSlicesInterpolator::OnInterpolationActivated(bool on)
 
 void QmitkSlicesInterpolator::Run3DInterpolation()
 {
-  m_SurfaceInterpolator->Interpolate();
+  // Returns immediately, rapid successive requests are coalesced by the controller
+  this->StartUpdateInterpolationTimer();
+  m_SurfaceInterpolator->InterpolateAsync();
 }
 
 void QmitkSlicesInterpolator::StartUpdateInterpolationTimer()
@@ -1143,13 +1150,9 @@ void QmitkSlicesInterpolator::On3DInterpolationActivated(bool on)
             ret = msgBox.exec();
           }
 
-          if (m_Watcher.isRunning())
-            m_Watcher.waitForFinished();
-
           if (ret == QMessageBox::Yes)
           {
-            m_Future = QtConcurrent::run(this, &QmitkSlicesInterpolator::Run3DInterpolation);
-            m_Watcher.setFuture(m_Future);
+            this->Run3DInterpolation();
           }
           else
           {
@@ -1212,13 +1215,16 @@ void QmitkSlicesInterpolator::OnSurfaceInterpolationInfoChanged(const itk::Event
 {
   if (m_3DInterpolationEnabled)
   {
-    if (m_Watcher.isRunning())
-      m_Watcher.waitForFinished();
-    m_Future = QtConcurrent::run(this, &QmitkSlicesInterpolator::Run3DInterpolation);
-    m_Watcher.setFuture(m_Future);
+    this->Run3DInterpolation();
   }
 }
 
+void QmitkSlicesInterpolator::OnSurfaceInterpolationFinishedEvent(const itk::EventObject & /*e*/)
+{
+  QMetaObject::invokeMethod(this, "OnSurfaceInterpolationFinished", Qt::QueuedConnection);
+  QMetaObject::invokeMethod(this, "StopUpdateInterpolationTimer", Qt::QueuedConnection);
+}
+
 void QmitkSlicesInterpolator::SetCurrentContourListID()
 {
   // New ContourList = hide current interpolation
@@ -1272,10 +1278,7 @@ void QmitkSlicesInterpolator::SetCurrentContourListID()
 
         if (m_3DInterpolationEnabled)
         {
-          if (m_Watcher.isRunning())
-            m_Watcher.waitForFinished();
-          m_Future = QtConcurrent::run(this, &QmitkSlicesInterpolator::Run3DInterpolation);
-          m_Watcher.setFuture(m_Future);
+          this->Run3DInterpolation();
         }
       }
     }
@@ -1330,10 +1333,8 @@ void QmitkSlicesInterpolator::OnSliceNavigationControllerDeleted(const itk::Obje
 
 void QmitkSlicesInterpolator::WaitForFutures()
 {
-  if (m_Watcher.isRunning())
-  {
-    m_Watcher.waitForFinished();
-  }
+  m_SurfaceInterpolator->CancelAsyncInterpolation();
+  m_Timer->stop();
 
   if (m_PlaneWatcher.isRunning())
   {
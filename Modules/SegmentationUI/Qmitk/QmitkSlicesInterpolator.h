@@ -121,6 +121,12 @@ public:
   */
   void OnSurfaceInterpolationInfoChanged(const itk::EventObject &);
 
+  /**
+    Just public because it is called by itk::Commands. You should not need to call this.
+    Called from the interpolation thread, forwards the result to the GUI thread.
+  */
+  void OnSurfaceInterpolationFinishedEvent(const itk::EventObject &);
+
   /**
    * @brief Set the visibility of the 3d interpolation
    */
@@ -256,6 +262,7 @@ private:
 
   unsigned int InterpolationInfoChangedObserverTag;
   unsigned int SurfaceInterpolationInfoChangedObserverTag;
+  unsigned int SurfaceInterpolationFinishedObserverTag;
 
   QGroupBox *m_GroupBoxEnableExclusiveInterpolationMode;
   QComboBox *m_CmbInterpolation;
@@ -285,8 +292,6 @@ private:
 
   mitk::DataStorage::Pointer m_DataStorage;
 
-  QFuture<void> m_Future;
-  QFutureWatcher<void> m_Watcher;
   QTimer *m_Timer;
 
   QFuture<void> m_PlaneFuture;
@@ -18,9 +18,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkCreateDistanceImageFromSurfaceFilter.h>
 #include <mitkIOUtil.h>
 #include <mitkImageAccessByItk.h>
+#include <mitkImageCast.h>
 #include <mitkTestFixture.h>
 #include <mitkTestingMacros.h>
 
+#include <itkImageRegionConstIterator.h>
+
 #include <vtkDebugLeaks.h>
 
 class mitkCreateDistanceImageFromSurfaceFilterTestSuite : public mitk::TestFixture
@@ -29,6 +32,7 @@ class mitkCreateDistanceImageFromSurfaceFilterTestSuite : public mitk::TestFixtu
   vtkDebugLeaks::SetExitError(0);
   MITK_TEST(TestCreateDistanceImageForLiver);
   MITK_TEST(TestCreateDistanceImageForTube);
+  MITK_TEST(TestCreateDistanceImageForLiverWithCompactRBF);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -131,6 +135,80 @@ public:
     CPPUNIT_ASSERT_MESSAGE("HolesDistanceImages are not equal!",
                            mitk::Equal(*(holesDistanceImageReference), *(holeDistanceImage), 0.0001, true));
   }
+
+  // The compactly supported RBF is no exact reproduction of the dense interpolation, but the inside/outside
+  // decision within the narrow band, i.e. the interpolated surface, has to match it
+  void TestCreateDistanceImageForLiverWithCompactRBF()
+  {
+    unsigned int NUMBER_OF_LIVER_CONTOURS = 18;
+
+    for (unsigned int i = 0; i <= NUMBER_OF_LIVER_CONTOURS; ++i)
+    {
+      std::stringstream s;
+      s << "SurfaceInterpolation/InterpolateLiver/LiverContourWithNormals_";
+      s << i;
+      s << ".vtk";
+      mitk::Surface::Pointer contour = dynamic_cast<mitk::Surface*>(mitk::IOUtil::Load(GetTestDataFilePath(s.str()))[0].GetPointer());
+      contourList.push_back(contour);
+    }
+
+    mitk::Image::Pointer segmentationImage =
+      dynamic_cast<mitk::Image*>(mitk::IOUtil::Load(GetTestDataFilePath("SurfaceInterpolation/Reference/LiverSegmentation.nrrd"))[0].GetPointer());
+
+    mitk::ComputeContourSetNormalsFilter::Pointer m_NormalsFilter = mitk::ComputeContourSetNormalsFilter::New();
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer m_InterpolateSurfaceFilter =
+      mitk::CreateDistanceImageFromSurfaceFilter::New();
+    m_InterpolateSurfaceFilter->SetRBFMode(mitk::CreateDistanceImageFromSurfaceFilter::CompactRBF);
+
+    itk::ImageBase<3>::Pointer itkImage = itk::ImageBase<3>::New();
+    AccessFixedDimensionByItk_1(segmentationImage, GetImageBase, 3, itkImage);
+    m_InterpolateSurfaceFilter->SetReferenceImage(itkImage.GetPointer());
+
+    for (unsigned int j = 0; j < contourList.size(); j++)
+    {
+      m_NormalsFilter->SetInput(j, contourList.at(j));
+      m_InterpolateSurfaceFilter->SetInput(j, m_NormalsFilter->GetOutput(j));
+    }
+
+    m_InterpolateSurfaceFilter->Update();
+
+    mitk::Image::Pointer liverDistanceImage = m_InterpolateSurfaceFilter->GetOutput();
+
+    CPPUNIT_ASSERT(liverDistanceImage.IsNotNull());
+    mitk::Image::Pointer liverDistanceImageReference =
+      dynamic_cast<mitk::Image*>(mitk::IOUtil::Load(GetTestDataFilePath("SurfaceInterpolation/Reference/LiverDistanceImage.nrrd"))[0].GetPointer());
+
+    mitk::CreateDistanceImageFromSurfaceFilter::DistanceImageType::Pointer distanceImage;
+    mitk::CreateDistanceImageFromSurfaceFilter::DistanceImageType::Pointer referenceImage;
+    mitk::CastToItkImage(liverDistanceImage, distanceImage);
+    mitk::CastToItkImage(liverDistanceImageReference, referenceImage);
+
+    CPPUNIT_ASSERT_MESSAGE("Compact and dense LiverDistanceImages differ in size",
+                           distanceImage->GetLargestPossibleRegion() == referenceImage->GetLargestPossibleRegion());
+
+    // voxels outside of the narrow band keep the default value of 10 * spacing
+    const double narrowBand = 2 * m_InterpolateSurfaceFilter->GetDistanceImageSpacing();
+    unsigned int numberOfComparedVoxels = 0;
+    unsigned int numberOfDifferentSigns = 0;
+    itk::ImageRegionConstIterator<mitk::CreateDistanceImageFromSurfaceFilter::DistanceImageType> it(
+      distanceImage, distanceImage->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<mitk::CreateDistanceImageFromSurfaceFilter::DistanceImageType> referenceIt(
+      referenceImage, referenceImage->GetLargestPossibleRegion());
+    for (; !it.IsAtEnd(); ++it, ++referenceIt)
+    {
+      if (std::fabs(it.Get()) > narrowBand || std::fabs(referenceIt.Get()) > narrowBand)
+        continue;
+
+      ++numberOfComparedVoxels;
+      if ((it.Get() < 0) != (referenceIt.Get() < 0))
+        ++numberOfDifferentSigns;
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("Narrow bands of the compact and dense LiverDistanceImages do not overlap",
+                           numberOfComparedVoxels > 0);
+    CPPUNIT_ASSERT_MESSAGE("Compact LiverDistanceImage does not match the dense reference",
+                           numberOfDifferentSigns < 0.05 * numberOfComparedVoxels);
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkCreateDistanceImageFromSurfaceFilter)
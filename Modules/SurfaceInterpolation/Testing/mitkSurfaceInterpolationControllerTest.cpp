@@ -24,6 +24,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImagePixelWriteAccessor.h"
 #include "mitkImageTimeSelector.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 class mitkSurfaceInterpolationControllerTestSuite : public mitk::TestFixture
 {
   CPPUNIT_TEST_SUITE(mitkSurfaceInterpolationControllerTestSuite);
@@ -45,11 +50,65 @@ class mitkSurfaceInterpolationControllerTestSuite : public mitk::TestFixture
 
   MITK_TEST(TestAddNewContour);
   MITK_TEST(TestRemoveContour);
+
+  MITK_TEST(TestInterpolateAsync);
+  MITK_TEST(TestInterpolateAsyncSuperseded);
+  MITK_TEST(TestInterpolateAsyncCoalescing);
+  MITK_TEST(TestCancelAsyncInterpolation);
   CPPUNIT_TEST_SUITE_END();
 
 private:
   mitk::SurfaceInterpolationController::Pointer m_Controller;
 
+  std::atomic<unsigned int> m_NumberOfFinishedEvents;
+  unsigned long m_FinishedObserverTag;
+  bool m_ObservesFinishedEvents;
+
+  void OnInterpolationFinished() { ++m_NumberOfFinishedEvents; }
+
+  /** Waits until the given number of asynchronous interpolations has finished, returns false after a timeout */
+  bool WaitForFinishedEvents(unsigned int numberOfEvents)
+  {
+    for (unsigned int i = 0; i < 3000 && m_NumberOfFinishedEvents < numberOfEvents; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return m_NumberOfFinishedEvents >= numberOfEvents;
+  }
+
+  /** Creates a circle parallel to the axial plane */
+  mitk::Surface::Pointer createContour(double z, double radius)
+  {
+    double center[3] = {10.0, 10.0, z};
+    double normal[3] = {0.0, 0.0, 1.0};
+    vtkSmartPointer<vtkRegularPolygonSource> polygonSource = vtkSmartPointer<vtkRegularPolygonSource>::New();
+    polygonSource->SetNumberOfSides(40);
+    polygonSource->SetCenter(center);
+    polygonSource->SetRadius(radius);
+    polygonSource->SetNormal(normal);
+    polygonSource->Update();
+    mitk::Surface::Pointer contour = mitk::Surface::New();
+    contour->SetVtkPolyData(polygonSource->GetOutput());
+    return contour;
+  }
+
+  /** Starts an interpolation session on an empty segmentation with three contours */
+  mitk::Image::Pointer createInterpolationSession()
+  {
+    unsigned int dimensions[] = {20, 20, 20};
+    mitk::Image::Pointer segmentation = createImage(dimensions);
+    {
+      mitk::ImagePixelWriteAccessor<unsigned char, 3> accessor(segmentation);
+      std::fill(accessor.GetData(), accessor.GetData() + 20 * 20 * 20, 0);
+    }
+
+    m_Controller->SetCurrentInterpolationSession(segmentation);
+    m_Controller->SetMinSpacing(1.0);
+    m_Controller->SetMaxSpacing(1.0);
+    m_Controller->AddNewContour(createContour(4.0, 5.0));
+    m_Controller->AddNewContour(createContour(10.0, 7.0));
+    m_Controller->AddNewContour(createContour(15.0, 4.0));
+    return segmentation;
+  }
+
 public:
   mitk::Image::Pointer createImage(unsigned int *dimensions)
   {
@@ -71,6 +130,8 @@ public:
   {
     m_Controller = mitk::SurfaceInterpolationController::GetInstance();
     m_Controller->SetCurrentTimeStep(0);
+    m_NumberOfFinishedEvents = 0;
+    m_ObservesFinishedEvents = false;
 
     vtkSmartPointer<vtkRegularPolygonSource> polygonSource = vtkSmartPointer<vtkRegularPolygonSource>::New();
     polygonSource->SetRadius(100);
@@ -80,6 +141,25 @@ public:
     surface->SetVtkPolyData(polygonSource->GetOutput());
   }
 
+  void tearDown() override
+  {
+    if (m_ObservesFinishedEvents)
+      m_Controller->RemoveObserver(m_FinishedObserverTag);
+    m_Controller->CancelAsyncInterpolation();
+    m_Controller->SetAsyncInterpolationDelay(250);
+  }
+
+  /** Counts the SurfaceInterpolationFinishedEvents of the controller */
+  void observeFinishedEvents()
+  {
+    m_NumberOfFinishedEvents = 0;
+    itk::SimpleMemberCommand<mitkSurfaceInterpolationControllerTestSuite>::Pointer command =
+      itk::SimpleMemberCommand<mitkSurfaceInterpolationControllerTestSuite>::New();
+    command->SetCallbackFunction(this, &mitkSurfaceInterpolationControllerTestSuite::OnInterpolationFinished);
+    m_FinishedObserverTag = m_Controller->AddObserver(mitk::SurfaceInterpolationFinishedEvent(), command);
+    m_ObservesFinishedEvents = true;
+  }
+
   void TestSingleton()
   {
     mitk::SurfaceInterpolationController::Pointer controller2 = mitk::SurfaceInterpolationController::GetInstance();
@@ -557,6 +637,102 @@ public:
     return true;
   }
 
+  void TestInterpolateAsync()
+  {
+    mitk::Image::Pointer segmentation = createInterpolationSession();
+    observeFinishedEvents();
+    m_Controller->SetAsyncInterpolationDelay(0);
+
+    m_Controller->InterpolateAsync();
+    CPPUNIT_ASSERT_MESSAGE("Asynchronous interpolation did not finish", WaitForFinishedEvents(1));
+    CPPUNIT_ASSERT_MESSAGE("Result of asynchronous interpolation not applied", m_Controller->ApplyAsyncInterpolationResult());
+    CPPUNIT_ASSERT_MESSAGE("Result can only be applied once", !m_Controller->ApplyAsyncInterpolationResult());
+
+    mitk::Surface::Pointer asyncResult = m_Controller->GetInterpolationResult();
+    CPPUNIT_ASSERT_MESSAGE("Asynchronous interpolation result is null", asyncResult.IsNotNull());
+    CPPUNIT_ASSERT_MESSAGE("Contours of asynchronous interpolation not applied",
+                           m_Controller->GetContoursAsSurface()->GetVtkPolyData()->GetNumberOfPoints() == 3 * 40);
+
+    m_Controller->Interpolate();
+    mitk::Surface::Pointer result = m_Controller->GetInterpolationResult();
+    CPPUNIT_ASSERT_MESSAGE("Interpolation result is null", result.IsNotNull());
+    CPPUNIT_ASSERT_MESSAGE("Asynchronous interpolation result differs from synchronous one",
+                           mitk::Equal(*(result->GetVtkPolyData()), *(asyncResult->GetVtkPolyData()), 0.0001, true));
+  }
+
+  void TestInterpolateAsyncSuperseded()
+  {
+    mitk::Image::Pointer segmentation = createInterpolationSession();
+    observeFinishedEvents();
+    m_Controller->SetAsyncInterpolationDelay(0);
+
+    // a synchronous interpolation supersedes the asynchronous one
+    m_Controller->InterpolateAsync();
+    m_Controller->Interpolate();
+    mitk::Surface::Pointer result = m_Controller->GetInterpolationResult();
+    m_Controller->CancelAsyncInterpolation();
+    CPPUNIT_ASSERT_MESSAGE("Superseded result applied", !m_Controller->ApplyAsyncInterpolationResult());
+    CPPUNIT_ASSERT_MESSAGE("Synchronous result replaced", m_Controller->GetInterpolationResult() == result);
+
+    // a newer request supersedes the running one, only its result is applied
+    m_Controller->InterpolateAsync();
+    m_Controller->AddNewContour(createContour(8.0, 6.0));
+    m_Controller->InterpolateAsync();
+
+    bool applied = false;
+    for (unsigned int i = 1; i <= 2 && !applied; ++i)
+    {
+      CPPUNIT_ASSERT_MESSAGE("Asynchronous interpolation did not finish", WaitForFinishedEvents(i));
+      applied = m_Controller->ApplyAsyncInterpolationResult();
+    }
+    CPPUNIT_ASSERT_MESSAGE("Result of newest request not applied", applied);
+    CPPUNIT_ASSERT_MESSAGE("Result of superseded request applied",
+                           m_Controller->GetContoursAsSurface()->GetVtkPolyData()->GetNumberOfPoints() == 4 * 40);
+  }
+
+  void TestInterpolateAsyncCoalescing()
+  {
+    mitk::Image::Pointer segmentation = createInterpolationSession();
+    observeFinishedEvents();
+    m_Controller->SetAsyncInterpolationDelay(500);
+
+    for (unsigned int i = 0; i < 5; ++i)
+      m_Controller->InterpolateAsync();
+
+    CPPUNIT_ASSERT_MESSAGE("Asynchronous interpolation did not finish", WaitForFinishedEvents(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Requests not coalesced", 1u, m_NumberOfFinishedEvents.load());
+    CPPUNIT_ASSERT_MESSAGE("Result of coalesced requests not applied", m_Controller->ApplyAsyncInterpolationResult());
+    CPPUNIT_ASSERT_MESSAGE("Result of coalesced requests is null", m_Controller->GetInterpolationResult().IsNotNull());
+  }
+
+  void TestCancelAsyncInterpolation()
+  {
+    mitk::Image::Pointer segmentation = createInterpolationSession();
+    observeFinishedEvents();
+    m_Controller->SetAsyncInterpolationDelay(500);
+
+    // cancel a pending request
+    m_Controller->InterpolateAsync();
+    m_Controller->CancelAsyncInterpolation();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Cancelled interpolation finished", 0u, m_NumberOfFinishedEvents.load());
+    CPPUNIT_ASSERT_MESSAGE("Result of cancelled interpolation applied", !m_Controller->ApplyAsyncInterpolationResult());
+
+    // cancel a running request
+    m_Controller->SetAsyncInterpolationDelay(0);
+    m_Controller->InterpolateAsync();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    m_Controller->CancelAsyncInterpolation();
+    CPPUNIT_ASSERT_MESSAGE("Result of cancelled interpolation applied", !m_Controller->ApplyAsyncInterpolationResult());
+
+    // the controller accepts new requests after a cancellation
+    unsigned int numberOfEvents = m_NumberOfFinishedEvents;
+    m_Controller->InterpolateAsync();
+    CPPUNIT_ASSERT_MESSAGE("Asynchronous interpolation did not finish", WaitForFinishedEvents(numberOfEvents + 1));
+    CPPUNIT_ASSERT_MESSAGE("Result after cancellation not applied", m_Controller->ApplyAsyncInterpolationResult());
+  }
+
   void TestSetCurrentInterpolationSession4D()
   {
     /*unsigned int testDimensions[] = {10, 10, 10, 5};
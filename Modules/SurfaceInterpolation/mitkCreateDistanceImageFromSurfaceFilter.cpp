@@ -20,13 +20,26 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vtkCellArray.h"
 #include "vtkCellData.h"
 #include "vtkDoubleArray.h"
+#include "vtkMath.h"
+#include "vtkPoints.h"
 #include "vtkPolyData.h"
 #include "vtkSmartPointer.h"
+#include "vtkStaticPointLocator.h"
 
 #include "itkImageRegionIteratorWithIndex.h"
 #include "itkNeighborhoodIterator.h"
 
-#include <queue>
+#include <cmath>
+
+namespace
+{
+  // Wendland's C2 function, positive definite in 3D. r is the distance divided by the support radius (r < 1).
+  inline double WendlandFunction(double r)
+  {
+    const double t = 1.0 - r;
+    return t * t * t * t * (4.0 * r + 1.0);
+  }
+}
 
 void mitk::CreateDistanceImageFromSurfaceFilter::CreateEmptyDistanceImage()
 {
@@ -111,6 +124,10 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateEmptyDistanceImage()
 mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImageFromSurfaceFilter()
 {
   m_DistanceImageVolume = 50000;
+  m_RBFMode = DenseRBF;
+  m_SupportRadius = 0.0;
+  m_CurrentSupportRadius = 0.0;
+  m_UseWarmStart = false;
   this->m_UseProgressBar = false;
   this->m_ProgressStepSize = 5;
 
@@ -133,7 +150,17 @@ void mitk::CreateDistanceImageFromSurfaceFilter::GenerateData()
   if (this->m_UseProgressBar)
     mitk::ProgressBar::GetInstance()->Progress(1);
 
-  m_Weights = m_SolutionMatrix.partialPivLu().solve(m_FunctionValues);
+  if (this->GetAbortGenerateData())
+    throw itk::ProcessAborted(__FILE__, __LINE__);
+
+  if (m_RBFMode == CompactRBF)
+  {
+    this->SolveSparseEquationSystem();
+  }
+  else
+  {
+    m_Weights = m_SolutionMatrix.partialPivLu().solve(m_FunctionValues);
+  }
 
   if (this->m_UseProgressBar)
     mitk::ProgressBar::GetInstance()->Progress(2);
@@ -146,6 +173,8 @@ void mitk::CreateDistanceImageFromSurfaceFilter::GenerateData()
 
   m_Centers.clear();
   m_Normals.clear();
+  m_CenterContourIds.clear();
+  m_Buckets.clear();
 }
 
 void mitk::CreateDistanceImageFromSurfaceFilter::PreprocessContourPoints()
@@ -159,6 +188,11 @@ void mitk::CreateDistanceImageFromSurfaceFilter::PreprocessContourPoints()
     return;
   }
 
+  // An aborted run may have left its centers behind
+  m_Centers.clear();
+  m_Normals.clear();
+  m_CenterContourIds.clear();
+
   // First of all we have to extract the nomals and the surface points.
   // Duplicated points can be eliminated
 
@@ -214,6 +248,7 @@ void mitk::CreateDistanceImageFromSurfaceFilter::PreprocessContourPoints()
           m_Normals.push_back(normal);
 
           m_Centers.push_back(currentPoint);
+          m_CenterContourIds.push_back(i);
         }
 
       } // end for all points
@@ -265,23 +300,33 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunction
   }
 
   // Now we have created all centers and all function values. Next step is to create the solution matrix
+  const unsigned int numberOfContourPoints = numberOfCenters;
   numberOfCenters = m_Centers.size();
 
+  if (m_RBFMode == CompactRBF)
+  {
+    this->CreateCenterBuckets(numberOfContourPoints);
+    this->CreateSparseSolutionMatrix();
+    return;
+  }
+
   m_SolutionMatrix.resize(numberOfCenters, numberOfCenters);
 
   m_Weights.resize(numberOfCenters);
 
-  PointType p1;
-  PointType p2;
-  double norm;
-
-  for (unsigned int i = 0; i < numberOfCenters; i++)
+  const int numberOfRows = numberOfCenters;
+#pragma omp parallel for
+  for (int i = 0; i < numberOfRows; i++)
   {
+    PointType p1;
+    PointType p2;
+    double norm;
+
     for (unsigned int j = 0; j < numberOfCenters; j++)
     {
       // Calculate the RBF value. Currently using Phi(r) = r with r is the euclidian distance between two points
-      p1 = m_Centers.at(i);
-      p2 = m_Centers.at(j);
+      p1 = m_Centers[i];
+      p2 = m_Centers[j];
       p1 = p1 - p2;
       norm = p1.two_norm();
       m_SolutionMatrix(i, j) = norm;
@@ -289,6 +334,188 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunction
   }
 }
 
+void mitk::CreateDistanceImageFromSurfaceFilter::CreateCenterBuckets(unsigned int numberOfContourPoints)
+{
+  m_CurrentSupportRadius = m_SupportRadius;
+
+  if (m_CurrentSupportRadius <= 0)
+  {
+    // The support has to bridge the gap between neighbouring contours. For each contour point we search the
+    // nearest point of another contour, the largest of these distances is the widest gap. The nearest point
+    // is looked up in a point locator per contour, which is built once and queried concurrently.
+    const unsigned int numberOfContours =
+      *std::max_element(m_CenterContourIds.begin(), m_CenterContourIds.begin() + numberOfContourPoints) + 1;
+    std::vector<vtkSmartPointer<vtkPoints>> contourPoints(numberOfContours);
+    for (unsigned int i = 0; i < numberOfContourPoints; i++)
+    {
+      vtkSmartPointer<vtkPoints> &points = contourPoints[m_CenterContourIds[i]];
+      if (points == nullptr)
+        points = vtkSmartPointer<vtkPoints>::New();
+      points->InsertNextPoint(m_Centers[i][0], m_Centers[i][1], m_Centers[i][2]);
+    }
+
+    std::vector<vtkSmartPointer<vtkStaticPointLocator>> locators(numberOfContours);
+    for (unsigned int contour = 0; contour < numberOfContours; contour++)
+    {
+      if (contourPoints[contour] == nullptr)
+        continue;
+
+      vtkSmartPointer<vtkPolyData> pointSet = vtkSmartPointer<vtkPolyData>::New();
+      pointSet->SetPoints(contourPoints[contour]);
+      locators[contour] = vtkSmartPointer<vtkStaticPointLocator>::New();
+      locators[contour]->SetDataSet(pointSet);
+      locators[contour]->BuildLocator();
+    }
+
+    std::vector<double> nearestDistances(numberOfContourPoints, 0.0);
+    const int numberOfPoints = numberOfContourPoints;
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < numberOfPoints; i++)
+    {
+      double point[3] = {m_Centers[i][0], m_Centers[i][1], m_Centers[i][2]};
+      double minSquaredDistance = -1;
+      for (unsigned int contour = 0; contour < numberOfContours; contour++)
+      {
+        if (locators[contour] == nullptr || contour == m_CenterContourIds[i])
+          continue;
+
+        double nearestPoint[3];
+        contourPoints[contour]->GetPoint(locators[contour]->FindClosestPoint(point), nearestPoint);
+        double squaredDistance = vtkMath::Distance2BetweenPoints(point, nearestPoint);
+        if (minSquaredDistance < 0 || squaredDistance < minSquaredDistance)
+          minSquaredDistance = squaredDistance;
+      }
+      if (minSquaredDistance > 0)
+        nearestDistances[i] = std::sqrt(minSquaredDistance);
+    }
+
+    double maxGap = *std::max_element(nearestDistances.begin(), nearestDistances.end());
+    m_CurrentSupportRadius = std::max(2 * maxGap, 8 * m_DistanceImageSpacing);
+  }
+
+  // Sort the centers into buckets with an edge length of the support radius. So all centers that contribute
+  // to the value at a point are found in the 27 buckets around it.
+  PointType minPoint = m_Centers[0];
+  PointType maxPoint = m_Centers[0];
+  for (auto centerIter = m_Centers.begin(); centerIter != m_Centers.end(); ++centerIter)
+  {
+    for (unsigned int dim = 0; dim < 3; ++dim)
+    {
+      minPoint[dim] = std::min(minPoint[dim], (*centerIter)[dim]);
+      maxPoint[dim] = std::max(maxPoint[dim], (*centerIter)[dim]);
+    }
+  }
+
+  m_BucketOrigin = minPoint;
+  for (unsigned int dim = 0; dim < 3; ++dim)
+    m_BucketDimensions[dim] = static_cast<int>((maxPoint[dim] - minPoint[dim]) / m_CurrentSupportRadius) + 1;
+
+  m_Buckets.clear();
+  m_Buckets.resize(m_BucketDimensions[0] * m_BucketDimensions[1] * m_BucketDimensions[2]);
+
+  int bucketIndex[3];
+  for (unsigned int i = 0; i < m_Centers.size(); i++)
+  {
+    this->GetBucketIndex(m_Centers[i], bucketIndex);
+    m_Buckets[(bucketIndex[2] * m_BucketDimensions[1] + bucketIndex[1]) * m_BucketDimensions[0] + bucketIndex[0]]
+      .push_back(i);
+  }
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::GetBucketIndex(const PointType &p, int bucketIndex[3]) const
+{
+  // Points outside of the buckets are clamped to the border buckets. This is safe since all centers
+  // within the support radius of such a point are still contained in the neighbouring buckets.
+  for (unsigned int dim = 0; dim < 3; ++dim)
+  {
+    int index = static_cast<int>(std::floor((p[dim] - m_BucketOrigin[dim]) / m_CurrentSupportRadius));
+    bucketIndex[dim] = std::max(0, std::min(m_BucketDimensions[dim] - 1, index));
+  }
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::CreateSparseSolutionMatrix()
+{
+  const int numberOfCenters = m_Centers.size();
+  const double squaredRadius = m_CurrentSupportRadius * m_CurrentSupportRadius;
+
+  std::vector<std::vector<Eigen::Triplet<double>>> rows(numberOfCenters);
+
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int i = 0; i < numberOfCenters; i++)
+  {
+    int bucketIndex[3];
+    this->GetBucketIndex(m_Centers[i], bucketIndex);
+
+    for (int z = std::max(0, bucketIndex[2] - 1); z <= std::min(m_BucketDimensions[2] - 1, bucketIndex[2] + 1); z++)
+      for (int y = std::max(0, bucketIndex[1] - 1); y <= std::min(m_BucketDimensions[1] - 1, bucketIndex[1] + 1); y++)
+        for (int x = std::max(0, bucketIndex[0] - 1); x <= std::min(m_BucketDimensions[0] - 1, bucketIndex[0] + 1);
+             x++)
+        {
+          const std::vector<unsigned int> &bucket =
+            m_Buckets[(z * m_BucketDimensions[1] + y) * m_BucketDimensions[0] + x];
+          for (auto bucketIter = bucket.begin(); bucketIter != bucket.end(); ++bucketIter)
+          {
+            double squaredDistance = (m_Centers[i] - m_Centers[*bucketIter]).squared_magnitude();
+            if (squaredDistance < squaredRadius)
+            {
+              rows[i].push_back(Eigen::Triplet<double>(
+                i, *bucketIter, WendlandFunction(std::sqrt(squaredDistance) / m_CurrentSupportRadius)));
+            }
+          }
+        }
+  }
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  for (auto rowIter = rows.begin(); rowIter != rows.end(); ++rowIter)
+    triplets.insert(triplets.end(), rowIter->begin(), rowIter->end());
+
+  m_SparseSolutionMatrix.resize(numberOfCenters, numberOfCenters);
+  m_SparseSolutionMatrix.setFromTriplets(triplets.begin(), triplets.end());
+
+  m_Weights.resize(numberOfCenters);
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::SolveSparseEquationSystem()
+{
+  // The compactly supported RBF vanishes far away from the contours. It therefore interpolates the offset
+  // to the default value, so that the distance function is positive (outside) where no center contributes.
+  Eigen::VectorXd offsetValues = (m_FunctionValues.array() - m_DistanceImageDefaultBufferValue).matrix();
+
+  Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Lower | Eigen::Upper> solver;
+  solver.compute(m_SparseSolutionMatrix);
+
+  if (m_UseWarmStart && !m_PreviousWeights.empty())
+  {
+    // Centers of unchanged contours keep their weights, new centers start at zero
+    Eigen::VectorXd initialGuess = Eigen::VectorXd::Zero(m_Centers.size());
+    for (unsigned int i = 0; i < m_Centers.size(); i++)
+    {
+      auto previousWeight = m_PreviousWeights.find(m_Centers[i]);
+      if (previousWeight != m_PreviousWeights.end())
+        initialGuess[i] = previousWeight->second;
+    }
+    m_Weights = solver.solveWithGuess(offsetValues, initialGuess);
+  }
+  else
+  {
+    m_Weights = solver.solve(offsetValues);
+  }
+
+  if (solver.info() != Eigen::Success)
+  {
+    MITK_WARN << "mitk::CreateDistanceImageFromSurfaceFilter: The sparse equation system did not converge after "
+              << solver.iterations() << " iterations (error " << solver.error() << ")";
+  }
+
+  if (m_UseWarmStart)
+  {
+    m_PreviousWeights.clear();
+    for (unsigned int i = 0; i < m_Centers.size(); i++)
+      m_PreviousWeights[m_Centers[i]] = m_Weights[i];
+  }
+}
+
 void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
 {
   /*
@@ -305,9 +532,13 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
   typedef itk::ImageRegionIteratorWithIndex<DistanceImageType> ImageIterator;
   typedef itk::NeighborhoodIterator<DistanceImageType> NeighborhoodImageIterator;
 
-  std::queue<DistanceImageType::IndexType> narrowbandPoints;
+  std::vector<DistanceImageType::IndexType> narrowbandPoints;
   PointType currentPoint = m_Centers.at(0);
-  double distance = this->CalculateDistanceValue(currentPoint);
+  double distance(0);
+  if (m_RBFMode == CompactRBF)
+    this->CalculateCompactDistanceValue(currentPoint, distance);
+  else
+    distance = this->CalculateDistanceValue(currentPoint);
 
   // create itk::Point from vnl_vector
   DistanceImageType::PointType currentPointAsPoint;
@@ -322,7 +553,7 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
   assert(
     m_DistanceImageITK->GetLargestPossibleRegion().IsInside(currentIndex)); // we are quite certain this should hold
 
-  narrowbandPoints.push(currentIndex);
+  narrowbandPoints.push_back(currentIndex);
   m_DistanceImageITK->SetPixel(currentIndex, distance);
 
   NeighborhoodImageIterator::RadiusType radius;
@@ -330,38 +561,85 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
   NeighborhoodImageIterator nIt(radius, m_DistanceImageITK, m_DistanceImageITK->GetLargestPossibleRegion());
   unsigned int relativeNbIdx[] = {4, 10, 12, 14, 16, 22};
 
+  // Pixels whose distance value exceeded the threshold, they don't have to be checked again
+  std::vector<bool> rejected(m_DistanceImageITK->GetLargestPossibleRegion().GetNumberOfPixels(), false);
+
+  std::vector<DistanceImageType::IndexType> candidates;
+  std::vector<double> candidateDistances;
+  std::vector<char> candidateAccepted;
+  itk::Functor::IndexLexicographicCompare<3> indexCompare;
+
+  // The narrowband grows front by front. The distance values of all neighbors of the current
+  // front are calculated in parallel, the accepted ones form the next front.
   bool isInBounds = false;
   while (!narrowbandPoints.empty())
   {
-    nIt.SetLocation(narrowbandPoints.front());
-    narrowbandPoints.pop();
+    if (this->GetAbortGenerateData())
+      throw itk::ProcessAborted(__FILE__, __LINE__);
 
-    unsigned int *relativeNb = &relativeNbIdx[0];
-    for (int i = 0; i < 6; i++)
+    candidates.clear();
+    for (auto pointIter = narrowbandPoints.begin(); pointIter != narrowbandPoints.end(); ++pointIter)
     {
-      nIt.GetPixel(*relativeNb, isInBounds);
-      if (isInBounds && nIt.GetPixel(*relativeNb) == m_DistanceImageDefaultBufferValue)
+      nIt.SetLocation(*pointIter);
+
+      for (int i = 0; i < 6; i++)
       {
-        currentIndex = nIt.GetIndex(*relativeNb);
+        nIt.GetPixel(relativeNbIdx[i], isInBounds);
+        if (isInBounds && nIt.GetPixel(relativeNbIdx[i]) == m_DistanceImageDefaultBufferValue)
+        {
+          currentIndex = nIt.GetIndex(relativeNbIdx[i]);
+          if (!rejected[m_DistanceImageITK->ComputeOffset(currentIndex)])
+            candidates.push_back(currentIndex);
+        }
+      }
+    }
 
-        // Transform the currently checked point from index-coordinates to
-        // world-coordinates
-        m_DistanceImageITK->TransformIndexToPhysicalPoint(currentIndex, currentPointAsPoint);
+    // neighboring points of the front share candidates
+    std::sort(candidates.begin(), candidates.end(), indexCompare);
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
 
-        // create a vnl_vector
-        currentPoint[0] = currentPointAsPoint[0];
-        currentPoint[1] = currentPointAsPoint[1];
-        currentPoint[2] = currentPointAsPoint[2];
+    const int numberOfCandidates = candidates.size();
+    candidateDistances.resize(numberOfCandidates);
+    candidateAccepted.resize(numberOfCandidates);
 
-        // and check the distance
-        distance = this->CalculateDistanceValue(currentPoint);
-        if (std::fabs(distance) <= m_DistanceImageSpacing * 2)
-        {
-          nIt.SetPixel(*relativeNb, distance);
-          narrowbandPoints.push(currentIndex);
-        }
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int i = 0; i < numberOfCandidates; i++)
+    {
+      // Transform the currently checked point from index-coordinates to
+      // world-coordinates
+      DistanceImageType::PointType candidatePointAsPoint;
+      m_DistanceImageITK->TransformIndexToPhysicalPoint(candidates[i], candidatePointAsPoint);
+
+      // create a vnl_vector
+      PointType candidatePoint;
+      candidatePoint[0] = candidatePointAsPoint[0];
+      candidatePoint[1] = candidatePointAsPoint[1];
+      candidatePoint[2] = candidatePointAsPoint[2];
+
+      // and check the distance
+      double candidateDistance(0);
+      bool isInNarrowband = true;
+      if (m_RBFMode == CompactRBF)
+        isInNarrowband = this->CalculateCompactDistanceValue(candidatePoint, candidateDistance);
+      else
+        candidateDistance = this->CalculateDistanceValue(candidatePoint);
+
+      candidateDistances[i] = candidateDistance;
+      candidateAccepted[i] = isInNarrowband && std::fabs(candidateDistance) <= m_DistanceImageSpacing * 2;
+    }
+
+    narrowbandPoints.clear();
+    for (int i = 0; i < numberOfCandidates; i++)
+    {
+      if (candidateAccepted[i])
+      {
+        m_DistanceImageITK->SetPixel(candidates[i], candidateDistances[i]);
+        narrowbandPoints.push_back(candidates[i]);
+      }
+      else
+      {
+        rejected[m_DistanceImageITK->ComputeOffset(candidates[i])] = true;
       }
-      relativeNb++;
     }
   }
 
@@ -443,6 +721,41 @@ double mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValue(PointT
   return distanceValue;
 }
 
+bool mitk::CreateDistanceImageFromSurfaceFilter::CalculateCompactDistanceValue(const PointType &p, double &distance)
+{
+  // Only points close to the contours are part of the narrowband. Further away the RBF fades out and
+  // the interpolated function is not meaningful anymore.
+  const double squaredRadius = m_CurrentSupportRadius * m_CurrentSupportRadius;
+  const double squaredNarrowbandRadius = 0.25 * squaredRadius;
+
+  bool isInNarrowband = false;
+  double distanceValue(0);
+
+  int bucketIndex[3];
+  this->GetBucketIndex(p, bucketIndex);
+
+  for (int z = std::max(0, bucketIndex[2] - 1); z <= std::min(m_BucketDimensions[2] - 1, bucketIndex[2] + 1); z++)
+    for (int y = std::max(0, bucketIndex[1] - 1); y <= std::min(m_BucketDimensions[1] - 1, bucketIndex[1] + 1); y++)
+      for (int x = std::max(0, bucketIndex[0] - 1); x <= std::min(m_BucketDimensions[0] - 1, bucketIndex[0] + 1); x++)
+      {
+        const std::vector<unsigned int> &bucket = m_Buckets[(z * m_BucketDimensions[1] + y) * m_BucketDimensions[0] + x];
+        for (auto bucketIter = bucket.begin(); bucketIter != bucket.end(); ++bucketIter)
+        {
+          double squaredDistance = (p - m_Centers[*bucketIter]).squared_magnitude();
+          if (squaredDistance < squaredRadius)
+          {
+            distanceValue +=
+              m_Weights[*bucketIter] * WendlandFunction(std::sqrt(squaredDistance) / m_CurrentSupportRadius);
+            if (squaredDistance < squaredNarrowbandRadius)
+              isInNarrowband = true;
+          }
+        }
+      }
+
+  distance = m_DistanceImageDefaultBufferValue + distanceValue;
+  return isInNarrowband;
+}
+
 void mitk::CreateDistanceImageFromSurfaceFilter::GenerateOutputInformation()
 {
 }
@@ -450,6 +763,11 @@ void mitk::CreateDistanceImageFromSurfaceFilter::GenerateOutputInformation()
 void mitk::CreateDistanceImageFromSurfaceFilter::PrintEquationSystem()
 {
   std::stringstream out;
+  if (m_RBFMode == CompactRBF)
+  {
+    out << "Sparse system with support radius " << m_CurrentSupportRadius << endl;
+    out << m_SparseSolutionMatrix << endl;
+  }
   out << "Nummber of rows: " << m_SolutionMatrix.rows() << " ****** Number of columns: " << m_SolutionMatrix.cols()
       << endl;
   out << "[ ";
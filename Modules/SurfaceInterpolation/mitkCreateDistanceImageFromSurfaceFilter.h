@@ -28,6 +28,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkImageBase.h"
 
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+#include <algorithm>
+#include <map>
 
 namespace mitk
 {
@@ -56,6 +60,11 @@ namespace mitk
          with the marching cubes algorithm. (Within the  distance image the surface goes exactly where the pixelvalues
   are zero)
 
+         By default the global RBF phi(r) = r is used and the dense equation system is solved directly, which
+         scales cubically with the number of contour points. For many or dense contours the CompactRBF mode uses a
+         Wendland function with compact support instead. Its sparse equation system is solved iteratively and each
+         voxel is evaluated only with the centers in the neighbouring buckets.
+
          Note that the obtained distance image has always an isotropig spacing. The size (in this case volume) of the
   image can be
          adjusted by calling SetDistanceImageVolume(unsigned int volume) which specifies the number ob pixels enclosed
@@ -78,6 +87,13 @@ namespace mitk
 
     typedef std::vector<Surface::Pointer> SurfaceList;
 
+    /** \brief Radial basis function that is used for the interpolation */
+    enum RBFMode
+    {
+      DenseRBF,  ///< phi(r) = r with support on the whole image, dense LU decomposition
+      CompactRBF ///< Wendland function with compact support, sparse conjugate gradient solver
+    };
+
     mitkClassMacro(CreateDistanceImageFromSurfaceFilter, ImageSource);
     itkFactorylessNewMacro(Self) itkCloneMacro(Self)
 
@@ -103,6 +119,27 @@ namespace mitk
     */
     itkSetMacro(DistanceImageVolume, unsigned int);
 
+    /**
+    \brief Set the radial basis function used for the interpolation. Default is DenseRBF.
+    */
+    itkSetMacro(RBFMode, RBFMode);
+    itkGetConstMacro(RBFMode, RBFMode);
+
+    /**
+    \brief Set the support radius (in mm) of the compactly supported RBF.
+           If it is 0 (default) the radius is derived from the distance between the input contours.
+    */
+    itkSetMacro(SupportRadius, double);
+    itkGetConstMacro(SupportRadius, double);
+
+    /**
+    \brief Use the weights of the previous run as initial guess for the iterative solver of the CompactRBF mode.
+           This speeds up repeated interpolations of slowly changing contour sets.
+    */
+    itkSetMacro(UseWarmStart, bool);
+    itkGetConstMacro(UseWarmStart, bool);
+    itkBooleanMacro(UseWarmStart);
+
     void PrintEquationSystem();
 
     // Resets the filter, i.e. removes all inputs and outputs
@@ -134,6 +171,22 @@ namespace mitk
     void CreateSolutionMatrixAndFunctionValues();
     double CalculateDistanceValue(PointType p);
 
+    /**
+    * \brief Evaluates the compactly supported distance function at p.
+    *
+    * Returns false if p is too far away from all centers to be part of the narrow band.
+    */
+    bool CalculateCompactDistanceValue(const PointType &p, double &distance);
+
+    /**
+    * \brief Determines the support radius of the compactly supported RBF and sorts the centers into
+    * buckets with an edge length of this radius.
+    */
+    void CreateCenterBuckets(unsigned int numberOfContourPoints);
+    void GetBucketIndex(const PointType &p, int bucketIndex[3]) const;
+    void CreateSparseSolutionMatrix();
+    void SolveSparseEquationSystem();
+
     void FillDistanceImage();
 
     /**
@@ -162,7 +215,10 @@ namespace mitk
     CenterList m_Centers;
     NormalList m_Normals;
 
+    std::vector<unsigned int> m_CenterContourIds;
+
     Eigen::MatrixXd m_SolutionMatrix;
+    Eigen::SparseMatrix<double> m_SparseSolutionMatrix;
     Eigen::VectorXd m_FunctionValues;
     Eigen::VectorXd m_Weights;
 
@@ -173,6 +229,27 @@ namespace mitk
     double m_DistanceImageDefaultBufferValue;
     unsigned int m_DistanceImageVolume;
 
+    RBFMode m_RBFMode;
+    double m_SupportRadius;
+    double m_CurrentSupportRadius;
+
+    struct PointLess
+    {
+      bool operator()(const PointType &p1, const PointType &p2) const
+      {
+        return std::lexicographical_compare(p1.begin(), p1.end(), p2.begin(), p2.end());
+      }
+    };
+
+    // Weights of the last run at their centers, used as initial guess for the next run
+    bool m_UseWarmStart;
+    std::map<PointType, double, PointLess> m_PreviousWeights;
+
+    // Uniform grid of buckets containing the indices of the centers
+    PointType m_BucketOrigin;
+    int m_BucketDimensions[3];
+    std::vector<std::vector<unsigned int>> m_Buckets;
+
     bool m_UseProgressBar;
     unsigned int m_ProgressStepSize;
   };
@@ -23,6 +23,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include "vtkXMLPolyDataWriter.h"
 #include "vtkPolyDataWriter.h"
 
+#include <chrono>
+
 // Check whether the given contours are coplanar
 bool ContoursCoplanar(mitk::SurfaceInterpolationController::ContourPositionInformation leftHandSide,
                       mitk::SurfaceInterpolationController::ContourPositionInformation rightHandSide)
@@ -78,7 +80,20 @@ mitk::SurfaceInterpolationController::ContourPositionInformation CreateContourPo
 }
 
 mitk::SurfaceInterpolationController::SurfaceInterpolationController()
-  : m_SelectedSegmentation(nullptr), m_CurrentTimeStep(0)
+  : m_SelectedSegmentation(nullptr),
+    m_CurrentTimeStep(0),
+    m_MinSpacing(-1),
+    m_MaxSpacing(-1),
+    m_DistanceImageVolume(50000),
+    m_RBFMode(CreateDistanceImageFromSurfaceFilter::CompactRBF),
+    m_RequestedRevision(0),
+    m_HandledRevision(0),
+    m_AsyncResultAvailable(false),
+    m_AsyncResultRevision(0),
+    m_AsyncDistanceImageSpacing(0.0),
+    m_AsyncInterpolationRunning(false),
+    m_StopAsyncThread(false),
+    m_AsyncInterpolationDelay(250)
 {
   m_DistanceImageSpacing = 0.0;
   m_ReduceFilter = ReduceContourSetFilter::New();
@@ -92,6 +107,16 @@ mitk::SurfaceInterpolationController::SurfaceInterpolationController()
   m_NormalsFilter->SetProgressStepSize(1);
   m_InterpolateSurfaceFilter->SetUseProgressBar(true);
   m_InterpolateSurfaceFilter->SetProgressStepSize(7);
+  m_InterpolateSurfaceFilter->SetRBFMode(m_RBFMode);
+
+  // The progress bar must not be touched from the interpolation thread
+  m_AsyncReduceFilter = ReduceContourSetFilter::New();
+  m_AsyncNormalsFilter = ComputeContourSetNormalsFilter::New();
+  m_AsyncInterpolateSurfaceFilter = CreateDistanceImageFromSurfaceFilter::New();
+  m_AsyncReduceFilter->SetUseProgressBar(false);
+  m_AsyncNormalsFilter->SetUseProgressBar(false);
+  m_AsyncInterpolateSurfaceFilter->SetUseProgressBar(false);
+  m_AsyncInterpolateSurfaceFilter->UseWarmStartOn();
 
   m_Contours = Surface::New();
 
@@ -105,6 +130,16 @@ mitk::SurfaceInterpolationController::SurfaceInterpolationController()
 
 mitk::SurfaceInterpolationController::~SurfaceInterpolationController()
 {
+  {
+    std::lock_guard<std::mutex> lock(m_AsyncMutex);
+    m_StopAsyncThread = true;
+    ++m_RequestedRevision;
+  }
+  m_AsyncInterpolateSurfaceFilter->AbortGenerateDataOn();
+  m_AsyncCondition.notify_all();
+  if (m_AsyncThread.joinable())
+    m_AsyncThread.join();
+
   // Removing all observers
   auto dataIter = m_SegmentationObserverTags.begin();
   for (; dataIter != m_SegmentationObserverTags.end(); ++dataIter)
@@ -265,6 +300,13 @@ unsigned int mitk::SurfaceInterpolationController::GetNumberOfContours()
 
 void mitk::SurfaceInterpolationController::Interpolate()
 {
+  {
+    // Pending and running asynchronous interpolations are outdated now
+    std::lock_guard<std::mutex> lock(m_AsyncMutex);
+    ++m_RequestedRevision;
+  }
+  m_AsyncInterpolateSurfaceFilter->AbortGenerateDataOn();
+
   m_ReduceFilter->Update();
 
   m_CurrentNumberOfReducedContours = m_ReduceFilter->GetNumberOfOutputs();
@@ -296,6 +338,7 @@ void mitk::SurfaceInterpolationController::Interpolate()
   if (m_CurrentNumberOfReducedContours < 2)
   {
     // If no interpolation is possible reset the interpolation result
+    std::lock_guard<std::mutex> lock(m_AsyncMutex);
     m_InterpolationResult = nullptr;
     return;
   }
@@ -313,7 +356,12 @@ void mitk::SurfaceInterpolationController::Interpolate()
 
   mitk::Surface::Pointer interpolationResult = mitk::Surface::New();
   interpolationResult->SetVtkPolyData(imageToSurfaceFilter->GetOutput()->GetVtkPolyData(), m_CurrentTimeStep);
-  m_InterpolationResult = interpolationResult;
+  interpolationResult->DisconnectPipeline();
+
+  {
+    std::lock_guard<std::mutex> lock(m_AsyncMutex);
+    m_InterpolationResult = interpolationResult;
+  }
 
   m_DistanceImageSpacing = m_InterpolateSurfaceFilter->GetDistanceImageSpacing();
 
@@ -328,12 +376,242 @@ void mitk::SurfaceInterpolationController::Interpolate()
 
   // Last progress step
   mitk::ProgressBar::GetInstance()->Progress(20);
+}
+
+void mitk::SurfaceInterpolationController::InterpolateAsync()
+{
+  if (!m_SelectedSegmentation || m_CurrentTimeStep >= m_SelectedSegmentation->GetTimeSteps() ||
+      m_ListOfInterpolationSessions[m_SelectedSegmentation].size() <= m_CurrentTimeStep)
+  {
+    return;
+  }
+
+  // Copy everything the interpolation needs, so that the contours can be edited in the meantime
+  AsyncInterpolationRequest request;
+  request.timeStep = m_CurrentTimeStep;
+
+  ContourPositionInformationList &contourList = m_ListOfInterpolationSessions[m_SelectedSegmentation][m_CurrentTimeStep];
+  for (auto contourIter = contourList.begin(); contourIter != contourList.end(); ++contourIter)
+    request.contours.push_back(contourIter->contour);
+
+  mitk::ImageTimeSelector::Pointer timeSelector = mitk::ImageTimeSelector::New();
+  timeSelector->SetInput(m_SelectedSegmentation);
+  timeSelector->SetTimeNr(m_CurrentTimeStep);
+  timeSelector->SetChannelNr(0);
+  timeSelector->Update();
+  request.segmentation = timeSelector->GetOutput();
+
+  itk::ImageBase<3>::Pointer itkImage = itk::ImageBase<3>::New();
+  AccessFixedDimensionByItk_1(request.segmentation, GetImageBase, 3, itkImage);
+  request.referenceImage = itkImage;
+
+  request.minSpacing = m_MinSpacing;
+  request.maxSpacing = m_MaxSpacing;
+  request.distanceImageVolume = m_DistanceImageVolume;
+  request.rbfMode = m_RBFMode;
+
+  {
+    std::lock_guard<std::mutex> lock(m_AsyncMutex);
+    request.revision = ++m_RequestedRevision;
+    m_PendingRequest = request;
+
+    if (!m_AsyncThread.joinable())
+      m_AsyncThread = std::thread(&SurfaceInterpolationController::AsyncInterpolationLoop, this);
+  }
+
+  // A running interpolation is outdated now
+  m_AsyncInterpolateSurfaceFilter->AbortGenerateDataOn();
+  m_AsyncCondition.notify_all();
+}
+
+void mitk::SurfaceInterpolationController::CancelAsyncInterpolation()
+{
+  std::unique_lock<std::mutex> lock(m_AsyncMutex);
+  ++m_RequestedRevision;
+  m_HandledRevision = m_RequestedRevision;
+  m_AsyncInterpolateSurfaceFilter->AbortGenerateDataOn();
+  m_AsyncCondition.notify_all();
+  m_AsyncCondition.wait(lock, [this] { return !m_AsyncInterpolationRunning; });
+}
+
+void mitk::SurfaceInterpolationController::SetAsyncInterpolationDelay(unsigned int milliseconds)
+{
+  std::lock_guard<std::mutex> lock(m_AsyncMutex);
+  m_AsyncInterpolationDelay = milliseconds;
+}
+
+void mitk::SurfaceInterpolationController::AsyncInterpolationLoop()
+{
+  std::unique_lock<std::mutex> lock(m_AsyncMutex);
+  while (!m_StopAsyncThread)
+  {
+    m_AsyncCondition.wait(lock, [this] { return m_StopAsyncThread || m_HandledRevision != m_RequestedRevision; });
+
+    // Coalesce requests that arrive in quick succession, e.g. while the user is drawing
+    unsigned long revision = m_RequestedRevision;
+    while (!m_StopAsyncThread &&
+           m_AsyncCondition.wait_for(lock, std::chrono::milliseconds(m_AsyncInterpolationDelay), [this, revision] {
+             return m_StopAsyncThread || m_RequestedRevision != revision;
+           }))
+    {
+      revision = m_RequestedRevision;
+    }
+
+    if (m_StopAsyncThread)
+      break;
+
+    m_HandledRevision = m_RequestedRevision;
 
-  m_InterpolationResult->DisconnectPipeline();
+    // The pending request was cancelled or superseded by a synchronous interpolation
+    if (m_PendingRequest.revision != m_HandledRevision)
+      continue;
+
+    AsyncInterpolationRequest request = m_PendingRequest;
+    m_PendingRequest.contours.clear();
+    m_AsyncInterpolationRunning = true;
+
+    lock.unlock();
+    this->RunAsyncInterpolation(request);
+    lock.lock();
+
+    m_AsyncInterpolationRunning = false;
+    m_AsyncCondition.notify_all();
+  }
+}
+
+void mitk::SurfaceInterpolationController::RunAsyncInterpolation(const AsyncInterpolationRequest &request)
+{
+  try
+  {
+    m_AsyncReduceFilter->Reset();
+    m_AsyncNormalsFilter->Reset();
+    m_AsyncInterpolateSurfaceFilter->Reset();
+
+    if (request.minSpacing > 0)
+      m_AsyncReduceFilter->SetMinSpacing(request.minSpacing);
+    if (request.maxSpacing > 0)
+    {
+      m_AsyncReduceFilter->SetMaxSpacing(request.maxSpacing);
+      m_AsyncNormalsFilter->SetMaxSpacing(request.maxSpacing);
+    }
+
+    for (unsigned int i = 0; i < request.contours.size(); i++)
+      m_AsyncReduceFilter->SetInput(i, request.contours[i]);
+    m_AsyncReduceFilter->Update();
+
+    if (this->IsSuperseded(request.revision))
+      return;
+
+    unsigned int numberOfReducedContours = m_AsyncReduceFilter->GetNumberOfOutputs();
+    if (numberOfReducedContours == 1 && m_AsyncReduceFilter->GetOutput(0)->GetVtkPolyData() == nullptr)
+      numberOfReducedContours = 0;
+
+    m_AsyncNormalsFilter->SetSegmentationBinaryImage(request.segmentation);
+    m_AsyncInterpolateSurfaceFilter->SetReferenceImage(request.referenceImage);
+    m_AsyncInterpolateSurfaceFilter->SetDistanceImageVolume(request.distanceImageVolume);
+    m_AsyncInterpolateSurfaceFilter->SetRBFMode(request.rbfMode);
+
+    for (unsigned int i = 0; i < numberOfReducedContours; i++)
+    {
+      mitk::Surface::Pointer reducedContour = m_AsyncReduceFilter->GetOutput(i);
+      reducedContour->DisconnectPipeline();
+      m_AsyncNormalsFilter->SetInput(i, reducedContour);
+      m_AsyncInterpolateSurfaceFilter->SetInput(i, m_AsyncNormalsFilter->GetOutput(i));
+    }
+
+    mitk::Surface::Pointer interpolationResult;
+    double distanceImageSpacing(0.0);
+
+    // If no interpolation is possible the interpolation result is reset
+    if (numberOfReducedContours >= 2)
+    {
+      mitk::ImageToSurfaceFilter::Pointer imageToSurfaceFilter = mitk::ImageToSurfaceFilter::New();
+      imageToSurfaceFilter->SetInput(m_AsyncInterpolateSurfaceFilter->GetOutput());
+      imageToSurfaceFilter->SetThreshold(0);
+      imageToSurfaceFilter->SetSmooth(true);
+      imageToSurfaceFilter->SetSmoothIteration(20);
+      imageToSurfaceFilter->Update();
+
+      if (this->IsSuperseded(request.revision))
+        return;
+
+      interpolationResult = mitk::Surface::New();
+      interpolationResult->SetVtkPolyData(imageToSurfaceFilter->GetOutput()->GetVtkPolyData(), request.timeStep);
+      interpolationResult->DisconnectPipeline();
+      distanceImageSpacing = m_AsyncInterpolateSurfaceFilter->GetDistanceImageSpacing();
+    }
+
+    vtkSmartPointer<vtkAppendPolyData> polyDataAppender = vtkSmartPointer<vtkAppendPolyData>::New();
+    for (unsigned int i = 0; i < request.contours.size(); i++)
+    {
+      polyDataAppender->AddInputData(request.contours[i]->GetVtkPolyData());
+    }
+    polyDataAppender->Update();
+
+    {
+      // The result is applied by ApplyAsyncInterpolationResult() on the thread that uses the controller
+      std::lock_guard<std::mutex> lock(m_AsyncMutex);
+      if (this->IsSuperseded(request.revision))
+        return;
+
+      m_AsyncResultAvailable = true;
+      m_AsyncResultRevision = request.revision;
+      m_AsyncInterpolationResult = interpolationResult;
+      m_AsyncContours = polyDataAppender->GetOutput();
+      m_AsyncDistanceImageSpacing = distanceImageSpacing;
+    }
+  }
+  catch (const itk::ProcessAborted &)
+  {
+    // superseded by a newer request
+    return;
+  }
+  catch (const std::exception &e)
+  {
+    MITK_ERROR << "Asynchronous surface interpolation failed: " << e.what();
+  }
+  catch (...)
+  {
+    MITK_ERROR << "Asynchronous surface interpolation failed";
+  }
+
+  this->InvokeEvent(SurfaceInterpolationFinishedEvent());
+}
+
+bool mitk::SurfaceInterpolationController::ApplyAsyncInterpolationResult()
+{
+  mitk::Surface::Pointer interpolationResult;
+  vtkSmartPointer<vtkPolyData> contours;
+  double distanceImageSpacing(0.0);
+
+  {
+    std::lock_guard<std::mutex> lock(m_AsyncMutex);
+    if (!m_AsyncResultAvailable)
+      return false;
+
+    m_AsyncResultAvailable = false;
+    interpolationResult = m_AsyncInterpolationResult;
+    contours = m_AsyncContours;
+    distanceImageSpacing = m_AsyncDistanceImageSpacing;
+    m_AsyncInterpolationResult = nullptr;
+    m_AsyncContours = nullptr;
+
+    // A synchronous interpolation or a newer request has been started meanwhile
+    if (this->IsSuperseded(m_AsyncResultRevision))
+      return false;
+
+    m_InterpolationResult = interpolationResult;
+  }
+
+  if (interpolationResult.IsNotNull())
+    m_DistanceImageSpacing = distanceImageSpacing;
+  m_Contours->SetVtkPolyData(contours);
+  return true;
 }
 
 mitk::Surface::Pointer mitk::SurfaceInterpolationController::GetInterpolationResult()
 {
+  std::lock_guard<std::mutex> lock(m_AsyncMutex);
   return m_InterpolationResult;
 }
 
@@ -349,20 +627,29 @@ void mitk::SurfaceInterpolationController::SetDataStorage(DataStorage::Pointer d
 
 void mitk::SurfaceInterpolationController::SetMinSpacing(double minSpacing)
 {
+  m_MinSpacing = minSpacing;
   m_ReduceFilter->SetMinSpacing(minSpacing);
 }
 
 void mitk::SurfaceInterpolationController::SetMaxSpacing(double maxSpacing)
 {
+  m_MaxSpacing = maxSpacing;
   m_ReduceFilter->SetMaxSpacing(maxSpacing);
   m_NormalsFilter->SetMaxSpacing(maxSpacing);
 }
 
 void mitk::SurfaceInterpolationController::SetDistanceImageVolume(unsigned int distImgVolume)
 {
+  m_DistanceImageVolume = distImgVolume;
   m_InterpolateSurfaceFilter->SetDistanceImageVolume(distImgVolume);
 }
 
+void mitk::SurfaceInterpolationController::SetRBFMode(CreateDistanceImageFromSurfaceFilter::RBFMode mode)
+{
+  m_RBFMode = mode;
+  m_InterpolateSurfaceFilter->SetRBFMode(mode);
+}
+
 mitk::Image::Pointer mitk::SurfaceInterpolationController::GetCurrentSegmentation()
 {
   return m_SelectedSegmentation;
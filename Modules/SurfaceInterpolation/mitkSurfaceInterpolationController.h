@@ -47,8 +47,19 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkProgressBar.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace mitk
 {
+  /**
+   * @brief Invoked by the SurfaceInterpolationController when an asynchronous interpolation has finished.
+   * Note that the observers are called from the interpolation thread.
+   */
+  itkEventMacro(SurfaceInterpolationFinishedEvent, itk::AnyEvent);
+
   class MITKSURFACEINTERPOLATION_EXPORT SurfaceInterpolationController : public itk::Object
   {
   public:
@@ -124,6 +135,38 @@ namespace mitk
      */
     void Interpolate();
 
+    /**
+     * @brief Interpolates the 3D surface in a background thread.
+     *
+     * The current contours are copied, so they can be edited while the interpolation is running. Requests that
+     * arrive within the delay (see SetAsyncInterpolationDelay) are coalesced into a single run and a running
+     * interpolation is cancelled as soon as a newer request arrives. The previous solution is used as initial
+     * guess of the equation system. When the result is available or the interpolation failed, a
+     * SurfaceInterpolationFinishedEvent is invoked from the worker thread. The result is not applied before
+     * ApplyAsyncInterpolationResult() is called.
+     */
+    void InterpolateAsync();
+
+    /**
+     * @brief Takes over the result of the last asynchronous interpolation as interpolation result, contours and
+     * distance image spacing.
+     *
+     * Call this from the thread that uses the controller (e.g. the GUI thread) after a
+     * SurfaceInterpolationFinishedEvent. Returns false if there is no new result, e.g. because the interpolation
+     * failed or was superseded by a newer request.
+     */
+    bool ApplyAsyncInterpolationResult();
+
+    /**
+     * @brief Cancels pending and running asynchronous interpolations and waits until they have stopped
+     */
+    void CancelAsyncInterpolation();
+
+    /**
+     * @brief Sets the time in milliseconds an asynchronous interpolation waits for further requests before it starts
+     */
+    void SetAsyncInterpolationDelay(unsigned int milliseconds);
+
     mitk::Surface::Pointer GetInterpolationResult();
 
     /**
@@ -144,6 +187,12 @@ namespace mitk
      */
     void SetDistanceImageVolume(unsigned int distImageVolume);
 
+    /**
+     * Sets the radial basis function used for the interpolation. By default the compactly supported RBF is used,
+     * since the dense equation system becomes too expensive for many contours
+     */
+    void SetRBFMode(CreateDistanceImageFromSurfaceFilter::RBFMode mode);
+
     /**
      * @brief Get the current selected segmentation for which the interpolation is performed
      * @return the current segmentation image
@@ -226,6 +275,24 @@ namespace mitk
 
     void AddToInterpolationPipeline(ContourPositionInformation contourInfo);
 
+    /** Everything an asynchronous interpolation needs, copied when it is requested */
+    struct AsyncInterpolationRequest
+    {
+      unsigned long revision;
+      unsigned int timeStep;
+      std::vector<Surface::Pointer> contours;
+      Image::Pointer segmentation;
+      itk::ImageBase<3>::Pointer referenceImage;
+      double minSpacing;
+      double maxSpacing;
+      unsigned int distanceImageVolume;
+      CreateDistanceImageFromSurfaceFilter::RBFMode rbfMode;
+    };
+
+    void AsyncInterpolationLoop();
+    void RunAsyncInterpolation(const AsyncInterpolationRequest &request);
+    bool IsSuperseded(unsigned long revision) const { return revision != m_RequestedRevision; }
+
     ReduceContourSetFilter::Pointer m_ReduceFilter;
     ComputeContourSetNormalsFilter::Pointer m_NormalsFilter;
     CreateDistanceImageFromSurfaceFilter::Pointer m_InterpolateSurfaceFilter;
@@ -249,6 +316,31 @@ namespace mitk
     std::map<mitk::Image *, unsigned long> m_SegmentationObserverTags;
 
     unsigned int m_CurrentTimeStep;
+
+    double m_MinSpacing;
+    double m_MaxSpacing;
+    unsigned int m_DistanceImageVolume;
+    CreateDistanceImageFromSurfaceFilter::RBFMode m_RBFMode;
+
+    // The asynchronous interpolation uses its own pipeline
+    ReduceContourSetFilter::Pointer m_AsyncReduceFilter;
+    ComputeContourSetNormalsFilter::Pointer m_AsyncNormalsFilter;
+    CreateDistanceImageFromSurfaceFilter::Pointer m_AsyncInterpolateSurfaceFilter;
+
+    std::thread m_AsyncThread;
+    std::mutex m_AsyncMutex; // guards the pending request, the worker state and the published results
+    std::condition_variable m_AsyncCondition;
+    AsyncInterpolationRequest m_PendingRequest;
+    std::atomic<unsigned long> m_RequestedRevision;
+    unsigned long m_HandledRevision;
+    bool m_AsyncResultAvailable;
+    unsigned long m_AsyncResultRevision;
+    Surface::Pointer m_AsyncInterpolationResult;
+    vtkSmartPointer<vtkPolyData> m_AsyncContours;
+    double m_AsyncDistanceImageSpacing;
+    bool m_AsyncInterpolationRunning;
+    bool m_StopAsyncThread;
+    unsigned int m_AsyncInterpolationDelay;
   };
 }
 #endif
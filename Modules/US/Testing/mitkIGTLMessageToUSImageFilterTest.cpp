@@ -0,0 +1,98 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkIGTLMessageToUSImageFilter.h>
+#include <mitkImageGenerator.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageToIGTLMessageFilter.h>
+
+#include <igtlImageMessage.h>
+#include <itkByteSwapper.h>
+
+#include <cstring>
+
+class mitkIGTLMessageToUSImageFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkIGTLMessageToUSImageFilterTestSuite);
+  MITK_TEST(GetNextImage_LittleEndianMessage_ReferencesMessageBuffer);
+  MITK_TEST(GetNextImage_ReleasedMessage_ImageStaysValid);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::Image::Pointer m_Image;
+  mitk::ImageToIGTLMessageFilter::Pointer m_ImageToMessage;
+  mitk::IGTLMessageToUSImageFilter::Pointer m_MessageToImage;
+
+  void CreatePipeline(unsigned int x, unsigned int y, unsigned int z)
+  {
+    m_Image = mitk::ImageGenerator::GenerateRandomImage<unsigned short>(x, y, z, 1, 1, 1, 1, 4095, 0);
+
+    m_ImageToMessage = mitk::ImageToIGTLMessageFilter::New();
+    m_ImageToMessage->SetInput(m_Image);
+
+    m_MessageToImage = mitk::IGTLMessageToUSImageFilter::New();
+    m_MessageToImage->ConnectTo(m_ImageToMessage);
+  }
+
+  bool DataEqual(mitk::Image* lhs, mitk::Image* rhs)
+  {
+    mitk::ImageReadAccessor lhsAccess(lhs, lhs->GetVolumeData(0));
+    mitk::ImageReadAccessor rhsAccess(rhs, rhs->GetVolumeData(0));
+    size_t size = lhs->GetDimension(0) * lhs->GetDimension(1) * lhs->GetDimension(2) * lhs->GetPixelType().GetSize();
+    return std::memcmp(lhsAccess.GetData(), rhsAccess.GetData(), size) == 0;
+  }
+
+public:
+  void tearDown() override
+  {
+    m_MessageToImage = nullptr;
+    m_ImageToMessage = nullptr;
+    m_Image = nullptr;
+  }
+
+  void GetNextImage_LittleEndianMessage_ReferencesMessageBuffer()
+  {
+    this->CreatePipeline(64, 48, 8);
+    mitk::Image::Pointer output = m_MessageToImage->GetNextImage();
+    CPPUNIT_ASSERT(output.IsNotNull());
+    CPPUNIT_ASSERT_MESSAGE("Received image equals the sent image", this->DataEqual(m_Image, output));
+
+    if (!itk::ByteSwapper<short>::SystemIsBigEndian())
+    {
+      auto* message = static_cast<igtl::ImageMessage*>(m_ImageToMessage->GetOutput()->GetMessage().GetPointer());
+      mitk::ImageReadAccessor access(output, output->GetVolumeData(0));
+      CPPUNIT_ASSERT_MESSAGE("Image wraps the pixel buffer of the message",
+                             access.GetData() == message->GetScalarPointer());
+    }
+  }
+
+  void GetNextImage_ReleasedMessage_ImageStaysValid()
+  {
+    this->CreatePipeline(32, 32, 4);
+    mitk::Image::Pointer output = m_MessageToImage->GetNextImage();
+
+    // the filters hold the last message, the image has to keep it alive on its own
+    m_MessageToImage = nullptr;
+    m_ImageToMessage = nullptr;
+
+    CPPUNIT_ASSERT_MESSAGE("Image data is still valid", this->DataEqual(m_Image, output));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkIGTLMessageToUSImageFilter)
@@ -17,6 +17,80 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkUSVideoDevice.h"
 #include "mitkUSProbe.h"
 #include "mitkTestingMacros.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* Device that gives the test access to the acquisition ring buffer.
+*/
+class mitkUSTestDevice : public mitk::USVideoDevice
+{
+public:
+  mitkClassMacro(mitkUSTestDevice, mitk::USVideoDevice);
+  mitkNewMacro3Param(Self, std::string, std::string, std::string);
+
+  /** Acquires a 2D image with all pixels set to the given value. */
+  void AddFrame(unsigned char value)
+  {
+    unsigned int dimensions[2] = { 4, 4 };
+    mitk::Image::Pointer image = mitk::Image::New();
+    image->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 2, dimensions);
+    {
+      mitk::ImageWriteAccessor accessor(image);
+      std::memset(accessor.GetData(), value, 4 * 4);
+    }
+    this->SetImage(image);
+  }
+
+  /** Reads the newest frame like a pipeline update does. */
+  void ReadLatestFrame()
+  {
+    this->GenerateData();
+  }
+
+  /** Calls the function while another thread holds the slots of the given frames, like a consumer reading them. */
+  void RunWhileFramesAreHeld(const std::vector<unsigned long>& frameNumbers, const std::function<void()>& function)
+  {
+    std::vector<std::mutex*> mutexes;
+    for (auto& slot : m_FrameBuffer)
+    {
+      std::lock_guard<std::mutex> lock(slot->mutex);
+      if (std::find(frameNumbers.begin(), frameNumbers.end(), slot->frameNumber) != frameNumbers.end())
+        mutexes.push_back(&slot->mutex);
+    }
+
+    std::promise<void> locked;
+    std::promise<void> release;
+    std::future<void> released = release.get_future();
+    std::thread consumer([&]()
+    {
+      std::vector<std::unique_lock<std::mutex>> locks;
+      for (auto mutex : mutexes)
+        locks.emplace_back(*mutex);
+      locked.set_value();
+      released.wait();
+    });
+
+    locked.get_future().wait();
+    function();
+    release.set_value();
+    consumer.join();
+  }
+
+protected:
+  mitkUSTestDevice(std::string videoFilePath, std::string manufacturer, std::string model)
+    : mitk::USVideoDevice(videoFilePath, manufacturer, model)
+  {
+  }
+};
 
 class mitkUSDeviceTestClass
 {
@@ -39,6 +113,79 @@ public:
   static void TestActivateProbe()
   {
   }
+
+  static unsigned char GetPixelValue(mitk::Image::Pointer image)
+  {
+    mitk::ImageReadAccessor accessor(image);
+    return *static_cast<const unsigned char*>(accessor.GetData());
+  }
+
+  static void TestFrameBuffer()
+  {
+    mitkUSTestDevice::Pointer device = mitkUSTestDevice::New("IllegalPath", "Manufacturer", "Model");
+
+    device->SetNumberOfBufferedFrames(1);
+    MITK_TEST_CONDITION(device->GetNumberOfBufferedFrames() == 3, "Ring buffer has at least three frames");
+
+    device->SetNumberOfBufferedFrames(4);
+    MITK_TEST_CONDITION_REQUIRED(device->GetNumberOfBufferedFrames() == 4, "Ring buffer has four frames");
+
+    mitk::USDevice::USFrame frame;
+    MITK_TEST_CONDITION(device->GetLatestFrameNumber() == 0, "No frame acquired yet");
+    MITK_TEST_CONDITION(!device->GetFrame(1, frame), "Frame 1 not acquired yet");
+
+    for (unsigned char value = 1; value <= 10; ++value)
+      device->AddFrame(value);
+
+    MITK_TEST_CONDITION(device->GetLatestFrameNumber() == 10, "Frames are numbered consecutively");
+
+    // after the buffer wrapped around, only the last four frames are available
+    for (unsigned long frameNumber = 1; frameNumber <= 11; ++frameNumber)
+    {
+      bool available = device->GetFrame(frameNumber, frame);
+      MITK_TEST_CONDITION(available == (frameNumber >= 7 && frameNumber <= 10), "Availability of frame " << frameNumber);
+      if (available)
+      {
+        MITK_TEST_CONDITION(frame.frameNumber == frameNumber, "Number of frame " << frameNumber);
+        MITK_TEST_CONDITION(GetPixelValue(frame.image) == frameNumber, "Image of frame " << frameNumber);
+      }
+    }
+
+    mitk::USDevice::USAcquisitionStatistics statistics = device->GetAcquisitionStatistics();
+    MITK_TEST_CONDITION(statistics.acquiredFrames == 10, "Number of acquired frames");
+    MITK_TEST_CONDITION(statistics.droppedFrames == 6, "Overwritten frames that were never read are dropped");
+  }
+
+  static void TestDroppedFramesWhileHeld()
+  {
+    mitkUSTestDevice::Pointer device = mitkUSTestDevice::New("IllegalPath", "Manufacturer", "Model");
+    device->SetNumberOfBufferedFrames(3);
+
+    device->AddFrame(1);
+    device->AddFrame(2);
+    device->AddFrame(3);
+    device->ReadLatestFrame();
+    MITK_TEST_CONDITION(device->GetAcquisitionStatistics().droppedFrames == 0, "No frame dropped");
+
+    // the slot of frame 1 would be next, but it is read at the moment: frame 2 is overwritten instead
+    device->RunWhileFramesAreHeld({ 1 }, [device]() { device->AddFrame(4); });
+
+    mitk::USDevice::USFrame frame;
+    MITK_TEST_CONDITION(device->GetAcquisitionStatistics().droppedFrames == 1, "Frame 2 dropped");
+    MITK_TEST_CONDITION(device->GetFrame(1, frame) && GetPixelValue(frame.image) == 1, "Held frame 1 is not overwritten");
+    MITK_TEST_CONDITION(!device->GetFrame(2, frame), "Frame 2 is overwritten");
+    MITK_TEST_CONDITION(device->GetFrame(4, frame) && GetPixelValue(frame.image) == 4, "Frame 4 is buffered");
+    MITK_TEST_CONDITION(device->GetLatestFrameNumber() == 4, "Frame 4 is the newest frame");
+
+    // all slots are read at the moment: the new frame cannot be buffered
+    device->RunWhileFramesAreHeld({ 1, 3, 4 }, [device]() { device->AddFrame(5); });
+
+    mitk::USDevice::USAcquisitionStatistics statistics = device->GetAcquisitionStatistics();
+    MITK_TEST_CONDITION(statistics.acquiredFrames == 5, "Number of acquired frames");
+    MITK_TEST_CONDITION(statistics.droppedFrames == 2, "Frame 5 dropped");
+    MITK_TEST_CONDITION(!device->GetFrame(5, frame), "Frame 5 is not buffered");
+    MITK_TEST_CONDITION(device->GetLatestFrameNumber() == 4, "Frame 4 is still the newest frame");
+  }
 };
 
 /**
@@ -51,6 +198,8 @@ int mitkUSDeviceTest(int /* argc */, char* /*argv*/[])
   mitkUSDeviceTestClass::TestInstantiation();
   mitkUSDeviceTestClass::TestAddProbe();
   mitkUSDeviceTestClass::TestActivateProbe();
+  mitkUSDeviceTestClass::TestFrameBuffer();
+  mitkUSDeviceTestClass::TestDroppedFramesWhileHeld();
 
   MITK_TEST_END();
 }
\ No newline at end of file
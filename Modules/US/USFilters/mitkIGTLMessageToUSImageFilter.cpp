@@ -15,8 +15,35 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include <mitkIGTLMessageToUSImageFilter.h>
+#include <mitkImageWriteAccessor.h>
 #include <igtlImageMessage.h>
 #include <itkByteSwapper.h>
+#include <itkCommand.h>
+
+namespace
+{
+  /**
+   * Keeps an OpenIGTLink message alive as long as the image that references
+   * its pixel buffer. It is registered as observer of the image, so the image
+   * owns it and releases it on destruction.
+   */
+  class MessageOwner : public itk::Command
+  {
+  public:
+    typedef MessageOwner Self;
+    typedef itk::SmartPointer<Self> Pointer;
+    itkFactorylessNewMacro(Self);
+    itkTypeMacro(MessageOwner, itk::Command);
+
+    void SetMessage(igtl::MessageBase* message) { m_Message = message; }
+
+    void Execute(itk::Object*, const itk::EventObject&) override {}
+    void Execute(const itk::Object*, const itk::EventObject&) override {}
+
+  private:
+    igtl::MessageBase::Pointer m_Message;
+  };
+}
 
 void mitk::IGTLMessageToUSImageFilter::GetNextRawImage(
   mitk::Image::Pointer& img)
@@ -78,22 +105,14 @@ void mitk::IGTLMessageToUSImageFilter::Initiate(mitk::Image::Pointer& img,
   igtl::ImageMessage* msg,
   bool big_endian)
 {
-  typedef itk::Image<TPixel, 3> ImageType;
-
-  typename ImageType::Pointer output = ImageType::New();
-  typename ImageType::RegionType region;
-  typename ImageType::RegionType::SizeType size;
-  typename ImageType::RegionType::IndexType index;
-  typename ImageType::SpacingType spacing;
-  typename ImageType::PointType origin;
-
   // Copy dimensions
   int dims[3];
   msg->GetDimensions(dims);
+  unsigned int dimensions[3];
   size_t num_pixel = 1;
   for (size_t i = 0; i < 3; i++)
   {
-    size[i] = dims[i];
+    dimensions[i] = dims[i];
     num_pixel *= dims[i];
   }
 
@@ -110,58 +129,49 @@ void mitk::IGTLMessageToUSImageFilter::Initiate(mitk::Image::Pointer& img,
     }
   }
 
-  index.Fill(0);
-
-  float matF[4][4];
-  msg->GetMatrix(matF);
-  vtkMatrix4x4* vtkMatrix = vtkMatrix4x4::New();
-
-  for (size_t i = 0; i < 4; ++i)
-    for (size_t j = 0; j < 4; ++j)
-      vtkMatrix->SetElement(i, j, matF[i][j]);
-
   float spacingMsg[3];
-
   msg->GetSpacing(spacingMsg);
 
+  mitk::Vector3D spacing;
   for (int i = 0; i < 3; ++i)
     spacing[i] = spacingMsg[i];
 
-  region.SetSize(size);
-  region.SetIndex(index);
-  output->SetRegions(region);
-  output->SetSpacing(spacing);
-  output->Allocate();
+  img = mitk::Image::New();
+  img->Initialize(mitk::MakeScalarPixelType<TPixel>(), 3, dimensions);
+  img->SetSpacing(spacing);
 
-  TPixel* in = (TPixel*)msg->GetScalarPointer();
-  TPixel* out = (TPixel*)output->GetBufferPointer();
-  memcpy(out, in, num_pixel * sizeof(TPixel));
-  if (big_endian)
+  bool swap = sizeof(TPixel) > 1 && big_endian != itk::ByteSwapper<TPixel>::SystemIsBigEndian();
+  if (!swap)
   {
-    // Even though this method is called "FromSystemToBigEndian", it also swaps
-    // "FromBigEndianToSystem".
-    // This makes sense, but might be confusing at first glance.
-    itk::ByteSwapper<TPixel>::SwapRangeFromSystemToBigEndian(out, num_pixel);
+    // No conversion necessary: the image directly references the pixel buffer
+    // of the message instead of copying it. The message is kept alive by the
+    // image and must not be modified afterwards.
+    img->SetImportVolume(msg->GetScalarPointer(), 0, 0, mitk::Image::ReferenceMemory);
+
+    MessageOwner::Pointer owner = MessageOwner::New();
+    owner->SetMessage(msg);
+    img->AddObserver(itk::DeleteEvent(), owner);
   }
   else
   {
-    itk::ByteSwapper<TPixel>::SwapRangeFromSystemToLittleEndian(out, num_pixel);
+    img->SetImportVolume(msg->GetScalarPointer(), 0, 0, mitk::Image::CopyMemory);
+
+    mitk::ImageWriteAccessor writeAccess(img, img->GetVolumeData(0));
+    TPixel* out = static_cast<TPixel*>(writeAccess.GetData());
+    if (big_endian)
+    {
+      // Even though this method is called "FromSystemToBigEndian", it also swaps
+      // "FromBigEndianToSystem".
+      // This makes sense, but might be confusing at first glance.
+      itk::ByteSwapper<TPixel>::SwapRangeFromSystemToBigEndian(out, num_pixel);
+    }
+    else
+    {
+      itk::ByteSwapper<TPixel>::SwapRangeFromSystemToLittleEndian(out, num_pixel);
+    }
   }
 
-  img = mitk::Image::New();
-  img->InitializeByItk(output.GetPointer());
-  img->SetVolume(output->GetBufferPointer());
-  //img->GetGeometry()->SetIndexToWorldTransformByVtkMatrix(vtkMatrix);
   m_previousImage = img;
-  vtkMatrix->Delete();
-
-  float iorigin[3];
-  msg->GetOrigin(iorigin);
-  for (size_t i = 0; i < 3; i++)
-  {
-    origin[i] = iorigin[i];
-  }
-  output->SetOrigin(origin);
 }
 
 mitk::IGTLMessageToUSImageFilter::IGTLMessageToUSImageFilter()
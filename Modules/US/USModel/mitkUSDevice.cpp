@@ -16,6 +16,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkUSDevice.h"
 #include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
+
+// STL
+#include <chrono>
+#include <cstring>
 
 // US Control Interfaces
 #include "mitkUSControlInterfaceProbes.h"
@@ -50,10 +55,12 @@ mitk::USDevice::USDevice(std::string manufacturer, std::string model)
   m_Name(model),
   m_SpawnAcquireThread(true),
   m_MultiThreader(itk::MultiThreader::New()),
-  m_ImageMutex(itk::FastMutexLock::New()),
   m_ThreadID(-1),
   m_UnregisteringStarted(false)
 {
+  this->AllocateFrameBuffer(8);
+  this->ResetAcquisitionStatistics();
+
   USImageCropArea empty;
   empty.cropBottom = 0;
   empty.cropTop = 0;
@@ -75,10 +82,12 @@ mitk::USDevice::USDevice(mitk::USImageMetadata::Pointer metadata)
   m_DeviceState(State_NoState),
   m_SpawnAcquireThread(true),
   m_MultiThreader(itk::MultiThreader::New()),
-  m_ImageMutex(itk::FastMutexLock::New()),
   m_ThreadID(-1),
   m_UnregisteringStarted(false)
 {
+  this->AllocateFrameBuffer(8);
+  this->ResetAcquisitionStatistics();
+
   m_Manufacturer = metadata->GetDeviceManufacturer();
   m_Name = metadata->GetDeviceModel();
   m_Comment = metadata->GetDeviceComment();
@@ -308,6 +317,8 @@ bool mitk::USDevice::Activate()
 
     m_FreezeBarrier = itk::ConditionVariable::New();
 
+    this->ResetAcquisitionStatistics();
+
     // spawn thread for aquire images if us device is active
     if (m_SpawnAcquireThread)
     {
@@ -546,11 +557,161 @@ output->Graft( graft );
 void mitk::USDevice::GrabImage()
 {
   mitk::Image::Pointer image = this->GetUSImageSource()->GetNextImage();
-  m_ImageMutex->Lock();
   this->SetImage(image);
-  m_ImageMutex->Unlock();
-  // if (image.IsNotNull() && (image->GetGeometry()!=nullptr)){
-  //  MITK_INFO << "Spacing: " << image->GetGeometry()->GetSpacing();}
+}
+
+void mitk::USDevice::SetImage(mitk::Image::Pointer image)
+{
+  if (image.IsNull() || !image->IsInitialized() || !image->IsVolumeSet(0))
+    return;
+
+  double timestamp = GetTimeInMilliseconds();
+  unsigned long frameNumber = ++m_NumberOfAcquiredFrames;
+
+  int numberOfSlots = static_cast<int>(m_FrameBuffer.size());
+  int latestSlot = m_LatestFrameSlot.load();
+
+  // never wait for consumers: use the next slot that is not read at the moment
+  for (int i = 1; i <= numberOfSlots; ++i)
+  {
+    int index = (latestSlot + i + numberOfSlots) % numberOfSlots;
+    FrameSlot& slot = *m_FrameBuffer[index];
+
+    std::unique_lock<std::mutex> lock(slot.mutex, std::try_to_lock);
+    if (!lock.owns_lock())
+      continue;
+
+    if (slot.frameNumber != 0 && !slot.consumed)
+      ++m_NumberOfDroppedFrames;
+
+    // the image of the slot is only reallocated if the image format changes
+    if (slot.image.IsNull() || slot.image->GetDimension() != image->GetDimension() ||
+      slot.image->GetDimension(0) != image->GetDimension(0) ||
+      slot.image->GetDimension(1) != image->GetDimension(1) ||
+      slot.image->GetDimension(2) != image->GetDimension(2) ||
+      slot.image->GetPixelType() != image->GetPixelType())
+    {
+      slot.image = mitk::Image::New();
+      slot.image->Initialize(image->GetPixelType(), image->GetDimension(), image->GetDimensions());
+    }
+
+    {
+      mitk::ImageReadAccessor inputReadAccessor(image, image->GetVolumeData(0));
+      mitk::ImageWriteAccessor slotWriteAccessor(slot.image, slot.image->GetVolumeData(0));
+      std::memcpy(slotWriteAccessor.GetData(), inputReadAccessor.GetData(),
+        image->GetPixelType().GetSize() * image->GetDimension(0) * image->GetDimension(1) * image->GetDimension(2));
+    }
+    slot.image->SetGeometry(image->GetGeometry()->Clone());
+    slot.image->Modified();
+
+    slot.timestamp = timestamp;
+    slot.frameNumber = frameNumber;
+    slot.consumed = false;
+    lock.unlock();
+
+    m_LatestFrameSlot = index;
+
+    if (m_LastFrameTimestamp > 0 && timestamp > m_LastFrameTimestamp)
+    {
+      // exponential moving average of the frame rate
+      double framesPerSecond = 1000.0 / (timestamp - m_LastFrameTimestamp);
+      double average = m_FramesPerSecond.load();
+      m_FramesPerSecond = average > 0 ? 0.9 * average + 0.1 * framesPerSecond : framesPerSecond;
+    }
+    m_LastFrameTimestamp = timestamp;
+    return;
+  }
+
+  // all frames are read by consumers at the moment
+  ++m_NumberOfDroppedFrames;
+}
+
+void mitk::USDevice::SetNumberOfBufferedFrames(unsigned int numberOfFrames)
+{
+  if (this->GetIsActive())
+  {
+    MITK_WARN("mitkUSDevice")
+      << "Cannot change the number of buffered frames while the device is active.";
+    return;
+  }
+
+  this->AllocateFrameBuffer(numberOfFrames);
+}
+
+unsigned int mitk::USDevice::GetNumberOfBufferedFrames()
+{
+  return static_cast<unsigned int>(m_FrameBuffer.size());
+}
+
+unsigned long mitk::USDevice::GetLatestFrameNumber()
+{
+  int index = m_LatestFrameSlot.load();
+  if (index < 0)
+    return 0;
+
+  FrameSlot& slot = *m_FrameBuffer[index];
+  std::lock_guard<std::mutex> lock(slot.mutex);
+  return slot.frameNumber;
+}
+
+bool mitk::USDevice::GetFrame(unsigned long frameNumber, USFrame& frame)
+{
+  for (auto& slot : m_FrameBuffer)
+  {
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    if (slot->frameNumber == frameNumber && frameNumber != 0)
+    {
+      frame.image = slot->image->Clone();
+      frame.timestamp = slot->timestamp;
+      frame.frameNumber = slot->frameNumber;
+      return true;
+    }
+  }
+  return false;
+}
+
+mitk::USDevice::USAcquisitionStatistics mitk::USDevice::GetAcquisitionStatistics()
+{
+  USAcquisitionStatistics statistics;
+  statistics.framesPerSecond = m_FramesPerSecond.load();
+  statistics.acquiredFrames = m_NumberOfAcquiredFrames.load();
+  statistics.droppedFrames = m_NumberOfDroppedFrames.load();
+  statistics.latency = m_Latency.load();
+  return statistics;
+}
+
+void mitk::USDevice::AllocateFrameBuffer(unsigned int numberOfFrames)
+{
+  // at least three frames, so that the capture thread always finds a frame
+  // that is neither the newest one nor read by GenerateData()
+  if (numberOfFrames < 3)
+    numberOfFrames = 3;
+
+  m_FrameBuffer.clear();
+  for (unsigned int i = 0; i < numberOfFrames; ++i)
+  {
+    std::unique_ptr<FrameSlot> slot(new FrameSlot);
+    slot->timestamp = 0;
+    slot->frameNumber = 0;
+    slot->consumed = false;
+    m_FrameBuffer.push_back(std::move(slot));
+  }
+  m_LatestFrameSlot = -1;
+}
+
+void mitk::USDevice::ResetAcquisitionStatistics()
+{
+  m_NumberOfAcquiredFrames = 0;
+  m_NumberOfDroppedFrames = 0;
+  m_FramesPerSecond = 0;
+  m_Latency = 0;
+  m_LastFrameTimestamp = 0;
+}
+
+double mitk::USDevice::GetTimeInMilliseconds()
+{
+  return std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 //########### GETTER & SETTER ##################//
@@ -575,37 +736,50 @@ std::string mitk::USDevice::GetDeviceComment() { return m_Comment; }
 
 void mitk::USDevice::GenerateData()
 {
-  m_ImageMutex->Lock();
+  int index = m_LatestFrameSlot.load();
+  if (index < 0)
+    return;
 
-  if (m_Image.IsNull() || !m_Image->IsInitialized())
-  {
-    m_ImageMutex->Unlock();
+  // the capture thread skips this frame while it is read
+  FrameSlot& slot = *m_FrameBuffer[index];
+  std::lock_guard<std::mutex> lock(slot.mutex);
+
+  mitk::Image::Pointer image = slot.image;
+  if (image.IsNull() || !image->IsInitialized())
     return;
-  }
 
   mitk::Image::Pointer output = this->GetOutput();
 
   if (!output->IsInitialized() ||
-    output->GetDimension(0) != m_Image->GetDimension(0) ||
-    output->GetDimension(1) != m_Image->GetDimension(1) ||
-    output->GetDimension(2) != m_Image->GetDimension(2) ||
-    output->GetPixelType()  != m_Image->GetPixelType())
+    output->GetDimension(0) != image->GetDimension(0) ||
+    output->GetDimension(1) != image->GetDimension(1) ||
+    output->GetDimension(2) != image->GetDimension(2) ||
+    output->GetPixelType()  != image->GetPixelType())
   {
-    output->Initialize(m_Image->GetPixelType(), m_Image->GetDimension(),
-      m_Image->GetDimensions());
+    output->Initialize(image->GetPixelType(), image->GetDimension(),
+      image->GetDimensions());
   }
 
-  // copy contents of the given image into the member variable, slice after slice
-  for (unsigned int sliceNumber = 0; sliceNumber < m_Image->GetDimension(2); ++sliceNumber)
+  // copy contents of the newest frame into the output, slice after slice
+  for (unsigned int sliceNumber = 0; sliceNumber < image->GetDimension(2); ++sliceNumber)
   {
-    if (m_Image->IsSliceSet(sliceNumber)) {
-      mitk::ImageReadAccessor inputReadAccessor(m_Image, m_Image->GetSliceData(sliceNumber, 0, 0));
+    if (image->IsSliceSet(sliceNumber)) {
+      mitk::ImageReadAccessor inputReadAccessor(image, image->GetSliceData(sliceNumber, 0, 0));
       output->SetSlice(inputReadAccessor.GetData(), sliceNumber);
     }
- }
+  }
 
-  output->SetGeometry(m_Image->GetGeometry());
-  m_ImageMutex->Unlock();
+  output->SetGeometry(image->GetGeometry());
+
+  if (!slot.consumed)
+  {
+    slot.consumed = true;
+
+    // exponential moving average of the latency
+    double latency = GetTimeInMilliseconds() - slot.timestamp;
+    double average = m_Latency.load();
+    m_Latency = average > 0 ? 0.9 * average + 0.1 * latency : latency;
+  }
 };
 
 std::string mitk::USDevice::GetServicePropertyLabel()
@@ -18,6 +18,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define MITKUSDevice_H_HEADER_INCLUDED_
 
 // STL
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 // MitkUS
@@ -89,6 +92,27 @@ namespace mitk {
       int cropTop;
     };
 
+    /**
+    * \brief A frame of the acquisition ring buffer.
+    */
+    struct USFrame
+    {
+      mitk::Image::Pointer image;
+      double timestamp;           ///< acquisition time in ms (steady clock)
+      unsigned long frameNumber;  ///< consecutive number of the frame, starting with 1
+    };
+
+    /**
+    * \brief Statistics of the image acquisition since the device was activated.
+    */
+    struct USAcquisitionStatistics
+    {
+      double framesPerSecond;        ///< current acquisition rate of the capture thread
+      unsigned long acquiredFrames;  ///< number of frames delivered by the image source
+      unsigned long droppedFrames;   ///< frames that were overwritten before GenerateData() read them or could not be buffered
+      double latency;                ///< mean time in ms between acquisition and output of a frame
+    };
+
     /**
      * \brief These constants are used in conjunction with Microservices.
      * The constants aren't defined as static member attributes to avoid the
@@ -310,17 +334,55 @@ namespace mitk {
     itkGetMacro(DeviceState, DeviceStates)
       itkGetMacro(ServiceProperties, us::ServiceProperties)
 
-      void GrabImage();
+    /**
+    * \brief Gets the next image from the image source and stores it in the
+    * acquisition ring buffer. This is called continuously by the capture thread.
+    */
+    void GrabImage();
+
+    /**
+    * \brief Sets the number of frames of the acquisition ring buffer
+    * (default 8). This can only be changed while the device is not active.
+    */
+    void SetNumberOfBufferedFrames(unsigned int numberOfFrames);
+    unsigned int GetNumberOfBufferedFrames();
+
+    /**
+    * \brief Returns the number of the newest frame in the ring buffer or 0 if
+    * no frame was acquired yet.
+    */
+    unsigned long GetLatestFrameNumber();
+
+    /**
+    * \brief Copies the frame with the given number if it is still in the ring
+    * buffer. Consumers that need every frame (e.g. recording) can poll the
+    * frame numbers from their last frame up to GetLatestFrameNumber().
+    *
+    * \return false if the frame was not acquired yet or already overwritten
+    */
+    bool GetFrame(unsigned long frameNumber, USFrame& frame);
+
+    /**
+    * \brief Returns frame rate, number of acquired and dropped frames and the
+    * latency between acquisition and output.
+    */
+    USAcquisitionStatistics GetAcquisitionStatistics();
 
   protected:
-    itkSetMacro(Image, mitk::Image::Pointer);
+    /**
+    * \brief Stores the image as newest frame in the acquisition ring buffer.
+    *
+    * The image data is copied into a preallocated frame. The capture thread
+    * never waits for consumers: frames that are read at the moment are
+    * skipped.
+    */
+    void SetImage(mitk::Image::Pointer image);
     itkSetMacro(SpawnAcquireThread, bool);
     itkGetMacro(SpawnAcquireThread, bool);
 
     static ITK_THREAD_RETURN_TYPE Acquire(void* pInfoStruct);
     static ITK_THREAD_RETURN_TYPE ConnectThread(void* pInfoStruct);
 
-    mitk::Image::Pointer m_Image;
     mitk::Image::Pointer m_OutputImage;
 
     /**
@@ -435,6 +497,28 @@ namespace mitk {
 
     std::string GetServicePropertyLabel();
 
+    // Acquisition ring buffer
+    struct FrameSlot
+    {
+      mitk::Image::Pointer image;
+      double timestamp;
+      unsigned long frameNumber; ///< 0 if the slot is empty
+      bool consumed;             ///< whether GenerateData() has read the frame
+      std::mutex mutex;          ///< held while the frame is written or read
+    };
+
+    void AllocateFrameBuffer(unsigned int numberOfFrames);
+    void ResetAcquisitionStatistics();
+    static double GetTimeInMilliseconds();
+
+    std::vector<std::unique_ptr<FrameSlot>> m_FrameBuffer;
+    std::atomic<int> m_LatestFrameSlot; ///< index of the newest frame, -1 if empty
+    std::atomic<unsigned long> m_NumberOfAcquiredFrames;
+    std::atomic<unsigned long> m_NumberOfDroppedFrames;
+    std::atomic<double> m_FramesPerSecond;
+    std::atomic<double> m_Latency;
+    double m_LastFrameTimestamp; ///< only used by the capture thread
+
   private:
 
     std::string m_Manufacturer;
@@ -457,7 +541,6 @@ namespace mitk {
     itk::ConditionVariable::Pointer m_FreezeBarrier;
     itk::SimpleMutexLock        m_FreezeMutex;
     itk::MultiThreader::Pointer m_MultiThreader; ///< itk::MultiThreader used for thread handling
-    itk::FastMutexLock::Pointer m_ImageMutex; ///< mutex for images provided by the image source
     int m_ThreadID; ///< ID of the started thread
 
     bool m_UnregisteringStarted;